@@ -17,8 +17,10 @@
     Copyright 2017-2020 Telegram Systems LLP
 */
 #include "adnl-ext-server.hpp"
+#include "common/checksum.h"
 #include "keys/encryptor.h"
 #include "utils.hpp"
+#include "td/utils/port/IPAddress.h"
 
 namespace ton {
 
@@ -37,7 +39,8 @@ td::Status AdnlInboundConnection::process_packet(td::BufferSlice data) {
           td::actor::send_closure(SelfId, &AdnlInboundConnection::send, serialize_tl_object(B, true));
         }
       });
-  td::actor::send_closure(peer_table_, &AdnlPeerTable::deliver_query, remote_id_, local_id_, std::move(f->query_),
+  td::actor::send_closure(peer_table_, &AdnlPeerTable::deliver_query,
+                          remote_id_.is_zero() ? anonymous_id_ : remote_id_, local_id_, std::move(f->query_),
                           std::move(P));
   return td::Status::OK();
 }
@@ -156,8 +159,13 @@ void AdnlExtServerImpl::add_local_id(AdnlNodeIdShort id) {
 }
 
 void AdnlExtServerImpl::accepted(td::SocketFd fd) {
+  auto anonymous_id = AdnlNodeIdShort::zero();
+  td::IPAddress addr;
+  if (addr.init_peer_address(fd).is_ok()) {
+    anonymous_id = AdnlNodeIdShort{td::sha256_bits256(PSLICE() << "adnl.ext.anonymous " << addr.get_ip_str())};
+  }
   td::actor::create_actor<AdnlInboundConnection>(td::actor::ActorOptions().with_name("inconn").with_poll(),
-                                                 std::move(fd), peer_table_, actor_id(this))
+                                                 std::move(fd), peer_table_, actor_id(this), anonymous_id)
       .release();
 }
 
@@ -37,8 +37,11 @@ class AdnlExtServerImpl;
 class AdnlInboundConnection : public AdnlExtConnection {
  public:
   AdnlInboundConnection(td::SocketFd fd, td::actor::ActorId<AdnlPeerTable> peer_table,
-                        td::actor::ActorId<AdnlExtServerImpl> ext_server)
-      : AdnlExtConnection(std::move(fd), nullptr, false), peer_table_(peer_table), ext_server_(ext_server) {
+                        td::actor::ActorId<AdnlExtServerImpl> ext_server, AdnlNodeIdShort anonymous_id)
+      : AdnlExtConnection(std::move(fd), nullptr, false)
+      , peer_table_(peer_table)
+      , ext_server_(ext_server)
+      , anonymous_id_(anonymous_id) {
   }
 
   td::Status process_packet(td::BufferSlice data) override;
@@ -53,6 +56,9 @@ class AdnlInboundConnection : public AdnlExtConnection {
 
   td::SecureString nonce_;
   AdnlNodeIdShort remote_id_ = AdnlNodeIdShort::zero();
+  // src of queries before authentication: derived from the remote IP address, so that receivers can tell anonymous
+  // clients apart (never equal to a public key hash); zero if the address is unknown
+  AdnlNodeIdShort anonymous_id_;
 };
 
 class AdnlExtServerImpl : public AdnlExtServer {
@@ -101,13 +101,9 @@ td::Result<Ref<vm::Cell>> check_extract_state_proof(ton::BlockIdExt blkid, td::S
   }
 }
 
-td::Status check_shard_proof(ton::BlockIdExt blk, ton::BlockIdExt shard_blk, td::Slice shard_proof) {
-  if (blk == shard_blk) {
-    if (!shard_proof.empty()) {
-      LOG(WARNING) << "Unexpected non-empty shard proof";
-    }
-    return td::Status::OK();
-  }
+// the caller catches VmError and VmVirtError
+static td::Result<std::unique_ptr<vm::Dictionary>> check_extract_shard_hashes_dict(ton::BlockIdExt blk,
+                                                                                  td::Slice shard_proof) {
   if (!blk.is_masterchain() || !blk.is_valid_full()) {
     return td::Status::Error(PSLICE() << "reference block " << blk.to_str()
                                       << " for a getAccountState query must belong to the masterchain");
@@ -117,23 +113,34 @@ td::Status check_shard_proof(ton::BlockIdExt blk, ton::BlockIdExt shard_blk, td:
   if (P_roots.size() != 2) {
     return td::Status::Error("shard configuration proof must have exactly two roots");
   }
-  try {
-    auto mc_state_root = vm::MerkleProof::virtualize(std::move(P_roots[1]), 1);
-    if (mc_state_root.is_null()) {
-      return td::Status::Error("shard configuration proof is invalid");
-    }
-    ton::Bits256 mc_state_hash = mc_state_root->get_hash().bits();
-    TRY_STATUS_PREFIX(
-        check_block_header_proof(vm::MerkleProof::virtualize(std::move(P_roots[0]), 1), blk, &mc_state_hash, true),
-        "error in shard configuration block header proof :");
-    block::gen::ShardStateUnsplit::Record sstate;
-    if (!(tlb::unpack_cell(mc_state_root, sstate))) {
-      return td::Status::Error("cannot unpack masterchain state header");
-    }
-    auto shards_dict = block::ShardConfig::extract_shard_hashes_dict(std::move(mc_state_root));
-    if (!shards_dict) {
-      return td::Status::Error("cannot extract shard configuration dictionary from proof");
+  auto mc_state_root = vm::MerkleProof::virtualize(std::move(P_roots[1]), 1);
+  if (mc_state_root.is_null()) {
+    return td::Status::Error("shard configuration proof is invalid");
+  }
+  ton::Bits256 mc_state_hash = mc_state_root->get_hash().bits();
+  TRY_STATUS_PREFIX(
+      check_block_header_proof(vm::MerkleProof::virtualize(std::move(P_roots[0]), 1), blk, &mc_state_hash, true),
+      "error in shard configuration block header proof :");
+  block::gen::ShardStateUnsplit::Record sstate;
+  if (!(tlb::unpack_cell(mc_state_root, sstate))) {
+    return td::Status::Error("cannot unpack masterchain state header");
+  }
+  auto shards_dict = block::ShardConfig::extract_shard_hashes_dict(std::move(mc_state_root));
+  if (!shards_dict) {
+    return td::Status::Error("cannot extract shard configuration dictionary from proof");
+  }
+  return std::move(shards_dict);
+}
+
+td::Status check_shard_proof(ton::BlockIdExt blk, ton::BlockIdExt shard_blk, td::Slice shard_proof) {
+  if (blk == shard_blk) {
+    if (!shard_proof.empty()) {
+      LOG(WARNING) << "Unexpected non-empty shard proof";
     }
+    return td::Status::OK();
+  }
+  try {
+    TRY_RESULT(shards_dict, check_extract_shard_hashes_dict(blk, shard_proof));
     vm::CellSlice cs;
     ton::ShardIdFull true_shard;
     if (!block::ShardConfig::get_shard_hash_raw_from(*shards_dict, cs, shard_blk.shard_full(), true_shard)) {
@@ -158,58 +165,70 @@ td::Status check_shard_proof(ton::BlockIdExt blk, ton::BlockIdExt shard_blk, td:
   return td::Status::OK();
 }
 
-td::Status check_account_proof(td::Slice proof, ton::BlockIdExt shard_blk, const block::StdAddress& addr,
-                               td::Ref<vm::Cell> root, ton::LogicalTime* last_trans_lt, ton::Bits256* last_trans_hash,
-                               td::uint32* save_utime, ton::LogicalTime* save_lt) {
+static td::Status check_account_in_dict(vm::AugmentedDictionary& accounts_dict, const block::StdAddress& addr,
+                                        const td::Ref<vm::Cell>& root, ton::LogicalTime* last_trans_lt,
+                                        ton::Bits256* last_trans_hash) {
+  auto acc_csr = accounts_dict.lookup(addr.addr);
+  if (acc_csr.not_null()) {
+    if (root.is_null()) {
+      return td::Status::Error(PSLICE() << "account state proof shows that account state for " << addr
+                                        << " must be non-empty, but it actually is empty");
+    }
+    block::gen::ShardAccount::Record acc_info;
+    if (!tlb::csr_unpack(std::move(acc_csr), acc_info)) {
+      return td::Status::Error("cannot unpack ShardAccount from proof");
+    }
+    if (acc_info.account->get_hash().bits().compare(root->get_hash().bits(), 256)) {
+      return td::Status::Error(PSLICE() << "account state hash mismatch: Merkle proof expects "
+                                        << acc_info.account->get_hash().bits().to_hex(256)
+                                        << " but received data has " << root->get_hash().bits().to_hex(256));
+    }
+    if (last_trans_hash) {
+      *last_trans_hash = acc_info.last_trans_hash;
+    }
+    if (last_trans_lt) {
+      *last_trans_lt = acc_info.last_trans_lt;
+    }
+  } else if (root.not_null()) {
+    return td::Status::Error(PSLICE() << "account state proof shows that account state for " << addr
+                                      << " must be empty, but it is not");
+  }
+  return td::Status::OK();
+}
+
+static td::Result<vm::AugmentedDictionary> check_extract_accounts_dict(td::Slice proof, ton::BlockIdExt shard_blk,
+                                                                       td::uint32* save_utime,
+                                                                       ton::LogicalTime* save_lt) {
   TRY_RESULT_PREFIX(Q_roots, vm::std_boc_deserialize_multi(std::move(proof)), "cannot deserialize account proof");
   if (Q_roots.size() != 2) {
     return td::Status::Error(PSLICE() << "account state proof must have exactly two roots");
   }
+  auto state_root = vm::MerkleProof::virtualize(std::move(Q_roots[1]), 1);
+  if (state_root.is_null()) {
+    return td::Status::Error("account state proof is invalid");
+  }
+  ton::Bits256 state_hash = state_root->get_hash().bits();
+  TRY_STATUS_PREFIX(check_block_header_proof(vm::MerkleProof::virtualize(std::move(Q_roots[0]), 1), shard_blk,
+                                             &state_hash, true, save_utime, save_lt),
+                    "error in account shard block header proof : ");
+  block::gen::ShardStateUnsplit::Record sstate;
+  if (!(tlb::unpack_cell(std::move(state_root), sstate))) {
+    return td::Status::Error("cannot unpack state header");
+  }
+  return vm::AugmentedDictionary{vm::load_cell_slice(sstate.accounts).prefetch_ref(), 256,
+                                 block::tlb::aug_ShardAccounts};
+}
 
+td::Status check_account_proof(td::Slice proof, ton::BlockIdExt shard_blk, const block::StdAddress& addr,
+                               td::Ref<vm::Cell> root, ton::LogicalTime* last_trans_lt, ton::Bits256* last_trans_hash,
+                               td::uint32* save_utime, ton::LogicalTime* save_lt) {
   if (last_trans_lt) {
     last_trans_hash->set_zero();
   }
 
   try {
-    auto state_root = vm::MerkleProof::virtualize(std::move(Q_roots[1]), 1);
-    if (state_root.is_null()) {
-      return td::Status::Error("account state proof is invalid");
-    }
-    ton::Bits256 state_hash = state_root->get_hash().bits();
-    TRY_STATUS_PREFIX(check_block_header_proof(vm::MerkleProof::virtualize(std::move(Q_roots[0]), 1), shard_blk,
-                                               &state_hash, true, save_utime, save_lt),
-                      "error in account shard block header proof : ");
-    block::gen::ShardStateUnsplit::Record sstate;
-    if (!(tlb::unpack_cell(std::move(state_root), sstate))) {
-      return td::Status::Error("cannot unpack state header");
-    }
-    vm::AugmentedDictionary accounts_dict{vm::load_cell_slice(sstate.accounts).prefetch_ref(), 256,
-                                          block::tlb::aug_ShardAccounts};
-    auto acc_csr = accounts_dict.lookup(addr.addr);
-    if (acc_csr.not_null()) {
-      if (root.is_null()) {
-        return td::Status::Error(PSLICE() << "account state proof shows that account state for " << addr
-                                          << " must be non-empty, but it actually is empty");
-      }
-      block::gen::ShardAccount::Record acc_info;
-      if (!tlb::csr_unpack(std::move(acc_csr), acc_info)) {
-        return td::Status::Error("cannot unpack ShardAccount from proof");
-      }
-      if (acc_info.account->get_hash().bits().compare(root->get_hash().bits(), 256)) {
-        return td::Status::Error(PSLICE() << "account state hash mismatch: Merkle proof expects "
-                                          << acc_info.account->get_hash().bits().to_hex(256)
-                                          << " but received data has " << root->get_hash().bits().to_hex(256));
-      }
-      if (last_trans_hash) {
-        *last_trans_hash = acc_info.last_trans_hash;
-      }
-      if (last_trans_lt) {
-        *last_trans_lt = acc_info.last_trans_lt;
-      }
-    } else if (root.not_null()) {
-      return td::Status::Error(PSLICE() << "account state proof shows that account state for " << addr
-                                        << " must be empty, but it is not");
-    }
+    TRY_RESULT(accounts_dict, check_extract_accounts_dict(proof, shard_blk, save_utime, save_lt));
+    TRY_STATUS(check_account_in_dict(accounts_dict, addr, root, last_trans_lt, last_trans_hash));
   } catch (vm::VmError err) {
     return td::Status::Error(PSLICE() << "error while traversing account proof : " << err.get_msg());
   } catch (vm::VmVirtError err) {
@@ -256,6 +275,83 @@ td::Result<AccountState::Info> AccountState::validate(ton::BlockIdExt ref_blk, b
   return res;
 }
 
+// accounts of workchains that are absent from the shard configuration of the reference block
+static td::Result<std::vector<AccountState::Info>> check_unknown_shard_accounts(const AccountStates& answer) {
+  std::vector<AccountState::Info> res;
+  try {
+    TRY_RESULT(shards_dict, check_extract_shard_hashes_dict(answer.blk, answer.shard_proof.as_slice()));
+    for (auto& state : answer.states) {
+      auto& addr = state.first;
+      if (addr.workchain == ton::masterchainId || !state.second.empty()) {
+        return td::Status::Error(PSLICE() << "received account " << addr << " without a shard block");
+      }
+      vm::CellSlice cs;
+      ton::ShardIdFull true_shard;
+      if (block::ShardConfig::get_shard_hash_raw_from(*shards_dict, cs,
+                                                      ton::extract_addr_prefix(addr.workchain, addr.addr).as_leaf_shard(),
+                                                      true_shard, false)) {
+        return td::Status::Error(PSLICE() << "shard configuration proof shows that the shard of account " << addr
+                                          << " exists, but no shard block was given");
+      }
+      AccountState::Info info;
+      info.last_trans_hash.set_zero();
+      res.push_back(std::move(info));
+    }
+  } catch (vm::VmError err) {
+    return td::Status::Error(PSLICE() << "error while traversing shard configuration proof : " << err.get_msg());
+  } catch (vm::VmVirtError err) {
+    return td::Status::Error(PSLICE() << "virtualization error while traversing shard configuration proof : "
+                                      << err.get_msg());
+  }
+  return res;
+}
+
+td::Result<std::vector<AccountState::Info>> AccountStates::validate(ton::BlockIdExt ref_blk) const {
+  if (blk != ref_blk && ref_blk.id.seqno != ~0U) {
+    return td::Status::Error(PSLICE() << "obtained getAccountStates() for a different reference block " << blk.to_str()
+                                      << " instead of requested " << ref_blk.to_str());
+  }
+  if (!shard_blk.is_valid()) {
+    return check_unknown_shard_accounts(*this);
+  }
+  if (!shard_blk.is_valid_full()) {
+    return td::Status::Error(PSLICE() << "shard block id " << shard_blk.to_str() << " in answer is invalid");
+  }
+  for (auto& state : states) {
+    auto& addr = state.first;
+    if (!ton::shard_contains(shard_blk.shard_full(), ton::extract_addr_prefix(addr.workchain, addr.addr))) {
+      return td::Status::Error(PSLICE() << "received data from shard block " << shard_blk.to_str()
+                                        << " that cannot contain account " << addr);
+    }
+  }
+
+  TRY_STATUS(block::check_shard_proof(blk, shard_blk, shard_proof.as_slice()));
+
+  std::vector<AccountState::Info> res;
+  try {
+    td::uint32 gen_utime = 0;
+    ton::LogicalTime gen_lt = 0;
+    TRY_RESULT(accounts_dict, check_extract_accounts_dict(proof.as_slice(), shard_blk, &gen_utime, &gen_lt));
+    for (auto& state : states) {
+      TRY_RESULT_PREFIX(root, vm::std_boc_deserialize(state.second.as_slice(), true),
+                        "cannot deserialize account state");
+      AccountState::Info info;
+      info.last_trans_hash.set_zero();
+      TRY_STATUS(check_account_in_dict(accounts_dict, state.first, root, &info.last_trans_lt, &info.last_trans_hash));
+      info.gen_utime = gen_utime;
+      info.gen_lt = gen_lt;
+      info.root = root;
+      info.true_root = std::move(root);
+      res.push_back(std::move(info));
+    }
+  } catch (vm::VmError err) {
+    return td::Status::Error(PSLICE() << "error while traversing account proof : " << err.get_msg());
+  } catch (vm::VmVirtError err) {
+    return td::Status::Error(PSLICE() << "virtualization error while traversing account proof : " << err.get_msg());
+  }
+  return res;
+}
+
 td::Result<Transaction::Info> Transaction::validate() {
   if (root.is_null()) {
     return td::Status::Error("transactions are expected to be non-empty");
@@ -57,6 +57,19 @@ struct AccountState {
   td::Result<Info> validate(ton::BlockIdExt ref_blk, block::StdAddress addr) const;
 };
 
+// Several accounts of one shard block from a liteServer.getAccountStates answer, sharing shard_proof and proof
+struct AccountStates {
+  ton::BlockIdExt blk;
+  ton::BlockIdExt shard_blk;
+  td::BufferSlice shard_proof;
+  td::BufferSlice proof;
+  std::vector<std::pair<block::StdAddress, td::BufferSlice>> states;
+
+  // checks the proofs once and returns the information about each account in the order of states;
+  // an invalid shard_blk marks accounts of unknown workchains, their states are empty
+  td::Result<std::vector<AccountState::Info>> validate(ton::BlockIdExt ref_blk) const;
+};
+
 struct Transaction {
   ton::BlockIdExt blkid;
   ton::LogicalTime lt;
@@ -105,6 +105,84 @@ td::Result<std::unique_ptr<ConfigInfo>> ConfigInfo::extract_config(Ref<vm::Cell>
   return std::move(config);
 }
 
+class ConfigInfoCache {
+public:
+  std::shared_ptr<const ConfigInfo> get(const ton::BlockIdExt& block_id, int mode, const vm::CellHash& state_hash) {
+    std::lock_guard lock{mutex_};
+    auto it = cache_.find(std::make_pair(block_id, mode));
+    if (it == cache_.end() || it->second->state_hash != state_hash) {
+      return {};
+    }
+    auto entry = it->second.get();
+    entry->remove();
+    lru_.put(entry);
+    return entry->value;
+  }
+
+  void set(const ton::BlockIdExt& block_id, int mode, const vm::CellHash& state_hash,
+           std::shared_ptr<const ConfigInfo> config) {
+    std::lock_guard lock{mutex_};
+    auto key = std::make_pair(block_id, mode);
+    std::unique_ptr<CacheEntry>& entry = cache_[key];
+    if (entry == nullptr) {
+      entry = std::make_unique<CacheEntry>(key, state_hash, std::move(config));
+    } else {
+      entry->state_hash = state_hash;
+      entry->value = std::move(config);
+      entry->remove();
+    }
+    lru_.put(entry.get());
+    if (cache_.size() > MAX_CACHE_SIZE) {
+      auto to_remove = (CacheEntry*)lru_.get();
+      CHECK(to_remove);
+      to_remove->remove();
+      cache_.erase(to_remove->key);
+    }
+  }
+
+private:
+  using Key = std::pair<ton::BlockIdExt, int>;
+  std::mutex mutex_;
+
+  struct CacheEntry : td::ListNode {
+    CacheEntry(Key key, vm::CellHash state_hash, std::shared_ptr<const ConfigInfo> value)
+        : key(std::move(key)), state_hash(state_hash), value(std::move(value)) {
+    }
+    Key key;
+    vm::CellHash state_hash;
+    std::shared_ptr<const ConfigInfo> value;
+  };
+  std::map<Key, std::unique_ptr<CacheEntry>> cache_;
+  td::ListNode lru_;
+
+  // every entry keeps its masterchain state alive, so only the most recent states are kept
+  static constexpr size_t MAX_CACHE_SIZE = 16;
+};
+
+td::Result<std::shared_ptr<const ConfigInfo>> ConfigInfo::extract_config_cached(Ref<vm::Cell> mc_state_root,
+                                                                                ton::BlockIdExt mc_block_id,
+                                                                                int mode) {
+  if (mc_state_root.is_null()) {
+    return td::Status::Error("configuration state root cell is null");
+  }
+  TRY_RESULT(loaded_root, mc_state_root->load_cell());
+  if (!loaded_root.tree_node.empty() || mc_state_root->get_virtualization() != 0) {
+    // Do not use cache during Merkle proof generation or for states restored from proofs
+    TRY_RESULT(config, extract_config(std::move(mc_state_root), mc_block_id, mode));
+    return std::shared_ptr<const ConfigInfo>(std::move(config));
+  }
+  static ConfigInfoCache cache;
+  auto state_hash = mc_state_root->get_hash();
+  auto result = cache.get(mc_block_id, mode, state_hash);
+  if (result) {
+    return result;
+  }
+  TRY_RESULT(config, extract_config(std::move(mc_state_root), mc_block_id, mode));
+  std::shared_ptr<const ConfigInfo> ptr = std::move(config);
+  cache.set(mc_block_id, mode, state_hash, ptr);
+  return ptr;
+}
+
 ConfigInfo::ConfigInfo(Ref<vm::Cell> mc_state_root, int _mode) : Config(_mode), state_root(std::move(mc_state_root)) {
   block_id.root_hash.set_zero();
   block_id.file_hash.set_zero();
@@ -778,6 +778,11 @@ class ConfigInfo : public Config, public ShardConfig {
   td::Result<Ref<vm::Tuple>> get_prev_blocks_info() const;
   static td::Result<std::unique_ptr<ConfigInfo>> extract_config(Ref<vm::Cell> mc_state_root,
                                                                 ton::BlockIdExt mc_block_id, int mode = 0);
+  // Same as extract_config, but the result is taken from a process-wide cache keyed by the block id and mode.
+  // The returned object is shared between all callers.
+  static td::Result<std::shared_ptr<const ConfigInfo>> extract_config_cached(Ref<vm::Cell> mc_state_root,
+                                                                             ton::BlockIdExt mc_block_id,
+                                                                             int mode = 0);
 
  private:
   ConfigInfo(Ref<vm::Cell> mc_state_root, int _mode = 0);
@@ -17,6 +17,9 @@
     Copyright 2017-2020 Telegram Systems LLP
 */
 #include "output-queue-merger.h"
+#include "vm/db/DynamicBagOfCellsDb.h"
+#include "td/utils/misc.h"
+#include "td/utils/Timer.h"
 
 namespace block {
 
@@ -140,7 +143,8 @@ void OutputQueueMerger::add_root(int src, Ref<vm::Cell> outmsg_root, td::int32 m
   }
   auto kv = std::make_unique<MsgKeyValue>(src, std::move(outmsg_root));
   if (kv->replace_by_prefix(common_pfx.cbits(), common_pfx_len)) {
-    heap.push_back(std::move(kv));
+    enqueue_prefetch(*kv);
+    heap.push_back(HeapEntry{kv->lt, std::move(kv)});
   }
   if ((int)src_remaining_msgs_.size() < src + 1) {
     src_remaining_msgs_.resize(src + 1);
@@ -148,8 +152,76 @@ void OutputQueueMerger::add_root(int src, Ref<vm::Cell> outmsg_root, td::int32 m
   src_remaining_msgs_[src] = msg_limit;
 }
 
-OutputQueueMerger::OutputQueueMerger(ton::ShardIdFull queue_for, std::vector<OutputQueueMerger::Neighbor> neighbors)
-    : eof(false), failed(false) {
+void OutputQueueMerger::push_heap(std::unique_ptr<MsgKeyValue> kv) {
+  auto lt = kv->lt;
+  heap.push_back(HeapEntry{lt, std::move(kv)});
+  std::push_heap(heap.begin(), heap.end(), HeapEntry::greater);
+}
+
+void OutputQueueMerger::enqueue_prefetch(const MsgKeyValue& kv) {
+  if (cell_reader_ && kv.is_fork() && kv.msg.not_null()) {
+    for (unsigned i = 0; i < kv.msg->size_refs(); i++) {
+      prefetch_queue_.emplace_back(kv.source, kv.msg->prefetch_ref(i));
+    }
+  }
+}
+
+// Loads the unloaded nodes in prefetch_queue_ and their descendants up to prefetch_depth levels, one load_bulk
+// per neighbor and level. Errors are ignored: the cells will be loaded on demand.
+void OutputQueueMerger::prefetch() {
+  auto queue = std::move(prefetch_queue_);
+  prefetch_queue_.clear();
+  std::sort(queue.begin(), queue.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+  for (size_t l = 0; l < queue.size();) {
+    int src = queue[l].first;
+    size_t r = l;
+    std::vector<Ref<vm::Cell>> level;
+    for (; r < queue.size() && queue[r].first == src; r++) {
+      if (!queue[r].second->is_loaded() && level.size() < max_prefetch_batch) {
+        level.push_back(std::move(queue[r].second));
+      }
+    }
+    l = r;
+    auto& stats = stats_.at(src);
+    td::Timer timer;
+    for (int depth = 0; depth < prefetch_depth && !level.empty(); depth++) {
+      std::vector<vm::CellHash> hashes;
+      hashes.reserve(level.size());
+      for (const auto& cell : level) {
+        hashes.push_back(cell->get_hash());
+      }
+      auto hash_slices = td::transform(hashes, [](const vm::CellHash& hash) { return hash.as_slice(); });
+      auto r_cells = cell_reader_->load_bulk(hash_slices);
+      ++stats.prefetch_batches;
+      if (r_cells.is_error()) {
+        LOG(DEBUG) << "cannot prefetch output queue of neighbor #" << src << ": " << r_cells.error();
+        break;
+      }
+      auto cells = r_cells.move_as_ok();
+      std::vector<Ref<vm::Cell>> next_level;
+      for (size_t i = 0; i < cells.size(); i++) {
+        // not load_cell(): the nodes may be wrapped into UsageCells, and prefetching must not mark them as visited
+        auto data_cell = cells[i];
+        if (level[i]->set_data_cell(std::move(cells[i])).is_error()) {
+          continue;
+        }
+        ++stats.cells_prefetched;
+        for (unsigned j = 0; j < data_cell->size_refs(); j++) {
+          auto child = data_cell->get_ref(j);
+          if (!child->is_loaded() && next_level.size() < max_prefetch_batch) {
+            next_level.push_back(std::move(child));
+          }
+        }
+      }
+      level = std::move(next_level);
+    }
+    stats.prefetch_time += timer.elapsed();
+  }
+}
+
+OutputQueueMerger::OutputQueueMerger(ton::ShardIdFull queue_for, std::vector<OutputQueueMerger::Neighbor> neighbors,
+                                     std::shared_ptr<vm::CellDbReader> cell_reader)
+    : eof(false), failed(false), cell_reader_(std::move(cell_reader)), stats_(neighbors.size()) {
   common_pfx.bits().store_int(queue_for.workchain, 32);
   int l = queue_for.pfx_len();
   td::bitstring::bits_store_long_top(common_pfx.bits() + 32, queue_for.shard, l);
@@ -165,7 +237,7 @@ OutputQueueMerger::OutputQueueMerger(ton::ShardIdFull queue_for, std::vector<Out
       i++;
     }
   }
-  std::make_heap(heap.begin(), heap.end(), MsgKeyValue::greater);
+  std::make_heap(heap.begin(), heap.end(), HeapEntry::greater);
   eof = heap.empty();
   if (!eof) {
     load();
@@ -195,23 +267,32 @@ bool OutputQueueMerger::load() {
   if (heap.empty() || failed) {
     return false;
   }
-  unsigned long long lt = heap[0]->lt;
+  if (!prefetch_queue_.empty()) {
+    prefetch();
+  }
+  unsigned long long lt = heap[0].lt;
   std::size_t orig_size = msg_list.size();
   do {
     while (heap[0]->is_fork()) {
+      auto& stats = stats_.at(heap[0]->source);
+      ++stats.nodes_split;
+      for (unsigned i = 0; i < heap[0]->msg->size_refs(); i++) {
+        stats.cells_loaded += !heap[0]->msg->prefetch_ref(i)->is_loaded();
+      }
       auto other = std::make_unique<MsgKeyValue>();
       if (!heap[0]->split(*other)) {
         failed = true;
         return false;
       }
-      heap.push_back(std::move(other));
-      std::push_heap(heap.begin(), heap.end(), MsgKeyValue::greater);
+      enqueue_prefetch(*heap[0].kv);
+      enqueue_prefetch(*other);
+      push_heap(std::move(other));
     }
-    assert(heap[0]->lt == lt);
-    std::pop_heap(heap.begin(), heap.end(), MsgKeyValue::greater);
-    msg_list.push_back(std::move(heap.back()));
+    assert(heap[0].lt == lt);
+    std::pop_heap(heap.begin(), heap.end(), HeapEntry::greater);
+    msg_list.push_back(std::move(heap.back().kv));
     heap.pop_back();
-  } while (!heap.empty() && heap[0]->lt <= lt);
+  } while (!heap.empty() && heap[0].lt <= lt);
   std::sort(msg_list.begin() + orig_size, msg_list.end(), MsgKeyValue::less);
   for (size_t i = orig_size; i < msg_list.size(); ++i) {
     td::int32 &remaining = src_remaining_msgs_[msg_list[i]->source];
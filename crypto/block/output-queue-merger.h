@@ -21,6 +21,10 @@
 #include "vm/cells/CellSlice.h"
 #include "block/mc-config.h"
 
+namespace vm {
+class CellDbReader;
+}
+
 namespace block {
 using td::Ref;
 
@@ -67,24 +71,55 @@ struct OutputQueueMerger {
     }
   };
 
-  OutputQueueMerger(ton::ShardIdFull queue_for, std::vector<Neighbor> neighbors);
+  struct NeighborStats {
+    td::uint64 nodes_split{0};
+    td::uint64 cells_loaded{0};  // dictionary nodes loaded on demand, not by prefetching
+    td::uint64 cells_prefetched{0};
+    td::uint32 prefetch_batches{0};
+    double prefetch_time{0.0};
+  };
+
+  // If cell_reader is set, unloaded dictionary nodes are loaded ahead of time in batches with load_bulk
+  OutputQueueMerger(ton::ShardIdFull queue_for, std::vector<Neighbor> neighbors,
+                    std::shared_ptr<vm::CellDbReader> cell_reader = {});
   bool is_eof() const {
     return eof;
   }
   MsgKeyValue* cur();
   std::unique_ptr<MsgKeyValue> extract_cur();
   bool next();
+  const std::vector<NeighborStats>& get_neighbor_stats() const {
+    return stats_;
+  }
 
  private:
+  static constexpr int prefetch_depth = 3;
+  static constexpr size_t max_prefetch_batch = 1024;
+  struct HeapEntry {
+    ton::LogicalTime lt;  // copy of kv->lt, so that most comparisons do not dereference kv
+    std::unique_ptr<MsgKeyValue> kv;
+    MsgKeyValue* operator->() const {
+      return kv.get();
+    }
+    static bool greater(const HeapEntry& he1, const HeapEntry& he2) {
+      return he1.lt > he2.lt || (he1.lt == he2.lt && *he2.kv < *he1.kv);
+    }
+  };
   td::BitArray<32 + 64> common_pfx;
   int common_pfx_len;
-  std::vector<std::unique_ptr<MsgKeyValue>> heap;
+  std::vector<HeapEntry> heap;
   std::size_t pos{0};
   std::vector<td::int32> src_remaining_msgs_;
   bool eof;
   bool failed;
   bool limit_exceeded{false};
+  std::shared_ptr<vm::CellDbReader> cell_reader_;
+  std::vector<std::pair<int, Ref<vm::Cell>>> prefetch_queue_;  // (source, dictionary node)
+  std::vector<NeighborStats> stats_;
   void add_root(int src, Ref<vm::Cell> outmsg_root, td::int32 msg_limit);
+  void push_heap(std::unique_ptr<MsgKeyValue> kv);
+  void enqueue_prefetch(const MsgKeyValue& kv);
+  void prefetch();
   bool load();
 };
 
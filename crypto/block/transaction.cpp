@@ -1943,11 +1943,15 @@ bool Transaction::prepare_compute_phase(const ComputePhaseConfig& cfg) {
       }
     }
   }
+  // cells created by the VM are temporary except for the new data and the action list, which are copied out
+  // of the slabs below
+  vm::DataCellArena::Scope arena_scope;
   vm::VmState vm{new_code, cfg.global_version, std::move(stack), gas, 1, new_data, vm_log, compute_vm_libraries(cfg)};
   vm.set_max_data_depth(cfg.max_vm_data_depth);
   vm.set_c7(prepare_vm_c7(cfg));  // tuple with SmartContractInfo
   vm.set_chksig_always_succeed(cfg.ignore_chksig);
   vm.set_stop_on_accept_message(cfg.stop_on_accept_message);
+  vm.set_lazy_cell_hashes(cfg.lazy_cell_hashes);
   // vm.incr_stack_trace(1);    // enable stack dump after each step
 
   LOG(DEBUG) << "starting VM";
@@ -1985,8 +1989,8 @@ bool Transaction::prepare_compute_phase(const ComputePhaseConfig& cfg) {
     cp.vm_log = logger->get_log();
   }
   if (cp.success) {
-    cp.new_data = vm.get_committed_state().c4;  // c4 -> persistent data
-    cp.actions = vm.get_committed_state().c5;   // c5 -> action list
+    cp.new_data = vm::DataCell::copy_out_of_slabs(vm.get_committed_state().c4);  // c4 -> persistent data
+    cp.actions = vm::DataCell::copy_out_of_slabs(vm.get_committed_state().c5);   // c5 -> action list
     int out_act_num = output_actions_count(cp.actions);
     if (verbosity > 2) {
       FLOG(INFO) {
@@ -129,6 +129,7 @@ struct ComputePhaseConfig {
   SizeLimitsConfig size_limits;
   int vm_log_verbosity = 0;
   bool stop_on_accept_message = false;
+  bool lazy_cell_hashes = false;
   PrecompiledContractsConfig precompiled_contracts;
   bool dont_run_precompiled_ = false;
   bool allow_external_unfreeze{false};
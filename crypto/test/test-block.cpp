@@ -0,0 +1,257 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <vector>
+
+#include "block/block.h"
+#include "block/block-auto.h"
+#include "block/block-parse.h"
+#include "block/check-proof.h"
+#include "block/mc-config.h"
+#include "vm/boc.h"
+#include "vm/cells/MerkleProof.h"
+#include "vm/dict.h"
+
+#include "td/utils/tests.h"
+
+namespace {
+
+// a masterchain block with its state, built locally with only the fields the proof checks look at
+struct TestBlock {
+  ton::BlockIdExt id;
+  td::Ref<vm::Cell> root;
+  td::Ref<vm::Cell> state;
+};
+
+td::Ref<vm::Cell> make_account(ton::StdSmcAddress addr, ton::LogicalTime lt) {
+  vm::CellBuilder cb;
+  cb.store_long(1, 1);  // account$1
+  cb.store_long(0b100, 3).store_long(ton::masterchainId, 8).store_bits(addr.cbits(), 256);
+  cb.store_zeroes(3 + 3 + 3 + 32 + 1);  // storage_stat
+  cb.store_long(lt, 64);
+  cb.store_long(1, 4).store_long(lt & 0xff, 8).store_zeroes(1);  // balance
+  cb.store_zeroes(2);                                             // account_uninit$00
+  return cb.finalize();
+}
+
+td::Ref<vm::Cell> make_accounts(const std::vector<std::pair<ton::StdSmcAddress, ton::LogicalTime>>& accounts) {
+  vm::AugmentedDictionary dict{256, block::tlb::aug_ShardAccounts};
+  for (auto& account : accounts) {
+    vm::CellBuilder cb;
+    // account_descr$_ account:^Account last_trans_hash:bits256 last_trans_lt:uint64 = ShardAccount;
+    CHECK(cb.store_ref_bool(make_account(account.first, account.second)) && cb.store_bits_bool(account.first.cbits(), 256) &&
+          cb.store_long_bool(account.second, 64));
+    CHECK(dict.set_builder(account.first, cb));
+  }
+  vm::CellBuilder cb;
+  CHECK(std::move(dict).append_dict_to_bool(cb));
+  return cb.finalize();
+}
+
+td::Ref<vm::Cell> make_mc_state_extra() {
+  vm::CellBuilder aux;
+  // flags, validator_info, empty prev_blocks with KeyMaxLt, after_key_block, no last_key_block
+  aux.store_zeroes(16 + 65 + 1 + 65 + 1 + 1);
+  vm::CellBuilder cb;
+  cb.store_long(0xcc26, 16);
+  cb.store_zeroes(1);    // no shard_hashes
+  cb.store_zeroes(256);  // config_addr
+  cb.store_ref(vm::CellBuilder().finalize());
+  cb.store_ref(aux.finalize());
+  cb.store_zeroes(5);  // global_balance
+  return cb.finalize();
+}
+
+td::Ref<vm::Cell> make_state(td::uint32 seqno, td::Ref<vm::Cell> accounts) {
+  vm::CellBuilder aux;
+  // overload and underload history, total_balance, total_validator_fees, libraries, no master_ref
+  aux.store_zeroes(64 + 64 + 5 + 5 + 1 + 1);
+  vm::CellBuilder cb;
+  cb.store_long(0x9023afe2, 32).store_long(-239, 32);
+  CHECK(block::tlb::t_ShardIdent.pack(cb, ton::ShardIdFull(ton::masterchainId)));
+  cb.store_long(seqno, 32).store_long(0, 32).store_long(1000, 32).store_long(2000, 64).store_long(0, 32);
+  cb.store_ref(vm::CellBuilder().finalize());  // out_msg_queue_info
+  cb.store_zeroes(1);                          // before_split
+  cb.store_ref(std::move(accounts));
+  cb.store_ref(aux.finalize());
+  cb.store_ones(1).store_ref(make_mc_state_extra());
+  return cb.finalize();
+}
+
+TestBlock make_block(td::uint32 seqno, td::Ref<vm::Cell> accounts) {
+  TestBlock res;
+  res.state = make_state(seqno, std::move(accounts));
+  ton::BlockIdExt prev{ton::masterchainId, ton::shardIdAll, seqno - 1, td::Bits256::zero(), td::Bits256::zero()};
+  vm::CellBuilder info;
+  info.store_long(0x9bc7a987, 32).store_long(0, 32);
+  info.store_zeroes(8 + 8);  // flags of a masterchain block that is not a key block
+  info.store_long(seqno, 32).store_long(0, 32);
+  CHECK(block::tlb::t_ShardIdent.pack(info, ton::ShardIdFull(ton::masterchainId)));
+  info.store_long(1000, 32).store_long(1000, 64).store_long(2000, 64);
+  info.store_zeroes(32 * 4);
+  info.store_ref(block::tlb::t_ExtBlkRef.pack_cell(prev, 999));
+  vm::CellBuilder cb;
+  cb.store_long(0x11ef55aa, 32).store_long(-239, 32);
+  cb.store_ref(info.finalize());
+  cb.store_ref(vm::CellBuilder().finalize());  // value_flow
+  cb.store_ref(vm::CellBuilder::create_merkle_update(res.state, res.state));
+  cb.store_ref(vm::CellBuilder().finalize());  // extra
+  res.root = cb.finalize();
+  // the file hash is not covered by the proofs
+  res.id = ton::BlockIdExt{ton::masterchainId, ton::shardIdAll, seqno, res.root->get_hash().bits(),
+                           td::Bits256::ones()};
+  return res;
+}
+
+td::Ref<vm::Cell> make_header_proof(const TestBlock& block) {
+  vm::MerkleProofBuilder pb{block.root};
+  ton::Bits256 state_hash;
+  CHECK(block::check_block_header_proof(pb.root(), block.id, &state_hash).is_ok());
+  return pb.extract_proof().move_as_ok();
+}
+
+// proof of the accounts dictionary entries of addrs, as the liteserver builds it
+td::BufferSlice make_accounts_proof(const TestBlock& block, const std::vector<ton::StdSmcAddress>& addrs) {
+  vm::MerkleProofBuilder pb{block.state};
+  block::gen::ShardStateUnsplit::Record sstate;
+  CHECK(tlb::unpack_cell(pb.root(), sstate));
+  vm::AugmentedDictionary accounts_dict{vm::load_cell_slice_ref(sstate.accounts), 256, block::tlb::aug_ShardAccounts};
+  for (auto& addr : addrs) {
+    accounts_dict.lookup(addr);
+  }
+  return vm::std_boc_serialize_multi({make_header_proof(block), pb.extract_proof().move_as_ok()}).move_as_ok();
+}
+
+// proof that the shard configuration has no shards of the workchains of addrs
+td::BufferSlice make_shard_hashes_proof(const TestBlock& block, const std::vector<block::StdAddress>& addrs) {
+  vm::MerkleProofBuilder pb{block.state};
+  auto shards_dict = block::ShardConfig::extract_shard_hashes_dict(pb.root());
+  CHECK(shards_dict);
+  for (auto& addr : addrs) {
+    vm::CellSlice cs;
+    ton::ShardIdFull true_shard;
+    CHECK(!block::ShardConfig::get_shard_hash_raw_from(
+        *shards_dict, cs, ton::extract_addr_prefix(addr.workchain, addr.addr).as_leaf_shard(), true_shard, false));
+  }
+  return vm::std_boc_serialize_multi({make_header_proof(block), pb.extract_proof().move_as_ok()}).move_as_ok();
+}
+
+td::BufferSlice serialize(td::Ref<vm::Cell> cell) {
+  return vm::std_boc_serialize(std::move(cell)).move_as_ok();
+}
+
+ton::StdSmcAddress make_addr(unsigned char c) {
+  ton::StdSmcAddress addr;
+  addr.as_slice().fill(c);
+  return addr;
+}
+
+}  // namespace
+
+TEST(Block, account_states_validate) {
+  auto addr1 = make_addr(0x11), addr2 = make_addr(0x77), addr3 = make_addr(0xcc);
+  auto block = make_block(10, make_accounts({{addr1, 100}, {addr2, 200}}));
+
+  auto make_answer = [&]() {
+    block::AccountStates answer;
+    answer.blk = block.id;
+    answer.shard_blk = block.id;
+    answer.proof = make_accounts_proof(block, {addr1, addr2, addr3});
+    answer.states.emplace_back(block::StdAddress(ton::masterchainId, addr1), serialize(make_account(addr1, 100)));
+    answer.states.emplace_back(block::StdAddress(ton::masterchainId, addr2), serialize(make_account(addr2, 200)));
+    answer.states.emplace_back(block::StdAddress(ton::masterchainId, addr3), td::BufferSlice());
+    return answer;
+  };
+
+  auto r_infos = make_answer().validate(block.id);
+  ASSERT_TRUE(r_infos.is_ok());
+  auto infos = r_infos.move_as_ok();
+  ASSERT_EQ(3u, infos.size());
+  ASSERT_EQ(100u, infos[0].last_trans_lt);
+  ASSERT_EQ(addr1.to_hex(), infos[0].last_trans_hash.to_hex());
+  ASSERT_EQ(200u, infos[1].last_trans_lt);
+  ASSERT_TRUE(infos[1].root.not_null());
+  ASSERT_TRUE(infos[2].root.is_null());
+  ASSERT_EQ(1000u, infos[2].gen_utime);
+
+  // the answer must be for the requested block
+  ASSERT_TRUE(make_answer().validate(make_block(11, make_accounts({})).id).is_error());
+
+  // a state that does not match the proven dictionary
+  auto tampered_state = make_answer();
+  tampered_state.states[1].second = serialize(make_account(addr2, 201));
+  ASSERT_TRUE(tampered_state.validate(block.id).is_error());
+
+  // an absent account reported as present, and a present one as absent
+  auto tampered_absent = make_answer();
+  tampered_absent.states[2].second = serialize(make_account(addr3, 300));
+  ASSERT_TRUE(tampered_absent.validate(block.id).is_error());
+  tampered_absent = make_answer();
+  tampered_absent.states[0].second = td::BufferSlice();
+  ASSERT_TRUE(tampered_absent.validate(block.id).is_error());
+
+  // a proof of another state under the header of the requested block
+  auto other = make_block(10, make_accounts({{addr1, 100}}));
+  auto tampered_proof = make_answer();
+  vm::MerkleProofBuilder pb{other.state};
+  block::gen::ShardStateUnsplit::Record sstate;
+  ASSERT_TRUE(tlb::unpack_cell(pb.root(), sstate));
+  tampered_proof.proof =
+      vm::std_boc_serialize_multi({make_header_proof(block), pb.extract_proof().move_as_ok()}).move_as_ok();
+  ASSERT_TRUE(tampered_proof.validate(block.id).is_error());
+
+  // the proof of the other block
+  tampered_proof.proof = make_accounts_proof(other, {addr1, addr2, addr3});
+  ASSERT_TRUE(tampered_proof.validate(block.id).is_error());
+
+  // a proof that does not cover one of the accounts
+  auto partial_proof = make_answer();
+  partial_proof.proof = make_accounts_proof(block, {addr1, addr3});
+  ASSERT_TRUE(partial_proof.validate(block.id).is_error());
+
+  auto missing_proof = make_answer();
+  missing_proof.proof = td::BufferSlice();
+  ASSERT_TRUE(missing_proof.validate(block.id).is_error());
+}
+
+TEST(Block, account_states_validate_unknown_workchain) {
+  auto block = make_block(10, make_accounts({}));
+  block::StdAddress addr1(7, make_addr(0x11)), addr2(0x1234, make_addr(0x22));
+
+  block::AccountStates answer;
+  answer.blk = block.id;
+  answer.shard_proof = make_shard_hashes_proof(block, {addr1, addr2});
+  answer.states.emplace_back(addr1, td::BufferSlice());
+  answer.states.emplace_back(addr2, td::BufferSlice());
+  auto r_infos = answer.validate(block.id);
+  ASSERT_TRUE(r_infos.is_ok());
+  auto infos = r_infos.move_as_ok();
+  ASSERT_EQ(2u, infos.size());
+  ASSERT_TRUE(infos[0].root.is_null());
+  ASSERT_TRUE(infos[1].root.is_null());
+
+  // the state of an account without a shard block cannot be non-empty
+  answer.states[1].second = serialize(make_account(addr2.addr, 100));
+  ASSERT_TRUE(answer.validate(block.id).is_error());
+
+  // the masterchain always exists
+  answer.states[1] = {block::StdAddress(ton::masterchainId, make_addr(0x33)), td::BufferSlice()};
+  ASSERT_TRUE(answer.validate(block.id).is_error());
+
+  answer.states.resize(1);
+  answer.shard_proof = td::BufferSlice();
+  ASSERT_TRUE(answer.validate(block.id).is_error());
+}
@@ -26,6 +26,11 @@
 #include <cstdlib>
 #include <cmath>
 #include <chrono>
+#include <optional>
+#include <map>
+#include <set>
+#include <thread>
+#include <tuple>
 #include "common/refcnt.hpp"
 #include "common/bigint.hpp"
 #include "common/refint.h"
@@ -34,10 +39,18 @@
 #include "common/util.h"
 #include "vm/cells.h"
 #include "vm/cellslice.h"
+#include "vm/cells/MerkleUpdate.h"
+#include "vm/cells/PoolMonitor.h"
+#include "vm/cells/CellTreeSplit.h"
+#include "vm/boc.h"
+#include "vm/dict.h"
 
 #include "td/utils/tests.h"
 #include "td/utils/crypto.h"
 #include "td/utils/misc.h"
+#include "td/utils/Random.h"
+#include "td/utils/port/thread.h"
+#include "td/utils/Time.h"
 
 static std::stringstream create_ss() {
   std::stringstream ss;
@@ -837,3 +850,553 @@ TEST(Cells, benchmark_sequential_fetch) {
   ASSERT_TRUE(duration.count() < 3000000);  // Should complete in < 3 seconds
   REGRESSION_VERIFY(os.str());
 }
+
+TEST(Cells, benchmark_merkle_update_parallel) {
+  // Generates and applies a Merkle update of a large synthetic state serially and with extra threads,
+  // the results must be the same
+  os = create_ss();
+  const int accounts = 200000;
+  const int changed_accounts = 10000;
+  const size_t extra_threads = 3;
+
+  auto account_key = [](int i) {
+    td::Bits256 key;
+    td::sha256(td::Slice(reinterpret_cast<const char*>(&i), sizeof(i)), key.as_slice());
+    return key;
+  };
+  auto account_value = [](int i, int version) {
+    vm::CellBuilder account;
+    account.store_long(i, 64).store_long(version, 32).store_zeroes(512);
+    vm::CellBuilder cb;
+    cb.store_ref(account.finalize()).store_long(version, 64);
+    return vm::load_cell_slice_ref(cb.finalize());
+  };
+
+  vm::Dictionary dict{256};
+  for (int i = 0; i < accounts; i++) {
+    dict.set(account_key(i), account_value(i, 0));
+  }
+  auto old_root = dict.get_root_cell();
+
+  auto usage_tree = std::make_shared<vm::CellUsageTree>();
+  vm::Dictionary new_dict{vm::UsageCell::create(old_root, usage_tree->root_ptr()), 256};
+  for (int i = 0; i < changed_accounts; i++) {
+    int id = static_cast<int>((static_cast<long long>(i) * 7919) % accounts);
+    new_dict.set(account_key(id), account_value(id, 1));
+  }
+  auto new_root = new_dict.get_root_cell();
+
+  auto measure = [](const char* name, auto&& f) {
+    auto start = std::chrono::high_resolution_clock::now();
+    auto res = f();
+    auto end = std::chrono::high_resolution_clock::now();
+    LOG(INFO) << name << ": " << std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() << " us";
+    return res;
+  };
+  auto update = measure("generate", [&] {
+    return vm::MerkleUpdate::generate(vm::UsageCell::create(old_root, usage_tree->root_ptr()), new_root,
+                                      usage_tree.get());
+  });
+  auto update_parallel = measure("generate (parallel)", [&] {
+    return vm::MerkleUpdate::generate(old_root, new_root, usage_tree.get(), extra_threads);
+  });
+  ASSERT_TRUE(update.not_null());
+  ASSERT_TRUE(update_parallel.not_null());
+  ASSERT_EQ(update->get_hash(), update_parallel->get_hash());
+
+  auto applied = measure("apply", [&] { return vm::MerkleUpdate::apply(old_root, update); });
+  auto applied_parallel =
+      measure("apply (parallel)", [&] { return vm::MerkleUpdate::apply(old_root, update, extra_threads); });
+  ASSERT_TRUE(applied.not_null());
+  ASSERT_TRUE(applied_parallel.not_null());
+  ASSERT_EQ(new_root->get_hash(), applied->get_hash());
+  ASSERT_EQ(new_root->get_hash(), applied_parallel->get_hash());
+
+  // an update applied to another state fails in both modes
+  vm::Dictionary other_dict{256};
+  other_dict.set(account_key(0), account_value(0, 2));
+  ASSERT_TRUE(vm::MerkleUpdate::apply(other_dict.get_root_cell(), update, extra_threads).is_null());
+
+  os << "merkle_update_parallel: " << accounts << " accounts, " << changed_accounts << " changed, update "
+     << update->get_hash().to_hex() << std::endl;
+  REGRESSION_VERIFY(os.str());
+}
+
+TEST(Cells, benchmark_data_cell_arena) {
+  // Runs the same transaction-like workload with and without a DataCellArena scope and compares
+  // the number of allocations per transaction; cells copied out of the scope must stay valid
+  os = create_ss();
+  const int transactions = 2000;
+  const int updates_per_transaction = 20;
+
+  auto run_transaction = [&](int tx, vm::Dictionary& state) {
+    // intermediate versions of the account dictionary are dropped, only the final root survives
+    vm::Dictionary dict{state.get_root_cell(), 32};
+    for (int i = 0; i < updates_per_transaction; i++) {
+      vm::CellBuilder cb;
+      cb.store_long(tx, 32).store_long(i, 32).store_zeroes(256);
+      dict.set_builder(td::BitArray<32>(tx * updates_per_transaction + i).bits(), 32, cb);
+    }
+    return dict.get_root_cell();
+  };
+
+  auto measure = [&](bool use_arena) {
+    vm::PoolMonitor::reset_all_statistics();
+    vm::Dictionary state{32};
+    std::vector<td::Ref<vm::Cell>> survivors;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int tx = 0; tx < transactions; tx++) {
+      std::optional<vm::DataCellArena::Scope> scope;
+      if (use_arena) {
+        scope.emplace();
+      }
+      auto root = vm::DataCell::copy_out_of_slabs(run_transaction(tx, state));
+      state = vm::Dictionary{root, 32};
+      survivors.push_back(std::move(root));
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    auto stats = vm::DataCellArena::get_stats();
+    LOG(INFO) << (use_arena ? "arena: " : "heap: ")
+              << std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() << " us, "
+              << vm::PoolMonitor::get_compact_stats();
+    return std::make_pair(survivors.back()->get_hash(), stats.heap_cells + stats.slabs_allocated);
+  };
+
+  auto live_slabs_before = vm::DataCellArena::get_stats().live_slabs;
+  auto heap = measure(false);
+  auto arena = measure(true);
+  ASSERT_EQ(heap.first, arena.first);
+  ASSERT_TRUE(arena.second * 2 < heap.second);
+  // no slab outlives its scope
+  ASSERT_EQ(live_slabs_before, vm::DataCellArena::get_stats().live_slabs);
+
+  LOG(INFO) << "allocations per transaction " << heap.second / transactions << " -> "
+            << static_cast<double>(arena.second) / transactions;
+  // allocation counts depend on the size of DataCell on the platform, only the result is verified
+  os << "data_cell_arena: " << transactions << " transactions, root " << heap.first.to_hex() << std::endl;
+  REGRESSION_VERIFY(os.str());
+}
+
+TEST(Cells, data_cell_arena_slab_limit) {
+  // one surviving cell per slab pins all of them, no more than kMaxLiveSlabs slabs are started
+  auto stats_before = vm::DataCellArena::get_stats();
+  vm::DataCellArena::reset_stats();
+  std::vector<td::Ref<vm::Cell>> survivors;
+  {
+    vm::DataCellArena::Scope scope;
+    for (size_t i = 0; vm::DataCellArena::get_stats().slab_limit_hits == 0; i++) {
+      ASSERT_TRUE(i < (vm::DataCellArena::kMaxLiveSlabs + 1) * vm::DataCellArena::kSlabSize / 32);
+      vm::CellBuilder cb;
+      cb.store_long(i, 64);
+      auto cell = cb.finalize();
+      if (i % 64 == 0) {
+        survivors.push_back(std::move(cell));
+      }
+    }
+    auto stats = vm::DataCellArena::get_stats();
+    ASSERT_TRUE(stats.live_slabs <= vm::DataCellArena::kMaxLiveSlabs);
+    ASSERT_TRUE(stats.live_slabs >= vm::DataCellArena::kMaxLiveSlabs - stats_before.live_slabs - 1);
+    // cells are still created, on the heap
+    auto heap_cells = stats.heap_cells;
+    ASSERT_TRUE(vm::CellBuilder().store_long(1, 64).finalize().not_null());
+    ASSERT_EQ(heap_cells + 1, vm::DataCellArena::get_stats().heap_cells);
+  }
+  survivors.clear();
+  ASSERT_EQ(stats_before.live_slabs, vm::DataCellArena::get_stats().live_slabs);
+}
+
+TEST(Cells, data_cell_arena_copy_out) {
+  // a cell kept after its scope is copied out of the slabs and does not keep any of them alive;
+  // cells that are not in slabs are shared, deserialized cells never go to slabs
+  auto live_slabs_before = vm::DataCellArena::get_stats().live_slabs;
+  auto old_cell = vm::CellBuilder().store_long(1, 64).finalize();
+  td::Ref<vm::Cell> kept, deserialized;
+  vm::CellHash hash;
+  {
+    vm::DataCellArena::Scope scope;
+    auto leaf = vm::CellBuilder().store_long(2, 64).finalize();
+    auto root = vm::CellBuilder().store_long(3, 64).store_ref(leaf).store_ref(old_cell).store_ref(leaf).finalize();
+    ASSERT_TRUE(vm::DataCellArena::get_stats().live_slabs > live_slabs_before);
+    hash = root->get_hash();
+    kept = vm::DataCell::copy_out_of_slabs(root);
+    deserialized = vm::std_boc_deserialize(vm::std_boc_serialize(root).move_as_ok()).move_as_ok();
+  }
+  ASSERT_EQ(live_slabs_before, vm::DataCellArena::get_stats().live_slabs);
+  ASSERT_EQ(hash, kept->get_hash());
+  ASSERT_EQ(hash, deserialized->get_hash());
+  vm::CellSlice cs{vm::NoVm(), kept};
+  ASSERT_TRUE(cs.prefetch_ref(0).get() == cs.prefetch_ref(2).get());
+  ASSERT_TRUE(cs.prefetch_ref(1).get() == old_cell.get());
+}
+
+TEST(Cells, lazy_hashes) {
+  // Cells with lazily computed hashes must have the same hashes and depths as ordinary ones,
+  // also when they reference pruned branches and when hashes are requested from several threads
+  auto build = [](bool lazy) {
+    td::Random::Xorshift128plus rnd(123);
+    std::vector<td::Ref<vm::Cell>> cells;
+    for (int i = 0; i < 2000; i++) {
+      vm::CellBuilder cb;
+      cb.store_bits(td::Bits256::zero().bits(), static_cast<unsigned>(rnd() % 256)).store_long(i, 32);
+      auto refs = cells.empty() ? 0 : static_cast<int>(rnd() % 4);
+      for (int j = 0; j < refs; j++) {
+        auto ref = cells[rnd() % cells.size()];
+        if (ref->get_level() == 0 && rnd() % 8 == 0) {
+          ref = vm::CellBuilder::create_pruned_branch(ref, 1);
+        }
+        cb.store_ref(std::move(ref));
+      }
+      vm::DataCell::use_lazy_hashes = lazy;
+      cells.push_back(cb.finalize());
+      vm::DataCell::use_lazy_hashes = false;
+    }
+    return cells;
+  };
+  auto eager = build(false);
+  auto lazy = build(true);
+
+  std::vector<td::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&] {
+      for (size_t i = 0; i < lazy.size(); i++) {
+        for (td::uint32 level = 0; level <= vm::Cell::max_level; level++) {
+          CHECK(lazy[i]->get_hash(level) == eager[i]->get_hash(level));
+          CHECK(lazy[i]->get_depth(level) == eager[i]->get_depth(level));
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+namespace {
+
+// extra of a subtree is the sum of the first 64 bits of its values
+struct SumAugmentation : vm::dict::AugmentationData {
+  bool skip_extra(vm::CellSlice& cs) const override {
+    return cs.advance(64);
+  }
+  bool eval_leaf(vm::CellBuilder& cb, vm::CellSlice& val_cs) const override {
+    return cb.store_long_bool(val_cs.prefetch_ulong(64), 64);
+  }
+  bool eval_fork(vm::CellBuilder& cb, vm::CellSlice& left_cs, vm::CellSlice& right_cs) const override {
+    return cb.store_long_bool(left_cs.prefetch_ulong(64) + right_cs.prefetch_ulong(64), 64);
+  }
+  bool eval_empty(vm::CellBuilder& cb) const override {
+    return cb.store_long_bool(0, 64);
+  }
+};
+
+// keys with long shared prefixes, sparse keys and keys next to each other
+td::BitArray<32> random_dict_key(td::Random::Xorshift128plus& rnd) {
+  static const td::uint32 prefixes[] = {0, 0x12340000, 0x12350000, 0xffff0000};
+  td::uint32 key = rnd() % 4 == 0 ? static_cast<td::uint32>(rnd())
+                                  : prefixes[rnd() % 4] | static_cast<td::uint32>(rnd() % (rnd() % 2 ? 64 : 65536));
+  td::BitArray<32> res;
+  res.store_ulong(key);
+  return res;
+}
+
+td::Bits256 dict_root_hash(const vm::DictionaryFixed& dict) {
+  auto root = dict.get_root_cell();
+  return root.is_null() ? td::Bits256::zero() : td::Bits256{root->get_hash().bits()};
+}
+
+// a batch of updates to keys present in the dictionary and to new ones, without duplicates;
+// value 0 stands for deletion and is only chosen for present keys
+std::vector<std::pair<td::BitArray<32>, td::uint64>> random_dict_updates(td::Random::Xorshift128plus& rnd,
+                                                                       const std::set<td::BitArray<32>>& present) {
+  std::set<td::BitArray<32>> keys;
+  std::vector<std::pair<td::BitArray<32>, td::uint64>> updates;
+  auto count = rnd() % 4 == 0 ? rnd() % 4 : rnd() % 100;
+  for (size_t i = 0; i < count; i++) {
+    td::BitArray<32> key;
+    if (!present.empty() && rnd() % 2) {
+      auto it = present.lower_bound(random_dict_key(rnd));
+      key = it == present.end() ? *present.begin() : *it;
+    } else {
+      key = random_dict_key(rnd);
+    }
+    if (!keys.insert(key).second) {
+      continue;
+    }
+    td::uint64 value = present.count(key) && rnd() % 3 == 0 ? 0 : rnd() % 1000000 + 1;
+    updates.emplace_back(key, value);
+  }
+  return updates;
+}
+
+td::Ref<vm::CellBuilder> dict_value(td::uint64 value) {
+  td::Ref<vm::CellBuilder> cb{true};
+  cb.write().store_long(value, 64).store_long(value % 7, static_cast<unsigned>(value % 5));
+  return cb;
+}
+
+}  // namespace
+
+TEST(Cells, dict_multiset) {
+  // multiset must give the same dictionary as applying the updates one by one
+  td::Random::Xorshift128plus rnd(321);
+  for (int test = 0; test < 100; test++) {
+    vm::Dictionary dict{32};
+    vm::Dictionary expected{32};
+    std::set<td::BitArray<32>> present;
+    for (int round = 0; round < 10; round++) {
+      auto updates = random_dict_updates(rnd, present);
+      std::vector<std::pair<td::ConstBitPtr, td::Ref<vm::CellBuilder>>> batch;
+      for (auto& [key, value] : updates) {
+        if (value == 0) {
+          ASSERT_TRUE(expected.lookup_delete(key).not_null());
+          present.erase(key);
+          batch.emplace_back(key.cbits(), td::Ref<vm::CellBuilder>{});
+        } else {
+          ASSERT_TRUE(expected.set_builder(key, *dict_value(value)));
+          present.insert(key);
+          batch.emplace_back(key.cbits(), dict_value(value));
+        }
+      }
+      ASSERT_TRUE(dict.multiset(batch));
+      ASSERT_EQ(dict_root_hash(expected).to_hex(), dict_root_hash(dict).to_hex());
+    }
+    // deleting everything gives the empty dictionary
+    std::vector<std::pair<td::ConstBitPtr, td::Ref<vm::CellBuilder>>> batch;
+    for (auto& key : present) {
+      batch.emplace_back(key.cbits(), td::Ref<vm::CellBuilder>{});
+    }
+    ASSERT_TRUE(dict.multiset(batch));
+    ASSERT_TRUE(dict.is_empty());
+  }
+
+  vm::Dictionary dict{32};
+  auto key1 = random_dict_key(rnd);
+  auto key2 = random_dict_key(rnd);
+  std::vector<std::pair<td::ConstBitPtr, td::Ref<vm::CellBuilder>>> batch;
+  ASSERT_TRUE(dict.multiset(batch));
+  ASSERT_TRUE(dict.is_empty());
+  batch = {{key1.cbits(), dict_value(1)}, {key2.cbits(), dict_value(2)}, {key1.cbits(), dict_value(3)}};
+  ASSERT_TRUE(!dict.multiset(batch));
+  ASSERT_TRUE(dict.is_empty());
+  batch = {{key1.cbits(), td::Ref<vm::CellBuilder>{}}};
+  ASSERT_TRUE(!dict.multiset(batch));
+  ASSERT_TRUE(dict.is_empty());
+}
+
+TEST(Cells, augmented_dict_multiset) {
+  // same as dict_multiset, also checking that the root extra is the sum of all values
+  SumAugmentation aug;
+  td::Random::Xorshift128plus rnd(654);
+  for (int test = 0; test < 100; test++) {
+    vm::AugmentedDictionary dict{32, aug};
+    vm::AugmentedDictionary expected{32, aug};
+    std::map<td::BitArray<32>, td::uint64> values;
+    std::set<td::BitArray<32>> present;
+    for (int round = 0; round < 10; round++) {
+      auto updates = random_dict_updates(rnd, present);
+      std::vector<std::pair<td::ConstBitPtr, td::Ref<vm::CellSlice>>> batch;
+      for (auto& [key, value] : updates) {
+        if (value == 0) {
+          ASSERT_TRUE(expected.lookup_delete(key.cbits(), 32).not_null());
+          present.erase(key);
+          values.erase(key);
+          batch.emplace_back(key.cbits(), td::Ref<vm::CellSlice>{});
+        } else {
+          auto cs = vm::load_cell_slice_ref(dict_value(value).write().finalize());
+          ASSERT_TRUE(expected.set(key, cs));
+          present.insert(key);
+          values[key] = value;
+          batch.emplace_back(key.cbits(), std::move(cs));
+        }
+      }
+      ASSERT_TRUE(dict.multiset(batch));
+      ASSERT_EQ(dict_root_hash(expected).to_hex(), dict_root_hash(dict).to_hex());
+      td::uint64 sum = 0;
+      for (auto& [key, value] : values) {
+        sum += value;
+      }
+      ASSERT_EQ(sum, dict.get_root_extra()->prefetch_ulong(64));
+      ASSERT_TRUE(dict.validate_check_extra([](auto, auto, auto, auto) { return true; }));
+    }
+    std::vector<std::pair<td::ConstBitPtr, td::Ref<vm::CellSlice>>> batch;
+    for (auto& key : present) {
+      batch.emplace_back(key.cbits(), td::Ref<vm::CellSlice>{});
+    }
+    ASSERT_TRUE(dict.multiset(batch));
+    ASSERT_TRUE(dict.is_empty());
+    ASSERT_EQ(0u, dict.get_root_extra()->prefetch_ulong(64));
+  }
+
+  vm::AugmentedDictionary dict{32, aug};
+  auto key1 = random_dict_key(rnd);
+  auto key2 = random_dict_key(rnd);
+  auto value = vm::load_cell_slice_ref(dict_value(1).write().finalize());
+  std::vector<std::pair<td::ConstBitPtr, td::Ref<vm::CellSlice>>> batch;
+  ASSERT_TRUE(dict.multiset(batch));
+  ASSERT_TRUE(dict.is_empty());
+  batch = {{key1.cbits(), value}, {key2.cbits(), value}, {key1.cbits(), value}};
+  ASSERT_TRUE(!dict.multiset(batch));
+  ASSERT_TRUE(dict.is_empty());
+  batch = {{key1.cbits(), td::Ref<vm::CellSlice>{}}};
+  ASSERT_TRUE(!dict.multiset(batch));
+  ASSERT_TRUE(dict.is_empty());
+}
+
+TEST(Cells, parallel_run) {
+  // every task runs exactly once, and the threads of the pool are reused by later calls
+  for (size_t threads = 0; threads <= 4; threads++) {
+    for (size_t n : {0, 1, 2, 100}) {
+      std::vector<std::atomic<int>> runs(n);
+      vm::detail::parallel_run(n, [&](size_t i) { runs[i]++; }, threads);
+      for (auto& cnt : runs) {
+        ASSERT_EQ(1, cnt.load());
+      }
+    }
+  }
+
+  // an exception thrown by a task on any thread reaches the caller after all running tasks have finished
+  for (int test = 0; test < 100; test++) {
+    std::atomic<int> running{0};
+    bool caught = false;
+    try {
+      vm::detail::parallel_run(
+          64,
+          [&](size_t i) {
+            running++;
+            if (i == static_cast<size_t>(test % 64)) {
+              running--;
+              throw vm::VmError{vm::Excno::cell_und, "test"};
+            }
+            td::this_thread::yield();
+            running--;
+          },
+          4);
+    } catch (vm::VmError& e) {
+      caught = true;
+    }
+    ASSERT_TRUE(caught);
+    ASSERT_EQ(0, running.load());
+  }
+}
+
+TEST(Cells, parallel_run_ordered) {
+  // results are consumed in order on the calling thread, each after its task has finished
+  for (size_t threads = 0; threads <= 4; threads++) {
+    for (size_t n : {0, 1, 2, 100}) {
+      std::vector<std::atomic<int>> runs(n);
+      size_t consumed = 0;
+      ASSERT_TRUE(vm::detail::parallel_run_ordered(
+          n, [&](size_t i) { runs[i]++; },
+          [&](size_t i) {
+            ASSERT_EQ(consumed++, i);
+            ASSERT_EQ(1, runs[i].load());
+            return true;
+          },
+          threads));
+      ASSERT_EQ(n, consumed);
+    }
+  }
+
+  // the first result is consumed while the last task is still running on another thread
+  auto caller = std::this_thread::get_id();
+  std::atomic<bool> first_consumed{false};
+  ASSERT_TRUE(vm::detail::parallel_run_ordered(
+      8,
+      [&](size_t i) {
+        if (i == 7 && std::this_thread::get_id() != caller) {
+          auto deadline = td::Timestamp::in(10.0);
+          while (!first_consumed && !deadline.is_in_past()) {
+            td::this_thread::yield();
+          }
+          ASSERT_TRUE(first_consumed.load());
+        }
+      },
+      [&](size_t i) {
+        first_consumed = true;
+        return true;
+      },
+      4));
+
+  // when the consumer stops, nothing is consumed after it and false is returned
+  for (size_t threads = 0; threads <= 4; threads++) {
+    size_t consumed = 0;
+    ASSERT_TRUE(!vm::detail::parallel_run_ordered(
+        100, [&](size_t i) {}, [&](size_t i) { return ++consumed < 10; }, threads));
+    ASSERT_EQ(10u, consumed);
+  }
+}
+
+TEST(Cells, dict_scan_diff_batched) {
+  // scan_diff_batched must report the same differences in the same order as scan_diff,
+  // for any number of threads and batch size, and must stop when the callback asks to
+  using Diff = std::tuple<std::string, std::string, std::string>;
+  auto value_hash = [](const td::Ref<vm::CellSlice>& cs) {
+    return cs.is_null() ? std::string() : vm::CellBuilder().append_cellslice(cs).finalize()->get_hash().to_hex();
+  };
+  auto make_diff = [&](td::ConstBitPtr key, const td::Ref<vm::CellSlice>& old_value,
+                       const td::Ref<vm::CellSlice>& new_value) {
+    return Diff{key.to_hex(32), value_hash(old_value), value_hash(new_value)};
+  };
+
+  td::Random::Xorshift128plus rnd(987);
+  for (int test = 0; test < 100; test++) {
+    vm::Dictionary dict1{32};
+    std::set<td::BitArray<32>> present;
+    auto size = rnd() % 4 == 0 ? rnd() % 3 : rnd() % 2000;
+    for (size_t i = 0; i < size; i++) {
+      auto key = random_dict_key(rnd);
+      dict1.set_builder(key, *dict_value(rnd() % 1000 + 1));
+      present.insert(key);
+    }
+    vm::Dictionary dict2{dict1.get_root_cell(), 32};
+    for (auto& [key, value] : random_dict_updates(rnd, present)) {
+      if (value == 0) {
+        dict2.lookup_delete(key);
+      } else {
+        dict2.set_builder(key, *dict_value(value));
+      }
+    }
+
+    std::vector<Diff> expected;
+    ASSERT_TRUE(dict1.scan_diff(dict2, [&](td::ConstBitPtr key, int key_len, td::Ref<vm::CellSlice> old_value,
+                                           td::Ref<vm::CellSlice> new_value) {
+      expected.push_back(make_diff(key, old_value, new_value));
+      return true;
+    }));
+
+    for (size_t threads : {0, 3}) {
+      for (size_t batch_size : {1, 7, 1024}) {
+        std::vector<Diff> diffs;
+        ASSERT_TRUE(dict1.scan_diff_batched(
+            dict2,
+            [&](const vm::ScanDiffBatch& batch) {
+              ASSERT_TRUE(batch.size() > 0 && batch.size() <= batch_size);
+              for (size_t i = 0; i < batch.size(); i++) {
+                diffs.push_back(make_diff(batch.key(i), batch.values[i].first, batch.values[i].second));
+              }
+              return true;
+            },
+            0, threads, batch_size));
+        ASSERT_TRUE(diffs == expected);
+
+        if (expected.empty()) {
+          continue;
+        }
+        // stop at a random difference: everything delivered so far is a prefix of the full list
+        size_t stop_at = rnd() % expected.size();
+        diffs.clear();
+        ASSERT_TRUE(!dict1.scan_diff_batched(
+            dict2,
+            [&](const vm::ScanDiffBatch& batch) {
+              for (size_t i = 0; i < batch.size(); i++) {
+                diffs.push_back(make_diff(batch.key(i), batch.values[i].first, batch.values[i].second));
+              }
+              return diffs.size() <= stop_at;
+            },
+            0, threads, batch_size));
+        ASSERT_TRUE(diffs.size() > stop_at && diffs.size() <= stop_at + batch_size);
+        ASSERT_TRUE(std::equal(diffs.begin(), diffs.end(), expected.begin()));
+      }
+    }
+  }
+}
@@ -41,6 +41,7 @@
 #include "td/utils/tests.h"
 #include "td/utils/tl_parsers.h"
 #include "td/utils/tl_helpers.h"
+#include "td/utils/port/Stat.h"
 
 #include "td/db/utils/BlobView.h"
 #include "td/db/RocksDb.h"
@@ -954,7 +955,7 @@ TEST(TonDb, BocMultipleRoots) {
   }
 };
 
-TEST(TonDb, InMemoryDynamicBocSimple) {
+void test_in_memory_dynamic_boc_simple(DynamicBagOfCellsDb::CreateInMemoryOptions options) {
   auto counter = [] { return td::NamedThreadSafeCounter::get_default().get_counter("DataCell").sum(); };
   auto before = counter();
   SCOPE_EXIT {
@@ -964,7 +965,7 @@ TEST(TonDb, InMemoryDynamicBocSimple) {
   auto kv = std::make_shared<td::MemoryKeyValue>();
   CellStorer storer(*kv);
 
-  auto boc = DynamicBagOfCellsDb::create_in_memory(kv.get(), {});
+  auto boc = DynamicBagOfCellsDb::create_in_memory(kv.get(), options);
 
   auto empty_cell = vm::CellBuilder().finalize();
   boc->inc(empty_cell);
@@ -981,7 +982,7 @@ TEST(TonDb, InMemoryDynamicBocSimple) {
   boc->commit(storer).ensure();
   auto got_one_ref_cell = boc->load_cell(one_ref_cell->get_hash().as_slice()).move_as_ok();
   ASSERT_EQ(one_ref_cell->get_hash(), got_one_ref_cell->get_hash());
-  boc = DynamicBagOfCellsDb::create_in_memory(kv.get(), {});
+  boc = DynamicBagOfCellsDb::create_in_memory(kv.get(), options);
 
   auto random_ref_cell = gen_random_cell(3, rnd);
   boc->inc(random_ref_cell);
@@ -989,7 +990,12 @@ TEST(TonDb, InMemoryDynamicBocSimple) {
   boc->commit(storer).ensure();
   auto got_random_ref_cell = boc->load_cell(random_ref_cell->get_hash().as_slice()).move_as_ok();
   ASSERT_EQ(random_ref_cell->get_hash(), got_random_ref_cell->get_hash());
-  boc = DynamicBagOfCellsDb::create_in_memory(kv.get(), {});
+  boc = DynamicBagOfCellsDb::create_in_memory(kv.get(), options);
+}
+
+TEST(TonDb, InMemoryDynamicBocSimple) {
+  test_in_memory_dynamic_boc_simple({});
+  test_in_memory_dynamic_boc_simple({.compact = true});
 }
 
 int VERBOSITY_NAME(boc) = VERBOSITY_NAME(DEBUG) + 10;
@@ -1247,7 +1253,8 @@ struct BocOptions {
                               },
                               [&](const CreateInMemoryOptions &options) {
                                 sb << "InMemory(use_arena=" << options.use_arena
-                                   << ", less_memory=" << options.use_less_memory_during_creation << ")";
+                                   << ", less_memory=" << options.use_less_memory_during_creation
+                                   << ", compact=" << options.compact << ")";
                               }),
                options);
     sb << kv_options;
@@ -1347,6 +1354,12 @@ void with_all_boc_options(F &&f, size_t tests_n, bool single_thread = false) {
                                                                   .use_less_memory_during_creation = less_memory}});
             }
           }
+          run({.async_executor = executor,
+               .kv_options = kv_options,
+               .options =
+                   DynamicBagOfCellsDb::CreateInMemoryOptions{.extra_threads = std::thread::hardware_concurrency(),
+                                                              .verbose = false,
+                                                              .compact = true}});
         }
       }
     }
@@ -1989,6 +2002,58 @@ TEST(TonDb, BenchDynamicBocGetAndSet) {
   with_all_boc_options(bench_dboc_get_and_set, 1);
 }
 
+TEST(TonDb, BenchInMemoryCompact) {
+  auto kv = std::make_shared<td::MemoryKeyValue>(std::make_shared<CellMerger>());
+  CellStorer storer(*kv);
+  td::Random::Xorshift128plus rnd{123};
+  std::vector<vm::CellHash> hashes;
+  {
+    auto boc = DynamicBagOfCellsDb::create_in_memory(kv.get(), {.verbose = false});
+    std::vector<Ref<Cell>> cells;
+    for (size_t i = 0; i < (1 << 20); i++) {
+      cells.push_back(vm::CellBuilder().store_long(rnd(), 64).store_long(rnd(), 64).finalize());
+    }
+    while (cells.size() > 1) {
+      std::vector<Ref<Cell>> parents;
+      for (size_t i = 0; i < cells.size(); i += 4) {
+        vm::CellBuilder cb;
+        cb.store_long(rnd(), 32);
+        for (size_t j = i; j < std::min(cells.size(), i + 4); j++) {
+          cb.store_ref(cells[j]);
+          hashes.push_back(cells[j]->get_hash());
+        }
+        parents.push_back(cb.finalize());
+      }
+      cells = std::move(parents);
+    }
+    boc->inc(cells[0]);
+    boc->prepare_commit().ensure();
+    boc->commit(storer).ensure();
+  }
+
+  for (bool compact : {false, true}) {
+    auto resident_size = [] {
+      auto r_mem_stat = td::mem_stat();
+      return r_mem_stat.is_ok() ? r_mem_stat.ok().resident_size_ : 0;
+    };
+    auto memory_before = resident_size();
+    td::Timer timer;
+    auto boc = DynamicBagOfCellsDb::create_in_memory(kv.get(), {.verbose = false, .compact = compact});
+    auto create_time = timer.elapsed();
+    auto memory_used = resident_size() - memory_before;
+
+    size_t loads_n = 1 << 20;
+    timer = td::Timer();
+    for (size_t i = 0; i < loads_n; i++) {
+      boc->load_cell(hashes[rnd() % hashes.size()].as_slice()).ensure();
+    }
+    auto load_time = timer.elapsed();
+    LOG(ERROR) << "compact=" << compact << " cells=" << hashes.size() + 1 << " created in " << create_time
+               << "s, memory_used=" << td::format::as_size(memory_used)
+               << ", load_cell=" << load_time * 1e9 / static_cast<double>(loads_n) << "ns";
+  }
+}
+
 TEST(TonDb, DynamicBocIncSimple) {
   auto kv = std::make_shared<td::MemoryKeyValue>(std::make_shared<CellMerger>());
   auto db = DynamicBagOfCellsDb::create_v2({.extra_threads = 0});
@@ -91,6 +91,8 @@ td::Result<Ref<DataCell>> CellSerializationInfo::create_data_cell(td::Slice cell
                                                                   td::Span<Ref<Cell>> refs) const {
   DCHECK(refs_cnt == (td::int64)refs.size());
   TRY_RESULT(bits, get_bits(cell_slice));
+  // deserialized cells (bags of cells, the cell db) are long-lived, they must not pin arena slabs
+  DataCellArena::Pause arena_pause;
   TRY_RESULT(res, DataCell::create(cell_slice.substr(data_offset), bits, refs, special));
   CHECK(!res.is_null());
   if (res->is_special() != special) {
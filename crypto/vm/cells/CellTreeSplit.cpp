@@ -0,0 +1,224 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "vm/cells/CellTreeSplit.h"
+
+#include "td/utils/port/thread.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+
+namespace vm {
+namespace detail {
+
+namespace {
+
+struct ParallelJob {
+  ParallelJob(size_t n, const std::function<void(size_t)> &run_task, bool track_done = false)
+      : n(n), run_task(run_task), done(track_done ? n : 0, false) {
+  }
+
+  const size_t n;
+  const std::function<void(size_t)> &run_task;
+  std::atomic<size_t> next_task_id{0};
+  std::atomic<bool> failed{false};
+  std::exception_ptr error;
+  size_t helpers_running{0};
+  std::mutex mutex;
+  std::condition_variable helpers_done;
+  // finished tasks, only for parallel_run_ordered
+  std::vector<bool> done;
+  std::condition_variable task_done;
+
+  // Takes and runs one task, returns false if there are none left. A helper that comes after the last task
+  // was taken calls nothing, so the job may outlive run_task
+  bool work_one() {
+    if (failed) {
+      return false;
+    }
+    auto task_id = next_task_id++;
+    if (task_id >= n) {
+      return false;
+    }
+    try {
+      run_task(task_id);
+    } catch (...) {
+      std::lock_guard<std::mutex> guard(mutex);
+      if (!error) {
+        error = std::current_exception();
+      }
+      failed = true;
+    }
+    if (!done.empty()) {
+      std::lock_guard<std::mutex> guard(mutex);
+      done[task_id] = true;
+      task_done.notify_all();
+    }
+    return true;
+  }
+
+  void work() {
+    while (work_one()) {
+    }
+  }
+
+  // Runs other tasks while task_id is not finished, returns false if the job failed
+  bool wait_task(size_t task_id) {
+    while (true) {
+      {
+        std::lock_guard<std::mutex> guard(mutex);
+        if (failed) {
+          return false;
+        }
+        if (done[task_id]) {
+          return true;
+        }
+      }
+      if (!work_one()) {
+        std::unique_lock<std::mutex> lock(mutex);
+        task_done.wait(lock, [&] { return failed || done[task_id]; });
+      }
+    }
+  }
+
+  void help() {
+    {
+      std::lock_guard<std::mutex> guard(mutex);
+      helpers_running++;
+    }
+    work();
+    std::lock_guard<std::mutex> guard(mutex);
+    if (--helpers_running == 0) {
+      helpers_done.notify_all();
+    }
+  }
+
+  void wait_helpers() {
+    std::unique_lock<std::mutex> lock(mutex);
+    helpers_done.wait(lock, [&] { return helpers_running == 0; });
+  }
+};
+
+// Threads are started on demand and are never stopped, so the tree splitting code does not pay for thread
+// creation on every call
+class ParallelRunPool {
+ public:
+  static ParallelRunPool &instance() {
+    static auto *pool = new ParallelRunPool();
+    return *pool;
+  }
+
+  void add(const std::shared_ptr<ParallelJob> &job, size_t helpers) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    for (size_t i = 0; i < helpers; i++) {
+      queue_.push_back(job);
+    }
+    while (idle_threads_ + starting_threads_ < queue_.size() && threads_.size() < max_threads_) {
+      // NB: it could be important that td::thread is used, not std::thread
+      starting_threads_++;
+      threads_.emplace_back([this] { loop(); });
+    }
+    cond_.notify_all();
+  }
+
+  // drops the requests for helpers that no thread has taken yet
+  void remove(const std::shared_ptr<ParallelJob> &job) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    queue_.erase(std::remove(queue_.begin(), queue_.end(), job), queue_.end());
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::deque<std::shared_ptr<ParallelJob>> queue_;
+  std::vector<td::thread> threads_;
+  size_t idle_threads_{0};
+  size_t starting_threads_{0};
+  const size_t max_threads_ = std::max<size_t>(td::thread::hardware_concurrency(), 1);
+
+  void loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    starting_threads_--;
+    while (true) {
+      idle_threads_++;
+      cond_.wait(lock, [&] { return !queue_.empty(); });
+      idle_threads_--;
+      auto job = std::move(queue_.front());
+      queue_.pop_front();
+      lock.unlock();
+      job->help();
+      job.reset();
+      lock.lock();
+    }
+  }
+};
+
+}  // namespace
+
+void parallel_run(size_t n, const std::function<void(size_t)> &run_task, size_t extra_threads_n) {
+  auto job = std::make_shared<ParallelJob>(n, run_task);
+  extra_threads_n = std::min(extra_threads_n, n == 0 ? 0 : n - 1);
+  if (extra_threads_n > 0) {
+    ParallelRunPool::instance().add(job, extra_threads_n);
+  }
+  job->work();
+  if (extra_threads_n > 0) {
+    ParallelRunPool::instance().remove(job);
+    job->wait_helpers();
+  }
+  if (job->error) {
+    std::rethrow_exception(job->error);
+  }
+}
+
+bool parallel_run_ordered(size_t n, const std::function<void(size_t)> &run_task,
+                          const std::function<bool(size_t)> &consume, size_t extra_threads_n) {
+  auto job = std::make_shared<ParallelJob>(n, run_task, true);
+  extra_threads_n = std::min(extra_threads_n, n == 0 ? 0 : n - 1);
+  if (extra_threads_n > 0) {
+    ParallelRunPool::instance().add(job, extra_threads_n);
+  }
+  bool ok = true;
+  std::exception_ptr consume_error;
+  try {
+    for (size_t i = 0; i < n && ok && job->wait_task(i); i++) {
+      ok = consume(i);
+    }
+  } catch (...) {
+    consume_error = std::current_exception();
+  }
+  // the tasks not started yet are not needed anymore
+  job->failed = true;
+  if (extra_threads_n > 0) {
+    ParallelRunPool::instance().remove(job);
+    job->wait_helpers();
+  }
+  if (consume_error) {
+    std::rethrow_exception(consume_error);
+  }
+  if (job->error) {
+    std::rethrow_exception(job->error);
+  }
+  return ok;
+}
+
+}  // namespace detail
+}  // namespace vm
@@ -0,0 +1,62 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace vm {
+namespace detail {
+
+// Runs run_task(0), ..., run_task(n - 1) on the current thread and up to extra_threads_n threads of a pool
+// shared by all callers. If a task throws, the tasks not started yet are skipped and the first exception is
+// rethrown here once no other task of this call is running.
+void parallel_run(size_t n, const std::function<void(size_t)> &run_task, size_t extra_threads_n);
+
+// Like parallel_run, but also calls consume(0), ..., consume(n - 1) on the current thread, each as soon as
+// its task is finished, while the other tasks are still running. If consume returns false, the tasks not
+// started yet are skipped and false is returned.
+bool parallel_run_ordered(size_t n, const std::function<void(size_t)> &run_task,
+                          const std::function<bool(size_t)> &consume, size_t extra_threads_n);
+
+// Expands the top levels of a cell tree breadth-first until there are at least min_tasks independent subtrees.
+// expand(node, children) either appends the children of node and returns true, or returns false for a node
+// that cannot be expanded, which is then kept as a subtree itself. In a shard state almost all subtrees
+// come from the forks of the ShardAccounts dictionary.
+template <class T, class F>
+std::vector<T> split_cell_tree(T root, size_t min_tasks, F &&expand) {
+  constexpr int max_split_depth = 24;
+  std::vector<T> res;
+  std::vector<T> level;
+  level.push_back(std::move(root));
+  for (int depth = 0; depth < max_split_depth && !level.empty() && res.size() + level.size() < min_tasks; depth++) {
+    std::vector<T> next_level;
+    for (auto &node : level) {
+      if (!expand(node, next_level)) {
+        res.push_back(std::move(node));
+      }
+    }
+    level = std::move(next_level);
+  }
+  for (auto &node : level) {
+    res.push_back(std::move(node));
+  }
+  return res;
+}
+
+}  // namespace detail
+}  // namespace vm
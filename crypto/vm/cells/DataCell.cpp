@@ -20,6 +20,9 @@
 #include "openssl/digest.hpp"
 #include "vm/cells/DataCell.h"
 
+#include <map>
+#include <thread>
+
 namespace vm {
 
 namespace {
@@ -34,7 +37,8 @@ class CellChecker {
       , bit_length_(bit_length) {
   }
 
-  td::Status check_and_compute_level_info() {
+  // with compute_hashes=false only the checks, level mask, depths and virtualization are computed
+  td::Status check_and_compute_level_info(bool compute_hashes = true) {
     // First, we figure out what is the type of the cell.
     type_ = Cell::SpecialType::Ordinary;
 
@@ -82,6 +86,9 @@ class CellChecker {
     if (virtualization_ > std::numeric_limits<td::uint8>::max()) {
       return td::Status::Error("Virtualization is too big to be stored in vm::DataCell");
     }
+    if (!compute_hashes) {
+      return {};
+    }
 
     // And finally, we compute cell hashes.
     // NOTE: Hash computation algorithm is not described correctly (or at all) in the documentation.
@@ -335,6 +342,7 @@ char* allocate_in_arena(size_t size) {
 }  // namespace
 
 thread_local bool DataCell::use_arena = false;
+thread_local bool DataCell::use_lazy_hashes = false;
 
 td::Result<Ref<DataCell>> DataCell::create(td::Slice data, int bit_length, td::Span<Ref<Cell>> refs, bool is_special) {
   CHECK(bit_length >= 0 && data.size() * 8 >= static_cast<size_t>(bit_length));
@@ -345,15 +353,27 @@ td::Result<Ref<DataCell>> DataCell::create(td::Slice data, int bit_length, td::S
     return td::Status::Error("Too many data bits");
   }
 
+  // hashes of special cells are checked against their contents, so they are always computed at once
+  bool lazy_hash = use_lazy_hashes && !is_special;
   CellChecker checker{is_special, data, bit_length, refs};
-  TRY_STATUS(checker.check_and_compute_level_info());
+  TRY_STATUS(checker.check_and_compute_level_info(!lazy_hash));
 
   auto level_info_size = sizeof(detail::LevelInfo) * (checker.level_mask().get_level() + 1);
-  auto cell_size = sizeof(DataCell) + level_info_size + (bit_length + 7) / 8;
-
-  void* storage = use_arena ? allocate_in_arena(cell_size) : ::operator new(cell_size);
+  auto cell_size = sizeof(DataCell) + level_info_size + (bit_length + 7) / 8 + (lazy_hash ? 1 : 0);
+
+  void* storage = nullptr;
+  auto allocation = Allocation::Heap;
+  if (use_arena) {
+    storage = allocate_in_arena(cell_size);
+    allocation = Allocation::PermanentArena;
+  } else if ((storage = DataCellArena::allocate(cell_size)) != nullptr) {
+    allocation = Allocation::Slab;
+  } else {
+    storage = ::operator new(cell_size);
+    DataCellArena::on_heap_allocation();
+  }
   DataCell* allocated_cell = new (storage)
-      DataCell{bit_length, refs.size(), checker.type(), checker.level_mask(), use_arena, checker.virtualization()};
+      DataCell{bit_length, refs.size(), checker.type(), checker.level_mask(), allocation, checker.virtualization()};
   auto& cell = *allocated_cell;
 
   auto mutable_data = cell.trailer_ + level_info_size;
@@ -376,6 +396,11 @@ td::Result<Ref<DataCell>> DataCell::create(td::Slice data, int bit_length, td::S
     };
   }
 
+  if (lazy_hash) {
+    cell.lazy_hash_ = true;
+    new (mutable_data + (bit_length + 7) / 8) std::atomic<td::uint8>{HashPending};
+  }
+
   for (int i = 0; i < cell.refs_cnt_; ++i) {
     cell.refs_[i] = refs[i];
   }
@@ -383,6 +408,61 @@ td::Result<Ref<DataCell>> DataCell::create(td::Slice data, int bit_length, td::S
   return Ref{allocated_cell, Ref<DataCell>::acquire_t{}};
 }
 
+namespace {
+
+Ref<Cell> copy_out_of_slabs_impl(const Ref<Cell>& cell, std::map<const Cell*, Ref<Cell>>& copies) {
+  auto data_cell = dynamic_cast<const DataCell*>(cell.get());
+  if (data_cell == nullptr || !data_cell->is_in_slab()) {
+    return cell;
+  }
+  auto it = copies.find(cell.get());
+  if (it != copies.end()) {
+    return it->second;
+  }
+  std::array<Ref<Cell>, CellTraits::max_refs> refs;
+  for (unsigned i = 0; i < data_cell->size_refs(); i++) {
+    refs[i] = copy_out_of_slabs_impl(data_cell->get_ref(i), copies);
+  }
+  Ref<Cell> res = DataCell::create(td::Slice(data_cell->get_data(), (data_cell->get_bits() + 7) / 8),
+                                   data_cell->get_bits(), td::Span<Ref<Cell>>(refs.data(), data_cell->size_refs()),
+                                   data_cell->is_special())
+                      .move_as_ok();
+  copies.emplace(cell.get(), res);
+  return res;
+}
+
+}  // namespace
+
+Ref<Cell> DataCell::copy_out_of_slabs(Ref<Cell> cell) {
+  if (cell.is_null()) {
+    return cell;
+  }
+  DataCellArena::Pause pause;
+  std::map<const Cell*, Ref<Cell>> copies;
+  return copy_out_of_slabs_impl(cell, copies);
+}
+
+void DataCell::compute_lazy_hashes() const {
+  auto& state = hash_state();
+  td::uint8 expected = HashPending;
+  if (!state.compare_exchange_strong(expected, HashComputing, std::memory_order_acquire)) {
+    // another thread computes the same hashes
+    while (state.load(std::memory_order_acquire) != HashReady) {
+      std::this_thread::yield();
+    }
+    return;
+  }
+  CellChecker checker{false, td::Slice(get_data(), (get_bits() + 7) / 8), static_cast<int>(get_bits()),
+                      td::Span<Ref<Cell>>(refs_.data(), refs_cnt_)};
+  // the cell was already checked when it was created
+  checker.check_and_compute_level_info().ensure();
+  auto level_info = const_cast<detail::LevelInfo*>(this->level_info());
+  for (int i = 0; i <= level_; ++i) {
+    level_info[i].hash = checker.hashes()[i];
+  }
+  state.store(HashReady, std::memory_order_release);
+}
+
 DataCell::~DataCell() {
   for (size_t i = 0; i < level_ + 1; ++i) {
     level_info()[i].~LevelInfo();
@@ -443,13 +523,14 @@ std::string DataCell::to_hex() const {
 }
 
 DataCell::DataCell(int bit_length, size_t refs_cnt, Cell::SpecialType type, LevelMask level_mask,
-                   bool allocated_in_arena, td::uint8 virtualization)
+                   Allocation allocation, td::uint8 virtualization)
     : bit_length_(bit_length)
     , refs_cnt_(static_cast<td::uint8>(refs_cnt))
     , type_(static_cast<td::uint8>(type))
     , level_(static_cast<td::uint8>(level_mask.get_level()))
     , level_mask_(level_mask.get_mask())
-    , allocated_in_arena_(allocated_in_arena)
+    , allocation_(static_cast<td::uint8>(allocation))
+    , lazy_hash_(false)
     , virtualization_(virtualization) {
   get_thread_safe_counter().add(1);
 }
@@ -21,6 +21,9 @@
 #include "td/utils/Span.h"
 #include "td/utils/ThreadSafeCounter.h"
 #include "vm/cells/Cell.h"
+#include "vm/cells/DataCellArena.h"
+
+#include <atomic>
 
 namespace vm {
 
@@ -37,8 +40,16 @@ class DataCell final : public Cell {
  public:
   // NB: cells created with use_arena=true are never freed
   static thread_local bool use_arena;
+  // hashes of ordinary cells created with use_lazy_hashes=true are computed on first request;
+  // depths, level masks and all checks are still done by create()
+  static thread_local bool use_lazy_hashes;
+
+  enum class Allocation : td::uint8 { Heap, PermanentArena, Slab };
 
   static td::Result<Ref<DataCell>> create(td::Slice data, int bit_length, td::Span<Ref<Cell>> refs, bool is_special);
+  // Returns cell with all its cells allocated in DataCellArena slabs copied to the heap, so the result keeps
+  // no slab alive. Other cells are shared with the original tree and are not traversed.
+  static Ref<Cell> copy_out_of_slabs(Ref<Cell> cell);
 
   static void store_depth(td::uint8* dest, td::uint16 depth) {
     td::bitstring::bits_store_long(dest, depth, depth_bits);
@@ -49,10 +60,12 @@ class DataCell final : public Cell {
   }
 
   void operator delete(DataCell* ptr, std::destroying_delete_t) {
-    bool allocated_in_arena = ptr->allocated_in_arena_;
+    auto allocation = static_cast<Allocation>(ptr->allocation_);
     ptr->~DataCell();
-    if (!allocated_in_arena) {
+    if (allocation == Allocation::Heap) {
       ::operator delete(ptr);
+    } else if (allocation == Allocation::Slab) {
+      DataCellArena::release(ptr);
     }
   }
 
@@ -90,6 +103,10 @@ class DataCell final : public Cell {
     return LevelMask{level_mask_};
   }
 
+  bool is_in_slab() const {
+    return static_cast<Allocation>(allocation_) == Allocation::Slab;
+  }
+
   unsigned get_refs_cnt() const {
     return refs_cnt_;
   }
@@ -142,7 +159,7 @@ class DataCell final : public Cell {
   }
 
   size_t get_storage_size() const {
-    return sizeof(DataCell) + sizeof(detail::LevelInfo) * (level_ + 1) + (bit_length_ + 7) / 8;
+    return sizeof(DataCell) + sizeof(detail::LevelInfo) * (level_ + 1) + (bit_length_ + 7) / 8 + lazy_hash_;
   }
 
   int serialize(unsigned char* buff, int buff_size, bool with_hashes = false) const;
@@ -168,7 +185,7 @@ class DataCell final : public Cell {
     return res;
   }
 
-  DataCell(int bit_length, size_t refs_cnt, Cell::SpecialType type, LevelMask level_mask, bool allocated_in_arena,
+  DataCell(int bit_length, size_t refs_cnt, Cell::SpecialType type, LevelMask level_mask, Allocation allocation,
            td::uint8 virtualization);
 
   detail::LevelInfo const* level_info() const {
@@ -180,9 +197,21 @@ class DataCell final : public Cell {
   }
 
   virtual const Hash do_get_hash(td::uint32 level) const override {
+    if (lazy_hash_ && hash_state().load(std::memory_order_acquire) != HashReady) {
+      compute_lazy_hashes();
+    }
     return level_info()[std::min<td::uint32>(level_, level)].hash;
   }
 
+  enum : td::uint8 { HashPending, HashComputing, HashReady };
+
+  // stored right after the data of cells with lazy hashes
+  std::atomic<td::uint8>& hash_state() const {
+    auto ptr = trailer_ + sizeof(detail::LevelInfo) * (level_ + 1) + (bit_length_ + 7) / 8;
+    return *reinterpret_cast<std::atomic<td::uint8>*>(const_cast<char*>(ptr));
+  }
+  void compute_lazy_hashes() const;
+
   td::uint8 construct_d1(td::uint32 level) const {
     return static_cast<td::uint8>(refs_cnt_ + (is_special() << 3) + (get_level_mask().apply(level).get_mask() << 5));
   }
@@ -191,12 +220,13 @@ class DataCell final : public Cell {
     return static_cast<td::uint8>(bit_length_ / 8 + (bit_length_ + 7) / 8);
   }
 
-  unsigned bit_length_ : 11;
+  unsigned bit_length_ : 10;
   unsigned refs_cnt_ : 3;
   unsigned type_ : 3;
-  unsigned level_ : 3;
+  unsigned level_ : 2;
   unsigned level_mask_ : 3;
-  unsigned allocated_in_arena_ : 1;
+  unsigned allocation_ : 2;
+  unsigned lazy_hash_ : 1;
   unsigned virtualization_ : 8;
 
   std::array<Ref<Cell>, max_refs> refs_{};
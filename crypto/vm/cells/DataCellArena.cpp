@@ -0,0 +1,131 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "vm/cells/DataCellArena.h"
+
+#include "td/utils/check.h"
+
+#include <atomic>
+#include <cstdint>
+#include <new>
+
+namespace vm {
+
+namespace {
+
+// Slabs are aligned to their size, so the header of a slab is found by masking a cell address
+struct alignas(16) SlabHeader {
+  // one reference per allocated cell plus one held by the thread while it allocates from the slab
+  std::atomic<td::uint32> refs{1};
+};
+
+constexpr std::align_val_t slab_alignment{DataCellArena::kSlabSize};
+
+std::atomic<size_t> live_slabs{0};
+
+void unref_slab(SlabHeader *slab) {
+  if (slab->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    slab->~SlabHeader();
+    ::operator delete(static_cast<void *>(slab), slab_alignment);
+    live_slabs.fetch_sub(1, std::memory_order_relaxed);
+  }
+}
+
+struct ThreadLocalArena {
+  int depth{0};
+  SlabHeader *slab{nullptr};
+  size_t used{0};
+  DataCellArena::Stats stats;
+
+  ~ThreadLocalArena() {
+    drop_current_slab();
+  }
+  void drop_current_slab() {
+    if (slab) {
+      unref_slab(slab);
+      slab = nullptr;
+    }
+  }
+};
+
+thread_local ThreadLocalArena arena;
+
+}  // namespace
+
+DataCellArena::Scope::Scope() {
+  arena.depth++;
+}
+
+DataCellArena::Scope::~Scope() {
+  CHECK(arena.depth > 0);
+  if (--arena.depth == 0) {
+    // the slab is freed as soon as its cells are, instead of waiting for the next scope
+    arena.drop_current_slab();
+  }
+}
+
+DataCellArena::Pause::Pause() : depth_(arena.depth) {
+  arena.depth = 0;
+}
+
+DataCellArena::Pause::~Pause() {
+  arena.depth = depth_;
+}
+
+void *DataCellArena::allocate(size_t size) {
+  if (arena.depth == 0) {
+    return nullptr;
+  }
+  size = (size + 7) / 8 * 8;
+  if (!arena.slab || arena.used + size > kSlabSize) {
+    arena.drop_current_slab();
+    if (live_slabs.load(std::memory_order_relaxed) >= kMaxLiveSlabs) {
+      arena.stats.slab_limit_hits++;
+      return nullptr;
+    }
+    arena.slab = new (::operator new(kSlabSize, slab_alignment)) SlabHeader;
+    arena.used = sizeof(SlabHeader);
+    arena.stats.slabs_allocated++;
+    live_slabs.fetch_add(1, std::memory_order_relaxed);
+  }
+  auto res = reinterpret_cast<char *>(arena.slab) + arena.used;
+  arena.used += size;
+  arena.slab->refs.fetch_add(1, std::memory_order_relaxed);
+  arena.stats.arena_cells++;
+  arena.stats.arena_bytes += size;
+  return res;
+}
+
+void DataCellArena::release(void *ptr) {
+  auto addr = reinterpret_cast<std::uintptr_t>(ptr) & ~static_cast<std::uintptr_t>(kSlabSize - 1);
+  unref_slab(reinterpret_cast<SlabHeader *>(addr));
+}
+
+void DataCellArena::on_heap_allocation() {
+  arena.stats.heap_cells++;
+}
+
+DataCellArena::Stats DataCellArena::get_stats() {
+  auto res = arena.stats;
+  res.live_slabs = live_slabs.load(std::memory_order_relaxed);
+  return res;
+}
+
+void DataCellArena::reset_stats() {
+  arena.stats = Stats{};
+}
+
+}  // namespace vm
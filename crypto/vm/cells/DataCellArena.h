@@ -0,0 +1,87 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "td/utils/int_types.h"
+
+#include <cstddef>
+
+namespace vm {
+
+/**
+ * Slab allocator for short-lived DataCell objects, such as the cells created by a TVM run.
+ *
+ * While a Scope is alive on the current thread, DataCell::create() carves cells out of 16 KiB slabs
+ * instead of allocating each cell separately. A slab is freed when the thread has moved on to the next
+ * slab or left the outermost scope, and all cells allocated in it are destroyed. Cells may be freed on
+ * any thread.
+ *
+ * Cells cannot be moved once created, so a single long-lived cell pins its whole slab. Open a scope only
+ * around code whose cells are temporary and copy the few survivors out with DataCell::copy_out_of_slabs()
+ * before keeping them. Cells deserialized from a bag of cells or loaded from the cell db never go to slabs.
+ * As a safety net, no new slab is started while kMaxLiveSlabs slabs are alive in the process; cells are
+ * then allocated on the heap as without a scope until old slabs are freed.
+ */
+class DataCellArena {
+ public:
+  static constexpr size_t kSlabSize = 1 << 14;
+  // 64 MiB of slabs
+  static constexpr size_t kMaxLiveSlabs = 4096;
+
+  class Scope {
+   public:
+    Scope();
+    ~Scope();
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+  };
+
+  // Cells created while a Pause is alive are allocated on the heap, even inside a Scope
+  class Pause {
+   public:
+    Pause();
+    ~Pause();
+    Pause(const Pause &) = delete;
+    Pause &operator=(const Pause &) = delete;
+
+   private:
+    int depth_;
+  };
+
+  /**
+   * Allocation statistics of the current thread, except live_slabs which is process-wide.
+   */
+  struct Stats {
+    size_t heap_cells{0};
+    size_t arena_cells{0};
+    size_t arena_bytes{0};
+    size_t slabs_allocated{0};
+    // allocations that went to the heap because kMaxLiveSlabs was reached
+    size_t slab_limit_hits{0};
+    size_t live_slabs{0};
+  };
+
+  // returns nullptr if there is no active scope on the current thread
+  static void *allocate(size_t size);
+  static void release(void *ptr);
+  static void on_heap_allocation();
+
+  static Stats get_stats();
+  static void reset_stats();
+};
+
+}  // namespace vm
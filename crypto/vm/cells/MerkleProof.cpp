@@ -17,6 +17,7 @@
     Copyright 2017-2020 Telegram Systems LLP
 */
 #include "vm/cells/MerkleProof.h"
+#include "vm/cells/CellTreeSplit.h"
 #include "td/utils/Status.h"
 #include "vm/cells/CellBuilder.h"
 #include "vm/cells/CellSlice.h"
@@ -31,17 +32,27 @@ class MerkleProofImpl {
  public:
   explicit MerkleProofImpl(MerkleProof::IsPrunnedFunction is_prunned) : is_prunned_(std::move(is_prunned)) {
   }
-  explicit MerkleProofImpl(CellUsageTree *usage_tree) : usage_tree_(usage_tree) {
+  MerkleProofImpl(CellUsageTree *usage_tree, size_t extra_threads)
+      : usage_tree_(usage_tree), extra_threads_(extra_threads) {
   }
 
   Ref<Cell> create_from(Ref<Cell> cell) {
+    // a custom is_prunned and cells with a usage tree are not safe to use from several threads
+    bool parallel = !is_prunned_ && extra_threads_ != 0 && cell->get_tree_node().empty();
     if (!is_prunned_) {
       CHECK(usage_tree_);
-      dfs_usage_tree(cell, usage_tree_->root_id());
+      if (parallel) {
+        dfs_usage_tree_parallel(cell);
+      } else {
+        dfs_usage_tree(visited_cells_, cell, usage_tree_->root_id());
+      }
       is_prunned_ = [this](const Ref<Cell> &cell) { return visited_cells_.count(cell->get_hash()) == 0; };
     }
     try {
-      return dfs(cell, cell->get_level());
+      if (parallel && !dfs_parallel(cell, cell->get_level())) {
+        return {};
+      }
+      return dfs(cells_, cell, cell->get_level());
     } catch (CellBuilder::CellWriteError &) {
       return {};
     } catch (CellBuilder::CellCreateError &) {
@@ -51,28 +62,98 @@ class MerkleProofImpl {
 
  private:
   using Key = std::pair<Cell::Hash, int>;
-  td::HashMap<Key, Ref<Cell>> cells_;
+  using Cells = td::HashMap<Key, Ref<Cell>>;
+  Cells cells_;
   td::HashSet<Cell::Hash> visited_cells_;
   CellUsageTree *usage_tree_{nullptr};
+  size_t extra_threads_{0};
   MerkleProof::IsPrunnedFunction is_prunned_;
 
-  void dfs_usage_tree(Ref<Cell> cell, CellUsageTree::NodeId node_id) {
+  size_t min_tasks() const {
+    return (extra_threads_ + 1) * 16;
+  }
+  size_t threads_for(size_t tasks) const {
+    return tasks == 0 ? 0 : std::min(extra_threads_, tasks - 1);
+  }
+
+  void dfs_usage_tree(td::HashSet<Cell::Hash> &visited_cells, Ref<Cell> cell, CellUsageTree::NodeId node_id) const {
     if (!usage_tree_->is_loaded(node_id)) {
       return;
     }
-    visited_cells_.insert(cell->get_hash());
+    visited_cells.insert(cell->get_hash());
     CellSlice cs(NoVm(), cell);
     for (unsigned i = 0; i < cs.size_refs(); i++) {
-      dfs_usage_tree(cs.prefetch_ref(i), usage_tree_->get_child(node_id, i));
+      dfs_usage_tree(visited_cells, cs.prefetch_ref(i), usage_tree_->get_child(node_id, i));
+    }
+  }
+
+  void dfs_usage_tree_parallel(Ref<Cell> root) {
+    using Node = std::pair<Ref<Cell>, CellUsageTree::NodeId>;
+    auto tasks = split_cell_tree(Node{std::move(root), usage_tree_->root_id()}, min_tasks(),
+                                 [&](Node &node, std::vector<Node> &children) {
+                                   if (!usage_tree_->is_loaded(node.second)) {
+                                     return true;
+                                   }
+                                   visited_cells_.insert(node.first->get_hash());
+                                   CellSlice cs(NoVm(), node.first);
+                                   for (unsigned i = 0; i < cs.size_refs(); i++) {
+                                     children.emplace_back(cs.prefetch_ref(i), usage_tree_->get_child(node.second, i));
+                                   }
+                                   return true;
+                                 });
+    std::vector<td::HashSet<Cell::Hash>> visited(tasks.size());
+    parallel_run(
+        tasks.size(), [&](size_t i) { dfs_usage_tree(visited[i], tasks[i].first, tasks[i].second); },
+        threads_for(tasks.size()));
+    for (auto &cells : visited) {
+      for (auto &hash : cells) {
+        visited_cells_.insert(hash);
+      }
+    }
+  }
+
+  // builds the subtrees below the top levels, the top levels are built by the final dfs
+  bool dfs_parallel(Ref<Cell> root, int merkle_depth) {
+    using Node = std::pair<Ref<Cell>, int>;
+    auto tasks = split_cell_tree(Node{std::move(root), merkle_depth}, min_tasks(),
+                                 [&](Node &node, std::vector<Node> &children) {
+                                   if (is_prunned_(node.first)) {
+                                     return true;
+                                   }
+                                   CellSlice cs(NoVm(), node.first);
+                                   int children_merkle_depth = cs.child_merkle_depth(node.second);
+                                   for (unsigned i = 0; i < cs.size_refs(); i++) {
+                                     children.emplace_back(cs.prefetch_ref(i), children_merkle_depth);
+                                   }
+                                   return true;
+                                 });
+    std::vector<Ref<Cell>> results(tasks.size());
+    parallel_run(
+        tasks.size(),
+        [&](size_t i) {
+          Cells cells;
+          try {
+            results[i] = dfs(cells, tasks[i].first, tasks[i].second);
+          } catch (CellBuilder::CellWriteError &) {
+          } catch (CellBuilder::CellCreateError &) {
+          }
+        },
+        threads_for(tasks.size()));
+    for (size_t i = 0; i < tasks.size(); i++) {
+      if (results[i].is_null()) {
+        return false;
+      }
+      cells_.emplace(Key{tasks[i].first->get_hash(), tasks[i].second}, std::move(results[i]));
     }
+    return true;
   }
 
-  Ref<Cell> dfs(Ref<Cell> cell, int merkle_depth) {
+  Ref<Cell> dfs(Cells &cells, Ref<Cell> cell, int merkle_depth) const {
     CHECK(cell.not_null());
     Key key{cell->get_hash(), merkle_depth};
     {
-      auto it = cells_.find(key);
-      if (it != cells_.end()) {
+      auto it = cells.find(key);
+      if (it != cells.end()) {
         CHECK(it->second.not_null());
         return it->second;
       }
@@ -81,7 +162,7 @@ class MerkleProofImpl {
     if (is_prunned_(cell)) {
       auto res = CellBuilder::create_pruned_branch(cell, merkle_depth + 1);
       CHECK(res.not_null());
-      cells_.emplace(key, res);
+      cells.emplace(key, res);
       return res;
     }
     CellSlice cs(NoVm(), cell);
@@ -89,11 +170,11 @@ class MerkleProofImpl {
     CellBuilder cb;
     cb.store_bits(cs.fetch_bits(cs.size()));
     for (unsigned i = 0; i < cs.size_refs(); i++) {
-      cb.store_ref(dfs(cs.prefetch_ref(i), children_merkle_depth));
+      cb.store_ref(dfs(cells, cs.prefetch_ref(i), children_merkle_depth));
     }
     auto res = cb.finalize(cs.is_special());
     CHECK(res.not_null());
-    cells_.emplace(key, res);
+    cells.emplace(key, res);
     return res;
   }
 };
@@ -103,8 +184,8 @@ Ref<Cell> MerkleProof::generate_raw(Ref<Cell> cell, IsPrunnedFunction is_prunned
   return detail::MerkleProofImpl(is_prunned).create_from(cell);
 }
 
-Ref<Cell> MerkleProof::generate_raw(Ref<Cell> cell, CellUsageTree *usage_tree) {
-  return detail::MerkleProofImpl(usage_tree).create_from(cell);
+Ref<Cell> MerkleProof::generate_raw(Ref<Cell> cell, CellUsageTree *usage_tree, size_t extra_threads) {
+  return detail::MerkleProofImpl(usage_tree, extra_threads).create_from(cell);
 }
 
 Ref<Cell> MerkleProof::virtualize_raw(Ref<Cell> cell, Cell::VirtualizationParameters virt) {
@@ -46,7 +46,8 @@ class MerkleProof {
   // works with upwrapped proofs
   // works fine with cell of non-zero level, but this is not supported (yet?) in MerkeProof special cell
   static Ref<Cell> generate_raw(Ref<Cell> cell, IsPrunnedFunction is_prunned);
-  static Ref<Cell> generate_raw(Ref<Cell> cell, CellUsageTree *usage_tree);
+  // with extra_threads > 0 and cell that is not a usage cell, subtrees are processed on additional threads
+  static Ref<Cell> generate_raw(Ref<Cell> cell, CellUsageTree *usage_tree, size_t extra_threads = 0);
   static Ref<Cell> virtualize_raw(Ref<Cell> cell, Cell::VirtualizationParameters virt);
   static Ref<Cell> combine_raw(Ref<Cell> a, Ref<Cell> b);
   static Ref<Cell> combine_fast_raw(Ref<Cell> a, Ref<Cell> b);
@@ -17,32 +17,62 @@
     Copyright 2017-2020 Telegram Systems LLP
 */
 #include "vm/cells/MerkleUpdate.h"
+#include "vm/cells/CellTreeSplit.h"
 #include "vm/cells/MerkleProof.h"
 
 #include "td/utils/HashMap.h"
 #include "td/utils/HashSet.h"
 
+#include <algorithm>
+
 namespace vm {
 namespace detail {
 class MerkleUpdateApply {
  public:
+  explicit MerkleUpdateApply(size_t extra_threads = 0) : extra_threads_(extra_threads) {
+  }
+
   Ref<Cell> apply(Ref<Cell> from, Ref<Cell> update_from, Ref<Cell> update_to, td::uint32 from_level,
                   td::uint32 to_level) {
     if (from_level != from->get_level()) {
       return {};
     }
-    dfs_both(from, update_from, from_level);
-    return dfs(update_to, to_level);
+    // cells with a usage tree must not be loaded from several threads
+    if (extra_threads_ == 0 || !from->get_tree_node().empty()) {
+      dfs_both(known_cells_, from, update_from, from_level);
+      return dfs(known_cells_, ready_cells_, update_to, to_level);
+    }
+    dfs_both_parallel(std::move(from), std::move(update_from), from_level);
+    if (!dfs_parallel(update_to, to_level)) {
+      return {};
+    }
+    return dfs(known_cells_, ready_cells_, update_to, to_level);
   }
 
  private:
   using Key = std::pair<Cell::Hash, int>;
-  td::HashMap<Cell::Hash, Ref<Cell>> known_cells_;
-  td::HashMap<Key, Ref<Cell>> ready_cells_;
+  using KnownCells = td::HashMap<Cell::Hash, Ref<Cell>>;
+  using ReadyCells = td::HashMap<Key, Ref<Cell>>;
+  size_t extra_threads_{0};
+  KnownCells known_cells_;
+  ReadyCells ready_cells_;
+
+  struct Node {
+    Ref<Cell> cell;
+    Ref<Cell> update_from;
+    int merkle_depth;
+  };
+
+  size_t min_tasks() const {
+    return (extra_threads_ + 1) * 16;
+  }
+  size_t threads_for(size_t tasks) const {
+    return tasks == 0 ? 0 : std::min(extra_threads_, tasks - 1);
+  }
 
-  void dfs_both(Ref<Cell> original, Ref<Cell> update_from, int merkle_depth) {
+  static void dfs_both(KnownCells &known_cells, Ref<Cell> original, Ref<Cell> update_from, int merkle_depth) {
     CellSlice cs_update_from(NoVm(), update_from);
-    known_cells_.emplace(original->get_hash(merkle_depth), original);
+    known_cells.emplace(original->get_hash(merkle_depth), original);
     if (cs_update_from.special_type() == Cell::SpecialType::PrunnedBranch) {
       return;
     }
@@ -50,16 +80,76 @@ class MerkleUpdateApply {
 
     CellSlice cs_original(NoVm(), original);
     for (unsigned i = 0; i < cs_original.size_refs(); i++) {
-      dfs_both(cs_original.prefetch_ref(i), cs_update_from.prefetch_ref(i), child_merkle_depth);
+      dfs_both(known_cells, cs_original.prefetch_ref(i), cs_update_from.prefetch_ref(i), child_merkle_depth);
+    }
+  }
+
+  // the top levels are visited here, the subtrees below them by the workers
+  void dfs_both_parallel(Ref<Cell> original, Ref<Cell> update_from, int merkle_depth) {
+    auto tasks = split_cell_tree(Node{std::move(original), std::move(update_from), merkle_depth}, min_tasks(),
+                                 [&](Node &node, std::vector<Node> &children) {
+                                   CellSlice cs_update_from(NoVm(), node.update_from);
+                                   known_cells_.emplace(node.cell->get_hash(node.merkle_depth), node.cell);
+                                   if (cs_update_from.special_type() == Cell::SpecialType::PrunnedBranch) {
+                                     return true;
+                                   }
+                                   int child_merkle_depth = cs_update_from.child_merkle_depth(node.merkle_depth);
+                                   CellSlice cs_original(NoVm(), node.cell);
+                                   for (unsigned i = 0; i < cs_original.size_refs(); i++) {
+                                     children.push_back(Node{cs_original.prefetch_ref(i),
+                                                             cs_update_from.prefetch_ref(i), child_merkle_depth});
+                                   }
+                                   return true;
+                                 });
+    std::vector<KnownCells> found(tasks.size());
+    parallel_run(
+        tasks.size(),
+        [&](size_t i) { dfs_both(found[i], tasks[i].cell, tasks[i].update_from, tasks[i].merkle_depth); },
+        threads_for(tasks.size()));
+    for (auto &cells : found) {
+      for (auto &it : cells) {
+        known_cells_.emplace(it.first, std::move(it.second));
+      }
+    }
+  }
+
+  // rebuilds the subtrees of the new tree below the top levels, the top levels are rebuilt by the final dfs
+  bool dfs_parallel(Ref<Cell> update_to, int merkle_depth) {
+    auto tasks = split_cell_tree(Node{std::move(update_to), {}, merkle_depth}, min_tasks(),
+                                 [](Node &node, std::vector<Node> &children) {
+                                   CellSlice cs(NoVm(), node.cell);
+                                   if (cs.special_type() == Cell::SpecialType::PrunnedBranch) {
+                                     return true;
+                                   }
+                                   int child_merkle_depth = cs.child_merkle_depth(node.merkle_depth);
+                                   for (unsigned i = 0; i < cs.size_refs(); i++) {
+                                     children.push_back(Node{cs.prefetch_ref(i), {}, child_merkle_depth});
+                                   }
+                                   return true;
+                                 });
+    std::vector<Ref<Cell>> results(tasks.size());
+    parallel_run(
+        tasks.size(),
+        [&](size_t i) {
+          ReadyCells ready_cells;
+          results[i] = dfs(known_cells_, ready_cells, tasks[i].cell, tasks[i].merkle_depth);
+        },
+        threads_for(tasks.size()));
+    for (size_t i = 0; i < tasks.size(); i++) {
+      if (results[i].is_null()) {
+        return false;
+      }
+      ready_cells_.emplace(Key{tasks[i].cell->get_hash(), tasks[i].merkle_depth}, std::move(results[i]));
     }
+    return true;
   }
 
-  Ref<Cell> dfs(Ref<Cell> cell, int merkle_depth) {
+  static Ref<Cell> dfs(const KnownCells &known_cells, ReadyCells &ready_cells, Ref<Cell> cell, int merkle_depth) {
     CellSlice cs(NoVm(), cell);
     if (cs.special_type() == Cell::SpecialType::PrunnedBranch) {
       if ((int)cell->get_level() == merkle_depth + 1) {
-        auto it = known_cells_.find(cell->get_hash(merkle_depth));
-        if (it != known_cells_.end()) {
+        auto it = known_cells.find(cell->get_hash(merkle_depth));
+        if (it != known_cells.end()) {
           return it->second;
         }
         return {};
@@ -68,8 +158,8 @@ class MerkleUpdateApply {
     }
     Key key{cell->get_hash(), merkle_depth};
     {
-      auto it = ready_cells_.find(key);
-      if (it != ready_cells_.end()) {
+      auto it = ready_cells.find(key);
+      if (it != ready_cells.end()) {
         return it->second;
       }
     }
@@ -79,14 +169,14 @@ class MerkleUpdateApply {
     CellBuilder cb;
     cb.store_bits(cs.fetch_bits(cs.size()));
     for (unsigned i = 0; i < cs.size_refs(); i++) {
-      auto ref = dfs(cs.prefetch_ref(i), child_merkle_depth);
+      auto ref = dfs(known_cells, ready_cells, cs.prefetch_ref(i), child_merkle_depth);
       if (ref.is_null()) {
         return {};
       }
       cb.store_ref(std::move(ref));
     }
     auto res = cb.finalize(cs.is_special());
-    ready_cells_.emplace(key, res);
+    ready_cells.emplace(key, res);
     return res;
   }
 };
@@ -158,7 +248,7 @@ td::Status MerkleUpdate::may_apply(Ref<Cell> from, Ref<Cell> update) {
   return td::Status::OK();
 }
 
-Ref<Cell> MerkleUpdate::apply(Ref<Cell> from, Ref<Cell> update) {
+Ref<Cell> MerkleUpdate::apply(Ref<Cell> from, Ref<Cell> update, size_t extra_threads) {
   if (update->get_level() != 0 || from->get_level() != 0) {
     return {};
   }
@@ -168,20 +258,22 @@ Ref<Cell> MerkleUpdate::apply(Ref<Cell> from, Ref<Cell> update) {
   }
   auto update_from = cs.fetch_ref();
   auto update_to = cs.fetch_ref();
-  return apply_raw(std::move(from), std::move(update_from), std::move(update_to), 0, 0);
+  return apply_raw(std::move(from), std::move(update_from), std::move(update_to), 0, 0, extra_threads);
 }
 
 Ref<Cell> MerkleUpdate::apply_raw(Ref<Cell> from, Ref<Cell> update_from, Ref<Cell> update_to, td::uint32 from_level,
-                                  td::uint32 to_level) {
+                                  td::uint32 to_level, size_t extra_threads) {
   if (from->get_hash(from_level) != update_from->get_hash(from_level)) {
     LOG(DEBUG) << "invalid Merkle update: expected old value hash = " << update_from->get_hash(from_level).to_hex()
                << ", applied to value with hash = " << from->get_hash(from_level).to_hex();
     return {};
   }
-  return detail::MerkleUpdateApply().apply(from, std::move(update_from), std::move(update_to), from_level, to_level);
+  return detail::MerkleUpdateApply(extra_threads)
+      .apply(from, std::move(update_from), std::move(update_to), from_level, to_level);
 }
 
-std::pair<Ref<Cell>, Ref<Cell>> MerkleUpdate::generate_raw(Ref<Cell> from, Ref<Cell> to, CellUsageTree *usage_tree) {
+std::pair<Ref<Cell>, Ref<Cell>> MerkleUpdate::generate_raw(Ref<Cell> from, Ref<Cell> to, CellUsageTree *usage_tree,
+                                                           size_t extra_threads) {
   // create Merkle update cell->new_cell
   auto update_to = MerkleProof::generate_raw(to, [tree = usage_tree](const Ref<Cell> &cell) {
     auto loaded_cell = cell->load_cell().move_as_ok();  // FIXME
@@ -191,7 +283,8 @@ std::pair<Ref<Cell>, Ref<Cell>> MerkleUpdate::generate_raw(Ref<Cell> from, Ref<C
     return !loaded_cell.tree_node.empty() && loaded_cell.tree_node.mark_path(tree);
   });
   usage_tree->set_use_mark_for_is_loaded(true);
-  auto update_from = MerkleProof::generate_raw(from, usage_tree);
+  // update_to is always built on this thread: the usage tree of to is changed while it is traversed
+  auto update_from = MerkleProof::generate_raw(from, usage_tree, extra_threads);
 
   return {std::move(update_from), std::move(update_to)};
 }
@@ -214,13 +307,13 @@ td::Status MerkleUpdate::validate(Ref<Cell> update) {
   return validate_raw(std::move(update_from), std::move(update_to), 0, 0);
 }
 
-Ref<Cell> MerkleUpdate::generate(Ref<Cell> from, Ref<Cell> to, CellUsageTree *usage_tree) {
+Ref<Cell> MerkleUpdate::generate(Ref<Cell> from, Ref<Cell> to, CellUsageTree *usage_tree, size_t extra_threads) {
   auto from_level = from->get_level();
   auto to_level = to->get_level();
   if (from_level != 0 || to_level != 0) {
     return {};
   }
-  auto res = generate_raw(std::move(from), std::move(to), usage_tree);
+  auto res = generate_raw(std::move(from), std::move(to), usage_tree, extra_threads);
   if (res.first.is_null() || res.second.is_null()) {
     return {};
   }
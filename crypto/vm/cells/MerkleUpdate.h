@@ -29,10 +29,12 @@ namespace vm {
 class MerkleUpdate {
  public:
   // from + update == to
-  static Ref<Cell> generate(Ref<Cell> from, Ref<Cell> to, CellUsageTree *usage_tree);
+  // With extra_threads > 0 independent subtrees below the top levels of the trees are processed on that many
+  // additional threads; the result is the same. from must not be a usage cell then, otherwise it is processed serially.
+  static Ref<Cell> generate(Ref<Cell> from, Ref<Cell> to, CellUsageTree *usage_tree, size_t extra_threads = 0);
   // Returns empty Ref<Cell> if something go wrong. If validate(from).is_ok() and may_apply(from, to).is_ok(), then it
   // must not fail.
-  static Ref<Cell> apply(Ref<Cell> from, Ref<Cell> update);
+  static Ref<Cell> apply(Ref<Cell> from, Ref<Cell> update, size_t extra_threads = 0);
 
   // check if update is valid
   static TD_WARN_UNUSED_RESULT td::Status validate(Ref<Cell> update);
@@ -40,8 +42,9 @@ class MerkleUpdate {
   static TD_WARN_UNUSED_RESULT td::Status may_apply(Ref<Cell> from, Ref<Cell> update);
 
   static Ref<Cell> apply_raw(Ref<Cell> from, Ref<Cell> update_from, Ref<Cell> update_to, td::uint32 from_level,
-                             td::uint32 to_level);
-  static std::pair<Ref<Cell>, Ref<Cell>> generate_raw(Ref<Cell> from, Ref<Cell> to, CellUsageTree *usage_tree);
+                             td::uint32 to_level, size_t extra_threads = 0);
+  static std::pair<Ref<Cell>, Ref<Cell>> generate_raw(Ref<Cell> from, Ref<Cell> to, CellUsageTree *usage_tree,
+                                                      size_t extra_threads = 0);
   static td::Status validate_raw(Ref<Cell> update_from, Ref<Cell> update_to, td::uint32 from_level,
                                  td::uint32 to_level);
 
@@ -17,6 +17,7 @@
 #pragma once
 
 #include "CellBuilderPool.h"
+#include "DataCellArena.h"
 #include <string>
 #include <sstream>
 
@@ -52,6 +53,15 @@ public:
       oss << "  Reuse rate:    " << reuse_rate << "%\n";
     }
 
+    auto arena_stats = DataCellArena::get_stats();
+    oss << "DataCell Arena:\n";
+    oss << "  Heap cells:    " << arena_stats.heap_cells << "\n";
+    oss << "  Arena cells:   " << arena_stats.arena_cells << "\n";
+    oss << "  Arena bytes:   " << arena_stats.arena_bytes << "\n";
+    oss << "  Slabs:         " << arena_stats.slabs_allocated << "\n";
+    oss << "  Live slabs:    " << arena_stats.live_slabs << "\n";
+    oss << "  Limit hits:    " << arena_stats.slab_limit_hits << "\n";
+
     oss << "==============================\n";
 
     return oss.str();
@@ -70,7 +80,11 @@ public:
       oss << "hits:" << cell_stats.pool_hits << "/" << cell_stats.allocations
           << "(" << static_cast<int>(hit_rate) << "%) ";
     }
-    oss << "pool:" << cell_stats.pool_size << "]";
+    oss << "pool:" << cell_stats.pool_size << "] ";
+
+    auto arena_stats = DataCellArena::get_stats();
+    oss << "DataCell[heap:" << arena_stats.heap_cells << " arena:" << arena_stats.arena_cells
+        << " slabs:" << arena_stats.slabs_allocated << "/" << arena_stats.live_slabs << "]";
 
     return oss.str();
   }
@@ -80,6 +94,7 @@ public:
    */
   static void reset_all_statistics() {
     CellBuilderPool::reset_stats();
+    DataCellArena::reset_stats();
   }
 };
 
@@ -147,9 +147,14 @@ class DynamicBagOfCellsDb {
     bool use_arena{false};
     // Almost no overhead in memory during creation, but will scan database twice
     bool use_less_memory_during_creation{true};
+    // Cells are kept packed in a flat arena and DataCells are materialized on demand.
+    // Uses several times less memory at the cost of slower loads; use_arena and
+    // use_less_memory_during_creation are ignored
+    bool compact{false};
     friend td::StringBuilder &operator<<(td::StringBuilder &sb, const CreateInMemoryOptions &options) {
       return sb << "InMemory{extra_threads=" << options.extra_threads << ", use_arena=" << options.use_arena
-                << ", use_less_memory_during_creation=" << options.use_less_memory_during_creation << "}";
+                << ", use_less_memory_during_creation=" << options.use_less_memory_during_creation
+                << ", compact=" << options.compact << "}";
     }
   };
   static std::unique_ptr<DynamicBagOfCellsDb> create_in_memory(td::KeyValueReader *kv, CreateInMemoryOptions options);
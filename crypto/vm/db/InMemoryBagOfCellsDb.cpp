@@ -14,7 +14,10 @@
 #include "td/utils/HashMap.h"
 #include "td/utils/HashSet.h"
 
+#include <cstring>
+#include <memory>
 #include <optional>
+#include <shared_mutex>
 
 #if TD_PORT_POSIX
 #include <sys/mman.h>
@@ -768,6 +771,662 @@ class CellStorage {
   }
 };
 
+// Compact alternative to CellStorage. Each cell is stored as a packed record in a chunked byte arena:
+// 2 bytes of descriptor, data bytes and 32-bit indices of the children. Hashes, depths and refcnts live in
+// arrays indexed by the same 32-bit cell index, and an open addressing table maps hashes to indices, so every
+// hash is stored exactly once. DataCells are materialized on demand with ExtCell children pointing back into
+// the storage, and recently materialized cells are kept in a small direct-mapped hot cache.
+class CompactCellStorage {
+  struct PrivateTag {};
+
+ public:
+  class Core;
+
+  struct ExtCellExtra {
+    std::shared_ptr<const Core> core;
+    td::uint32 idx;
+  };
+  struct ExtCellLoader {
+    static td::Result<Ref<DataCell>> load_data_cell(const Cell &cell, const ExtCellExtra &extra) {
+      return extra.core->materialize(extra.idx);
+    }
+  };
+  using CompactExtCell = ExtCell<ExtCellExtra, ExtCellLoader>;
+
+  class Core : public std::enable_shared_from_this<Core> {
+   public:
+    static constexpr td::uint32 kEmpty = std::numeric_limits<td::uint32>::max();
+    static constexpr td::uint32 kDeleted = kEmpty - 1;
+    static constexpr td::uint64 kErased = std::numeric_limits<td::uint64>::max();
+    static constexpr size_t kChunkSize = 1 << 20;
+    static constexpr size_t kMaxRecordSize = 2 + CellTraits::max_bytes + 4 * CellTraits::max_refs;
+    static constexpr size_t kHotCacheSize = 1 << 16;
+    static constexpr size_t kHotCacheStripes = 64;
+
+    Core() : hot_cache_(kHotCacheSize), free_records_(kMaxRecordSize + 1) {
+    }
+
+    td::Result<Ref<DataCell>> materialize(td::uint32 idx) const {
+      std::shared_lock<std::shared_mutex> lock(mutex_);
+      return do_materialize(idx);
+    }
+
+    std::optional<CellInfo> get_info(const CellHash &hash) const {
+      std::shared_lock<std::shared_mutex> lock(mutex_);
+      auto idx = find(hash);
+      if (idx == kEmpty) {
+        return {};
+      }
+      auto r_cell = do_materialize(idx);
+      LOG_CHECK(r_cell.is_ok()) << r_cell.error();
+      return CellInfo{.db_refcnt = refcnts_[idx], .cell = r_cell.move_as_ok()};
+    }
+
+    td::Result<Ref<DataCell>> load_cell(const CellHash &hash) const {
+      std::shared_lock<std::shared_mutex> lock(mutex_);
+      auto idx = find(hash);
+      if (idx == kEmpty) {
+        return td::Status::Error("not found");
+      }
+      return do_materialize(idx);
+    }
+
+    td::Result<Ref<DataCell>> load_root(const CellHash &hash) const {
+      std::shared_lock<std::shared_mutex> lock(mutex_);
+      if (roots_.count(hash) == 0) {
+        return td::Status::Error("not found");
+      }
+      return do_load_root(hash);
+    }
+
+    td::Result<std::vector<Ref<DataCell>>> load_roots() const {
+      std::shared_lock<std::shared_mutex> lock(mutex_);
+      std::vector<Ref<DataCell>> result;
+      result.reserve(roots_.size());
+      for (auto &hash : roots_) {
+        TRY_RESULT(cell, do_load_root(hash));
+        result.push_back(std::move(cell));
+      }
+      return result;
+    }
+
+    // returns true if the cell was a root
+    bool erase(const CellHash &hash) {
+      std::unique_lock<std::shared_mutex> lock(mutex_);
+      auto slot = find_slot(hash);
+      auto idx = index_[slot];
+      CHECK(idx != kEmpty);
+      index_[slot] = kDeleted;
+      cells_count_--;
+      auto offset = offsets_[idx];
+      auto size = record_size(record_ptr(offset));
+      free_records_[size].push_back(offset);
+      free_bytes_ += size;
+      offsets_[idx] = kErased;
+      extra_levels_.erase(idx);
+      free_indices_.push_back(idx);
+      {
+        auto &entry = hot_cache_[hot_cache_slot(idx)];
+        std::lock_guard<std::mutex> guard(hot_cache_mutex(idx));
+        if (entry.first == idx) {
+          entry = {};
+        }
+      }
+      pending_roots_.erase(hash);
+      return roots_.erase(hash) != 0;
+    }
+
+    // returns true if the cell is a new root
+    bool add_root(Ref<DataCell> cell) {
+      std::unique_lock<std::shared_mutex> lock(mutex_);
+      auto hash = cell->get_hash();
+      if (!roots_.insert(hash).second) {
+        return false;
+      }
+      if (find(hash) == kEmpty) {
+        // roots are added in prepare_commit, before the cells are stored in commit
+        pending_roots_.emplace(hash, std::move(cell));
+      }
+      return true;
+    }
+
+    void set(td::int32 refcnt, const Ref<DataCell> &cell) {
+      // new children are loaded before the write lock is taken: loading may read from disk or materialize
+      // a cell of this core, which takes the shared lock
+      std::vector<Ref<DataCell>> new_cells;
+      if (!contains(cell->get_hash())) {
+        td::HashSet<CellHash> visited;
+        collect_new_cells(*cell, visited, new_cells);
+      }
+      std::unique_lock<std::shared_mutex> lock(mutex_);
+      auto idx = find(cell->get_hash());
+      if (idx == kEmpty) {
+        for (auto &new_cell : new_cells) {
+          if (find(new_cell->get_hash()) == kEmpty) {
+            insert(*new_cell);
+          }
+        }
+        idx = insert(*cell);
+        pending_roots_.erase(cell->get_hash());
+      }
+      refcnts_[idx] = refcnt;
+    }
+
+    template <class F>
+    void build(DynamicBagOfCellsDb::CreateInMemoryOptions options, F &&parallel_scan_cells,
+               DynamicBagOfCellsDb::Stats &stats) {
+      std::unique_lock<std::shared_mutex> lock(mutex_);
+      auto verbose = options.verbose;
+      td::Slice P = "loading compact in-memory cell database: ";
+      DefaultPrunnedCellCreator pc_creator;
+
+      // cells of different tasks have different first bytes of hashes, so first bytes are used as task ids
+      struct ScannedCell {
+        CellHash hash;
+        td::int32 refcnt;
+        td::uint16 depth;
+      };
+      struct Bucket {
+        std::vector<ScannedCell> cells;
+        std::vector<std::pair<CellHash, std::string>> extra_levels;
+        td::int64 cells_size{0};
+        std::string records;
+        std::vector<td::uint32> indices;
+      };
+      std::vector<Bucket> buckets(256);
+
+      auto timer = td::Timer();
+      auto [cell_count, desc_count] = parallel_scan_cells(pc_creator, false, [&](td::int32 refcnt, Ref<DataCell> cell) {
+        auto &bucket = buckets[cell->get_hash().as_array()[0]];
+        bucket.cells.push_back({.hash = cell->get_hash(), .refcnt = refcnt, .depth = cell->get_depth()});
+        bucket.cells_size += static_cast<td::int64>(cell->get_storage_size());
+        if (cell->get_level_mask().get_mask() != 0) {
+          bucket.extra_levels.emplace_back(cell->get_hash(), serialize_levels(*cell));
+        }
+      });
+      LOG_IF(WARNING, verbose) << P << "hashes loaded in " << timer.elapsed() << "s, cells_count=" << cell_count;
+
+      timer = td::Timer();
+      reserve(static_cast<size_t>(cell_count));
+      for (auto &bucket : buckets) {
+        for (auto &scanned : bucket.cells) {
+          auto idx = new_index(scanned.hash);
+          refcnts_[idx] = scanned.refcnt;
+          depths_[idx] = scanned.depth;
+          stats.cells_total_count++;
+        }
+        for (auto &[hash, levels] : bucket.extra_levels) {
+          extra_levels_.emplace(find(hash), std::move(levels));
+        }
+        stats.cells_total_size += bucket.cells_size;
+        td::reset_to_empty(bucket.cells);
+        td::reset_to_empty(bucket.extra_levels);
+      }
+      LOG_IF(WARNING, verbose) << P << "index built in " << timer.elapsed() << "s";
+
+      timer = td::Timer();
+      std::vector<std::atomic<td::int32>> parents_count(refcnts_.size());
+      auto [new_cell_count, new_desc_count] =
+          parallel_scan_cells(pc_creator, false, [&](td::int32 refcnt, Ref<DataCell> cell) {
+            auto &bucket = buckets[cell->get_hash().as_array()[0]];
+            std::array<td::uint32, CellTraits::max_refs> refs;
+            for (unsigned i = 0; i < cell->size_refs(); i++) {
+              refs[i] = find(cell->get_ref_raw_ptr(i)->get_hash());
+              CHECK(refs[i] != kEmpty);
+              parents_count[refs[i]].fetch_add(1, std::memory_order_relaxed);
+            }
+            auto size = record_size(*cell);
+            bucket.records.resize(bucket.records.size() + size);
+            write_record(td::MutableSlice(bucket.records).uend() - size, *cell, refs.data());
+            bucket.indices.push_back(find(cell->get_hash()));
+          });
+      CHECK(new_cell_count == cell_count);
+      CHECK(new_desc_count == desc_count);
+      for (auto &bucket : buckets) {
+        auto records = td::Slice(bucket.records);
+        for (auto idx : bucket.indices) {
+          auto size = record_size(records.ubegin());
+          auto offset = allocate_record(size);
+          std::memcpy(record_ptr(offset), records.ubegin(), size);
+          offsets_[idx] = offset;
+          records.remove_prefix(size);
+        }
+        CHECK(records.empty());
+        td::reset_to_empty(bucket.records);
+        td::reset_to_empty(bucket.indices);
+      }
+      for (size_t idx = 0; idx < refcnts_.size(); idx++) {
+        CHECK(offsets_[idx] != kErased);
+        auto parents = parents_count[idx].load(std::memory_order_relaxed);
+        CHECK(refcnts_[idx] >= parents);
+        if (refcnts_[idx] != parents) {
+          roots_.insert(hashes_[idx]);
+        }
+      }
+      stats.roots_total_count = static_cast<td::int64>(roots_.size());
+      LOG_IF(WARNING, verbose) << P << "records packed in " << timer.elapsed() << "s, arena_size="
+                               << td::format::as_size(chunks_.size() * kChunkSize);
+      LOG_IF(ERROR, desc_count != 0 && desc_count != stats.roots_total_count + 1)
+          << "desc<> keys count is " << desc_count << " which is different from roots count "
+          << stats.roots_total_count;
+    }
+
+    void clear() {
+      {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        pending_roots_.clear();
+      }
+      for (size_t i = 0; i < kHotCacheSize; i++) {
+        std::lock_guard<std::mutex> guard(hot_cache_mutex(i));
+        hot_cache_[i] = {};
+      }
+    }
+
+    size_t cells_count() const {
+      std::shared_lock<std::shared_mutex> lock(mutex_);
+      return cells_count_;
+    }
+    size_t roots_count() const {
+      std::shared_lock<std::shared_mutex> lock(mutex_);
+      return roots_.size();
+    }
+
+    template <class F>
+    void get_custom_stats(F &&add_stat) const {
+      std::shared_lock<std::shared_mutex> lock(mutex_);
+      auto arena_size = chunks_.size() * kChunkSize;
+      auto arrays_size = refcnts_.capacity() * (sizeof(CellHash) + sizeof(td::uint16) + sizeof(td::int32) +
+                                                sizeof(td::uint64)) +
+                         index_.capacity() * sizeof(td::uint32);
+      add_stat("compact.cells", cells_count_);
+      add_stat("compact.index_capacity", index_.size());
+      add_stat("compact.index_load", double(index_used_) / std::max(1.0, double(index_.size())));
+      add_stat("compact.arena_size", arena_size);
+      add_stat("compact.arena_free", free_bytes_);
+      add_stat("compact.arrays_size", arrays_size);
+      add_stat("compact.extra_levels", extra_levels_.size());
+      add_stat("compact.memory_used", arena_size + arrays_size);
+      add_stat("compact.hot_cache_hits", hot_cache_hits_.load(std::memory_order_relaxed));
+      add_stat("compact.hot_cache_misses", hot_cache_misses_.load(std::memory_order_relaxed));
+    }
+
+   private:
+    mutable std::shared_mutex mutex_;
+
+    std::vector<CellHash> hashes_;
+    std::vector<td::uint16> depths_;
+    std::vector<td::int32> refcnts_;
+    std::vector<td::uint64> offsets_;
+    // level mask, hashes and depths of all significant levels of cells with non-zero level
+    td::HashMap<td::uint32, std::string> extra_levels_;
+    std::vector<td::uint32> free_indices_;
+    size_t cells_count_{0};
+
+    std::vector<td::uint32> index_;
+    size_t index_used_{0};
+
+    std::vector<std::unique_ptr<unsigned char[]>> chunks_;
+    size_t chunk_used_{kChunkSize};
+    std::vector<std::vector<td::uint64>> free_records_;
+    size_t free_bytes_{0};
+
+    td::HashSet<CellHash> roots_;
+    td::HashMap<CellHash, Ref<DataCell>> pending_roots_;
+
+    mutable std::vector<std::pair<td::uint32, Ref<DataCell>>> hot_cache_;
+    mutable std::array<std::mutex, kHotCacheStripes> hot_cache_mutexes_;
+    mutable std::atomic<td::uint64> hot_cache_hits_{0};
+    mutable std::atomic<td::uint64> hot_cache_misses_{0};
+
+    static size_t hot_cache_slot(td::uint32 idx) {
+      return (idx * 0x9E3779B1u) % kHotCacheSize;
+    }
+    std::mutex &hot_cache_mutex(size_t idx) const {
+      return hot_cache_mutexes_[hot_cache_slot(static_cast<td::uint32>(idx)) % kHotCacheStripes];
+    }
+
+    static size_t hash_slot(const CellHash &hash, size_t mask) {
+      td::uint64 value;
+      std::memcpy(&value, hash.as_slice().ubegin() + 8, sizeof(value));
+      return static_cast<size_t>(value) & mask;
+    }
+    size_t find_slot(const CellHash &hash) const {
+      if (index_.empty()) {
+        return std::numeric_limits<size_t>::max();
+      }
+      auto mask = index_.size() - 1;
+      for (auto slot = hash_slot(hash, mask);; slot = (slot + 1) & mask) {
+        auto idx = index_[slot];
+        if (idx == kEmpty) {
+          return std::numeric_limits<size_t>::max();
+        }
+        if (idx != kDeleted && hashes_[idx] == hash) {
+          return slot;
+        }
+      }
+    }
+    td::uint32 find(const CellHash &hash) const {
+      auto slot = find_slot(hash);
+      return slot == std::numeric_limits<size_t>::max() ? kEmpty : index_[slot];
+    }
+    void index_insert(const CellHash &hash, td::uint32 idx) {
+      if ((index_used_ + 1) * 10 > index_.size() * 7) {
+        rehash(std::max(cells_count_ + 1, index_.size() / 2));
+      }
+      auto mask = index_.size() - 1;
+      auto slot = hash_slot(hash, mask);
+      while (index_[slot] != kEmpty && index_[slot] != kDeleted) {
+        slot = (slot + 1) & mask;
+      }
+      if (index_[slot] == kEmpty) {
+        index_used_++;
+      }
+      index_[slot] = idx;
+    }
+    void rehash(size_t expected_size) {
+      size_t new_size = 16;
+      while (new_size * 7 < expected_size * 10 * 2) {
+        new_size *= 2;
+      }
+      std::vector<td::uint32> old_index(new_size, kEmpty);
+      std::swap(old_index, index_);
+      index_used_ = 0;
+      auto mask = index_.size() - 1;
+      for (auto idx : old_index) {
+        if (idx == kEmpty || idx == kDeleted) {
+          continue;
+        }
+        auto slot = hash_slot(hashes_[idx], mask);
+        while (index_[slot] != kEmpty) {
+          slot = (slot + 1) & mask;
+        }
+        index_[slot] = idx;
+        index_used_++;
+      }
+    }
+    void reserve(size_t cells_count) {
+      hashes_.reserve(cells_count);
+      depths_.reserve(cells_count);
+      refcnts_.reserve(cells_count);
+      offsets_.reserve(cells_count);
+      rehash(cells_count);
+    }
+    td::uint32 new_index(const CellHash &hash) {
+      td::uint32 idx;
+      if (!free_indices_.empty()) {
+        idx = free_indices_.back();
+        free_indices_.pop_back();
+        hashes_[idx] = hash;
+      } else {
+        idx = td::narrow_cast<td::uint32>(hashes_.size());
+        CHECK(idx < kDeleted);
+        hashes_.push_back(hash);
+        depths_.push_back(0);
+        refcnts_.push_back(0);
+        offsets_.push_back(kErased);
+      }
+      index_insert(hash, idx);
+      cells_count_++;
+      return idx;
+    }
+
+    bool contains(const CellHash &hash) const {
+      std::shared_lock<std::shared_mutex> lock(mutex_);
+      return find(hash) != kEmpty;
+    }
+
+    // appends the loaded children of cell that are missing in the core to res, children before parents;
+    // called without the lock held
+    void collect_new_cells(const DataCell &cell, td::HashSet<CellHash> &visited,
+                           std::vector<Ref<DataCell>> &res) const {
+      for (unsigned i = 0; i < cell.size_refs(); i++) {
+        auto child = cell.get_ref(i);
+        auto hash = child->get_hash();
+        if (!visited.insert(hash).second || contains(hash)) {
+          continue;
+        }
+        auto r_child = child->load_cell();
+        LOG_CHECK(r_child.is_ok()) << r_child.error();
+        auto data_cell = std::move(r_child.ok_ref().data_cell);
+        collect_new_cells(*data_cell, visited, res);
+        res.push_back(std::move(data_cell));
+      }
+    }
+
+    // all children must be stored already (see set); new children are stored with zero refcnt,
+    // it is set later in the same commit
+    td::uint32 insert(const DataCell &cell) {
+      std::array<td::uint32, CellTraits::max_refs> refs;
+      for (unsigned i = 0; i < cell.size_refs(); i++) {
+        refs[i] = find(cell.get_ref(i)->get_hash());
+        LOG_CHECK(refs[i] != kEmpty) << "child cell is not stored";
+      }
+      auto idx = new_index(cell.get_hash());
+      depths_[idx] = cell.get_depth();
+      if (cell.get_level_mask().get_mask() != 0) {
+        extra_levels_[idx] = serialize_levels(cell);
+      }
+      auto offset = allocate_record(record_size(cell));
+      write_record(record_ptr(offset), cell, refs.data());
+      offsets_[idx] = offset;
+      return idx;
+    }
+
+    td::uint64 allocate_record(size_t size) {
+      if (!free_records_[size].empty()) {
+        auto offset = free_records_[size].back();
+        free_records_[size].pop_back();
+        free_bytes_ -= size;
+        return offset;
+      }
+      if (chunk_used_ + size > kChunkSize) {
+        if (!chunks_.empty()) {
+          free_bytes_ += kChunkSize - chunk_used_;
+        }
+        chunks_.push_back(std::make_unique<unsigned char[]>(kChunkSize));
+        chunk_used_ = 0;
+      }
+      auto offset = (chunks_.size() - 1) * kChunkSize + chunk_used_;
+      chunk_used_ += size;
+      return offset;
+    }
+
+    unsigned char *record_ptr(td::uint64 offset) const {
+      return chunks_[offset / kChunkSize].get() + offset % kChunkSize;
+    }
+    static size_t record_size(const DataCell &cell) {
+      return 2 + (cell.size() + 7) / 8 + 4 * cell.size_refs();
+    }
+    static size_t record_size(const unsigned char *record) {
+      td::uint16 header = static_cast<td::uint16>(record[0] | (record[1] << 8));
+      return 2 + ((header & 1023) + 7) / 8 + 4 * (header >> 11);
+    }
+    static void write_record(unsigned char *record, const DataCell &cell, const td::uint32 *refs) {
+      auto header = static_cast<td::uint16>(cell.size() | (cell.is_special() << 10) | (cell.size_refs() << 11));
+      record[0] = static_cast<unsigned char>(header & 0xff);
+      record[1] = static_cast<unsigned char>(header >> 8);
+      auto data_size = (cell.size() + 7) / 8;
+      std::memcpy(record + 2, cell.get_data(), data_size);
+      std::memcpy(record + 2 + data_size, refs, 4 * cell.size_refs());
+    }
+    static std::string serialize_levels(const DataCell &cell) {
+      auto level_mask = cell.get_level_mask();
+      std::string res(1 + level_mask.get_hashes_count() * (CellTraits::hash_bytes + CellTraits::depth_bytes), '\0');
+      res[0] = static_cast<char>(level_mask.get_mask());
+      auto hashes = td::MutableSlice(res).substr(1);
+      auto depths = hashes.substr(level_mask.get_hashes_count() * CellTraits::hash_bytes);
+      for (unsigned i = 0; i <= level_mask.get_level(); i++) {
+        if (!level_mask.is_significant(i)) {
+          continue;
+        }
+        hashes.copy_from(cell.get_hash(i).as_slice());
+        hashes.remove_prefix(CellTraits::hash_bytes);
+        DataCell::store_depth(depths.ubegin(), cell.get_depth(i));
+        depths.remove_prefix(CellTraits::depth_bytes);
+      }
+      return res;
+    }
+
+    td::Result<Ref<Cell>> make_ext_cell(td::uint32 idx) const {
+      auto core = shared_from_this();
+      if (auto it = extra_levels_.find(idx); it != extra_levels_.end()) {
+        auto levels = td::Slice(it->second);
+        auto level_mask = Cell::LevelMask(static_cast<td::uint8>(levels[0]));
+        auto hashes_size = level_mask.get_hashes_count() * CellTraits::hash_bytes;
+        TRY_RESULT(cell,
+                   CompactExtCell::create(PrunnedCellInfo{level_mask, levels.substr(1, hashes_size),
+                                                          levels.substr(1 + hashes_size)},
+                                          ExtCellExtra{std::move(core), idx}));
+        return std::move(cell);
+      }
+      td::uint8 depth[CellTraits::depth_bytes];
+      DataCell::store_depth(depth, depths_[idx]);
+      TRY_RESULT(cell, CompactExtCell::create(PrunnedCellInfo{Cell::LevelMask(), hashes_[idx].as_slice(),
+                                                              td::Slice(depth, CellTraits::depth_bytes)},
+                                              ExtCellExtra{std::move(core), idx}));
+      return std::move(cell);
+    }
+
+    td::Result<Ref<DataCell>> do_load_root(const CellHash &hash) const {
+      auto idx = find(hash);
+      if (idx != kEmpty) {
+        return do_materialize(idx);
+      }
+      auto it = pending_roots_.find(hash);
+      CHECK(it != pending_roots_.end());
+      return it->second;
+    }
+
+    td::Result<Ref<DataCell>> do_materialize(td::uint32 idx) const {
+      auto &entry = hot_cache_[hot_cache_slot(idx)];
+      {
+        std::lock_guard<std::mutex> guard(hot_cache_mutex(idx));
+        if (entry.first == idx && entry.second.not_null()) {
+          hot_cache_hits_.fetch_add(1, std::memory_order_relaxed);
+          return entry.second;
+        }
+      }
+      hot_cache_misses_.fetch_add(1, std::memory_order_relaxed);
+      if (idx >= offsets_.size() || offsets_[idx] == kErased) {
+        return td::Status::Error("cell was erased");
+      }
+      auto record = record_ptr(offsets_[idx]);
+      td::uint16 header = static_cast<td::uint16>(record[0] | (record[1] << 8));
+      int bits = header & 1023;
+      bool is_special = (header >> 10) & 1;
+      unsigned refs_cnt = header >> 11;
+      auto data = td::Slice(record + 2, (bits + 7) / 8);
+      std::array<Ref<Cell>, CellTraits::max_refs> refs;
+      for (unsigned i = 0; i < refs_cnt; i++) {
+        td::uint32 child;
+        std::memcpy(&child, data.ubegin() + data.size() + 4 * i, sizeof(child));
+        TRY_RESULT_ASSIGN(refs[i], make_ext_cell(child));
+      }
+      TRY_RESULT(cell, DataCell::create(data, bits, td::Span<Ref<Cell>>(refs.data(), refs_cnt), is_special));
+      std::lock_guard<std::mutex> guard(hot_cache_mutex(idx));
+      entry = {idx, cell};
+      return std::move(cell);
+    }
+  };
+
+  static td::unique_ptr<CompactCellStorage> build_empty(DynamicBagOfCellsDb::CreateInMemoryOptions options) {
+    return build(options, [](auto, auto, auto) { return std::make_pair(0, 0); });
+  }
+
+  template <class F>
+  static td::unique_ptr<CompactCellStorage> build(DynamicBagOfCellsDb::CreateInMemoryOptions options,
+                                                  F &&parallel_scan_cells) {
+    auto storage = td::make_unique<CompactCellStorage>(PrivateTag{});
+    auto timer = td::Timer();
+    storage->core_->build(options, parallel_scan_cells, storage->stats_);
+    if (options.verbose) {
+      auto r_mem_stat = td::mem_stat();
+      td::MemStat mem_stat;
+      if (r_mem_stat.is_ok()) {
+        mem_stat = r_mem_stat.move_as_ok();
+      }
+      auto stats = storage->get_stats();
+      td::StringBuilder sb;
+      for (auto &[key, value] : stats.custom_stats) {
+        sb << "\n\t" << key << "=" << value;
+      }
+      LOG(WARNING) << "loading compact in-memory cell database: done in " << timer.elapsed()
+                   << "\n\troots_count=" << stats.roots_total_count << "\n\tcells_count=" << stats.cells_total_count
+                   << "\n\tcells_size=" << td::format::as_size(stats.cells_total_size) << sb.as_cslice()
+                   << "\n\tmemory_used=" << td::format::as_size(mem_stat.resident_size_)
+                   << "\n\tpeak_memory_used=" << td::format::as_size(mem_stat.resident_size_peak_);
+    }
+    return storage;
+  }
+
+  ~CompactCellStorage() {
+    // materialized cells reference the core through their children, so the cycle is broken here
+    core_->clear();
+  }
+  CompactCellStorage() = delete;
+  explicit CompactCellStorage(PrivateTag) : core_(std::make_shared<Core>()) {
+  }
+
+  std::optional<CellInfo> get_info(const CellHash &hash) const {
+    return core_->get_info(hash);
+  }
+
+  DynamicBagOfCellsDb::Stats get_stats() {
+    auto stats = stats_;
+    core_->get_custom_stats([&stats](auto key, auto value) {
+      stats.custom_stats.emplace_back(std::move(key), PSTRING() << value);
+    });
+    CHECK(td::narrow_cast<size_t>(stats.roots_total_count) == core_->roots_count());
+    return stats;
+  }
+  void apply_stats_diff(DynamicBagOfCellsDb::Stats diff) {
+    stats_.apply_diff(diff);
+    CHECK(td::narrow_cast<size_t>(stats_.roots_total_count) == core_->roots_count());
+    CHECK(td::narrow_cast<size_t>(stats_.cells_total_count) == core_->cells_count());
+  }
+
+  td::Result<Ref<DataCell>> load_cell(const CellHash &hash) const {
+    return core_->load_cell(hash);
+  }
+  td::Result<std::vector<Ref<DataCell>>> load_bulk(td::Span<CellHash> hashes) const {
+    std::vector<Ref<DataCell>> res;
+    res.reserve(hashes.size());
+    for (auto &hash : hashes) {
+      TRY_RESULT(cell, load_cell(hash));
+      res.push_back(std::move(cell));
+    }
+    return res;
+  }
+  td::Result<Ref<DataCell>> load_root_local(const CellHash &hash) const {
+    return core_->load_root(hash);
+  }
+  td::Result<std::vector<Ref<DataCell>>> load_known_roots_local() const {
+    return core_->load_roots();
+  }
+  td::Result<Ref<DataCell>> load_root_shared(const CellHash &hash) const {
+    return core_->load_root(hash);
+  }
+
+  void erase(const CellHash &hash) {
+    if (core_->erase(hash)) {
+      CHECK(stats_.roots_total_count > 0);
+      stats_.roots_total_count--;
+    }
+  }
+  void add_new_root(Ref<DataCell> cell) {
+    if (core_->add_root(std::move(cell))) {
+      stats_.roots_total_count++;
+    }
+  }
+  void set(td::int32 refcnt, Ref<DataCell> cell) {
+    core_->set(refcnt, cell);
+  }
+
+ private:
+  std::shared_ptr<Core> core_;
+  DynamicBagOfCellsDb::Stats stats_;
+};
+
 class MetaStorage {
  public:
   explicit MetaStorage(std::vector<std::pair<std::string, std::string>> values)
@@ -817,9 +1476,10 @@ class MetaStorage {
   std::vector<CellStorer::MetaDiff> meta_diffs_;
 };
 
+template <class StorageT>
 class InMemoryBagOfCellsDb : public DynamicBagOfCellsDb {
  public:
-  explicit InMemoryBagOfCellsDb(td::unique_ptr<CellStorage> storage, td::unique_ptr<MetaStorage> meta_storage)
+  explicit InMemoryBagOfCellsDb(td::unique_ptr<StorageT> storage, td::unique_ptr<MetaStorage> meta_storage)
       : storage_(std::move(storage)), meta_storage_(std::move(meta_storage)) {
   }
 
@@ -962,7 +1622,7 @@ class InMemoryBagOfCellsDb : public DynamicBagOfCellsDb {
   }
 
  private:
-  td::unique_ptr<CellStorage> storage_;
+  td::unique_ptr<StorageT> storage_;
   td::unique_ptr<MetaStorage> meta_storage_;
 
   struct Info {
@@ -995,7 +1655,7 @@ class InMemoryBagOfCellsDb : public DynamicBagOfCellsDb {
       }
     };
   };
-  td::HashSet<Info, Info::Hash, Info::Eq> info_;
+  td::HashSet<Info, typename Info::Hash, typename Info::Eq> info_;
 
   std::unique_ptr<CellLoader> loader_;
   std::vector<Ref<Cell>> to_inc_;
@@ -1052,9 +1712,13 @@ std::unique_ptr<DynamicBagOfCellsDb> DynamicBagOfCellsDb::create_in_memory(td::K
                                                                            CreateInMemoryOptions options) {
   if (kv == nullptr) {
     LOG_IF(WARNING, options.verbose) << "Create empty in-memory cells database (no key value is given)";
-    auto storage = CellStorage::build(options, [](auto, auto, auto) { return std::make_pair(0, 0); });
     auto meta_storage = td::make_unique<MetaStorage>(std::vector<std::pair<std::string, std::string>>{});
-    return std::make_unique<InMemoryBagOfCellsDb>(std::move(storage), std::move(meta_storage));
+    if (options.compact) {
+      return std::make_unique<InMemoryBagOfCellsDb<CompactCellStorage>>(CompactCellStorage::build_empty(options),
+                                                                         std::move(meta_storage));
+    }
+    auto storage = CellStorage::build(options, [](auto, auto, auto) { return std::make_pair(0, 0); });
+    return std::make_unique<InMemoryBagOfCellsDb<CellStorage>>(std::move(storage), std::move(meta_storage));
   }
 
   std::vector<std::string> keys;
@@ -1103,7 +1767,13 @@ std::unique_ptr<DynamicBagOfCellsDb> DynamicBagOfCellsDb::create_in_memory(td::K
     return std::make_pair(cell_count.load(), desc_count.load());
   };
 
-  auto storage = CellStorage::build(options, parallel_scan_cells);
+  td::unique_ptr<CellStorage> storage;
+  td::unique_ptr<CompactCellStorage> compact_storage;
+  if (options.compact) {
+    compact_storage = CompactCellStorage::build(options, parallel_scan_cells);
+  } else {
+    storage = CellStorage::build(options, parallel_scan_cells);
+  }
 
   std::vector<std::pair<std::string, std::string>> meta;
   // NB: it scans 1/(2^32) of the database which is not much
@@ -1122,6 +1792,10 @@ std::unique_ptr<DynamicBagOfCellsDb> DynamicBagOfCellsDb::create_in_memory(td::K
   });
   auto meta_storage = td::make_unique<MetaStorage>(std::move(meta));
 
-  return std::make_unique<InMemoryBagOfCellsDb>(std::move(storage), std::move(meta_storage));
+  if (compact_storage) {
+    return std::make_unique<InMemoryBagOfCellsDb<CompactCellStorage>>(std::move(compact_storage),
+                                                                       std::move(meta_storage));
+  }
+  return std::make_unique<InMemoryBagOfCellsDb<CellStorage>>(std::move(storage), std::move(meta_storage));
 }
 }  // namespace vm
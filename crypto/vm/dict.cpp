@@ -18,6 +18,7 @@
 */
 #include "vm/dict.h"
 #include "vm/cells.h"
+#include "vm/cells/CellTreeSplit.h"
 #include "vm/cellslice.h"
 #include "vm/stack.hpp"
 #include "common/bitstring.h"
@@ -2513,6 +2514,136 @@ bool DictionaryFixed::scan_diff(DictionaryFixed& dict2, const scan_diff_func_t&
   }
 }
 
+namespace {
+struct ScanDiffTask {
+  Ref<Cell> dict1, dict2;
+  int n;  // the first key_len - n bits of all keys are in prefix
+  unsigned char prefix[DictionaryBase::max_key_bytes];
+};
+}  // namespace
+
+bool DictionaryFixed::scan_diff_batched(DictionaryFixed& dict2, const scan_diff_batch_func_t& diff_func,
+                                        int check_augm, size_t extra_threads, size_t batch_size) {
+  force_validate();
+  dict2.force_validate();
+  int key_len = get_key_bits();
+  if (key_len != dict2.get_key_bits()) {
+    throw VmError{Excno::dict_err, "cannot compare dictionaries with different key lengths"};
+  }
+  auto root1 = get_root_cell(), root2 = dict2.get_root_cell();
+  ScanDiffBatch batch{key_len};
+  auto flush = [&]() {
+    bool ok = batch.empty() || diff_func(batch);
+    batch.clear();
+    return ok;
+  };
+  auto add_diff = [&](td::ConstBitPtr key, int, Ref<CellSlice> old_value, Ref<CellSlice> new_value) {
+    batch.add(key, std::move(old_value), std::move(new_value));
+    return batch.size() < batch_size || flush();
+  };
+  // cells with a usage tree must not be loaded from several threads
+  if (extra_threads == 0 || (root1.not_null() && !root1->get_tree_node().empty()) ||
+      (root2.not_null() && !root2->get_tree_node().empty())) {
+    unsigned char key_buffer[max_key_bytes];
+    try {
+      return dict_scan_diff(std::move(root1), std::move(root2), td::BitPtr{key_buffer}, key_len, key_len, add_diff,
+                            check_augm) &&
+             flush();
+    } catch (CombineError) {
+      return false;
+    }
+  }
+
+  // forks with equal labels in both dictionaries are expanded here, the subtrees below them are disjoint
+  ScanDiffTask root_task{std::move(root1), std::move(root2), key_len, {}};
+  auto tasks = detail::split_cell_tree(root_task, (extra_threads + 1) * 16, [&](ScanDiffTask& task,
+                                                                                std::vector<ScanDiffTask>& children) {
+    if (task.dict1.is_null() && task.dict2.is_null()) {
+      return true;
+    }
+    if (task.dict1.is_null() || task.dict2.is_null()) {
+      return false;
+    }
+    if (task.dict1 == task.dict2 || task.dict1->get_hash() == task.dict2->get_hash()) {
+      return true;
+    }
+    LabelParser label1{task.dict1, task.n, label_mode()}, label2{task.dict2, task.n, label_mode()};
+    int l = label1.l_bits;
+    td::BitPtr key{task.prefix};
+    key += key_len - task.n;
+    if (l >= task.n || label2.l_bits != l) {
+      return false;
+    }
+    label1.extract_label_to(key);
+    if (label2.common_prefix_len(key, l) != l) {
+      return false;
+    }
+    label2.skip_label();
+    int m = task.n - l - 1;
+    if ((check_augm & 1) && !check_fork_raw(label1.remainder, m + 1)) {
+      throw VmError{Excno::dict_err, "invalid fork in the first dictionary being compared"};
+    }
+    if ((check_augm & 2) && !check_fork_raw(label2.remainder, m + 1)) {
+      throw VmError{Excno::dict_err, "invalid fork in the second dictionary being compared"};
+    }
+    for (unsigned sw = 0; sw <= 1; sw++) {
+      key[l] = (bool)sw;
+      children.push_back(
+          ScanDiffTask{label1.remainder->prefetch_ref(sw), label2.remainder->prefetch_ref(sw), m, {}});
+      std::memcpy(children.back().prefix, task.prefix, sizeof(task.prefix));
+    }
+    return true;
+  });
+  // the prefixes of the subtrees are disjoint, so ordering them orders all keys
+  std::sort(tasks.begin(), tasks.end(), [&](const ScanDiffTask& a, const ScanDiffTask& b) {
+    return td::bitstring::bits_memcmp(td::ConstBitPtr{a.prefix}, td::ConstBitPtr{b.prefix},
+                                      key_len - std::max(a.n, b.n)) < 0;
+  });
+
+  // the differences of a subtree are delivered as soon as it and all subtrees before it are compared
+  std::vector<ScanDiffBatch> results(tasks.size(), ScanDiffBatch{key_len});
+  std::vector<std::exception_ptr> errors(tasks.size());
+  return detail::parallel_run_ordered(
+      tasks.size(),
+      [&](size_t i) {
+        auto& task = tasks[i];
+        auto& result = results[i];
+        unsigned char key_buffer[max_key_bytes];
+        std::memcpy(key_buffer, task.prefix, sizeof(key_buffer));
+        try {
+          dict_scan_diff(
+              std::move(task.dict1), std::move(task.dict2), td::BitPtr{key_buffer} + (key_len - task.n), task.n,
+              key_len,
+              [&](td::ConstBitPtr key, int, Ref<CellSlice> old_value, Ref<CellSlice> new_value) {
+                result.add(key, std::move(old_value), std::move(new_value));
+                return true;
+              },
+              check_augm);
+        } catch (...) {
+          errors[i] = std::current_exception();
+        }
+      },
+      [&](size_t i) {
+        if (errors[i]) {
+          try {
+            std::rethrow_exception(errors[i]);
+          } catch (CombineError) {
+            return false;
+          }
+        }
+        auto result = std::move(results[i]);
+        for (size_t j = 0; j < result.size(); j++) {
+          if (!add_diff(result.key(j), key_len, std::move(result.values[j].first),
+                        std::move(result.values[j].second))) {
+            return false;
+          }
+        }
+        return true;
+      },
+      extra_threads) &&
+         flush();
+}
+
 bool DictionaryFixed::dict_validate_check(Ref<Cell> dict, td::BitPtr key_buffer, int n, int total_key_len,
                                           const DictionaryFixed::foreach_func_t& foreach_func,
                                           bool invert_first) const {
@@ -3129,6 +3260,144 @@ bool AugmentedDictionary::set_builder(td::ConstBitPtr key, int key_len, const Ce
   return set(key, key_len, load_cell_slice(value.finalize_copy()));
 }
 
+bool AugmentedDictionary::multiset(td::MutableSpan<std::pair<td::ConstBitPtr, Ref<CellSlice>>> new_values) {
+  force_validate();
+  if (!is_valid()) {
+    return false;
+  }
+  auto cmp = [&](const std::pair<td::ConstBitPtr, Ref<CellSlice>>& a,
+                 const std::pair<td::ConstBitPtr, Ref<CellSlice>>& b) {
+    return td::bitstring::bits_memcmp(a.first, b.first, key_bits) < 0;
+  };
+  if (!std::is_sorted(new_values.begin(), new_values.end(), cmp)) {
+    std::sort(new_values.begin(), new_values.end(), cmp);
+  }
+  for (size_t i = 0; i + 1 < new_values.size(); ++i) {
+    if (td::bitstring::bits_memcmp(new_values[i].first, new_values[i + 1].first, key_bits) == 0) {
+      return false;
+    }
+  }
+  try {
+    set_root_cell(dict_multiset(get_root_cell(), new_values, key_bits));
+    return true;
+  } catch (CombineError) {
+    return false;
+  }
+}
+
+// values are sorted, all keys have the same first key_bits - n bits as the keys of dict
+Ref<Cell> AugmentedDictionary::dict_multiset(Ref<Cell> dict, td::Span<std::pair<td::ConstBitPtr, Ref<CellSlice>>> values,
+                                             int n) const {
+  if (values.empty()) {
+    return dict;
+  }
+  if (dict.is_null()) {
+    return dict_build(values, n);
+  }
+  int prefix_len = key_bits - n;
+  LabelParser label{std::move(dict), n, label_mode()};
+  unsigned char label_buffer[max_key_bytes];
+  td::BitPtr label_bits{label_buffer};
+  label.extract_label_to(label_bits);
+  // all keys between the first and the last one share a prefix with both of them
+  int c = label.l_bits;
+  for (const auto& value : {values.front(), values.back()}) {
+    std::size_t common;
+    td::bitstring::bits_memcmp(value.first + prefix_len, label_bits, c, &common);
+    c = std::min(c, static_cast<int>(common));
+  }
+  if (c == n) {
+    // the edge leads to a leaf with the only key
+    CHECK(values.size() == 1);
+    if (values[0].second.is_null()) {
+      return {};
+    }
+    CellBuilder cb;
+    append_dict_label(cb, label_bits, n, n);
+    return finish_create_leaf(cb, *values[0].second);
+  }
+  size_t idx = 0;
+  while (idx < values.size() && !values[idx].first[prefix_len + c]) {
+    ++idx;
+  }
+  auto values_left = values.substr(0, idx);
+  auto values_right = values.substr(idx);
+  Ref<Cell> c1, c2;
+  if (c == label.l_bits) {
+    // all keys go into the subtrees of the fork
+    c1 = dict_multiset(label.remainder->prefetch_ref(0), values_left, n - c - 1);
+    c2 = dict_multiset(label.remainder->prefetch_ref(1), values_right, n - c - 1);
+  } else {
+    // the edge is split by a new fork, the lower part of the edge keeps the old payload
+    int m = n - c - 1;
+    CellBuilder cb;
+    append_dict_label(cb, label_bits + c + 1, label.l_bits - c - 1, m);
+    if (!cell_builder_add_slice_bool(cb, *label.remainder)) {
+      throw VmError{Excno::cell_ov, "cannot change label of an old augmented dictionary cell"};
+    }
+    auto old = cb.finalize();
+    if (label_bits[c]) {
+      c1 = dict_build(values_left, m);
+      c2 = dict_multiset(std::move(old), values_right, m);
+    } else {
+      c1 = dict_multiset(std::move(old), values_left, m);
+      c2 = dict_build(values_right, m);
+    }
+  }
+  label.remainder.clear();
+  return create_fork_or_merge(label_bits, c, n, std::move(c1), std::move(c2));
+}
+
+Ref<Cell> AugmentedDictionary::dict_build(td::Span<std::pair<td::ConstBitPtr, Ref<CellSlice>>> values, int n) const {
+  if (values.empty()) {
+    return {};
+  }
+  int prefix_len = key_bits - n;
+  if (values.size() == 1) {
+    if (values[0].second.is_null()) {
+      // cannot delete an absent key
+      throw CombineError{};
+    }
+    CellBuilder cb;
+    append_dict_label(cb, values[0].first + prefix_len, n, n);
+    return finish_create_leaf(cb, *values[0].second);
+  }
+  std::size_t c;
+  td::bitstring::bits_memcmp(values.front().first + prefix_len, values.back().first + prefix_len, n, &c);
+  CHECK(static_cast<int>(c) < n);
+  size_t idx = 0;
+  while (!values[idx].first[prefix_len + c]) {
+    ++idx;
+  }
+  auto c1 = dict_build(values.substr(0, idx), n - static_cast<int>(c) - 1);
+  auto c2 = dict_build(values.substr(idx), n - static_cast<int>(c) - 1);
+  CellBuilder cb;
+  append_dict_label(cb, values[0].first + prefix_len, static_cast<int>(c), n);
+  return finish_create_fork(cb, std::move(c1), std::move(c2), n - static_cast<int>(c));
+}
+
+// creates a fork with l-bit label, or merges the edge with the only non-empty child; label is used as a buffer
+Ref<Cell> AugmentedDictionary::create_fork_or_merge(td::BitPtr label, int l, int n, Ref<Cell> c1, Ref<Cell> c2) const {
+  if (c1.is_null() && c2.is_null()) {
+    return {};
+  }
+  CellBuilder cb;
+  if (c1.not_null() && c2.not_null()) {
+    append_dict_label(cb, label, l, n);
+    return finish_create_fork(cb, std::move(c1), std::move(c2), n - l);
+  }
+  bool sw = c1.is_null();
+  label[l] = sw;
+  LabelParser label2{sw ? std::move(c2) : std::move(c1), n - l - 1, label_mode()};
+  label2.extract_label_to(label + l + 1);
+  append_dict_label(cb, label, l + 1 + label2.l_bits, n);
+  // the payload (and the extra) of the child does not change
+  if (!cell_builder_add_slice_bool(cb, *label2.remainder)) {
+    throw VmError{Excno::cell_ov, "cannot change label of an old augmented dictionary cell while merging edges"};
+  }
+  return cb.finalize();
+}
+
 bool AugmentedDictionary::check_for_each_extra(const foreach_extra_func_t& foreach_extra_func, bool invert_first) {
   force_validate();
   const auto& augm = aug;
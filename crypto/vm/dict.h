@@ -173,6 +173,39 @@ class DictionaryBase {
 
 class DictIterator;
 
+// differences found by DictionaryFixed::scan_diff_batched, in the order of keys
+struct ScanDiffBatch {
+  int key_len{0};
+  std::vector<unsigned char> keys;
+  std::vector<std::pair<Ref<CellSlice>, Ref<CellSlice>>> values;
+
+  explicit ScanDiffBatch(int key_len = 0) : key_len(key_len) {
+  }
+  size_t size() const {
+    return values.size();
+  }
+  bool empty() const {
+    return values.empty();
+  }
+  td::ConstBitPtr key(size_t i) const {
+    return td::ConstBitPtr{keys.data() + i * key_bytes()};
+  }
+  void add(td::ConstBitPtr key, Ref<CellSlice> old_value, Ref<CellSlice> new_value) {
+    keys.resize(keys.size() + key_bytes());
+    td::BitPtr{keys.data() + values.size() * key_bytes()}.copy_from(key, key_len);
+    values.emplace_back(std::move(old_value), std::move(new_value));
+  }
+  void clear() {
+    keys.clear();
+    values.clear();
+  }
+
+ private:
+  size_t key_bytes() const {
+    return (key_len + 7) / 8;
+  }
+};
+
 template <typename T>
 std::pair<T, int> dict_range(T&& dict, bool rev = false, bool sgnd = false) {
   return std::pair<T, int>{std::forward<T>(dict), (int)rev + 2 * (int)sgnd};
@@ -185,6 +218,7 @@ class DictionaryFixed : public DictionaryBase {
   typedef std::function<bool(CellBuilder&, Ref<CellSlice>, Ref<CellSlice>, td::ConstBitPtr, int)> combine_func_t;
   typedef std::function<bool(Ref<CellSlice>, td::ConstBitPtr, int)> foreach_func_t;
   typedef std::function<bool(td::ConstBitPtr, int, Ref<CellSlice>, Ref<CellSlice>)> scan_diff_func_t;
+  typedef std::function<bool(const ScanDiffBatch&)> scan_diff_batch_func_t;
 
   DictionaryFixed(int _n, bool validate = true) : DictionaryBase(_n, validate) {
   }
@@ -229,6 +263,11 @@ class DictionaryFixed : public DictionaryBase {
   bool combine_with(DictionaryFixed& dict2, const simple_combine_func_t& simple_combine_func, int mode = 0);
   bool combine_with(DictionaryFixed& dict2);
   bool scan_diff(DictionaryFixed& dict2, const scan_diff_func_t& diff_func, int check_augm = 0);
+  // same as scan_diff, but differences are delivered in batches of up to batch_size entries on the calling thread;
+  // with extra_threads > 0 disjoint subtrees below the top levels are compared on that many additional threads,
+  // and each batch is delivered as soon as the subtrees it comes from are compared
+  bool scan_diff_batched(DictionaryFixed& dict2, const scan_diff_batch_func_t& diff_func, int check_augm = 0,
+                         size_t extra_threads = 0, size_t batch_size = 1024);
   bool validate_check(const foreach_func_t& foreach_func, bool invert_first = false);
   bool validate_all();
   DictIterator null_iterator();
@@ -591,6 +630,9 @@ class AugmentedDictionary final : public DictionaryFixed {
   bool set(td::ConstBitPtr key, int key_len, Ref<CellSlice> value, SetMode mode = SetMode::Set);
   bool set_ref(td::ConstBitPtr key, int key_len, Ref<Cell> val_ref, SetMode mode = SetMode::Set);
   bool set_builder(td::ConstBitPtr key, int key_len, const CellBuilder& value, SetMode mode = SetMode::Set);
+  // sets values for many keys at once (a null value deletes the key, which must be present);
+  // each affected fork is rebuilt and its extra recomputed only once
+  bool multiset(td::MutableSpan<std::pair<td::ConstBitPtr, Ref<CellSlice>>> new_values);
   bool check_for_each_extra(const foreach_extra_func_t& foreach_extra_func, bool invert_first = false);
   std::pair<Ref<CellSlice>, Ref<CellSlice>> traverse_extra(td::BitPtr key_buffer, int key_len,
                                                            const traverse_func_t& traverse_node);
@@ -647,6 +689,9 @@ class AugmentedDictionary final : public DictionaryFixed {
   Ref<Cell> finish_create_fork(CellBuilder& cb, Ref<Cell> c1, Ref<Cell> c2, int n) const override;
   std::pair<Ref<Cell>, bool> dict_set(Ref<Cell> dict, td::ConstBitPtr key, int n, const CellSlice& value,
                                       SetMode mode = SetMode::Set) const;
+  Ref<Cell> dict_multiset(Ref<Cell> dict, td::Span<std::pair<td::ConstBitPtr, Ref<CellSlice>>> values, int n) const;
+  Ref<Cell> dict_build(td::Span<std::pair<td::ConstBitPtr, Ref<CellSlice>>> values, int n) const;
+  Ref<Cell> create_fork_or_merge(td::BitPtr label, int l, int n, Ref<Cell> c1, Ref<Cell> c2) const;
   int label_mode() const override {
     return dict::LabelParser::chk_size;
   }
@@ -24,6 +24,8 @@
 #include "cp0.h"
 #include "memo.h"
 
+#include "td/utils/ScopeGuard.h"
+
 #include <sodium.h>
 
 namespace vm {
@@ -507,6 +509,11 @@ int VmState::run() {
     // throw VmError{Excno::fatal, "cannot run an uninitialized VM"};
     return (int)Excno::fatal;  // no ~ for unhandled exceptions
   }
+  // the mode of the caller is restored on exit, VMs may be nested
+  auto prev_lazy_hashes = std::exchange(DataCell::use_lazy_hashes, lazy_cell_hashes);
+  SCOPE_EXIT {
+    DataCell::use_lazy_hashes = prev_lazy_hashes;
+  };
   int res = 0;
   bool restore_parent = false;
   while (true) {
@@ -100,6 +100,7 @@ class VmState final : public VmStateInterface {
   int stack_trace{0}, debug_off{0};
   bool chksig_always_succeed{false};
   bool stop_on_accept_message{false};
+  bool lazy_cell_hashes{false};
   td::optional<td::Bits256> missing_library;
   td::uint16 max_data_depth = 512; // Default value
   int global_version{0};
@@ -412,6 +413,10 @@ class VmState final : public VmStateInterface {
   bool get_stop_on_accept_message() const {
     return stop_on_accept_message;
   }
+  // cells created by the VM get their hashes computed on first use, see DataCell::use_lazy_hashes
+  void set_lazy_cell_hashes(bool flag) {
+    lazy_cell_hashes = flag;
+  }
   Ref<OrdCont> ref_to_cont(Ref<Cell> cell) const {
     return td::make_ref<OrdCont>(load_cell_slice_ref(std::move(cell)), get_cp());
   }
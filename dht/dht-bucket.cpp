@@ -23,6 +23,8 @@
 
 #include "td/utils/format.h"
 
+#include <limits>
+
 #include "keys/encryptor.h"
 
 #include "auto/tl/ton_api.hpp"
@@ -41,12 +43,15 @@ void DhtBucket::get_nearest_nodes(DhtKeyId id, td::uint32 bit, DhtNodesList &vec
   if (active_nodes_.size() == 0) {
     return;
   }
-  std::map<DhtKeyId, size_t> list;
+  // all nodes of a bucket share the same distance prefix to us, so prefer the ones that answer faster;
+  // nodes with unknown rtt go last, ties are broken by distance to the key
+  std::map<std::pair<double, DhtKeyId>, size_t> list;
 
   for (size_t i = 0; i < active_nodes_.size(); i++) {
     auto &node = active_nodes_[i];
     if (node) {
-      list.emplace(id ^ node->get_key(), i);
+      double rtt = node->rtt() > 0 ? node->rtt() : std::numeric_limits<double>::max();
+      list.emplace(std::make_pair(rtt, id ^ node->get_key()), i);
     }
   }
 
@@ -146,6 +151,21 @@ void DhtBucket::receive_ping(DhtKeyId id, DhtNode result, td::actor::ActorId<adn
   }
 }
 
+void DhtBucket::update_rtt(DhtKeyId id, double rtt) {
+  for (auto &node : active_nodes_) {
+    if (node && node->get_key() == id) {
+      node->update_rtt(rtt);
+      return;
+    }
+  }
+  for (auto &node : backup_nodes_) {
+    if (node && node->get_key() == id) {
+      node->update_rtt(rtt);
+      return;
+    }
+  }
+}
+
 void DhtBucket::demote_node(size_t idx) {
   size_t new_idx = select_backup_node_to_drop();
   if (new_idx < backup_nodes_.size()) {
@@ -197,13 +217,13 @@ void DhtBucket::dump(td::StringBuilder &sb) const {
   sb << "    active:\n";
   for (auto &node : active_nodes_) {
     if (node) {
-      sb << "      " << node->get_key() << "\n";
+      sb << "      " << node->get_key() << " rtt=" << node->rtt() << "\n";
     }
   }
   sb << "    backup:\n";
   for (auto &node : backup_nodes_) {
     if (node) {
-      sb << "      " << node->get_key() << "\n";
+      sb << "      " << node->get_key() << " rtt=" << node->rtt() << "\n";
     }
   }
 }
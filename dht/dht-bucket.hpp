@@ -55,6 +55,7 @@ class DhtBucket {
   void check(bool client_only, td::actor::ActorId<adnl::Adnl> adnl, td::actor::ActorId<DhtMember> node,
              adnl::AdnlNodeIdShort src);
   void receive_ping(DhtKeyId id, DhtNode result, td::actor::ActorId<adnl::Adnl> adnl, adnl::AdnlNodeIdShort self_id);
+  void update_rtt(DhtKeyId id, double rtt);
   void get_nearest_nodes(DhtKeyId id, td::uint32 bit, DhtNodesList &vec, td::uint32 k);
   void dump(td::StringBuilder &sb) const;
   DhtNodesList export_nodes() const;
@@ -34,9 +34,14 @@ class DhtMemberImpl : public DhtMember {
  private:
   class DhtKeyValueLru : public td::ListNode {
    public:
-    DhtKeyValueLru(DhtValue value) : kv_(std::move(value)) {
+    DhtKeyValueLru(DhtValue value, td::Timestamp refresh_at) : kv_(std::move(value)), refresh_at_(refresh_at) {
     }
     DhtValue kv_;
+    // the value is served until its own ttl, but looked up again in background once this is in the past
+    td::Timestamp refresh_at_;
+    bool expired() const {
+      return kv_.expired();
+    }
     static inline DhtKeyValueLru *from_list_node(ListNode *node) {
       return static_cast<DhtKeyValueLru *>(node);
     }
@@ -58,6 +63,14 @@ class DhtMemberImpl : public DhtMember {
   std::map<DhtKeyId, DhtValue> values_;
   std::set<std::pair<td::uint32, DhtKeyId>> values_ttl_order_;
 
+  // results of our own lookups, persisted to db to speed up resolving after restart
+  std::map<DhtKeyId, std::unique_ptr<DhtKeyValueLru>> cached_values_;
+  td::ListNode cached_values_lru_;
+  // lookups in progress: concurrent requests for the same key share one query (no promises for background refresh)
+  std::map<DhtKeyId, std::vector<td::Promise<DhtValue>>> pending_lookups_;
+  // lookups waiting for the signed self node; started together once it is ready
+  std::vector<DhtKeyId> queued_lookups_;
+
   td::Timestamp fill_att_ = td::Timestamp::in(0);
   td::Timestamp republish_att_ = td::Timestamp::in(0);
 
@@ -107,12 +120,22 @@ class DhtMemberImpl : public DhtMember {
   td::uint64 find_value_queries_{0};
   td::uint64 store_queries_{0};
   td::uint64 get_addr_list_queries_{0};
+  td::uint64 cache_hits_{0};
+  td::uint64 cache_misses_{0};
 
   using DbType = td::KeyValueAsync<td::Bits256, td::BufferSlice>;
   DbType db_;
   td::Timestamp next_save_to_db_at_ = td::Timestamp::in(10.0);
+  td::Timestamp next_save_cache_to_db_at_ = td::Timestamp::in(60.0);
 
   void save_to_db();
+  void save_cache_to_db();
+
+  void add_cached_value(DhtValue value, td::Timestamp refresh_at);
+  DhtKeyValueLru *get_cached_value(DhtKeyId key);
+  void queue_lookup(DhtKeyId key);
+  void start_lookups(DhtNode self);
+  void finish_lookup(DhtKeyId key, td::Result<DhtValue> R);
 
   DhtNodesList get_nearest_nodes(DhtKeyId id, td::uint32 k);
   void check();
@@ -158,6 +181,7 @@ class DhtMemberImpl : public DhtMember {
   }
 
   void receive_ping(DhtKeyId id, DhtNode result) override;
+  void update_node_rtt(DhtKeyId id, double rtt) override;
 
   void set_value(DhtValue key_value, td::Promise<td::Unit> result) override;
   td::uint32 distance(DhtKeyId key_id, td::uint32 max_value);
@@ -176,6 +200,7 @@ class DhtMemberImpl : public DhtMember {
     get_value_in(key.compute_key_id(), std::move(result));
   }
   void get_value_many(DhtKey key, std::function<void(DhtValue)> callback, td::Promise<td::Unit> promise) override;
+  void get_values(std::vector<DhtKey> keys, td::Promise<std::vector<td::Result<DhtValue>>> promise) override;
 
   void alarm() override {
     alarm_timestamp() = td::Timestamp::in(1.0);
@@ -192,6 +217,8 @@ class DhtMemberImpl : public DhtMember {
 
   static constexpr size_t MAX_VALUES = 100000;
   static constexpr size_t MAX_REVERSE_CONNECTIONS = 100000;
+  static constexpr size_t MAX_CACHED_VALUES = 10000;
+  static constexpr double CACHED_VALUE_REFRESH_PERIOD = 30.0;
 };
 
 }  // namespace dht
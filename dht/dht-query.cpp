@@ -52,6 +52,7 @@ void DhtQuery::send_queries() {
     CHECK(it != nodes_.end());
     td::actor::send_closure(adnl_, &adnl::Adnl::add_peer, get_src(), it->second.node.adnl_id(),
                             it->second.node.addr_list());
+    query_sent(id.to_adnl());
     send_one_query(id.to_adnl());
   }
   if (active_queries_ == 0) {
@@ -84,11 +85,22 @@ void DhtQuery::add_nodes(DhtNodesList list) {
   }
 }
 
+void DhtQuery::query_sent(adnl::AdnlNodeIdShort id) {
+  auto it = nodes_.find(key_ ^ DhtKeyId(id));
+  if (it != nodes_.end()) {
+    it->second.sent_at = td::Time::now();
+  }
+}
+
 void DhtQuery::finish_query(adnl::AdnlNodeIdShort id, bool success) {
   active_queries_--;
   CHECK(active_queries_ <= k_);
   auto id_xor = key_ ^ DhtKeyId(id);
   if (success) {
+    auto it = nodes_.find(id_xor);
+    if (it != nodes_.end() && it->second.sent_at > 0) {
+      td::actor::send_closure(node_, &DhtMember::update_node_rtt, DhtKeyId(id), td::Time::now() - it->second.sent_at);
+    }
     result_list_.insert(id_xor);
     if (result_list_.size() > k_) {
       result_list_.erase(--result_list_.end());
@@ -169,6 +181,7 @@ void DhtQueryFindValue::send_one_query_nodes(adnl::AdnlNodeIdShort id) {
   auto Pr = td::PromiseCreator::lambda([SelfId = actor_id(this), dst = id](td::Result<td::BufferSlice> R) {
     td::actor::send_closure(SelfId, &DhtQueryFindValue::on_result_nodes, std::move(R), dst);
   });
+  query_sent(id);
 
   td::actor::send_closure(adnl_, &adnl::Adnl::send_query, get_src(), id, "dht findValue", std::move(Pr),
                           td::Timestamp::in(2.0 + td::Random::fast(0, 20) * 0.1), std::move(B));
@@ -275,6 +288,35 @@ void DhtQueryFindValueMany::tear_down() {
   }
 }
 
+void DhtQueryGetValues::start_up() {
+  remaining_ = keys_.size();
+  for (size_t i = 0; i < keys_.size(); i++) {
+    result_.emplace_back(td::Status::Error(ErrorCode::notready, "dht key not found"));
+  }
+  if (remaining_ == 0) {
+    promise_.set_value(std::move(result_));
+    stop();
+    return;
+  }
+  // DhtMember shares in-flight lookups and the result cache between keys, so duplicates are resolved once
+  for (size_t i = 0; i < keys_.size(); i++) {
+    auto P = td::PromiseCreator::lambda([SelfId = actor_id(this), i](td::Result<DhtValue> R) {
+      td::actor::send_closure(SelfId, &DhtQueryGetValues::got_value, i, std::move(R));
+    });
+    td::actor::send_closure(node_, &DhtMember::get_value_in, keys_[i], std::move(P));
+  }
+}
+
+void DhtQueryGetValues::got_value(size_t idx, td::Result<DhtValue> R) {
+  result_[idx] = std::move(R);
+  CHECK(remaining_ > 0);
+  if (--remaining_ == 0) {
+    VLOG(DHT_EXTRA_DEBUG) << this << ": resolved " << keys_.size() << " keys";
+    promise_.set_value(std::move(result_));
+    stop();
+  }
+}
+
 DhtQueryStore::DhtQueryStore(DhtValue key_value, DhtMember::PrintId print_id, adnl::AdnlNodeIdShort src,
                              DhtNodesList list, td::uint32 k, td::uint32 a, td::int32 our_network_id, DhtNode self,
                              bool client_only, td::actor::ActorId<DhtMember> node, td::actor::ActorId<adnl::Adnl> adnl,
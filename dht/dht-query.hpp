@@ -64,6 +64,8 @@ class DhtQuery : public td::actor::Actor {
   void send_queries();
   void add_nodes(DhtNodesList list);
   void finish_query(adnl::AdnlNodeIdShort id, bool success = true);
+  // records the send time of a query to the node, used to measure its rtt in finish_query
+  void query_sent(adnl::AdnlNodeIdShort id);
   DhtKeyId get_key() const {
     return key_;
   }
@@ -87,6 +89,7 @@ class DhtQuery : public td::actor::Actor {
   struct NodeInfo {
     DhtNode node;
     int failed_attempts = 0;
+    double sent_at = 0;
   };
   DhtMember::PrintId print_id_;
   adnl::AdnlNodeIdShort src_;
@@ -185,6 +188,27 @@ class DhtQueryFindValueMany : public DhtQueryFindValue {
   bool found_ = false;
 };
 
+class DhtQueryGetValues : public td::actor::Actor {
+ private:
+  std::vector<DhtKeyId> keys_;
+  DhtMember::PrintId print_id_;
+  td::actor::ActorId<DhtMember> node_;
+  td::Promise<std::vector<td::Result<DhtValue>>> promise_;
+  std::vector<td::Result<DhtValue>> result_;
+  size_t remaining_ = 0;
+
+ public:
+  DhtQueryGetValues(std::vector<DhtKeyId> keys, DhtMember::PrintId print_id, td::actor::ActorId<DhtMember> node,
+                    td::Promise<std::vector<td::Result<DhtValue>>> promise)
+      : keys_(std::move(keys)), print_id_(print_id), node_(node), promise_(std::move(promise)) {
+  }
+  void start_up() override;
+  void got_value(size_t idx, td::Result<DhtValue> R);
+  DhtMember::PrintId print_id() const {
+    return print_id_;
+  }
+};
+
 class DhtQueryStore : public td::actor::Actor {
  private:
   DhtMember::PrintId print_id_;
@@ -284,6 +308,16 @@ inline td::StringBuilder &operator<<(td::StringBuilder &sb, const DhtQuery *dht)
   return sb;
 }
 
+inline td::StringBuilder &operator<<(td::StringBuilder &sb, const DhtQueryGetValues &dht) {
+  sb << dht.print_id();
+  return sb;
+}
+
+inline td::StringBuilder &operator<<(td::StringBuilder &sb, const DhtQueryGetValues *dht) {
+  sb << dht->print_id();
+  return sb;
+}
+
 inline td::StringBuilder &operator<<(td::StringBuilder &sb, const DhtQueryStore &dht) {
   sb << dht.print_id();
   return sb;
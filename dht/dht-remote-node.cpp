@@ -35,6 +35,7 @@ namespace dht {
 static const double PING_INTERVAL_DEFAULT = 60.0;
 static const double PING_INTERVAL_MULTIPLIER = 1.1;
 static const double PING_INTERVAL_MAX = 3600.0 * 4;
+static const double RTT_SMOOTHING = 0.2;
 
 DhtRemoteNode::DhtRemoteNode(DhtNode node, td::uint32 max_missed_pings, td::int32 our_network_id)
     : node_(std::move(node))
@@ -60,6 +61,14 @@ void DhtRemoteNode::receive_ping() {
   }
 }
 
+void DhtRemoteNode::update_rtt(double rtt) {
+  if (rtt_ == 0) {
+    rtt_ = rtt;
+  } else {
+    rtt_ = rtt_ * (1 - RTT_SMOOTHING) + rtt * RTT_SMOOTHING;
+  }
+}
+
 td::Status DhtRemoteNode::update_value(DhtNode node, td::actor::ActorId<adnl::Adnl> adnl,
                                        adnl::AdnlNodeIdShort self_id) {
   if (node.adnl_id() != node_.adnl_id()) {
@@ -96,7 +105,8 @@ void DhtRemoteNode::send_ping(bool client_only, td::actor::ActorId<adnl::Adnl> a
       LOG(ERROR) << "[dht]: failed to get self node";
       return;
     }
-    auto P = td::PromiseCreator::lambda([key, node, adnl, our_network_id](td::Result<td::BufferSlice> R) {
+    auto P = td::PromiseCreator::lambda([key, node, adnl, our_network_id,
+                                         sent_at = td::Time::now()](td::Result<td::BufferSlice> R) {
       if (R.is_error()) {
         VLOG(DHT_INFO) << "[dht]: received error for query to " << key << ": " << R.move_as_error();
         return;
@@ -107,6 +117,7 @@ void DhtRemoteNode::send_ping(bool client_only, td::actor::ActorId<adnl::Adnl> a
         auto N = DhtNode::create(F.move_as_ok(), our_network_id);
         if (N.is_ok()) {
           td::actor::send_closure(node, &DhtMember::receive_ping, key, N.move_as_ok());
+          td::actor::send_closure(node, &DhtMember::update_node_rtt, key, td::Time::now() - sent_at);
         } else {
           VLOG(DHT_WARNING) << "[dht]: bad answer from " << key
                             << ": dropping bad getSignedAddressList() query answer: " << N.move_as_error();
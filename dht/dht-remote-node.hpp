@@ -46,6 +46,7 @@ class DhtRemoteNode {
   double ready_from_ = 0;
   double failed_from_ = 0;
   double ping_interval_;
+  double rtt_ = 0;
   td::int32 version_;
 
  public:
@@ -78,6 +79,10 @@ class DhtRemoteNode {
   double ping_interval() const {
     return ping_interval_;
   }
+  double rtt() const {
+    return rtt_;
+  }
+  void update_rtt(double rtt);
   void send_ping(bool client_only, td::actor::ActorId<adnl::Adnl> adnl, td::actor::ActorId<DhtMember> node,
                  adnl::AdnlNodeIdShort src);
   td::Status receive_ping(DhtNode node, td::actor::ActorId<adnl::Adnl> adnl, adnl::AdnlNodeIdShort self_id);
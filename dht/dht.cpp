@@ -119,6 +119,27 @@ void DhtMemberImpl::start_up() {
         }
       }
     }
+    {
+      auto key = create_hash_tl_object<ton_api::dht_db_key_cachedValues>();
+      std::string value;
+      auto R = kv->get(key.as_slice(), value);
+      R.ensure();
+      if (R.move_as_ok() == td::KeyValue::GetStatus::Ok) {
+        auto V = fetch_tl_object<ton_api::dht_db_cachedValues>(td::BufferSlice{value}, true);
+        if (V.is_ok()) {
+          for (auto &entry : V.ok_ref()->values_) {
+            auto value = DhtValue::create(std::move(entry), true);
+            if (value.is_ok()) {
+              // values may have changed while the node was down, refresh them on first use
+              add_cached_value(value.move_as_ok(), td::Timestamp::now());
+            }
+          }
+          VLOG(DHT_INFO) << this << ": loaded " << cached_values_.size() << " cached values from db";
+        } else {
+          VLOG(DHT_WARNING) << this << ": failed to load cached values: " << V.move_as_error();
+        }
+      }
+    }
     db_ = DbType{std::move(kv)};
   }
 }
@@ -158,6 +179,59 @@ void DhtMemberImpl::save_to_db() {
   }
 }
 
+void DhtMemberImpl::save_cache_to_db() {
+  if (db_root_.empty()) {
+    return;
+  }
+  next_save_cache_to_db_at_ = td::Timestamp::in(60.0);
+  alarm_timestamp().relax(next_save_cache_to_db_at_);
+
+  std::vector<tl_object_ptr<ton_api::dht_value>> values;
+  for (auto &p : cached_values_) {
+    if (!p.second->expired()) {
+      values.push_back(p.second->kv_.tl());
+    }
+  }
+  auto key = create_hash_tl_object<ton_api::dht_db_key_cachedValues>();
+  db_.set(key, create_serialize_tl_object<ton_api::dht_db_cachedValues>(std::move(values)));
+}
+
+void DhtMemberImpl::add_cached_value(DhtValue value, td::Timestamp refresh_at) {
+  if (value.expired()) {
+    return;
+  }
+  auto key_id = value.key_id();
+  auto &entry = cached_values_[key_id];
+  if (entry == nullptr) {
+    entry = std::make_unique<DhtKeyValueLru>(std::move(value), refresh_at);
+  } else {
+    entry->kv_ = std::move(value);
+    entry->refresh_at_ = refresh_at;
+    entry->remove();
+  }
+  cached_values_lru_.put(entry.get());
+  while (cached_values_.size() > MAX_CACHED_VALUES) {
+    auto to_remove = DhtKeyValueLru::from_list_node(cached_values_lru_.get());
+    CHECK(to_remove);
+    cached_values_.erase(to_remove->kv_.key_id());
+  }
+}
+
+DhtMemberImpl::DhtKeyValueLru *DhtMemberImpl::get_cached_value(DhtKeyId key) {
+  auto it = cached_values_.find(key);
+  if (it == cached_values_.end()) {
+    return nullptr;
+  }
+  auto entry = it->second.get();
+  if (entry->expired()) {
+    cached_values_.erase(it);
+    return nullptr;
+  }
+  entry->remove();
+  cached_values_lru_.put(entry);
+  return entry;
+}
+
 DhtNodesList DhtMemberImpl::get_nearest_nodes(DhtKeyId id, td::uint32 k) {
   DhtNodesList vec;
 
@@ -252,6 +326,8 @@ td::Status DhtMemberImpl::store_in(DhtValue value) {
   TRY_STATUS(value.check());
 
   auto key_id = value.key_id();
+  // a fresher value may have been published, do not serve the cached one anymore
+  cached_values_.erase(key_id);
 
   auto dist = distance(key_id, k_ + 10);
   if (dist < k_ + 10) {
@@ -427,6 +503,14 @@ void DhtMemberImpl::receive_ping(DhtKeyId key, DhtNode result) {
   }
 }
 
+void DhtMemberImpl::update_node_rtt(DhtKeyId key, double rtt) {
+  auto eid = key ^ key_;
+  auto bit = eid.count_leading_zeroes();
+  if (bit < 256) {
+    buckets_[bit].update_rtt(key, rtt);
+  }
+}
+
 void DhtMemberImpl::receive_message(adnl::AdnlNodeIdShort src, td::BufferSlice data) {
   auto F = fetch_tl_object<ton_api::dht_requestReversePingCont>(data, true);
   if (F.is_ok()) {
@@ -464,17 +548,79 @@ void DhtMemberImpl::set_value(DhtValue value, td::Promise<td::Unit> promise) {
 }
 
 void DhtMemberImpl::get_value_in(DhtKeyId key, td::Promise<DhtValue> result) {
-  auto P = td::PromiseCreator::lambda([key, promise = std::move(result), SelfId = actor_id(this), print_id = print_id(),
-                                       adnl = adnl_, list = get_nearest_nodes(key, k_ * 2), k = k_, a = a_,
-                                       network_id = network_id_, id = id_,
-                                       client_only = client_only_](td::Result<DhtNode> R) mutable {
+  auto entry = get_cached_value(key);
+  if (entry) {
+    cache_hits_++;
+    result.set_value(entry->kv_.clone());
+    // the publisher may have replaced the value (e.g. a new address list) long before its ttl
+    if (entry->refresh_at_.is_in_past() &&
+        pending_lookups_.emplace(key, std::vector<td::Promise<DhtValue>>()).second) {
+      entry->refresh_at_ = td::Timestamp::in(CACHED_VALUE_REFRESH_PERIOD);
+      queue_lookup(key);
+    }
+    return;
+  }
+  cache_misses_++;
+
+  auto &promises = pending_lookups_[key];
+  promises.push_back(std::move(result));
+  if (promises.size() == 1) {
+    queue_lookup(key);
+  }
+}
+
+void DhtMemberImpl::queue_lookup(DhtKeyId key) {
+  queued_lookups_.push_back(key);
+  if (queued_lookups_.size() > 1) {
+    return;
+  }
+  get_self_node([SelfId = actor_id(this)](td::Result<DhtNode> R) {
     R.ensure();
-    td::actor::create_actor<DhtQueryFindValueSingle>("FindValueQuery", key, print_id, id, std::move(list), k, a, network_id,
-                                               R.move_as_ok(), client_only, SelfId, adnl, std::move(promise))
-        .release();
+    td::actor::send_closure(SelfId, &DhtMemberImpl::start_lookups, R.move_as_ok());
   });
+}
 
-  get_self_node(std::move(P));
+void DhtMemberImpl::start_lookups(DhtNode self) {
+  auto keys = std::move(queued_lookups_);
+  queued_lookups_.clear();
+  for (auto &key : keys) {
+    auto P = td::PromiseCreator::lambda([SelfId = actor_id(this), key](td::Result<DhtValue> R) {
+      td::actor::send_closure(SelfId, &DhtMemberImpl::finish_lookup, key, std::move(R));
+    });
+    td::actor::create_actor<DhtQueryFindValueSingle>("FindValueQuery", key, print_id(), id_,
+                                                     get_nearest_nodes(key, k_ * 2), k_, a_, network_id_, self.clone(),
+                                                     client_only_, actor_id(this), adnl_, std::move(P))
+        .release();
+  }
+}
+
+void DhtMemberImpl::finish_lookup(DhtKeyId key, td::Result<DhtValue> R) {
+  auto it = pending_lookups_.find(key);
+  CHECK(it != pending_lookups_.end());
+  auto promises = std::move(it->second);
+  pending_lookups_.erase(it);
+  if (R.is_ok()) {
+    add_cached_value(R.ok().clone(), td::Timestamp::in(CACHED_VALUE_REFRESH_PERIOD));
+    for (auto &promise : promises) {
+      promise.set_value(R.ok().clone());
+    }
+  } else {
+    // do not keep serving a value that can no longer be found
+    cached_values_.erase(key);
+    for (auto &promise : promises) {
+      promise.set_error(R.error().clone());
+    }
+  }
+}
+
+void DhtMemberImpl::get_values(std::vector<DhtKey> keys, td::Promise<std::vector<td::Result<DhtValue>>> promise) {
+  std::vector<DhtKeyId> key_ids;
+  for (auto &key : keys) {
+    key_ids.push_back(key.compute_key_id());
+  }
+  td::actor::create_actor<DhtQueryGetValues>("GetValuesQuery", std::move(key_ids), print_id(), actor_id(this),
+                                             std::move(promise))
+      .release();
 }
 
 void DhtMemberImpl::get_value_many(DhtKey key, std::function<void(DhtValue)> callback, td::Promise<td::Unit> promise) {
@@ -559,6 +705,8 @@ void DhtMemberImpl::check() {
                  << " fvalue=" << find_value_queries_ << " store=" << store_queries_
                  << " addrlist=" << get_addr_list_queries_;
   VLOG(DHT_INFO) << this << ": values=" << values_.size() << " our_values=" << our_values_.size();
+  VLOG(DHT_INFO) << this << ": cached_values=" << cached_values_.size() << " cache_hits=" << cache_hits_
+                 << " cache_misses=" << cache_misses_ << " pending_lookups=" << pending_lookups_.size();
   VLOG(DHT_INFO) << this << ": reverse_conns=" << reverse_connections_.size()
                  << " our_reverse_conns=" << our_reverse_connections_.size();
   for (auto &bucket : buckets_) {
@@ -567,6 +715,9 @@ void DhtMemberImpl::check() {
   if (next_save_to_db_at_.is_in_past()) {
     save_to_db();
   }
+  if (next_save_cache_to_db_at_.is_in_past()) {
+    save_cache_to_db();
+  }
 
   for (auto it = values_ttl_order_.begin();
        it != values_ttl_order_.end() && (it->first < td::Clocks::system() || values_.size() > MAX_VALUES);) {
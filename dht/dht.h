@@ -54,6 +54,8 @@ class Dht : public td::actor::Actor {
   virtual void set_value(DhtValue key_value, td::Promise<td::Unit> result) = 0;
   virtual void get_value(DhtKey key, td::Promise<DhtValue> result) = 0;
   virtual void get_value_many(DhtKey key, std::function<void(DhtValue)> callback, td::Promise<td::Unit> promise) = 0;
+  // Resolves many keys at once; results are returned in the same order as keys
+  virtual void get_values(std::vector<DhtKey> keys, td::Promise<std::vector<td::Result<DhtValue>>> promise) = 0;
 
   virtual void register_reverse_connection(adnl::AdnlNodeIdFull client, td::Promise<td::Unit> promise) = 0;
   virtual void request_reverse_ping(adnl::AdnlNode target, adnl::AdnlNodeIdShort client,
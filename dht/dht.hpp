@@ -98,6 +98,7 @@ class DhtMember : public Dht {
   virtual void add_full_node(DhtKeyId id, DhtNode node, bool set_active) = 0;
 
   virtual void receive_ping(DhtKeyId id, DhtNode result) = 0;
+  virtual void update_node_rtt(DhtKeyId id, double rtt) = 0;
 
   virtual void get_value_in(DhtKeyId key, td::Promise<DhtValue> result) = 0;
 
@@ -911,6 +911,8 @@ bool TestNode::show_help(std::string command) {
          "status\tShow connection and local database status\n"
          "getaccount <addr> [<block-id-ext>]\tLoads the most recent state of specified account; <addr> is in "
          "[<workchain>:]<hex-or-base64-addr> format\n"
+         "getaccounts <addr>...\tLoads the most recent states of several accounts with one query and shows their "
+         "balances\n"
          "saveaccount[code|data] <filename> <addr> [<block-id-ext>]\tSaves into specified file the most recent state "
          "(StateInit) or just the code or data of specified account; <addr> is in "
          "[<workchain>:]<hex-or-base64-addr> format\n"
@@ -1005,6 +1007,15 @@ bool TestNode::do_parse_line() {
            (seekeoln() ? get_account_state(workchain, addr, mc_last_id_, addr_ext, "", -1, prunned)
                        : parse_block_id_ext(blkid) && seekeoln() &&
                              get_account_state(workchain, addr, blkid, addr_ext, "", -1, prunned));
+  } else if (word == "getaccounts") {
+    std::vector<std::pair<ton::WorkchainId, ton::StdSmcAddress>> accounts;
+    while (!seekeoln()) {
+      if (!parse_account_addr(workchain, addr)) {
+        return false;
+      }
+      accounts.emplace_back(workchain, addr);
+    }
+    return get_account_states(std::move(accounts), mc_last_id_);
   } else if (word == "saveaccount" || word == "saveaccountcode" || word == "saveaccountdata") {
     std::string filename;
     int mode = ((word.c_str()[11] >> 1) & 3);
@@ -1242,6 +1253,40 @@ bool TestNode::get_account_state(ton::WorkchainId workchain, ton::StdSmcAddress
   });
 }
 
+bool TestNode::get_account_states(std::vector<std::pair<ton::WorkchainId, ton::StdSmcAddress>> accounts,
+                                  ton::BlockIdExt ref_blkid) {
+  if (!ref_blkid.is_valid()) {
+    return set_error("must obtain last block information before making other queries");
+  }
+  if (!(ready_ && !client_.empty())) {
+    return set_error("server connection not ready");
+  }
+  if (accounts.empty()) {
+    return set_error("no accounts specified");
+  }
+  std::vector<ton::tl_object_ptr<ton::lite_api::liteServer_accountId>> ids;
+  for (auto& account : accounts) {
+    ids.push_back(ton::create_tl_object<ton::lite_api::liteServer_accountId>(account.first, account.second));
+  }
+  auto b = ton::serialize_tl_object(ton::create_tl_object<ton::lite_api::liteServer_getAccountStates>(
+                                        1, ton::create_tl_lite_block_id(ref_blkid), std::move(ids)),
+                                    true);
+  LOG(INFO) << "requesting states of " << accounts.size() << " accounts with respect to " << ref_blkid.to_str();
+  return envelope_send_query(std::move(b), [Self = actor_id(this), ref_blkid,
+                                            accounts = std::move(accounts)](td::Result<td::BufferSlice> R) mutable {
+    if (R.is_error()) {
+      return;
+    }
+    auto F = ton::fetch_tl_object<ton::lite_api::liteServer_accountStates>(R.move_as_ok(), true);
+    if (F.is_error()) {
+      LOG(ERROR) << "cannot parse answer to liteServer.getAccountStates";
+    } else {
+      td::actor::send_closure_later(Self, &TestNode::got_account_states, ref_blkid, std::move(accounts),
+                                    F.move_as_ok());
+    }
+  });
+}
+
 td::int64 TestNode::compute_method_id(std::string method) {
   td::int64 method_id;
   if (!convert_int64(method, method_id)) {
@@ -2199,6 +2244,59 @@ void TestNode::got_account_state(ton::BlockIdExt ref_blk, ton::BlockIdExt blk, t
   }
 }
 
+void TestNode::got_account_states(ton::BlockIdExt ref_blk,
+                                  std::vector<std::pair<ton::WorkchainId, ton::StdSmcAddress>> accounts,
+                                  ton::tl_object_ptr<ton::lite_api::liteServer_accountStates> states) {
+  auto blk = ton::create_block_id(states->id_);
+  LOG(INFO) << "got states of accounts in " << states->shards_.size() << " shard blocks with respect to block "
+            << blk.to_str();
+  auto out = td::TerminalIO::out();
+  std::set<std::pair<ton::WorkchainId, ton::StdSmcAddress>> found;
+  for (auto& shard : states->shards_) {
+    block::AccountStates account_states;
+    account_states.blk = blk;
+    account_states.shard_blk = ton::create_block_id(shard->shardblk_);
+    if (account_states.shard_blk != blk) {
+      account_states.shard_proof = states->shard_proof_.clone();
+    }
+    account_states.proof = std::move(shard->proof_);
+    for (auto& entry : shard->accounts_) {
+      account_states.states.emplace_back(block::StdAddress(entry->account_->workchain_, entry->account_->id_),
+                                         std::move(entry->state_));
+    }
+    auto r_infos = account_states.validate(ref_blk);
+    if (r_infos.is_error()) {
+      out << "error in states from shard block " << account_states.shard_blk.to_str() << " : "
+          << r_infos.error().message() << std::endl;
+      continue;
+    }
+    auto infos = r_infos.move_as_ok();
+    for (size_t i = 0; i < infos.size(); i++) {
+      auto& address = account_states.states[i].first;
+      auto& info = infos[i];
+      out << address.workchain << ":" << address.addr.to_hex() << " : ";
+      found.emplace(address.workchain, address.addr);
+      block::gen::Account::Record_account acc;
+      block::gen::AccountStorage::Record store;
+      block::CurrencyCollection balance;
+      if (info.root.is_null()) {
+        out << "account state is empty" << std::endl;
+      } else if (tlb::unpack_cell(info.root, acc) && tlb::csr_unpack(acc.storage, store) &&
+                 balance.unpack(store.balance)) {
+        out << "account balance is " << balance.to_str() << ", last transaction lt = " << info.last_trans_lt
+            << std::endl;
+      } else {
+        out << "error unpacking account state" << std::endl;
+      }
+    }
+  }
+  for (auto& account : accounts) {
+    if (!found.count(account)) {
+      out << account.first << ":" << account.second.to_hex() << " : no valid state in the answer" << std::endl;
+    }
+  }
+}
+
 void TestNode::run_smc_method(int mode, ton::BlockIdExt ref_blk, ton::BlockIdExt blk, ton::BlockIdExt shard_blk,
                               td::BufferSlice shard_proof, td::BufferSlice proof, td::BufferSlice state,
                               ton::WorkchainId workchain, ton::StdSmcAddress addr, std::string method,
@@ -195,6 +195,11 @@ class TestNode : public td::actor::Actor {
                          td::BufferSlice shard_proof, td::BufferSlice proof, td::BufferSlice state,
                          ton::WorkchainId workchain, ton::StdSmcAddress addr, std::string filename, int mode,
                          bool prunned);
+  bool get_account_states(std::vector<std::pair<ton::WorkchainId, ton::StdSmcAddress>> accounts,
+                          ton::BlockIdExt ref_blkid);
+  void got_account_states(ton::BlockIdExt ref_blk,
+                          std::vector<std::pair<ton::WorkchainId, ton::StdSmcAddress>> accounts,
+                          ton::tl_object_ptr<ton::lite_api::liteServer_accountStates> states);
   bool parse_run_method(ton::WorkchainId workchain, ton::StdSmcAddress addr, ton::BlockIdExt ref_blkid, int addr_ext,
                         std::string method_name, bool ext_mode);
   bool after_parse_run_method(ton::WorkchainId workchain, ton::StdSmcAddress addr, ton::BlockIdExt ref_blkid,
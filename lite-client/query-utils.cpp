@@ -119,6 +119,26 @@ QueryInfo get_query_info(const lite_api::Function& f) {
                          info.type = QueryInfo::t_simple;
                        }
                      },
+                     [&](const lite_api::liteServer_getAccountStates& q) {
+                       // See LiteQuery::perform_getAccountStates
+                       // The query goes to the smallest shard containing all accounts; accounts from several
+                       // workchains make it a masterchain query
+                       for (size_t i = 0; i < q.accounts_.size(); i++) {
+                         AccountIdPrefixFull prefix =
+                             extract_addr_prefix(q.accounts_[i]->workchain_, q.accounts_[i]->id_);
+                         if (i == 0) {
+                           info.shard_id = prefix.as_leaf_shard();
+                         } else if (info.shard_id.workchain != prefix.workchain) {
+                           info.shard_id = ShardIdFull{masterchainId};
+                           break;
+                         }
+                         while (!shard_contains(info.shard_id, prefix)) {
+                           info.shard_id = shard_parent(info.shard_id);
+                         }
+                       }
+                       info.type = QueryInfo::t_mc_seqno;
+                       info.value = create_block_id(q.id_).seqno();
+                     },
                      [&](const lite_api::liteServer_getOneTransaction& q) { from_block_id(q.id_); },
                      [&](const lite_api::liteServer_getTransactions& q) {
                        AccountIdPrefixFull acc_id_prefix = extract_addr_prefix(q.account_->workchain_, q.account_->id_);
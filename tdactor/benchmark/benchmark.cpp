@@ -1637,6 +1637,107 @@ class YieldMany : public td::Benchmark {
   bool use_io_{false};
 };
 
+// Round trip latency of a consensus-class ping-pong while all cpu threads are busy with background actors
+class PriorityPingPong : public td::Benchmark {
+ public:
+  explicit PriorityPingPong(bool use_priority) : use_priority_(use_priority) {
+  }
+  std::string get_description() const {
+    return PSTRING() << "PriorityPingPong use_priority(" << use_priority_ << ")";
+  }
+
+  void run(int n) {
+    class Load : public td::actor::Actor {
+     public:
+      explicit Load(std::atomic<bool> *done) : done_(done) {
+      }
+      void loop() override {
+        if (done_->load(std::memory_order_relaxed)) {
+          return stop();
+        }
+        auto until = td::Time::now() + 50e-6;
+        while (td::Time::now() < until) {
+        }
+        yield();
+      };
+
+     private:
+      std::atomic<bool> *done_;
+    };
+    class Pong : public td::actor::Actor {
+     public:
+      void ping(td::Promise<td::Unit> promise) {
+        promise.set_value(td::Unit());
+      }
+    };
+    class Ping : public td::actor::Actor {
+     public:
+      Ping(td::actor::ActorId<Pong> pong, int n, std::vector<double> *latencies, Sem *sem)
+          : pong_(pong), n_(n), latencies_(latencies), sem_(sem) {
+      }
+      void start_up() override {
+        do_ping();
+      }
+      void do_ping() {
+        if (n_-- == 0) {
+          sem_->post();
+          return stop();
+        }
+        auto sent_at = td::Time::now();
+        send_closure(pong_, &Pong::ping, [self = actor_id(this), sent_at](td::Result<td::Unit>) {
+          send_closure(self, &Ping::on_pong, td::Time::now() - sent_at);
+        });
+      }
+      void on_pong(double latency) {
+        latencies_->push_back(latency);
+        do_ping();
+      }
+
+     private:
+      td::actor::ActorId<Pong> pong_;
+      int n_;
+      std::vector<double> *latencies_;
+      Sem *sem_;
+    };
+
+    unsigned cpu_n = td::thread::hardware_concurrency();
+    unsigned load_n = cpu_n * 4;
+    auto high = use_priority_ ? td::actor::ActorPriority::Consensus : td::actor::ActorPriority::Default;
+    auto low = use_priority_ ? td::actor::ActorPriority::Background : td::actor::ActorPriority::Default;
+    std::atomic<bool> done{false};
+    std::vector<double> latencies;
+    latencies.reserve(n);
+
+    td::actor::Scheduler scheduler{{cpu_n}};
+    auto sch = td::thread([&] { scheduler.run(); });
+    Sem sem;
+    scheduler.run_in_context_external([&] {
+      for (unsigned i = 0; i < load_n; i++) {
+        td::actor::create_actor<Load>(td::actor::ActorOptions().with_name("Load").with_priority(low), &done).release();
+      }
+      auto pong = td::actor::create_actor<Pong>(td::actor::ActorOptions().with_name("Pong").with_priority(high));
+      td::actor::create_actor<Ping>(td::actor::ActorOptions().with_name("Ping").with_priority(high), pong.get(), n,
+                                    &latencies, &sem)
+          .release();
+      pong.release();
+    });
+    sem.wait();
+    done = true;
+    scheduler.run_in_context_external([&] { td::actor::SchedulerContext::get()->stop(); });
+    sch.join();
+
+    std::sort(latencies.begin(), latencies.end());
+    auto quantile = [&](double q) {
+      return latencies.empty() ? 0.0 : latencies[std::min(latencies.size() - 1, size_t(q * double(latencies.size())))];
+    };
+    LOG(ERROR) << get_description() << ": p50=" << quantile(0.5) * 1e6 << "us p99=" << quantile(0.99) * 1e6
+               << "us max=" << quantile(1) * 1e6 << "us";
+  }
+
+ private:
+  bool use_priority_{false};
+};
+
 int main(int argc, char **argv) {
   if (argc > 1) {
     if (argv[1][0] == 'a') {
@@ -1662,6 +1763,8 @@ int main(int argc, char **argv) {
   bench(ChainedSpawnInplace(true));
   bench(ChainedSpawn(false));
   bench(ChainedSpawn(true));
+  bench(PriorityPingPong(false));
+  bench(PriorityPingPong(true));
 
   run_queue_bench(10, 10);
   run_queue_bench(10, 1);
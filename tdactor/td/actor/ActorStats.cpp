@@ -1,5 +1,6 @@
 #include "ActorStats.h"
 
+#include "td/utils/filesystem.h"
 #include "td/utils/ThreadSafeCounter.h"
 namespace td {
 namespace actor {
@@ -163,6 +164,19 @@ std::string ActorStats::prepare_stats() {
   do_describe([&sb]() -> td::StringBuilder & { return sb << "\t"; }, sum_stat_10s, sum_stat_10m, sum_stat_forever);
   sb << "\n";
 
+  sb << "Queue delay by priority (p50 p99 p999, since start):\n";
+  auto priority_stats = ActorPriorityStatManager::get_stats(estimated_inv_ticks_per_second);
+  for (size_t i = 0; i < priority_stats.size(); i++) {
+    auto &stat = priority_stats[i];
+    if (stat.total == 0) {
+      continue;
+    }
+    sb << "\t" << core::actor_priority_name(static_cast<ActorPriority>(i)) << ":\t" << stat.delay_quantile(0.5)
+       << "s " << stat.delay_quantile(0.99) << "s " << stat.delay_quantile(0.999) << "s\tcount: " << stat.total
+       << "\n";
+  }
+  sb << "\n";
+
   auto top_k_by = [&](auto &stats_map, size_t k, std::string description, auto by) {
     auto stats = td::transform(stats_map, [](auto &it) { return std::make_pair(it.first, it.second); });
     k = std::min(k, stats.size());
@@ -220,6 +234,25 @@ std::string ActorStats::prepare_stats() {
   sb << "\n";
   return sb.as_cslice().str();
 }
+std::string ActorStats::prepare_profile_json() {
+  return core::ActorProfiler::get_profile(estimate_inv_ticks_per_second(), PROFILE_TOP_INSTANCES).to_json();
+}
+
+void ActorStats::set_profile_dump(std::string file_name, double period) {
+  profile_file_name_ = std::move(file_name);
+  profile_dump_period_ = period;
+  next_profile_dump_at_ = td::Timestamp::in(period);
+}
+
+void ActorStats::dump_profile() {
+  if (profile_file_name_.empty() || !next_profile_dump_at_.is_in_past()) {
+    return;
+  }
+  next_profile_dump_at_ = td::Timestamp::in(profile_dump_period_);
+  auto S = td::atomic_write_file(profile_file_name_, prepare_profile_json());
+  LOG_IF(WARNING, S.is_error()) << "Failed to write actor profile to " << profile_file_name_ << ": " << S;
+}
+
 ActorStats::PefStat::PefStat() {
   for (std::size_t i = 0; i < SIZE; i++) {
     perf_stat_[i] = td::TimedStat<StatStorer<td::int64>>(DURATIONS[i], td::Time::now());
@@ -11,6 +11,10 @@ class ActorStats : public td::actor::Actor {
   void start_up() override;
   double estimate_inv_ticks_per_second();
   std::string prepare_stats();
+  // sampled per-type and per-instance execution profile, see core::ActorProfiler
+  std::string prepare_profile_json();
+  // periodically write prepare_profile_json() to file_name; empty name disables it
+  void set_profile_dump(std::string file_name, double period);
 
  private:
   template <class T>
@@ -41,11 +45,17 @@ class ActorStats : public td::actor::Actor {
   std::map<std::string, PefStat> pef_stats_;
   td::Timestamp begin_ts_;
   td::uint64 begin_ticks_{};
+  std::string profile_file_name_;
+  double profile_dump_period_{0};
+  td::Timestamp next_profile_dump_at_;
+  static constexpr size_t PROFILE_TOP_INSTANCES = 50;
   void loop() override {
     alarm_timestamp() = td::Timestamp::in(5.0);
     update(td::Timestamp::now());
+    dump_profile();
   }
   void update(td::Timestamp now);
+  void dump_profile();
 };
 
 }  // namespace actor
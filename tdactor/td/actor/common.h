@@ -215,6 +215,9 @@ class Scheduler {
 using core::ActorTypeStat;
 using core::ActorTypeStatManager;
 using core::ActorTypeStats;
+using core::ActorPriority;
+using core::ActorPriorityStatManager;
+using core::ActorProfiler;
 
 // Some helper functions. Not part of public interface and not part
 // of namespace core
@@ -20,6 +20,8 @@
 
 #include "td/utils/ScopeGuard.h"
 
+#include <typeinfo>
+
 namespace td {
 namespace actor {
 namespace core {
@@ -35,7 +37,7 @@ void ActorExecutor::send_immediate(ActorMessage message) {
     return;
   }
   actor_execute_context_.set_link_token(message.get_link_token());
-  message.run();
+  run_message(message);
 }
 
 void ActorExecutor::send_immediate(ActorSignals signals) {
@@ -59,6 +61,9 @@ void ActorExecutor::send(ActorMessage message) {
     return send_immediate(std::move(message));
   }
   //LOG(ERROR) << "AE::send delayed";
+  if (ActorProfiler::is_enabled()) {
+    message.set_enqueued_at(Clocks::rdtsc());
+  }
   actor_info_.mailbox().push(std::move(message));
   pending_signals_.add_signal(ActorSignals::Message);
 }
@@ -114,8 +119,16 @@ void ActorExecutor::start() noexcept {
 
   actor_execute_context_.set_actor(&actor_info_.actor());
 
+  if (ActorProfiler::should_sample()) {
+    auto &actor = actor_info_.actor();
+    profile_.start(actor_info_.get_actor_stat_id(), typeid(actor).name(), &actor_info_, actor_info_.get_name(),
+                   actor_info_.get_in_queue_since());
+  }
   actor_stats_ = actor_info_.actor_type_stat();
   auto execute_timer = actor_stats_.create_execute_timer();
+  SCOPE_EXIT {
+    profile_.finish();
+  };
   while (flush_one_signal(signals)) {
     if (actor_execute_context_.has_immediate_flags()) {
       return;
@@ -235,6 +248,9 @@ bool ActorExecutor::flush_one_signal(ActorSignals &signals) {
     case ActorSignals::Message:
       pending_signals_.add_signal(ActorSignals::Message);
       actor_info_.mailbox().pop_all();
+      if (profile_.is_active()) {
+        profile_.on_mailbox_depth(actor_info_.mailbox().reader().calc_size());
+      }
       break;
     case ActorSignals::Pop:
       flags().set_in_queue(false);
@@ -261,10 +277,20 @@ bool ActorExecutor::flush_one_message() {
 
   actor_execute_context_.set_link_token(message.get_link_token());
   auto message_timer = actor_stats_.create_message_timer();
-  message.run();
+  run_message(message);
   return true;
 }
 
+void ActorExecutor::run_message(ActorMessage &message) {
+  if (!profile_.is_active()) {
+    return message.run();
+  }
+  auto enqueued_at = message.get_enqueued_at();
+  auto started_at = Clocks::rdtsc();
+  message.run();
+  profile_.on_message(enqueued_at, started_at, Clocks::rdtsc());
+}
+
 void ActorExecutor::flush_context_flags() {
   if (actor_execute_context_.get_stop()) {
     if (actor_info_.get_alarm_timestamp()) {
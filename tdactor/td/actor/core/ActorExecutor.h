@@ -22,6 +22,7 @@
 #include "td/actor/core/ActorInfo.h"
 #include "td/actor/core/ActorLocker.h"
 #include "td/actor/core/ActorMessage.h"
+#include "td/actor/core/ActorProfiler.h"
 #include "td/actor/core/ActorSignals.h"
 #include "td/actor/core/ActorState.h"
 #include "td/actor/core/ActorTypeStat.h"
@@ -97,6 +98,7 @@ class ActorExecutor {
   SchedulerDispatcher &dispatcher_;
   Options options_;
   ActorTypeStatRef actor_stats_;
+  ActorProfiler::Sample profile_;
   ActorLocker actor_locker_{&actor_info_.state(), ActorLocker::Options()
                                                       .with_can_execute_paused(options_.from_queue)
                                                       .with_is_shared(!options_.has_poll)
@@ -120,6 +122,7 @@ class ActorExecutor {
   bool flush_one(ActorSignals &signals);
   bool flush_one_signal(ActorSignals &signals);
   bool flush_one_message();
+  void run_message(ActorMessage &message);
   void flush_context_flags();
 };
 }  // namespace core
@@ -18,6 +18,7 @@
 */
 #pragma once
 
+#include "td/actor/core/ActorPriority.h"
 #include "td/actor/core/ActorState.h"
 #include "td/actor/core/ActorTypeStat.h"
 #include "td/actor/core/ActorMailbox.h"
@@ -35,8 +36,9 @@ class ActorInfo;
 using ActorInfoPtr = SharedObjectPool<ActorInfo>::Ptr;
 class ActorInfo : private HeapNode, private ListNode {
  public:
-  ActorInfo(std::unique_ptr<Actor> actor, ActorState::Flags state_flags, Slice name, td::uint32 actor_stat_id)
-      : actor_(std::move(actor)), name_(name.begin(), name.size()), actor_stat_id_(actor_stat_id) {
+  ActorInfo(std::unique_ptr<Actor> actor, ActorState::Flags state_flags, Slice name, td::uint32 actor_stat_id,
+            ActorPriority priority = ActorPriority::Default)
+      : actor_(std::move(actor)), name_(name.begin(), name.size()), actor_stat_id_(actor_stat_id), priority_(priority) {
     state_.set_flags_unsafe(state_flags);
     VLOG(actor) << "Create actor [" << name_ << "]";
   }
@@ -63,6 +65,7 @@ class ActorInfo : private HeapNode, private ListNode {
   ActorTypeStatRef actor_type_stat() {
     auto res = ActorTypeStatManager::get_actor_type_stat(actor_stat_id_, actor_.get());
     if (in_queue_since_) {
+      ActorPriorityStatManager::on_pop_from_queue(priority_, td::Clocks::rdtsc() - in_queue_since_);
       res.pop_from_queue(in_queue_since_);
       in_queue_since_ = 0;
     }
@@ -83,6 +86,16 @@ class ActorInfo : private HeapNode, private ListNode {
   CSlice get_name() const {
     return name_;
   }
+  ActorPriority get_priority() const {
+    return priority_;
+  }
+  td::uint32 get_actor_stat_id() const {
+    return actor_stat_id_;
+  }
+  // NB: must be called only when actor is locked, before actor_type_stat()
+  td::uint64 get_in_queue_since() const {
+    return in_queue_since_;
+  }
 
   HeapNode *as_heap_node() {
     return this;
@@ -118,6 +131,7 @@ class ActorInfo : private HeapNode, private ListNode {
   ActorInfoPtr pin_;
   td::uint64 in_queue_since_{0};
   td::uint32 actor_stat_id_{0};
+  ActorPriority priority_{ActorPriority::Default};
 };
 
 }  // namespace core
@@ -51,11 +51,17 @@ class ActorInfoCreator {
       return *this;
     }
 
+    Options &with_priority(ActorPriority new_priority) {
+      priority = new_priority;
+      return *this;
+    }
+
    private:
     friend class ActorInfoCreator;
     Slice name;
     SchedulerId scheduler_id;
     td::uint32 actor_stat_id{0};
+    ActorPriority priority{ActorPriority::Default};
     bool is_shared{true};
     bool in_queue{true};
     //TODO: rename
@@ -71,7 +77,7 @@ class ActorInfoCreator {
     flags.set_in_queue(args.in_queue);
     flags.set_signals(ActorSignals::one(ActorSignals::StartUp));
 
-    auto actor_info_ptr = pool_.alloc(std::move(actor), flags, args.name, args.actor_stat_id);
+    auto actor_info_ptr = pool_.alloc(std::move(actor), flags, args.name, args.actor_stat_id, args.priority);
     actor_info_ptr->actor().set_actor_info_ptr(actor_info_ptr);
     return actor_info_ptr;
   }
@@ -49,6 +49,7 @@ class ActorMessageImpl : private MpscLinkQueueImpl::Node {
   }
 
   uint64 link_token_{EmptyLinkToken};
+  uint64 enqueued_at_{0};
   bool is_big_{false};
 };
 
@@ -78,6 +79,13 @@ class ActorMessage {
   void set_big() {
     impl_->is_big_ = true;
   }
+  // rdtsc of the moment the message was put into a mailbox, 0 if unknown
+  void set_enqueued_at(uint64 enqueued_at) {
+    impl_->enqueued_at_ = enqueued_at;
+  }
+  uint64 get_enqueued_at() const {
+    return impl_->enqueued_at_;
+  }
 
  private:
   std::unique_ptr<ActorMessageImpl> impl_;
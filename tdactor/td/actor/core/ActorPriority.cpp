@@ -0,0 +1,113 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "td/actor/core/ActorPriority.h"
+#include "td/actor/core/Scheduler.h"
+
+#include "td/utils/bits.h"
+#include "td/utils/port/thread_local.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace td {
+namespace actor {
+namespace core {
+
+double ActorPriorityStat::delay_quantile(double q) const {
+  if (total == 0) {
+    return 0;
+  }
+  auto need = static_cast<td::uint64>(q * static_cast<double>(total));
+  td::uint64 sum = 0;
+  for (size_t i = 0; i < BUCKETS; i++) {
+    sum += delay_histogram[i];
+    if (sum > need || sum == total) {
+      return i == 0 ? 0 : static_cast<double>(td::uint64(1) << (i - 1)) * 2 * inv_ticks_per_second;
+    }
+  }
+  return 0;
+}
+
+// Each thread writes only to its own entry, so relaxed stores are enough and no cache lines are shared
+struct ActorPriorityStatsTlsEntry {
+  std::array<std::array<std::atomic<td::uint64>, ActorPriorityStat::BUCKETS>, ACTOR_PRIORITY_COUNT> histograms{};
+
+  void add(size_t priority, size_t bucket) {
+    auto &value = histograms[priority][bucket];
+    value.store(value.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+};
+
+struct ActorPriorityStatsRegistry {
+  std::mutex mutex;
+  std::vector<std::shared_ptr<ActorPriorityStatsTlsEntry>> entries;
+  void registry_entry(std::shared_ptr<ActorPriorityStatsTlsEntry> entry) {
+    std::lock_guard<std::mutex> guard(mutex);
+    entries.push_back(std::move(entry));
+  }
+  template <class F>
+  void foreach_entry(F &&f) {
+    std::lock_guard<std::mutex> guard(mutex);
+    for (auto &entry : entries) {
+      f(*entry);
+    }
+  }
+};
+
+static ActorPriorityStatsRegistry priority_stats_registry;
+
+struct ActorPriorityStatsTlsEntryRef {
+  ActorPriorityStatsTlsEntryRef() {
+    entry_ = std::make_shared<ActorPriorityStatsTlsEntry>();
+    priority_stats_registry.registry_entry(entry_);
+  }
+  std::shared_ptr<ActorPriorityStatsTlsEntry> entry_;
+};
+
+static TD_THREAD_LOCAL ActorPriorityStatsTlsEntryRef *actor_priority_stats_tls_entry = nullptr;
+
+void ActorPriorityStatManager::on_pop_from_queue(ActorPriority priority, td::uint64 delay_ticks) {
+  if (!need_debug()) {
+    return;
+  }
+  td::init_thread_local<ActorPriorityStatsTlsEntryRef>(actor_priority_stats_tls_entry);
+  size_t bucket = delay_ticks == 0 ? 0 : 64 - td::count_leading_zeroes64(delay_ticks);
+  actor_priority_stats_tls_entry->entry_->add(static_cast<size_t>(priority), bucket);
+}
+
+ActorPriorityStats ActorPriorityStatManager::get_stats(double inv_ticks_per_second) {
+  ActorPriorityStats stats;
+  priority_stats_registry.foreach_entry([&](ActorPriorityStatsTlsEntry &entry) {
+    for (size_t p = 0; p < ACTOR_PRIORITY_COUNT; p++) {
+      for (size_t i = 0; i < ActorPriorityStat::BUCKETS; i++) {
+        auto value = entry.histograms[p][i].load(std::memory_order_relaxed);
+        stats[p].delay_histogram[i] += value;
+        stats[p].total += value;
+      }
+    }
+  });
+  for (auto &stat : stats) {
+    stat.inv_ticks_per_second = inv_ticks_per_second;
+  }
+  return stats;
+}
+
+}  // namespace core
+}  // namespace actor
+}  // namespace td
@@ -0,0 +1,77 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+#include "td/utils/int_types.h"
+#include "td/utils/Slice.h"
+
+#include <array>
+
+namespace td {
+namespace actor {
+namespace core {
+
+// Latency class of an actor, from the most to the least urgent one.
+// CPU workers pop actors of more urgent classes first (see CpuWorker::try_pop).
+enum class ActorPriority : td::uint8 { Consensus, Collation, Default, Serving, Background };
+constexpr size_t ACTOR_PRIORITY_COUNT = 5;
+
+inline Slice actor_priority_name(ActorPriority priority) {
+  switch (priority) {
+    case ActorPriority::Consensus:
+      return Slice("consensus");
+    case ActorPriority::Collation:
+      return Slice("collation");
+    case ActorPriority::Default:
+      return Slice("default");
+    case ActorPriority::Serving:
+      return Slice("serving");
+    case ActorPriority::Background:
+      return Slice("background");
+  }
+  return Slice("unknown");
+}
+
+struct ActorPriorityStat {
+  // bucket i counts queue delays in [2^(i-1), 2^i) ticks
+  static constexpr size_t BUCKETS = 65;
+  std::array<td::uint64, BUCKETS> delay_histogram{};
+  td::uint64 total{0};
+  double inv_ticks_per_second{0};
+
+  ActorPriorityStat &operator+=(const ActorPriorityStat &other) {
+    for (size_t i = 0; i < BUCKETS; i++) {
+      delay_histogram[i] += other.delay_histogram[i];
+    }
+    total += other.total;
+    return *this;
+  }
+
+  // upper bound of the q-quantile of the queue delay, in seconds
+  double delay_quantile(double q) const;
+};
+
+using ActorPriorityStats = std::array<ActorPriorityStat, ACTOR_PRIORITY_COUNT>;
+
+class ActorPriorityStatManager {
+ public:
+  static void on_pop_from_queue(ActorPriority priority, td::uint64 delay_ticks);
+  static ActorPriorityStats get_stats(double inv_ticks_per_second);
+};
+
+}  // namespace core
+}  // namespace actor
+}  // namespace td
@@ -0,0 +1,318 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "td/actor/core/ActorProfiler.h"
+#include "td/actor/core/ActorTypeStat.h"
+
+#include "td/utils/bits.h"
+#include "td/utils/JsonBuilder.h"
+#include "td/utils/port/thread_local.h"
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace td {
+namespace actor {
+namespace core {
+
+std::atomic<td::uint32> ActorProfiler::sample_period_{0};
+
+void ActorProfileHistogram::add(td::uint64 value) {
+  buckets[value == 0 ? 0 : 64 - td::count_leading_zeroes64(value)]++;
+  count++;
+  sum += value;
+  max = std::max(max, value);
+}
+
+ActorProfileHistogram &ActorProfileHistogram::operator+=(const ActorProfileHistogram &other) {
+  for (size_t i = 0; i < BUCKETS; i++) {
+    buckets[i] += other.buckets[i];
+  }
+  count += other.count;
+  sum += other.sum;
+  max = std::max(max, other.max);
+  return *this;
+}
+
+td::uint64 ActorProfileHistogram::quantile(double q) const {
+  if (count == 0) {
+    return 0;
+  }
+  auto need = static_cast<td::uint64>(q * static_cast<double>(count));
+  td::uint64 total = 0;
+  for (size_t i = 0; i < BUCKETS; i++) {
+    total += buckets[i];
+    if (total > need || total == count) {
+      if (i == 0) {
+        return 0;
+      }
+      return std::min(max, i == 64 ? std::numeric_limits<td::uint64>::max() : (td::uint64(1) << i) - 1);
+    }
+  }
+  return max;
+}
+
+namespace {
+struct ActorProfilerTlsEntry;
+
+struct ActorProfilerTypeEntry {
+  ActorProfilerTlsEntry *tls_entry{nullptr};
+  const char *type_name{nullptr};
+  ActorTypeProfile profile;
+};
+
+struct ActorProfilerTlsEntry {
+  // number of the hottest instances remembered by each thread
+  static constexpr size_t MAX_INSTANCES = 256;
+
+  std::mutex mutex;
+  std::vector<std::unique_ptr<ActorProfilerTypeEntry>> by_id;
+  std::map<const void *, ActorInstanceProfile> instances;
+
+  ActorProfilerTypeEntry *get_type_entry(td::uint32 id, const char *type_name) {
+    std::lock_guard<std::mutex> guard(mutex);
+    if (id >= by_id.size()) {
+      by_id.resize(id + 1);
+    }
+    auto &entry = by_id[id];
+    if (!entry) {
+      entry = std::make_unique<ActorProfilerTypeEntry>();
+      entry->tls_entry = this;
+      entry->type_name = type_name;
+    }
+    return entry.get();
+  }
+
+  // NB: must be called under mutex
+  ActorInstanceProfile &get_instance(const void *instance, Slice name, const char *type_name) {
+    auto it = instances.find(instance);
+    if (it != instances.end()) {
+      if (it->second.name == name) {
+        return it->second;
+      }
+      // the address was reused by another actor
+      instances.erase(it);
+    } else if (instances.size() >= MAX_INSTANCES) {
+      auto coldest = std::min_element(instances.begin(), instances.end(), [](const auto &a, const auto &b) {
+        return a.second.execute_ticks < b.second.execute_ticks;
+      });
+      instances.erase(coldest);
+    }
+    auto &res = instances[instance];
+    res.name = name.str();
+    res.type_name = type_name;
+    return res;
+  }
+};
+
+struct ActorProfilerRegistry {
+  std::mutex mutex;
+  std::vector<std::shared_ptr<ActorProfilerTlsEntry>> entries;
+  void registry_entry(std::shared_ptr<ActorProfilerTlsEntry> entry) {
+    std::lock_guard<std::mutex> guard(mutex);
+    entries.push_back(std::move(entry));
+  }
+  template <class F>
+  void foreach_entry(F &&f) {
+    std::lock_guard<std::mutex> guard(mutex);
+    for (auto &entry : entries) {
+      f(*entry);
+    }
+  }
+};
+
+ActorProfilerRegistry profiler_registry;
+
+struct ActorProfilerTlsEntryRef {
+  ActorProfilerTlsEntryRef() {
+    entry_ = std::make_shared<ActorProfilerTlsEntry>();
+    profiler_registry.registry_entry(entry_);
+  }
+  std::shared_ptr<ActorProfilerTlsEntry> entry_;
+};
+
+TD_THREAD_LOCAL ActorProfilerTlsEntryRef *actor_profiler_tls_entry = nullptr;
+TD_THREAD_LOCAL td::uint32 actor_profiler_counter;
+}  // namespace
+
+bool ActorProfiler::should_sample() {
+  auto period = get_sample_period();
+  if (period == 0) {
+    return false;
+  }
+  if (++actor_profiler_counter < period) {
+    return false;
+  }
+  actor_profiler_counter = 0;
+  return true;
+}
+
+void ActorProfiler::Sample::start(td::uint32 actor_stat_id, const char *type_name, const void *instance,
+                                  Slice instance_name, td::uint64 in_queue_since) {
+  td::init_thread_local<ActorProfilerTlsEntryRef>(actor_profiler_tls_entry);
+  auto *entry = actor_profiler_tls_entry->entry_->get_type_entry(actor_stat_id, type_name);
+  type_entry_ = entry;
+  instance_ = instance;
+  instance_name_ = instance_name;
+  started_at_ = Clocks::rdtsc();
+  messages_ = 0;
+  mailbox_depth_ = 0;
+  if (in_queue_since != 0 && in_queue_since <= started_at_) {
+    std::lock_guard<std::mutex> guard(entry->tls_entry->mutex);
+    entry->profile.queue_delay_ticks.add(started_at_ - in_queue_since);
+  }
+}
+
+void ActorProfiler::Sample::on_mailbox_depth(size_t depth) {
+  auto *entry = static_cast<ActorProfilerTypeEntry *>(type_entry_);
+  if (!entry) {
+    return;
+  }
+  mailbox_depth_ = std::max<td::uint64>(mailbox_depth_, depth);
+  std::lock_guard<std::mutex> guard(entry->tls_entry->mutex);
+  entry->profile.mailbox_depth.add(depth);
+}
+
+void ActorProfiler::Sample::on_message(td::uint64 enqueued_at, td::uint64 started_at, td::uint64 finished_at) {
+  auto *entry = static_cast<ActorProfilerTypeEntry *>(type_entry_);
+  if (!entry) {
+    return;
+  }
+  messages_++;
+  std::lock_guard<std::mutex> guard(entry->tls_entry->mutex);
+  entry->profile.message_ticks.add(finished_at - started_at);
+  if (enqueued_at != 0 && enqueued_at <= started_at) {
+    entry->profile.message_wait_ticks.add(started_at - enqueued_at);
+  }
+}
+
+void ActorProfiler::Sample::finish() {
+  auto *entry = static_cast<ActorProfilerTypeEntry *>(type_entry_);
+  if (!entry) {
+    return;
+  }
+  type_entry_ = nullptr;
+  auto ticks = Clocks::rdtsc() - started_at_;
+  std::lock_guard<std::mutex> guard(entry->tls_entry->mutex);
+  entry->profile.execute_ticks.add(ticks);
+  auto &instance = entry->tls_entry->get_instance(instance_, instance_name_, entry->type_name);
+  instance.executions++;
+  instance.messages += messages_;
+  instance.execute_ticks += ticks;
+  instance.max_execute_ticks = std::max(instance.max_execute_ticks, ticks);
+  instance.max_mailbox_depth = std::max(instance.max_mailbox_depth, mailbox_depth_);
+}
+
+ActorProfile ActorProfiler::get_profile(double inv_ticks_per_second, size_t top_n) {
+  std::map<std::string, ActorTypeProfile> types;
+  std::map<const void *, ActorInstanceProfile> instances;
+  profiler_registry.foreach_entry([&](ActorProfilerTlsEntry &tls_entry) {
+    std::lock_guard<std::mutex> guard(tls_entry.mutex);
+    for (auto &entry : tls_entry.by_id) {
+      if (!entry) {
+        continue;
+      }
+      auto &type = types[entry->type_name];
+      type.execute_ticks += entry->profile.execute_ticks;
+      type.message_ticks += entry->profile.message_ticks;
+      type.message_wait_ticks += entry->profile.message_wait_ticks;
+      type.queue_delay_ticks += entry->profile.queue_delay_ticks;
+      type.mailbox_depth += entry->profile.mailbox_depth;
+    }
+    for (auto &it : tls_entry.instances) {
+      auto &instance = instances[it.first];
+      if (instance.name != it.second.name) {
+        // the same address belongs to different actors on different threads, keep the hotter one
+        if (instance.execute_ticks < it.second.execute_ticks) {
+          instance = it.second;
+        }
+        continue;
+      }
+      instance.executions += it.second.executions;
+      instance.messages += it.second.messages;
+      instance.execute_ticks += it.second.execute_ticks;
+      instance.max_execute_ticks = std::max(instance.max_execute_ticks, it.second.max_execute_ticks);
+      instance.max_mailbox_depth = std::max(instance.max_mailbox_depth, it.second.max_mailbox_depth);
+    }
+  });
+
+  ActorProfile res;
+  res.sample_period = get_sample_period();
+  res.inv_ticks_per_second = inv_ticks_per_second;
+  for (auto &it : types) {
+    it.second.name = ActorTypeStatManager::get_class_name(it.first.c_str());
+    res.types.push_back(std::move(it.second));
+  }
+  std::sort(res.types.begin(), res.types.end(),
+            [](const auto &a, const auto &b) { return a.execute_ticks.sum > b.execute_ticks.sum; });
+  for (auto &it : instances) {
+    it.second.type_name = ActorTypeStatManager::get_class_name(it.second.type_name.c_str());
+    res.top_instances.push_back(std::move(it.second));
+  }
+  top_n = std::min(top_n, res.top_instances.size());
+  std::partial_sort(res.top_instances.begin(), res.top_instances.begin() + top_n, res.top_instances.end(),
+                    [](const auto &a, const auto &b) { return a.execute_ticks > b.execute_ticks; });
+  res.top_instances.resize(top_n);
+  return res;
+}
+
+std::string ActorProfile::to_json() const {
+  auto seconds = [this](td::uint64 ticks) { return static_cast<double>(ticks) * inv_ticks_per_second; };
+  auto histogram = [seconds](const ActorProfileHistogram &h, bool is_ticks) {
+    auto value = [seconds, is_ticks](td::uint64 x) { return is_ticks ? seconds(x) : static_cast<double>(x); };
+    return td::json_object([&h, value](auto &o) {
+      o("count", td::JsonLong(static_cast<td::int64>(h.count)));
+      o("avg", h.count == 0 ? 0.0 : value(h.sum) / static_cast<double>(h.count));
+      o("p50", value(h.quantile(0.5)));
+      o("p99", value(h.quantile(0.99)));
+      o("max", value(h.max));
+    });
+  };
+
+  td::JsonBuilder jb;
+  auto o = jb.enter_object();
+  o("sample_period", static_cast<td::int64>(sample_period));
+  o("types", td::json_array(types, [&](const ActorTypeProfile &type) {
+      return td::json_object([&](auto &t) {
+        t("name", type.name);
+        t("execute", histogram(type.execute_ticks, true));
+        t("message", histogram(type.message_ticks, true));
+        t("message_wait", histogram(type.message_wait_ticks, true));
+        t("queue_delay", histogram(type.queue_delay_ticks, true));
+        t("mailbox_depth", histogram(type.mailbox_depth, false));
+      });
+    }));
+  o("top_instances", td::json_array(top_instances, [&](const ActorInstanceProfile &instance) {
+      return td::json_object([&](auto &t) {
+        t("name", instance.name);
+        t("type", instance.type_name);
+        t("executions", static_cast<td::int64>(instance.executions));
+        t("messages", static_cast<td::int64>(instance.messages));
+        t("execute_seconds", seconds(instance.execute_ticks));
+        t("max_execute_seconds", seconds(instance.max_execute_ticks));
+        t("max_mailbox_depth", static_cast<td::int64>(instance.max_mailbox_depth));
+      });
+    }));
+  o.leave();
+  return jb.string_builder().as_cslice().str();
+}
+
+}  // namespace core
+}  // namespace actor
+}  // namespace td
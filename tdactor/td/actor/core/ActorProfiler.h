@@ -0,0 +1,126 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+#include "td/utils/int_types.h"
+#include "td/utils/port/Clocks.h"
+#include "td/utils/Slice.h"
+
+#include <array>
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace td {
+namespace actor {
+namespace core {
+
+// bucket i counts values in [2^(i-1), 2^i)
+struct ActorProfileHistogram {
+  static constexpr size_t BUCKETS = 65;
+  std::array<td::uint64, BUCKETS> buckets{};
+  td::uint64 count{0};
+  td::uint64 sum{0};
+  td::uint64 max{0};
+
+  void add(td::uint64 value);
+  ActorProfileHistogram &operator+=(const ActorProfileHistogram &other);
+  // upper bound of the q-quantile
+  td::uint64 quantile(double q) const;
+};
+
+struct ActorTypeProfile {
+  std::string name;
+  // all histograms except mailbox_depth are in rdtsc ticks
+  ActorProfileHistogram execute_ticks;
+  ActorProfileHistogram message_ticks;
+  ActorProfileHistogram message_wait_ticks;
+  ActorProfileHistogram queue_delay_ticks;
+  ActorProfileHistogram mailbox_depth;
+};
+
+struct ActorInstanceProfile {
+  std::string name;
+  std::string type_name;
+  td::uint64 executions{0};
+  td::uint64 messages{0};
+  td::uint64 execute_ticks{0};
+  td::uint64 max_execute_ticks{0};
+  td::uint64 max_mailbox_depth{0};
+};
+
+struct ActorProfile {
+  td::uint32 sample_period{0};
+  double inv_ticks_per_second{0};
+  std::vector<ActorTypeProfile> types;
+  // sorted by execute_ticks
+  std::vector<ActorInstanceProfile> top_instances;
+
+  std::string to_json() const;
+};
+
+// Sampling profiler of actor executions. Only every sample_period-th execution on each thread is measured,
+// so the cost of a disabled or sparse profiler is one thread-local counter increment per execution.
+class ActorProfiler {
+ public:
+  // 0 disables the profiler
+  static void set_sample_period(td::uint32 period) {
+    sample_period_.store(period, std::memory_order_relaxed);
+  }
+  static td::uint32 get_sample_period() {
+    return sample_period_.load(std::memory_order_relaxed);
+  }
+  static bool is_enabled() {
+    return get_sample_period() != 0;
+  }
+  static bool should_sample();
+
+  static ActorProfile get_profile(double inv_ticks_per_second, size_t top_n);
+
+  class Sample {
+   public:
+    Sample() = default;
+    Sample(const Sample &) = delete;
+    Sample &operator=(const Sample &) = delete;
+    ~Sample() {
+      finish();
+    }
+
+    bool is_active() const {
+      return type_entry_ != nullptr;
+    }
+    void start(td::uint32 actor_stat_id, const char *type_name, const void *instance, Slice instance_name,
+               td::uint64 in_queue_since);
+    void on_mailbox_depth(size_t depth);
+    void on_message(td::uint64 enqueued_at, td::uint64 started_at, td::uint64 finished_at);
+    void finish();
+
+   private:
+    void *type_entry_{nullptr};
+    const void *instance_{nullptr};
+    Slice instance_name_;
+    td::uint64 started_at_{0};
+    td::uint64 messages_{0};
+    td::uint64 mailbox_depth_{0};
+  };
+
+ private:
+  static std::atomic<td::uint32> sample_period_;
+};
+
+}  // namespace core
+}  // namespace actor
+}  // namespace td
@@ -66,16 +66,50 @@ bool CpuWorker::try_pop_global(SchedulerMessage &message, size_t thread_id) {
   return false;
 }
 
-bool CpuWorker::try_pop(SchedulerMessage &message, size_t thread_id) {
+bool CpuWorker::try_pop_priority(SchedulerMessage &message, ActorPriority priority, size_t thread_id) {
+  auto i = static_cast<size_t>(priority);
+  if (i >= priority_queues_.size() || !priority_queues_[i]) {
+    return false;
+  }
+  SchedulerMessage::Raw *raw_message;
+  if (priority_queues_[i]->try_pop(raw_message, thread_id)) {
+    message = SchedulerMessage(SchedulerMessage::acquire_t{}, raw_message);
+    return true;
+  }
+  return false;
+}
+
+bool CpuWorker::try_pop_default(SchedulerMessage &message, size_t thread_id) {
   if (++cnt_ == 51) {
     cnt_ = 0;
-    if (try_pop_global(message, thread_id) || try_pop_local(message)) {
-      return true;
-    }
-  } else {
-    if (try_pop_local(message) || try_pop_global(message, thread_id)) {
-      return true;
-    }
+    return try_pop_global(message, thread_id) || try_pop_local(message);
+  }
+  return try_pop_local(message) || try_pop_global(message, thread_id);
+}
+
+bool CpuWorker::try_pop(SchedulerMessage &message, size_t thread_id) {
+  auto slot = priority_cnt_++ % PRIORITY_PERIOD;
+  if (slot == 0 && try_pop_priority(message, ActorPriority::Background, thread_id)) {
+    return true;
+  }
+  if (slot == PRIORITY_PERIOD / 2 && try_pop_priority(message, ActorPriority::Serving, thread_id)) {
+    return true;
+  }
+  bool default_first = slot % 8 == 4;
+  if (default_first && try_pop_default(message, thread_id)) {
+    return true;
+  }
+
+  if (try_pop_priority(message, ActorPriority::Consensus, thread_id) ||
+      try_pop_priority(message, ActorPriority::Collation, thread_id)) {
+    return true;
+  }
+  if (!default_first && try_pop_default(message, thread_id)) {
+    return true;
+  }
+  if (try_pop_priority(message, ActorPriority::Serving, thread_id) ||
+      try_pop_priority(message, ActorPriority::Background, thread_id)) {
+    return true;
   }
 
   for (size_t i = 1; i < local_queues_.size(); i++) {
@@ -18,6 +18,7 @@
 */
 #pragma once
 
+#include "td/actor/core/ActorPriority.h"
 #include "td/actor/core/SchedulerMessage.h"
 
 #include "td/utils/MpmcQueue.h"
@@ -32,8 +33,9 @@ struct LocalQueue;
 class CpuWorker {
  public:
   CpuWorker(MpmcQueue<SchedulerMessage::Raw *> &queue, MpmcWaiter &waiter, size_t id,
-            MutableSpan<LocalQueue<SchedulerMessage::Raw *>> local_queues)
-      : queue_(queue), waiter_(waiter), id_(id), local_queues_(local_queues) {
+            MutableSpan<LocalQueue<SchedulerMessage::Raw *>> local_queues,
+            MutableSpan<std::unique_ptr<MpmcQueue<SchedulerMessage::Raw *>>> priority_queues = {})
+      : queue_(queue), waiter_(waiter), id_(id), local_queues_(local_queues), priority_queues_(priority_queues) {
   }
   void run();
 
@@ -42,10 +44,18 @@ class CpuWorker {
   MpmcWaiter &waiter_;
   size_t id_;
   MutableSpan<LocalQueue<SchedulerMessage::Raw *>> local_queues_;
+  MutableSpan<std::unique_ptr<MpmcQueue<SchedulerMessage::Raw *>>> priority_queues_;
   size_t cnt_{0};
+  size_t priority_cnt_{0};
+
+  // Within each period the least urgent classes get the first chance once, so they can't starve
+  static constexpr size_t PRIORITY_PERIOD = 64;
 
   bool try_pop(SchedulerMessage &message, size_t thread_id);
 
+  bool try_pop_default(SchedulerMessage &message, size_t thread_id);
+  bool try_pop_priority(SchedulerMessage &message, ActorPriority priority, size_t thread_id);
+
   bool try_pop_local(SchedulerMessage &message);
   bool try_pop_global(SchedulerMessage &message, size_t thread_id);
 };
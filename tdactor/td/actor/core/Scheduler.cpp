@@ -47,6 +47,12 @@ Scheduler::Scheduler(std::shared_ptr<SchedulerGroupInfo> scheduler_group_info, S
     info_->cpu_queue_waiter = std::make_unique<MpmcWaiter>();
 
     info_->cpu_local_queue = std::vector<LocalQueue<SchedulerMessage::Raw *>>(cpu_threads_count);
+    info_->cpu_priority_queue.resize(ACTOR_PRIORITY_COUNT);
+    for (size_t i = 0; i < ACTOR_PRIORITY_COUNT; i++) {
+      if (static_cast<ActorPriority>(i) != ActorPriority::Default) {
+        info_->cpu_priority_queue[i] = std::make_unique<MpmcQueue<SchedulerMessage::Raw *>>(1024, max_thread_count());
+      }
+    }
   }
   info_->io_queue = std::make_unique<MpscPollableQueue<SchedulerMessage>>();
   info_->io_queue->init();
@@ -79,7 +85,8 @@ void Scheduler::start() {
   for (size_t i = 0; i < cpu_threads_.size(); i++) {
     cpu_threads_[i] = td::thread([this, i] {
       this->run_in_context_impl(*this->info_->cpu_workers[i], [this, i] {
-        CpuWorker(*info_->cpu_queue, *info_->cpu_queue_waiter, i, info_->cpu_local_queue).run();
+        CpuWorker(*info_->cpu_queue, *info_->cpu_queue_waiter, i, info_->cpu_local_queue, info_->cpu_priority_queue)
+            .run();
       });
     });
     cpu_threads_[i].set_name(PSLICE() << "#" << info_->id.value() << ":cpu#" << i);
@@ -161,6 +168,12 @@ void Scheduler::ContextImpl::add_to_queue(ActorInfoPtr actor_info_ptr, Scheduler
   if (need_poll || !info.cpu_queue) {
     info.io_queue->writer_put(std::move(actor_info_ptr));
   } else {
+    auto priority = static_cast<size_t>(actor_info_ptr->get_priority());
+    if (info.cpu_priority_queue[priority]) {
+      info.cpu_priority_queue[priority]->push(actor_info_ptr.release(), get_thread_id());
+      info.cpu_queue_waiter->notify();
+      return;
+    }
     if (scheduler_id == get_scheduler_id() && cpu_worker_id_.is_valid()) {
       // may push local
       CHECK(actor_info_ptr);
@@ -315,6 +328,20 @@ void Scheduler::close_scheduler_group(SchedulerGroupInfo &group_info) {
           queues_are_empty = false;
         }
       }
+      for (auto &q : scheduler_info.cpu_priority_queue) {
+        if (!q) {
+          continue;
+        }
+        while (true) {
+          SchedulerMessage::Raw *raw_message;
+          if (!q->try_pop(raw_message, get_thread_id())) {
+            break;
+          }
+          SchedulerMessage(SchedulerMessage::acquire_t{}, raw_message);
+          // message's destructor is called
+          queues_are_empty = false;
+        }
+      }
     }
     if (++it > 100) {
       LOG(FATAL) << "Failed to drain all queues";
@@ -326,6 +353,7 @@ void Scheduler::close_scheduler_group(SchedulerGroupInfo &group_info) {
   for (auto &scheduler_info : group_info.schedulers) {
     scheduler_info.io_queue.reset();
     scheduler_info.cpu_queue.reset();
+    scheduler_info.cpu_priority_queue.clear();
 
     // Do not destroy worker infos. run_in_context will crash if they are empty
     scheduler_info.io_worker->actor_info_creator.clear();
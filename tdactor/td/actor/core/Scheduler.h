@@ -155,6 +155,8 @@ struct SchedulerInfo {
   std::unique_ptr<MpmcWaiter> cpu_queue_waiter;
 
   std::vector<LocalQueue<SchedulerMessage::Raw *>> cpu_local_queue;
+  // one queue per ActorPriority except Default, which uses cpu_queue and cpu_local_queue
+  std::vector<std::unique_ptr<MpmcQueue<SchedulerMessage::Raw *>>> cpu_priority_queue;
   //std::vector<td::StealingQueue<SchedulerMessage>> cpu_stealing_queue;
 
   // only scheduler itself may read from io_queue_
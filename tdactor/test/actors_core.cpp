@@ -22,11 +22,13 @@
 #include "td/actor/ActorStats.h"
 
 #include "td/utils/format.h"
+#include "td/utils/JsonBuilder.h"
 #include "td/utils/logging.h"
 #include "td/utils/misc.h"
 #include "td/utils/port/thread.h"
 #include "td/utils/port/thread.h"
 #include "td/utils/Random.h"
+#include "td/utils/ScopeGuard.h"
 #include "td/utils/Slice.h"
 #include "td/utils/StringBuilder.h"
 #include "td/utils/tests.h"
@@ -34,6 +36,7 @@
 #include "td/utils/TimedStat.h"
 #include "td/utils/port/sleep.h"
 
+#include <algorithm>
 #include <array>
 #include <atomic>
 #include <deque>
@@ -1108,6 +1111,176 @@ TEST(Actor2, send_vs_close2) {
   }
 }
 
+TEST(Actor2, priorities) {
+  Scheduler scheduler({4});
+  td::actor::set_debug(true);
+
+  std::atomic<int> done{0};
+  constexpr int yields = 1000;
+  scheduler.run_in_context([&] {
+    class Worker : public Actor {
+     public:
+      Worker(std::shared_ptr<td::Destructor> watcher, std::atomic<int> *done)
+          : watcher_(std::move(watcher)), done_(done) {
+      }
+      void loop() override {
+        if (++cnt_ == yields) {
+          done_->fetch_add(1);
+          return stop();
+        }
+        yield();
+      }
+
+     private:
+      std::shared_ptr<td::Destructor> watcher_;
+      std::atomic<int> *done_;
+      int cnt_{0};
+    };
+    auto watcher = td::create_shared_destructor([] { SchedulerContext::get()->stop(); });
+    for (size_t i = 0; i < core::ACTOR_PRIORITY_COUNT; i++) {
+      for (int j = 0; j < 10; j++) {
+        td::actor::create_actor<Worker>(
+            ActorOptions().with_name("Worker").with_priority(static_cast<ActorPriority>(i)), watcher, &done)
+            .release();
+      }
+    }
+  });
+  scheduler.run();
+
+  ASSERT_EQ(static_cast<int>(core::ACTOR_PRIORITY_COUNT) * 10, done.load());
+  auto stats = ActorPriorityStatManager::get_stats(td::Clocks::inv_ticks_per_second());
+  for (auto &stat : stats) {
+    ASSERT_TRUE(stat.total >= 10 * yields);
+  }
+}
+
+TEST(Actor2, priority_order) {
+  // one cpu thread is blocked while low-priority actors are created before high-priority ones,
+  // then the order in which they are served is checked
+  Scheduler scheduler({1});
+  constexpr int per_class = 10;
+
+  std::vector<ActorPriority> order;
+  scheduler.run_in_context([&] {
+    class Recorder : public Actor {
+     public:
+      Recorder(std::shared_ptr<td::Destructor> watcher, ActorPriority priority, std::vector<ActorPriority> *order)
+          : watcher_(std::move(watcher)), priority_(priority), order_(order) {
+      }
+      void start_up() override {
+        order_->push_back(priority_);
+        stop();
+      }
+
+     private:
+      std::shared_ptr<td::Destructor> watcher_;
+      ActorPriority priority_;
+      std::vector<ActorPriority> *order_;
+    };
+    class Blocker : public Actor {
+     public:
+      Blocker(std::shared_ptr<td::Destructor> watcher, std::vector<ActorPriority> *order)
+          : watcher_(std::move(watcher)), order_(order) {
+      }
+      void start_up() override {
+        // the only cpu worker is busy here, so everything created below waits in the queues
+        for (auto priority : {ActorPriority::Background, ActorPriority::Serving, ActorPriority::Default,
+                              ActorPriority::Collation, ActorPriority::Consensus}) {
+          for (int i = 0; i < per_class; i++) {
+            td::actor::create_actor<Recorder>(ActorOptions().with_name("Recorder").with_priority(priority), watcher_,
+                                              priority, order_)
+                .release();
+          }
+        }
+        stop();
+      }
+
+     private:
+      std::shared_ptr<td::Destructor> watcher_;
+      std::vector<ActorPriority> *order_;
+    };
+    auto watcher = td::create_shared_destructor([] { SchedulerContext::get()->stop(); });
+    td::actor::create_actor<Blocker>("Blocker", std::move(watcher), &order).release();
+  });
+  scheduler.run();
+
+  ASSERT_EQ(static_cast<size_t>(per_class * 5), order.size());
+  auto served_before_last = [&](std::initializer_list<ActorPriority> high, std::initializer_list<ActorPriority> low) {
+    auto is_in = [](ActorPriority p, std::initializer_list<ActorPriority> list) {
+      return std::find(list.begin(), list.end(), p) != list.end();
+    };
+    size_t last_high = 0;
+    for (size_t i = 0; i < order.size(); i++) {
+      if (is_in(order[i], high)) {
+        last_high = i;
+      }
+    }
+    int cnt = 0;
+    for (size_t i = 0; i < last_high; i++) {
+      cnt += is_in(order[i], low);
+    }
+    return cnt;
+  };
+  // serving and background get the first chance only once per CpuWorker::PRIORITY_PERIOD pops
+  ASSERT_TRUE(served_before_last({ActorPriority::Consensus, ActorPriority::Collation},
+                                 {ActorPriority::Serving, ActorPriority::Background}) <= 2);
+  ASSERT_TRUE(served_before_last({ActorPriority::Default}, {ActorPriority::Serving, ActorPriority::Background}) <= 2);
+  // default queues get the first chance on every 8th pop
+  ASSERT_TRUE(served_before_last({ActorPriority::Consensus, ActorPriority::Collation}, {ActorPriority::Default}) <=
+              per_class / 2);
+}
+
+TEST(Actor2, profiler) {
+  Scheduler scheduler({2});
+  ActorProfiler::set_sample_period(1);
+  SCOPE_EXIT {
+    ActorProfiler::set_sample_period(0);
+  };
+
+  auto watcher = td::create_shared_destructor([] { SchedulerContext::get()->stop(); });
+  scheduler.run_in_context([watcher = std::move(watcher)] {
+    class Sink : public Actor {
+     public:
+      void ping() {
+        td::usleep_for(100);
+      }
+    };
+    class Source : public Actor {
+     public:
+      Source(std::shared_ptr<td::Destructor> watcher) : watcher_(std::move(watcher)) {
+      }
+      void start_up() override {
+        sink_ = td::actor::create_actor<Sink>("ProfiledSink");
+        for (int i = 0; i < 100; i++) {
+          send_closure(sink_, &Sink::ping);
+        }
+        alarm_timestamp() = td::Timestamp::in(0.2);
+      }
+      void alarm() override {
+        stop();
+      }
+
+     private:
+      std::shared_ptr<td::Destructor> watcher_;
+      td::actor::ActorOwn<Sink> sink_;
+    };
+    td::actor::create_actor<Source>("Source", watcher).release();
+  });
+  scheduler.run();
+
+  auto profile = ActorProfiler::get_profile(td::Clocks::inv_ticks_per_second(), 10);
+  auto it = std::find_if(profile.types.begin(), profile.types.end(),
+                         [](auto &type) { return td::ends_with(type.name, "Sink"); });
+  ASSERT_TRUE(it != profile.types.end());
+  ASSERT_EQ(100u, it->message_ticks.count);
+  ASSERT_TRUE(it->mailbox_depth.max > 0);
+  ASSERT_TRUE(std::any_of(profile.top_instances.begin(), profile.top_instances.end(),
+                          [](auto &instance) { return instance.name == "ProfiledSink"; }));
+
+  auto json = profile.to_json();
+  ASSERT_TRUE(td::json_decode(td::MutableSlice(json)).is_ok());
+}
+
 TEST(Actor2, test_stats) {
   Scheduler scheduler({8});
   td::actor::set_debug(true);
@@ -34,6 +34,7 @@
 #include "td/utils/port/signals.h"
 #include "td/utils/port/path.h"
 #include "td/utils/Random.h"
+#include "td/utils/Timer.h"
 
 #include <memory>
 #include <set>
@@ -403,6 +404,47 @@ int main() {
   }
   LOG(ERROR) << "success";
 
+  auto run_bulk_get = [&](td::uint32 node_idx) {
+    std::vector<ton::dht::DhtKey> keys;
+    for (td::uint32 x = 0; x < 100; x++) {
+      keys.emplace_back(key_short_id, PSTRING() << "test-" << x, x % 8);
+    }
+    remaining++;
+    auto P = td::PromiseCreator::lambda([&](td::Result<std::vector<td::Result<ton::dht::DhtValue>>> R) {
+      R.ensure();
+      auto values = R.move_as_ok();
+      CHECK(values.size() == 100);
+      for (td::uint32 idx = 0; idx < values.size(); idx++) {
+        auto v = values[idx].move_as_ok();
+        CHECK(v.key().key().name() == (PSTRING() << "test-" << idx));
+        td::uint8 buf[1];
+        buf[0] = static_cast<td::uint8>(idx);
+        CHECK(v.value().as_slice() == td::Slice(buf, 1));
+      }
+      remaining--;
+    });
+    td::Timer timer;
+    scheduler.run_in_context(
+        [&] { td::actor::send_closure(dht[node_idx], &ton::dht::Dht::get_values, std::move(keys), std::move(P)); });
+
+    t = td::Timestamp::in(60.0);
+    while (scheduler.run(1)) {
+      if (!remaining) {
+        break;
+      }
+      if (t.is_in_past()) {
+        LOG(FATAL) << "failed: remaining = " << remaining;
+      }
+    }
+    return timer.elapsed();
+  };
+
+  LOG(ERROR) << "bulk gets";
+  td::uint32 bulk_node = td::Random::fast(0, total_nodes - 1);
+  auto cold = run_bulk_get(bulk_node);
+  auto warm = run_bulk_get(bulk_node);
+  LOG(ERROR) << "success: 100 keys resolved in " << cold << "s (cold), " << warm << "s (cached)";
+
   td::rmrf(db_root_).ensure();
   std::_Exit(0);
   return 0;
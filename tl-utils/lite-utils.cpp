@@ -142,6 +142,7 @@ std::string lite_query_name_by_id(int id) {
       {lite_api::liteServer_sendMessage::ID, "sendMessage"},
       {lite_api::liteServer_getAccountState::ID, "getAccountState"},
       {lite_api::liteServer_getAccountStatePrunned::ID, "getAccountStatePrunned"},
+      {lite_api::liteServer_getAccountStates::ID, "getAccountStates"},
       {lite_api::liteServer_runSmcMethod::ID, "runSmcMethod"},
       {lite_api::liteServer_getShardInfo::ID, "getShardInfo"},
       {lite_api::liteServer_getAllShardsInfo::ID, "getAllShardsInfo"},
@@ -91,7 +91,7 @@ tl::TL_writer::Mode TD_TL_writer::get_storer_mode(int type) const {
 
 std::vector<std::string> TD_TL_writer::get_parsers() const {
   std::vector<std::string> parsers;
-  if (tl_name == "ton_api" || tl_name == "lite_api") {
+  if (tl_name == "ton_api" || tl_name == "lite_api" || tl_name == "tonlib_api") {
     parsers.push_back("td::TlParser");
   }
   return parsers;
@@ -99,7 +99,7 @@ std::vector<std::string> TD_TL_writer::get_parsers() const {
 
 std::vector<std::string> TD_TL_writer::get_storers() const {
   std::vector<std::string> storers;
-  if (tl_name == "ton_api" || tl_name == "lite_api") {
+  if (tl_name == "ton_api" || tl_name == "lite_api" || tl_name == "tonlib_api") {
     storers.push_back("td::TlStorerCalcLength");
     storers.push_back("td::TlStorerUnsafe");
   }
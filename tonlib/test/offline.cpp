@@ -27,7 +27,9 @@
 
 #include "tonlib/utils.h"
 #include "tonlib/TonlibClient.h"
+#include "tonlib/GetMethodCache.h"
 #include "tonlib/Client.h"
+#include "tonlib/ClientJson.h"
 
 #include "auto/tl/ton_api_json.h"
 #include "auto/tl/tonlib_api_json.h"
@@ -39,6 +41,8 @@
 #include "td/utils/port/path.h"
 #include "td/utils/PathView.h"
 #include "td/utils/tests.h"
+#include "td/utils/tl_parsers.h"
+#include "td/utils/tl_storers.h"
 
 // KeyManager
 #include "tonlib/keys/bip39.h"
@@ -693,3 +697,187 @@ TEST(Tonlib, ConfigCache) {
                         make_object<tonlib_api::config>(custom, "testnet", true, false)))
       .ensure_error();
 }
+
+static std::string serialize_binary(td::int64 id, const ton::TlObject &object) {
+  td::TlStorerCalcLength calc;
+  calc.store_long(id);
+  calc.store_int(object.get_id());
+  object.store(calc);
+
+  std::string str(calc.get_length(), '\0');
+  td::TlStorerUnsafe storer(td::MutableSlice(str).ubegin());
+  storer.store_long(id);
+  storer.store_int(object.get_id());
+  object.store(storer);
+  return str;
+}
+
+// Per-request work of ClientJson: parse the request and serialize the response
+class ClientJsonBench : public td::Benchmark {
+ public:
+  ClientJsonBench(std::string name, bool binary, tonlib_api::object_ptr<tonlib_api::Function> request,
+                  tonlib_api::object_ptr<tonlib_api::Object> response)
+      : name_(std::move(name)), binary_(binary), request_(std::move(request)), response_(std::move(response)) {
+  }
+  std::string get_description() const override {
+    return PSTRING() << name_ << (binary_ ? " binary" : " json");
+  }
+  void start_up() override {
+    serialized_request_ =
+        binary_ ? serialize_binary(1, *request_) : td::json_encode<std::string>(td::ToJson(*request_));
+  }
+  void run(int n) override {
+    size_t size = 0;
+    for (int i = 0; i < n; i++) {
+      if (binary_) {
+        td::TlParser parser(serialized_request_);
+        parser.fetch_long();
+        auto function = tonlib_api::Function::fetch(parser);
+        parser.fetch_end();
+        parser.get_status().ensure();
+        size += serialize_binary(1, *response_).size();
+      } else {
+        auto str = serialized_request_;
+        tonlib_api::object_ptr<tonlib_api::Function> function;
+        from_json(function, td::json_decode(str).move_as_ok()).ensure();
+        size += td::json_encode<std::string>(td::ToJson(*response_)).size();
+      }
+    }
+    td::do_not_optimize_away(size);
+  }
+
+ private:
+  std::string name_;
+  bool binary_;
+  tonlib_api::object_ptr<tonlib_api::Function> request_;
+  tonlib_api::object_ptr<tonlib_api::Object> response_;
+  std::string serialized_request_;
+};
+
+TEST(Tonlib, ClientJsonBinary) {
+  auto response = ClientJson::execute_binary(serialize_binary(123, tonlib_api::getLogVerbosityLevel()));
+  td::TlParser parser(response);
+  ASSERT_EQ(123, parser.fetch_long());
+  ASSERT_EQ(tonlib_api::logVerbosityLevel::ID, parser.fetch_int());
+  parser.fetch_int();
+  parser.fetch_end();
+  parser.get_status().ensure();
+  ASSERT_TRUE(ClientJson::execute_binary("abacaba").empty());
+
+  using tonlib_api::make_object;
+  auto address = [] { return make_object<tonlib_api::accountAddress>(std::string(48, 'E')); };
+  auto get_account_state = [&] { return make_object<tonlib_api::raw_getAccountState>(address()); };
+  auto account_state = [] {
+    return make_object<tonlib_api::raw_fullAccountState>(
+        1000000000, std::vector<tonlib_api::object_ptr<tonlib_api::extraCurrency>>(), td::rand_string('a', 'z', 2048),
+        td::rand_string('a', 'z', 8192), make_object<tonlib_api::internal_transactionId>(1, std::string(32, 'a')),
+        make_object<tonlib_api::ton_blockIdExt>(0, 0, 1, std::string(32, 'a'), std::string(32, 'b')), "", 1);
+  };
+  auto run_get_method = [] {
+    return make_object<tonlib_api::smc_runGetMethod>(
+        1, make_object<tonlib_api::smc_methodIdName>("get_wallet_data"),
+        std::vector<tonlib_api::object_ptr<tonlib_api::tvm_StackEntry>>());
+  };
+  auto run_result = [] {
+    std::vector<tonlib_api::object_ptr<tonlib_api::tvm_StackEntry>> stack;
+    for (int i = 0; i < 8; i++) {
+      stack.push_back(make_object<tonlib_api::tvm_stackEntryNumber>(
+          make_object<tonlib_api::tvm_numberDecimal>("1234567890123456789")));
+    }
+    auto cell = make_object<tonlib_api::tvm_cell>(td::rand_string('a', 'z', 1024));
+    stack.push_back(make_object<tonlib_api::tvm_stackEntryCell>(std::move(cell)));
+    return make_object<tonlib_api::smc_runResult>(1000, std::move(stack), 0);
+  };
+  for (bool binary : {false, true}) {
+    td::bench(ClientJsonBench("raw.getAccountState", binary, get_account_state(), account_state()));
+    td::bench(ClientJsonBench("smc.runGetMethod", binary, run_get_method(), run_result()));
+  }
+}
+
+namespace {
+
+td::Ref<vm::Cell> make_get_method_cell(int value) {
+  vm::CellBuilder cb;
+  cb.store_long(value, 32);
+  return cb.finalize();
+}
+
+ton::SmartContract::Args make_get_method_args(td::int32 method_id) {
+  return ton::SmartContract::Args()
+      .set_method_id(method_id)
+      .set_address(block::StdAddress(0, td::Bits256::zero()))
+      .set_now(1000)
+      .set_balance(100)
+      .set_stack({vm::StackEntry(td::make_refint(1))});
+}
+
+tonlib::GetMethodCache::Key make_get_method_key(const ton::SmartContract::Args &args, int data = 0) {
+  return tonlib::GetMethodCache::make_key({make_get_method_cell(1), make_get_method_cell(data)}, args).move_as_ok();
+}
+
+}  // namespace
+
+TEST(Tonlib, GetMethodCacheHit) {
+  tonlib::GetMethodCache cache;
+  auto key = make_get_method_key(make_get_method_args(1));
+  ASSERT_TRUE(!cache.get(key));
+  cache.set(key, {123, td::Ref<vm::Stack>(true), 0});
+  auto value = cache.get(key);
+  ASSERT_TRUE(bool(value));
+  ASSERT_EQ(123, value.value().gas_used);
+  // the same inputs give the same key
+  ASSERT_TRUE(cache.get(make_get_method_key(make_get_method_args(1))));
+  ASSERT_TRUE(!cache.get(make_get_method_key(make_get_method_args(2))));
+  ASSERT_EQ(2u, cache.get_stats().hits);
+  ASSERT_EQ(2u, cache.get_stats().misses);
+
+  // a new state of the account drops its entries
+  ASSERT_TRUE(!cache.get(make_get_method_key(make_get_method_args(1), 1)));
+  ASSERT_EQ(1u, cache.get_stats().invalidations);
+  ASSERT_EQ(0u, cache.size());
+}
+
+TEST(Tonlib, GetMethodCacheEviction) {
+  tonlib::GetMethodCache cache{2};
+  auto key1 = make_get_method_key(make_get_method_args(1));
+  auto key2 = make_get_method_key(make_get_method_args(2));
+  auto key3 = make_get_method_key(make_get_method_args(3));
+  cache.set(key1, {1, td::Ref<vm::Stack>(true), 0});
+  cache.set(key2, {2, td::Ref<vm::Stack>(true), 0});
+  // the least recently used entry is evicted
+  ASSERT_TRUE(cache.get(key1));
+  cache.set(key3, {3, td::Ref<vm::Stack>(true), 0});
+  ASSERT_EQ(2u, cache.size());
+  ASSERT_EQ(1u, cache.get_stats().evictions);
+  ASSERT_TRUE(!cache.get(key2));
+  ASSERT_TRUE(cache.get(key1));
+  ASSERT_TRUE(cache.get(key3));
+}
+
+TEST(Tonlib, GetMethodCacheKey) {
+  auto base = make_get_method_key(make_get_method_args(1)).hash;
+  auto check_differs = [&](ton::SmartContract::Args args, int data = 0) {
+    ASSERT_TRUE(make_get_method_key(args, data).hash != base);
+  };
+  check_differs(make_get_method_args(1), 1);
+  check_differs(make_get_method_args(2));
+  check_differs(make_get_method_args(1).set_address(block::StdAddress(-1, td::Bits256::zero())));
+  check_differs(make_get_method_args(1).set_now(1001));
+  check_differs(make_get_method_args(1).set_balance(101));
+  check_differs(make_get_method_args(1).set_amount(1));
+  check_differs(make_get_method_args(1).set_ignore_chksig(true));
+  td::Bits256 rand_seed = td::Bits256::zero();
+  rand_seed.as_slice()[0] = 1;
+  check_differs(make_get_method_args(1).set_rand_seed(rand_seed));
+  check_differs(make_get_method_args(1).set_stack({vm::StackEntry(td::make_refint(2))}));
+  check_differs(make_get_method_args(1).set_prev_blocks_info(vm::make_tuple_ref()));
+  check_differs(make_get_method_args(1).set_extra_currencies(make_get_method_cell(1)));
+
+  // executions with explicit c7 or gas limits are not cached
+  ASSERT_TRUE(tonlib::GetMethodCache::make_key({make_get_method_cell(1), make_get_method_cell(0)},
+                                               make_get_method_args(1).set_c7(vm::make_tuple_ref()))
+                  .is_error());
+  ASSERT_TRUE(tonlib::GetMethodCache::make_key({make_get_method_cell(1), make_get_method_cell(0)},
+                                               make_get_method_args(1).set_limits(vm::GasLimits{1000}))
+                  .is_error());
+}
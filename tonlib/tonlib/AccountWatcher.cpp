@@ -0,0 +1,347 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "tonlib/AccountWatcher.h"
+
+#include "block/block-auto.h"
+#include "block/block-parse.h"
+#include "block/check-proof.h"
+#include "block/mc-config.h"
+#include "ton/lite-tl.hpp"
+#include "ton/ton-shard.h"
+#include "vm/boc.h"
+#include "vm/cells/MerkleProof.h"
+
+#include "td/actor/MultiPromise.h"
+
+namespace tonlib {
+
+template <class Type>
+using lite_api_ptr = ton::lite_api::object_ptr<Type>;
+
+td::Status check_block_transactions_proof(lite_api_ptr<ton::lite_api::liteServer_blockTransactions>& bTxes, int32_t mode,
+    ton::LogicalTime start_lt, td::Bits256 start_addr, td::Bits256 root_hash, int req_count);
+
+namespace {
+
+td::Result<block::ShardConfig> check_shard_config(ton::BlockIdExt mc_block_id,
+                                                  ton::lite_api::liteServer_allShardsInfo &info) {
+  if (info.data_.empty() || info.proof_.empty()) {
+    return td::Status::Error("shard configuration or proof is empty");
+  }
+  TRY_RESULT_PREFIX(proof, vm::std_boc_deserialize(std::move(info.proof_)), "cannot deserialize shards proof: ");
+  TRY_RESULT_PREFIX(data, vm::std_boc_deserialize(std::move(info.data_)), "cannot deserialize shard configuration: ");
+  try {
+    auto virt_root = vm::MerkleProof::virtualize(std::move(proof), 1);
+    if (virt_root.is_null()) {
+      return td::Status::Error("shards proof is not a valid Merkle proof");
+    }
+    if (ton::RootHash{virt_root->get_hash().bits()} != mc_block_id.root_hash) {
+      return td::Status::Error("shards proof has incorrect root hash");
+    }
+    block::gen::Block::Record blk;
+    block::gen::BlockExtra::Record extra;
+    block::gen::McBlockExtra::Record mc_extra;
+    if (!tlb::unpack_cell(virt_root, blk) || !tlb::unpack_cell(blk.extra, extra) || !extra.custom->have_refs() ||
+        !tlb::unpack_cell(extra.custom->prefetch_ref(), mc_extra)) {
+      return td::Status::Error("cannot unpack block extra of block " + mc_block_id.to_str());
+    }
+    auto data_csr = vm::load_cell_slice_ref(std::move(data));
+    if (data_csr->prefetch_ref()->get_hash() != mc_extra.shard_hashes->prefetch_ref()->get_hash()) {
+      return td::Status::Error("shard configuration and proof hashes don't match");
+    }
+    block::ShardConfig shard_config;
+    if (!shard_config.unpack(std::move(data_csr))) {
+      return td::Status::Error("cannot unpack shard configuration");
+    }
+    return std::move(shard_config);
+  } catch (vm::VmError &err) {
+    return err.as_status("cannot check shard configuration: ");
+  } catch (vm::VmVirtError &err) {
+    return err.as_status("cannot check shard configuration: ");
+  }
+}
+
+// returns the previous block of the same shard, or nothing if the shard was split or merged right before the block
+td::Result<td::optional<ton::BlockIdExt>> check_prev_block(ton::BlockIdExt block_id,
+                                                           ton::lite_api::liteServer_blockHeader &header) {
+  if (ton::create_block_id(header.id_) != block_id) {
+    return td::Status::Error("liteserver returned a header of a wrong block");
+  }
+  TRY_RESULT_PREFIX(proof, vm::std_boc_deserialize(std::move(header.header_proof_)),
+                    "cannot deserialize block header proof: ");
+  try {
+    auto virt_root = vm::MerkleProof::virtualize(std::move(proof), 1);
+    if (virt_root.is_null()) {
+      return td::Status::Error("block header proof is not a valid Merkle proof");
+    }
+    TRY_STATUS(block::check_block_header_proof(virt_root, block_id));
+    std::vector<ton::BlockIdExt> prev;
+    ton::BlockIdExt mc_block_id;
+    bool after_split;
+    TRY_STATUS(block::unpack_block_prev_blk_try(virt_root, block_id, prev, mc_block_id, after_split));
+    if (prev.size() != 1 || prev[0].shard_full() != block_id.shard_full()) {
+      return td::optional<ton::BlockIdExt>();
+    }
+    return td::optional<ton::BlockIdExt>(prev[0]);
+  } catch (vm::VmError &err) {
+    return err.as_status("cannot check block header: ");
+  } catch (vm::VmVirtError &err) {
+    return err.as_status("cannot check block header: ");
+  }
+}
+
+}  // namespace
+
+AccountWatcher::AccountWatcher(ExtClientRef client, std::vector<block::StdAddress> addresses,
+                               td::unique_ptr<Callback> callback)
+    : callback_(std::move(callback)) {
+  client_.set_client(client);
+  for (auto &address : addresses) {
+    watched_[AccountKey{address.workchain, address.addr}] = std::move(address);
+  }
+}
+
+void AccountWatcher::start_up() {
+  alarm_timestamp() = td::Timestamp::now();
+}
+
+void AccountWatcher::alarm() {
+  if (!round_in_progress_ && !watched_.empty()) {
+    start_round();
+  }
+  alarm_timestamp() = td::Timestamp::in(poll_interval());
+}
+
+void AccountWatcher::hangup() {
+  stop();
+}
+
+void AccountWatcher::watch(block::StdAddress address) {
+  watched_[AccountKey{address.workchain, address.addr}] = std::move(address);
+}
+
+void AccountWatcher::unwatch(block::StdAddress address) {
+  watched_.erase(AccountKey{address.workchain, address.addr});
+}
+
+void AccountWatcher::get_stats(td::Promise<std::vector<std::pair<std::string, td::int64>>> promise) {
+  std::vector<std::pair<std::string, td::int64>> res;
+  res.emplace_back("account_watcher.watched", static_cast<td::int64>(watched_.size()));
+  res.emplace_back("account_watcher.last_mc_seqno", last_mc_block_id_ ? last_mc_block_id_.value().seqno() : 0);
+  res.emplace_back("account_watcher.rounds", stats_.rounds);
+  res.emplace_back("account_watcher.blocks_scanned", stats_.blocks_scanned);
+  res.emplace_back("account_watcher.queries", stats_.queries);
+  res.emplace_back("account_watcher.shard_fallbacks", stats_.shard_fallbacks);
+  res.emplace_back("account_watcher.notifications", stats_.notifications);
+  promise.set_value(std::move(res));
+}
+
+void AccountWatcher::start_round() {
+  round_in_progress_ = true;
+  stats_.rounds++;
+  client_.with_last_block(
+      [self = this](td::Result<LastBlockState> r_state) { self->got_last_block(std::move(r_state)); });
+}
+
+void AccountWatcher::got_last_block(td::Result<LastBlockState> r_state) {
+  if (r_state.is_error()) {
+    return finish_round(r_state.move_as_error());
+  }
+  auto mc_block_id = r_state.ok().last_block_id;
+  if (last_mc_block_id_ && last_mc_block_id_.value().seqno() >= mc_block_id.seqno()) {
+    return finish_round(td::Status::OK());
+  }
+  round_mc_block_id_ = mc_block_id;
+  stats_.queries++;
+  client_.send_query(
+      ton::lite_api::liteServer_getAllShardsInfo(ton::create_tl_lite_block_id(mc_block_id)),
+      [self = this](td::Result<ton::lite_api::object_ptr<ton::lite_api::liteServer_allShardsInfo>> r_info) {
+        self->got_shards(std::move(r_info));
+      });
+}
+
+void AccountWatcher::got_shards(
+    td::Result<ton::lite_api::object_ptr<ton::lite_api::liteServer_allShardsInfo>> r_info) {
+  if (r_info.is_error()) {
+    return finish_round(r_info.move_as_error());
+  }
+  auto status = process_shards(r_info.move_as_ok());
+  if (status.is_error()) {
+    finish_round(std::move(status));
+  }
+}
+
+td::Status AccountWatcher::process_shards(ton::lite_api::object_ptr<ton::lite_api::liteServer_allShardsInfo> info) {
+  if (ton::create_block_id(info->id_) != round_mc_block_id_) {
+    return td::Status::Error("liteserver returned shards of a wrong block");
+  }
+  TRY_RESULT(shard_config, check_shard_config(round_mc_block_id_, *info));
+  round_shard_tops_.clear();
+  round_shard_tops_[ton::ShardIdFull(ton::masterchainId)] = round_mc_block_id_;
+  for (auto &id : shard_config.get_shard_hash_ids(true)) {
+    auto shard_hash = shard_config.get_shard_hash(ton::ShardIdFull(id));
+    if (shard_hash.not_null()) {
+      round_shard_tops_[shard_hash->shard()] = shard_hash->top_block_id();
+    }
+  }
+  round_changed_.clear();
+
+  if (!last_mc_block_id_) {
+    // changes are tracked starting from the blocks after the first seen masterchain block
+    apply_round();
+    finish_round(td::Status::OK());
+    return td::Status::OK();
+  }
+
+  td::MultiPromise mp;
+  auto ig = mp.init_guard();
+  ig.add_promise([self = this](td::Result<td::Unit> R) {
+    if (R.is_error()) {
+      return self->finish_round(R.move_as_error());
+    }
+    self->apply_round();
+    self->finish_round(td::Status::OK());
+  });
+  for (auto &it : round_shard_tops_) {
+    auto shard = it.first;
+    auto &top = it.second;
+    if (!has_watched(shard)) {
+      continue;
+    }
+    auto prev = shard_tops_.find(shard);
+    if (prev != shard_tops_.end() && prev->second == top) {
+      continue;
+    }
+    if (prev == shard_tops_.end() || top.seqno() <= prev->second.seqno() ||
+        top.seqno() - prev->second.seqno() > max_shard_blocks_per_round()) {
+      stats_.shard_fallbacks++;
+      mark_changed(shard);
+      continue;
+    }
+    scan_blocks(top, prev->second, ig.get_promise());
+  }
+  return td::Status::OK();
+}
+
+void AccountWatcher::scan_blocks(ton::BlockIdExt block_id, ton::BlockIdExt known_top, td::Promise<td::Unit> promise) {
+  td::MultiPromise mp;
+  auto ig = mp.init_guard();
+  ig.add_promise(std::move(promise));
+  list_transactions(block_id, nullptr, ig.get_promise());
+  if (block_id.seqno() == known_top.seqno() + 1) {
+    return;
+  }
+  // intermediate blocks are reached through the proven headers, starting from the top proven by the masterchain
+  stats_.queries++;
+  client_.send_query(
+      ton::lite_api::liteServer_getBlockHeader(ton::create_tl_lite_block_id(block_id), 0),
+      [self = this, block_id, known_top, promise = ig.get_promise()](
+          td::Result<ton::lite_api::object_ptr<ton::lite_api::liteServer_blockHeader>> r_header) mutable {
+        TRY_RESULT_PROMISE(promise, header, std::move(r_header));
+        TRY_RESULT_PROMISE(promise, prev, check_prev_block(block_id, *header));
+        if (!prev) {
+          self->stats_.shard_fallbacks++;
+          self->mark_changed(block_id.shard_full());
+          return promise.set_value(td::Unit());
+        }
+        self->scan_blocks(prev.unwrap(), known_top, std::move(promise));
+      });
+}
+
+void AccountWatcher::list_transactions(ton::BlockIdExt block_id,
+                                       ton::lite_api::object_ptr<ton::lite_api::liteServer_transactionId3> after,
+                                       td::Promise<td::Unit> promise) {
+  stats_.queries++;
+  // account and lt of each transaction, checked against the block
+  td::int32 mode = 3 | ton::lite_api::liteServer_listBlockTransactions::WANT_PROOF_MASK;
+  td::Bits256 start_addr = td::Bits256::zero();
+  ton::LogicalTime start_lt = 0;
+  if (after) {
+    mode |= ton::lite_api::liteServer_listBlockTransactions::AFTER_MASK;
+    start_addr = after->account_;
+    start_lt = after->lt_;
+  }
+  client_.send_query(
+      ton::lite_api::liteServer_listBlockTransactions(ton::create_tl_lite_block_id(block_id), mode,
+                                                      transactions_per_query(), std::move(after), false, true),
+      [self = this, block_id, mode, start_addr, start_lt, promise = std::move(promise)](
+          td::Result<ton::lite_api::object_ptr<ton::lite_api::liteServer_blockTransactions>> r_transactions) mutable {
+        TRY_RESULT_PROMISE(promise, transactions, std::move(r_transactions));
+        if (ton::create_block_id(transactions->id_) != block_id) {
+          return promise.set_error(td::Status::Error("liteserver returned transactions of a wrong block"));
+        }
+        TRY_STATUS_PROMISE(promise, check_block_transactions_proof(transactions, mode, start_lt, start_addr,
+                                                                   block_id.root_hash, transactions_per_query()));
+        for (auto &id : transactions->ids_) {
+          AccountKey key{block_id.id.workchain, id->account_};
+          if (self->watched_.count(key)) {
+            self->round_changed_.insert(key);
+          }
+        }
+        // a full page without the incomplete flag is not trusted to be the last one, the next page is empty then
+        if (!transactions->ids_.empty() &&
+            (transactions->incomplete_ || transactions->ids_.size() >= transactions_per_query())) {
+          auto &last = transactions->ids_.back();
+          self->list_transactions(
+              block_id, ton::lite_api::make_object<ton::lite_api::liteServer_transactionId3>(last->account_, last->lt_),
+              std::move(promise));
+          return;
+        }
+        self->stats_.blocks_scanned++;
+        promise.set_value(td::Unit());
+      });
+}
+
+void AccountWatcher::apply_round() {
+  for (auto &key : round_changed_) {
+    auto it = watched_.find(key);
+    if (it != watched_.end()) {
+      stats_.notifications++;
+      callback_->on_account_changed(it->second, round_mc_block_id_);
+    }
+  }
+  round_changed_.clear();
+  last_mc_block_id_ = round_mc_block_id_;
+  shard_tops_ = std::move(round_shard_tops_);
+  round_shard_tops_.clear();
+}
+
+void AccountWatcher::finish_round(td::Status status) {
+  if (status.is_error()) {
+    LOG(WARNING) << "Failed to check watched accounts: " << status;
+  }
+  round_in_progress_ = false;
+}
+
+bool AccountWatcher::has_watched(ton::ShardIdFull shard) const {
+  for (auto &it : watched_) {
+    if (ton::shard_contains(shard, ton::extract_addr_prefix(it.first.first, it.first.second))) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void AccountWatcher::mark_changed(ton::ShardIdFull shard) {
+  for (auto &it : watched_) {
+    if (ton::shard_contains(shard, ton::extract_addr_prefix(it.first.first, it.first.second))) {
+      round_changed_.insert(it.first);
+    }
+  }
+}
+
+}  // namespace tonlib
@@ -0,0 +1,117 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "td/actor/actor.h"
+
+#include "tonlib/ExtClient.h"
+#include "tonlib/LastBlock.h"
+
+#include "block/block.h"
+
+#include "td/utils/optional.h"
+
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace tonlib {
+
+/**
+ * Tracks changes of watched accounts instead of polling each of them.
+ *
+ * On every new masterchain block seen by LastBlock the watcher requests the shard configuration once,
+ * walks the new blocks of the shards that contain watched accounts and lists the accounts touched by their
+ * transactions. The shard configuration is checked against the masterchain block, the new shard blocks are
+ * reached from the proven shard top through the proven headers, and the transaction lists are checked against
+ * the blocks. Watched accounts found there are reported to the callback, so liteserver queries scale with
+ * the number of blocks rather than with the number of accounts. If a shard was split or merged, or too many
+ * of its blocks were missed, all watched accounts of the shard are reported.
+ */
+class AccountWatcher : public td::actor::Actor {
+ public:
+  class Callback {
+   public:
+    virtual ~Callback() {
+    }
+    // the account may have changed in a block committed in the masterchain not later than mc_block_id
+    virtual void on_account_changed(block::StdAddress address, ton::BlockIdExt mc_block_id) = 0;
+  };
+
+  AccountWatcher(ExtClientRef client, std::vector<block::StdAddress> addresses, td::unique_ptr<Callback> callback);
+
+  void watch(block::StdAddress address);
+  void unwatch(block::StdAddress address);
+  void get_stats(td::Promise<std::vector<std::pair<std::string, td::int64>>> promise);
+
+ private:
+  using AccountKey = std::pair<ton::WorkchainId, ton::StdSmcAddress>;
+
+  td::unique_ptr<Callback> callback_;
+  std::map<AccountKey, block::StdAddress> watched_;
+
+  td::optional<ton::BlockIdExt> last_mc_block_id_;
+  std::map<ton::ShardIdFull, ton::BlockIdExt> shard_tops_;
+
+  bool round_in_progress_{false};
+  ton::BlockIdExt round_mc_block_id_;
+  std::map<ton::ShardIdFull, ton::BlockIdExt> round_shard_tops_;
+  std::set<AccountKey> round_changed_;
+
+  struct Stats {
+    td::int64 rounds{0};
+    td::int64 blocks_scanned{0};
+    td::int64 queries{0};
+    td::int64 shard_fallbacks{0};
+    td::int64 notifications{0};
+  } stats_;
+
+  // destroyed first, so that cancelled queries find the rest of the watcher alive
+  ExtClient client_;
+
+  static constexpr double poll_interval() {
+    return 2.0;
+  }
+  static constexpr ton::BlockSeqno max_shard_blocks_per_round() {
+    return 16;
+  }
+  static constexpr td::uint32 transactions_per_query() {
+    return 256;
+  }
+
+  void start_up() override;
+  void alarm() override;
+  void hangup() override;
+
+  void start_round();
+  void got_last_block(td::Result<LastBlockState> r_state);
+  void got_shards(td::Result<ton::lite_api::object_ptr<ton::lite_api::liteServer_allShardsInfo>> r_info);
+  td::Status process_shards(ton::lite_api::object_ptr<ton::lite_api::liteServer_allShardsInfo> info);
+  void scan_blocks(ton::BlockIdExt block_id, ton::BlockIdExt known_top, td::Promise<td::Unit> promise);
+  void list_transactions(ton::BlockIdExt block_id,
+                         ton::lite_api::object_ptr<ton::lite_api::liteServer_transactionId3> after,
+                         td::Promise<td::Unit> promise);
+  void apply_round();
+  void finish_round(td::Status status);
+
+  bool has_watched(ton::ShardIdFull shard) const;
+  void mark_changed(ton::ShardIdFull shard);
+};
+
+}  // namespace tonlib
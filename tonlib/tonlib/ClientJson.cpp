@@ -27,7 +27,10 @@
 #include "td/utils/JsonBuilder.h"
 #include "td/utils/logging.h"
 #include "td/utils/port/thread_local.h"
+#include "td/utils/misc.h"
 #include "td/utils/Status.h"
+#include "td/utils/tl_parsers.h"
+#include "td/utils/tl_storers.h"
 
 #include <utility>
 
@@ -64,6 +67,35 @@ static std::string from_response(const tonlib_api::Object &object, const td::str
   return str;
 }
 
+static td::Result<std::pair<tonlib_api::object_ptr<tonlib_api::Function>, std::int64_t>> to_binary_request(
+    td::Slice request) {
+#if TONLIB_ENABLE_JNI
+  return td::Status::Error("Binary requests aren't supported in JNI-compatible build");
+#else
+  td::TlParser parser(request);
+  auto id = parser.fetch_long();
+  auto func = tonlib_api::Function::fetch(parser);
+  parser.fetch_end();
+  TRY_STATUS(parser.get_status());
+  CHECK(func != nullptr);
+  return std::make_pair(std::move(func), id);
+#endif
+}
+
+static std::string from_binary_response(const tonlib_api::Object &object, std::int64_t id) {
+  td::TlStorerCalcLength calc;
+  calc.store_long(id);
+  calc.store_int(object.get_id());
+  object.store(calc);
+
+  std::string str(calc.get_length(), '\0');
+  td::TlStorerUnsafe storer(td::MutableSlice(str).ubegin());
+  storer.store_long(id);
+  storer.store_int(object.get_id());
+  object.store(storer);
+  return str;
+}
+
 static TD_THREAD_LOCAL std::string *current_output;
 
 static td::CSlice store_string(std::string str) {
@@ -79,12 +111,7 @@ void ClientJson::send(td::Slice request) {
     return;
   }
 
-  std::uint64_t extra_id = extra_id_.fetch_add(1, std::memory_order_relaxed);
-  if (!r_request.ok_ref().second.empty()) {
-    std::lock_guard<std::mutex> guard(mutex_);
-    extra_[extra_id] = std::move(r_request.ok_ref().second);
-  }
-  client_.send(Client::Request{extra_id, std::move(r_request.ok_ref().first)});
+  send_request(std::move(r_request.ok_ref().first), std::move(r_request.ok_ref().second));
 }
 
 td::CSlice ClientJson::receive(double timeout) {
@@ -93,16 +120,7 @@ td::CSlice ClientJson::receive(double timeout) {
     return {};
   }
 
-  std::string extra;
-  if (response.id != 0) {
-    std::lock_guard<std::mutex> guard(mutex_);
-    auto it = extra_.find(response.id);
-    if (it != extra_.end()) {
-      extra = std::move(it->second);
-      extra_.erase(it);
-    }
-  }
-  return store_string(from_response(*response.object, extra));
+  return store_string(from_response(*response.object, pop_extra(response.id)));
 }
 
 td::CSlice ClientJson::execute(td::Slice request) {
@@ -116,4 +134,59 @@ td::CSlice ClientJson::execute(td::Slice request) {
                                     r_request.ok().second));
 }
 
+void ClientJson::send_binary(td::Slice request) {
+  auto r_request = to_binary_request(request);
+  if (r_request.is_error()) {
+    LOG(ERROR) << "Failed to parse binary request of size " << request.size() << " " << r_request.error();
+    return;
+  }
+
+  auto id = r_request.ok().second;
+  send_request(std::move(r_request.ok_ref().first), id == 0 ? std::string() : td::to_string(id));
+}
+
+td::Slice ClientJson::receive_binary(double timeout) {
+  auto response = client_.receive(timeout);
+  if (!response.object) {
+    return {};
+  }
+
+  // responses to JSON requests are returned with id 0 unless their @extra is an integer
+  auto r_id = td::to_integer_safe<std::int64_t>(pop_extra(response.id));
+  return store_string(from_binary_response(*response.object, r_id.is_ok() ? r_id.ok() : 0));
+}
+
+td::Slice ClientJson::execute_binary(td::Slice request) {
+  auto r_request = to_binary_request(request);
+  if (r_request.is_error()) {
+    LOG(ERROR) << "Failed to parse binary request of size " << request.size() << " " << r_request.error();
+    return {};
+  }
+
+  return store_string(from_binary_response(
+      *Client::execute(Client::Request{0, std::move(r_request.ok_ref().first)}).object, r_request.ok().second));
+}
+
+void ClientJson::send_request(tonlib_api::object_ptr<tonlib_api::Function> function, std::string extra) {
+  std::uint64_t extra_id = extra_id_.fetch_add(1, std::memory_order_relaxed);
+  if (!extra.empty()) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    extra_[extra_id] = std::move(extra);
+  }
+  client_.send(Client::Request{extra_id, std::move(function)});
+}
+
+std::string ClientJson::pop_extra(std::uint64_t id) {
+  std::string extra;
+  if (id != 0) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    auto it = extra_.find(id);
+    if (it != extra_.end()) {
+      extra = std::move(it->second);
+      extra_.erase(it);
+    }
+  }
+  return extra;
+}
+
 }  // namespace tonlib
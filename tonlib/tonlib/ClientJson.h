@@ -38,10 +38,22 @@ class ClientJson final {
 
   static td::CSlice execute(td::Slice request);
 
+  // Binary interface over the same request queue. A request is a request id (int64) followed by a boxed
+  // TL-serialized tonlib_api function; a response is the id of the request (0 for updates) followed by a boxed
+  // TL-serialized tonlib_api object. Bytes fields are passed as is, without base64 encoding.
+  void send_binary(td::Slice request);
+
+  td::Slice receive_binary(double timeout);
+
+  static td::Slice execute_binary(td::Slice request);
+
  private:
+  void send_request(tonlib_api::object_ptr<tonlib_api::Function> function, std::string extra);
+  std::string pop_extra(std::uint64_t id);
+
   Client client_;
   std::mutex mutex_;  // for extra_
-  std::unordered_map<std::int64_t, std::string> extra_;
+  std::unordered_map<std::int64_t, std::string> extra_;  // binary request ids are kept as JSON numbers
   std::atomic<std::uint64_t> extra_id_{1};
 };
 
@@ -0,0 +1,154 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "tonlib/GetMethodCache.h"
+
+#include "td/utils/crypto.h"
+
+namespace tonlib {
+
+namespace {
+
+void feed_cell_hash(td::Sha256State &sha, const td::Ref<vm::Cell> &cell) {
+  if (cell.is_null()) {
+    td::Bits256 zero;
+    zero.set_zero();
+    sha.feed(zero.as_slice());
+  } else {
+    sha.feed(cell->get_hash().as_slice());
+  }
+}
+
+td::Status feed_stack(td::Sha256State &sha, const vm::Stack &stack) {
+  vm::CellBuilder cb;
+  if (!stack.serialize(cb)) {
+    return td::Status::Error("cannot serialize stack");
+  }
+  TRY_RESULT(cell, cb.finalize_novm_nothrow());
+  feed_cell_hash(sha, cell);
+  return td::Status::OK();
+}
+
+template <class T>
+void feed_value(td::Sha256State &sha, const T &value) {
+  sha.feed(td::Slice(reinterpret_cast<const char *>(&value), sizeof(value)));
+}
+
+}  // namespace
+
+td::Result<GetMethodCache::Key> GetMethodCache::make_key(const ton::SmartContract::State &state,
+                                                         const ton::SmartContract::Args &args) {
+  if (state.code.is_null() || !args.method_id || !args.address || args.c7 || args.limits) {
+    return td::Status::Error("get method execution is not cacheable");
+  }
+  Key key;
+  key.address = std::make_pair(args.address.value().workchain, args.address.value().addr);
+
+  td::Sha256State state_sha;
+  state_sha.init();
+  feed_cell_hash(state_sha, state.code);
+  feed_cell_hash(state_sha, state.data);
+  state_sha.extract(key.state_hash.as_slice(), true);
+
+  td::Sha256State sha;
+  sha.init();
+  sha.feed(key.state_hash.as_slice());
+  feed_value(sha, key.address.first);
+  sha.feed(key.address.second.as_slice());
+  feed_value(sha, args.method_id.value());
+  feed_value(sha, args.now ? args.now.value() : 0);
+  feed_value(sha, args.balance);
+  feed_value(sha, args.amount);
+  feed_value(sha, static_cast<td::uint8>(args.ignore_chksig));
+  td::Bits256 rand_seed = td::Bits256::zero();
+  if (args.rand_seed) {
+    rand_seed = args.rand_seed.value();
+  }
+  sha.feed(rand_seed.as_slice());
+  feed_cell_hash(sha, args.extra_currencies);
+  feed_cell_hash(sha, args.config ? args.config.value()->get_root_cell() : td::Ref<vm::Cell>());
+  feed_cell_hash(sha, args.libraries ? args.libraries.value().get_root_cell() : td::Ref<vm::Cell>());
+  if (args.prev_blocks_info) {
+    TRY_STATUS(feed_stack(sha, vm::Stack{std::vector<vm::StackEntry>{vm::StackEntry(args.prev_blocks_info.value())}}));
+  }
+  TRY_STATUS(feed_stack(sha, args.stack ? *args.stack.value() : vm::Stack()));
+  sha.extract(key.hash.as_slice(), true);
+  return key;
+}
+
+td::optional<GetMethodCache::Value> GetMethodCache::get(const Key &key) {
+  update_account(key);
+  auto it = entries_.find(key.hash);
+  if (it == entries_.end()) {
+    stats_.misses++;
+    return {};
+  }
+  stats_.hits++;
+  auto entry = it->second.get();
+  entry->remove();
+  lru_.put(entry);
+  return entry->value;
+}
+
+void GetMethodCache::set(const Key &key, Value value) {
+  update_account(key);
+  auto &entry = entries_[key.hash];
+  if (entry == nullptr) {
+    entry = std::make_unique<Entry>(key, std::move(value));
+    auto &account = accounts_[key.address];
+    account.state_hash = key.state_hash;
+    account.keys.insert(key.hash);
+  } else {
+    entry->value = std::move(value);
+    entry->remove();
+  }
+  lru_.put(entry.get());
+  while (entries_.size() > max_size_) {
+    auto to_remove = static_cast<Entry *>(lru_.get());
+    CHECK(to_remove);
+    stats_.evictions++;
+    erase(to_remove);
+  }
+}
+
+void GetMethodCache::update_account(const Key &key) {
+  auto account_it = accounts_.find(key.address);
+  if (account_it == accounts_.end() || account_it->second.state_hash == key.state_hash) {
+    return;
+  }
+  stats_.invalidations++;
+  for (auto &hash : account_it->second.keys) {
+    auto it = entries_.find(hash);
+    CHECK(it != entries_.end());
+    it->second->remove();
+    entries_.erase(it);
+  }
+  accounts_.erase(account_it);
+}
+
+void GetMethodCache::erase(Entry *entry) {
+  entry->remove();
+  auto hash = entry->key.hash;
+  auto account_it = accounts_.find(entry->key.address);
+  CHECK(account_it != accounts_.end());
+  account_it->second.keys.erase(hash);
+  if (account_it->second.keys.empty()) {
+    accounts_.erase(account_it);
+  }
+  entries_.erase(hash);
+}
+
+}  // namespace tonlib
@@ -0,0 +1,104 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "smc-envelope/SmartContract.h"
+
+#include "td/utils/List.h"
+#include "td/utils/optional.h"
+#include "td/utils/Status.h"
+
+#include <map>
+#include <memory>
+#include <set>
+#include <utility>
+
+namespace tonlib {
+
+/**
+ * Bounded LRU cache of get-method results.
+ *
+ * A result is keyed by the hash of everything the execution depends on: code and data of the account,
+ * the known libraries, the c7 fields (balance, extra currencies, now, address, config, prev_blocks_info,
+ * rand_seed), the amount, ignore_chksig, the method id and the input stack. Entries of an account are dropped
+ * as soon as a different state of the account is seen.
+ *
+ * now, the config root and prev_blocks_info change with every masterchain block, so a result is only reused
+ * for the same account state within one masterchain block (and the same sync time): the cache serves repeated
+ * calls, not calls spread over time. tonlib does not set rand_seed, amount and ignore_chksig for runGetMethod;
+ * they are in the key so that callers that do set them never get results computed with other values.
+ */
+class GetMethodCache {
+ public:
+  struct Key {
+    std::pair<ton::WorkchainId, ton::StdSmcAddress> address;
+    td::Bits256 state_hash;
+    td::Bits256 hash;
+  };
+
+  struct Value {
+    td::int64 gas_used;
+    td::Ref<vm::Stack> stack;
+    td::int32 exit_code;
+  };
+
+  struct Stats {
+    td::uint64 hits{0};
+    td::uint64 misses{0};
+    td::uint64 invalidations{0};
+    td::uint64 evictions{0};
+  };
+
+  explicit GetMethodCache(size_t max_size = 4096) : max_size_(max_size) {
+  }
+
+  // returns an error if the execution can't be cached
+  static td::Result<Key> make_key(const ton::SmartContract::State &state, const ton::SmartContract::Args &args);
+
+  td::optional<Value> get(const Key &key);
+  void set(const Key &key, Value value);
+
+  size_t size() const {
+    return entries_.size();
+  }
+  const Stats &get_stats() const {
+    return stats_;
+  }
+
+ private:
+  struct Entry : td::ListNode {
+    Entry(Key key, Value value) : key(std::move(key)), value(std::move(value)) {
+    }
+    Key key;
+    Value value;
+  };
+  struct AccountInfo {
+    td::Bits256 state_hash;
+    std::set<td::Bits256> keys;
+  };
+
+  void update_account(const Key &key);
+  void erase(Entry *entry);
+
+  size_t max_size_;
+  std::map<td::Bits256, std::unique_ptr<Entry>> entries_;
+  std::map<std::pair<ton::WorkchainId, ton::StdSmcAddress>, AccountInfo> accounts_;
+  td::ListNode lru_;
+  Stats stats_;
+};
+
+}  // namespace tonlib
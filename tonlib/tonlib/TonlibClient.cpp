@@ -54,6 +54,7 @@
 
 #include "td/utils/as.h"
 #include "td/utils/Random.h"
+#include "td/utils/Timer.h"
 #include "td/utils/optional.h"
 #include "td/utils/overloaded.h"
 
@@ -1326,6 +1327,86 @@ class RemoteRunSmcMethod : public td::actor::Actor {
   }
 };
 
+td::Result<RawAccountState> to_raw_account_state(ton::BlockIdExt block_id, block::AccountState::Info info) {
+  RawAccountState res;
+  res.block_id = block_id;
+  res.info = std::move(info);
+  auto cell = res.info.root;
+  if (cell.is_null()) {
+    return res;
+  }
+  block::gen::Account::Record_account account;
+  if (!tlb::unpack_cell(cell, account)) {
+    return td::Status::Error("Failed to unpack Account");
+  }
+  {
+    block::gen::StorageInfo::Record storage_info;
+    if (!tlb::csr_unpack(account.storage_stat, storage_info)) {
+      return td::Status::Error("Failed to unpack StorageInfo");
+    }
+    res.storage_last_paid = storage_info.last_paid;
+    td::RefInt256 due_payment;
+    if (storage_info.due_payment->prefetch_ulong(1) == 1) {
+      vm::CellSlice& cs2 = storage_info.due_payment.write();
+      cs2.advance(1);
+      due_payment = block::tlb::t_Grams.as_integer_skip(cs2);
+      if (due_payment.is_null() || !cs2.empty_ext()) {
+        return td::Status::Error("Failed to upack due_payment");
+      }
+    } else {
+      due_payment = td::RefInt256{true, 0};
+    }
+    block::gen::StorageUsed::Record storage_used;
+    if (!tlb::csr_unpack(storage_info.used, storage_used)) {
+      return td::Status::Error("Failed to unpack StorageInfo");
+    }
+    unsigned long long u = 0;
+    block::StorageUsed storage_stat;
+    u |= storage_stat.cells = block::tlb::t_VarUInteger_7.as_uint(*storage_used.cells);
+    u |= storage_stat.bits = block::tlb::t_VarUInteger_7.as_uint(*storage_used.bits);
+    if (u == std::numeric_limits<td::uint64>::max()) {
+      return td::Status::Error("Failed to unpack StorageStat");
+    }
+
+    res.storage_used = storage_stat;
+  }
+
+  block::gen::AccountStorage::Record storage;
+  if (!tlb::csr_unpack(account.storage, storage)) {
+    return td::Status::Error("Failed to unpack AccountStorage");
+  }
+  TRY_RESULT(balance, to_balance(storage.balance));
+  res.balance = balance;
+  res.extra_currencies = storage.balance->prefetch_ref();
+  auto state_tag = block::gen::t_AccountState.get_tag(*storage.state);
+  if (state_tag < 0) {
+    return td::Status::Error("Failed to parse AccountState tag");
+  }
+  if (state_tag == block::gen::AccountState::account_frozen) {
+    block::gen::AccountState::Record_account_frozen state;
+    if (!tlb::csr_unpack(storage.state, state)) {
+      return td::Status::Error("Failed to parse AccountState");
+    }
+    res.frozen_hash = state.state_hash.as_slice().str();
+    return res;
+  }
+  if (state_tag != block::gen::AccountState::account_active) {
+    return res;
+  }
+  block::gen::AccountState::Record_account_active state;
+  if (!tlb::csr_unpack(storage.state, state)) {
+    return td::Status::Error("Failed to parse AccountState");
+  }
+  block::gen::StateInit::Record state_init;
+  res.state = vm::CellBuilder().append_cellslice(state.x).finalize();
+  if (!tlb::csr_unpack(state.x, state_init)) {
+    return td::Status::Error("Failed to parse StateInit");
+  }
+  state_init.code->prefetch_maybe_ref(res.code);
+  state_init.data->prefetch_maybe_ref(res.data);
+  return res;
+}
+
 class GetRawAccountState : public td::actor::Actor {
  public:
   GetRawAccountState(ExtClientRef ext_client_ref, block::StdAddress address, td::optional<ton::BlockIdExt> block_id,
@@ -1362,89 +1443,128 @@ class GetRawAccountState : public td::actor::Actor {
       ton::tl_object_ptr<ton::lite_api::liteServer_accountState> raw_account_state) {
     auto account_state = create_account_state(std::move(raw_account_state));
     TRY_RESULT(info, account_state.validate(block_id_.value(), address_));
-    auto serialized_state = account_state.state.clone();
-    RawAccountState res;
-    res.block_id = block_id_.value();
-    res.info = std::move(info);
-    auto cell = res.info.root;
-    //std::ostringstream outp;
-    //block::gen::t_Account.print_ref(outp, cell);
-    //LOG(INFO) << outp.str();
-    if (cell.is_null()) {
-      return res;
+    return to_raw_account_state(block_id_.value(), std::move(info));
+  }
+
+  void with_last_block(td::Result<LastBlockState> r_last_block) {
+    check(do_with_last_block(std::move(r_last_block)));
+  }
+
+  void with_block_id() {
+    client_.send_query(
+        ton::lite_api::liteServer_getAccountState(
+            ton::create_tl_lite_block_id(block_id_.value()),
+            ton::create_tl_object<ton::lite_api::liteServer_accountId>(address_.workchain, address_.addr)),
+        [self = this](auto r_state) { self->with_account_state(std::move(r_state)); });
+  }
+
+  td::Status do_with_last_block(td::Result<LastBlockState> r_last_block) {
+    TRY_RESULT(last_block, std::move(r_last_block));
+    block_id_ = std::move(last_block.last_block_id);
+    with_block_id();
+    return td::Status::OK();
+  }
+
+  void start_up() override {
+    if (block_id_) {
+      with_block_id();
+    } else {
+      client_.with_last_block(
+          [self = this](td::Result<LastBlockState> r_last_block) { self->with_last_block(std::move(r_last_block)); });
     }
-    block::gen::Account::Record_account account;
-    if (!tlb::unpack_cell(cell, account)) {
-      return td::Status::Error("Failed to unpack Account");
+  }
+
+  void check(td::Status status) {
+    if (status.is_error()) {
+      promise_.set_error(std::move(status));
+      stop();
     }
-    {
-      block::gen::StorageInfo::Record storage_info;
-      if (!tlb::csr_unpack(account.storage_stat, storage_info)) {
-        return td::Status::Error("Failed to unpack StorageInfo");
-      }
-      res.storage_last_paid = storage_info.last_paid;
-      td::RefInt256 due_payment;
-      if (storage_info.due_payment->prefetch_ulong(1) == 1) {
-        vm::CellSlice& cs2 = storage_info.due_payment.write();
-        cs2.advance(1);
-        due_payment = block::tlb::t_Grams.as_integer_skip(cs2);
-        if (due_payment.is_null() || !cs2.empty_ext()) {
-          return td::Status::Error("Failed to upack due_payment");
-        }
-      } else {
-        due_payment = td::RefInt256{true, 0};
+  }
+  void hangup() override {
+    check(TonlibError::Cancelled());
+  }
+};
+
+class GetRawAccountStates : public td::actor::Actor {
+ public:
+  GetRawAccountStates(ExtClientRef ext_client_ref, std::vector<block::StdAddress> addresses,
+                      td::optional<ton::BlockIdExt> block_id, td::actor::ActorShared<> parent,
+                      td::Promise<std::vector<RawAccountState>>&& promise)
+      : addresses_(std::move(addresses))
+      , block_id_(std::move(block_id))
+      , promise_(std::move(promise))
+      , parent_(std::move(parent)) {
+    client_.set_client(ext_client_ref);
+  }
+
+  // must not exceed the limit of liteServer.getAccountStates
+  static constexpr size_t max_batch_size = 1024;
+
+ private:
+  std::vector<block::StdAddress> addresses_;
+  td::optional<ton::BlockIdExt> block_id_;
+  td::Promise<std::vector<RawAccountState>> promise_;
+  td::actor::ActorShared<> parent_;
+  ExtClient client_;
+  std::map<std::pair<ton::WorkchainId, ton::StdSmcAddress>, RawAccountState> states_;
+  size_t pending_queries_{0};
+  td::Timer timer_;
+
+  void with_account_states(td::Result<ton::tl_object_ptr<ton::lite_api::liteServer_accountStates>> r_states) {
+    check(do_with_account_states(std::move(r_states)));
+  }
+
+  td::Status do_with_account_states(
+      td::Result<ton::tl_object_ptr<ton::lite_api::liteServer_accountStates>> r_states) {
+    TRY_RESULT(states, std::move(r_states));
+    TRY_STATUS_PREFIX(TRY_VM(do_with_account_states(std::move(states))), TonlibError::ValidateAccountState());
+    pending_queries_--;
+    finish();
+    return td::Status::OK();
+  }
+
+  td::Status do_with_account_states(ton::tl_object_ptr<ton::lite_api::liteServer_accountStates> states) {
+    auto blk = ton::create_block_id(states->id_);
+    for (auto& shard : states->shards_) {
+      block::AccountStates account_states;
+      account_states.blk = blk;
+      account_states.shard_blk = ton::create_block_id(shard->shardblk_);
+      if (account_states.shard_blk != blk) {
+        account_states.shard_proof = states->shard_proof_.clone();
       }
-      block::gen::StorageUsed::Record storage_used;
-      if (!tlb::csr_unpack(storage_info.used, storage_used)) {
-        return td::Status::Error("Failed to unpack StorageInfo");
+      account_states.proof = std::move(shard->proof_);
+      for (auto& entry : shard->accounts_) {
+        account_states.states.emplace_back(block::StdAddress(entry->account_->workchain_, entry->account_->id_),
+                                           std::move(entry->state_));
       }
-      unsigned long long u = 0;
-      block::StorageUsed storage_stat;
-      u |= storage_stat.cells = block::tlb::t_VarUInteger_7.as_uint(*storage_used.cells);
-      u |= storage_stat.bits = block::tlb::t_VarUInteger_7.as_uint(*storage_used.bits);
-      //LOG(DEBUG) << "last_paid=" << res.storage_last_paid << "; cells=" << storage_stat.cells
-      //<< " bits=" << storage_stat.bits;
-      if (u == std::numeric_limits<td::uint64>::max()) {
-        return td::Status::Error("Failed to unpack StorageStat");
+      TRY_RESULT(infos, account_states.validate(block_id_.value()));
+      for (size_t i = 0; i < infos.size(); i++) {
+        auto& address = account_states.states[i].first;
+        TRY_RESULT(state, to_raw_account_state(block_id_.value(), std::move(infos[i])));
+        states_[std::make_pair(address.workchain, address.addr)] = std::move(state);
       }
-
-      res.storage_used = storage_stat;
     }
+    return td::Status::OK();
+  }
 
-    block::gen::AccountStorage::Record storage;
-    if (!tlb::csr_unpack(account.storage, storage)) {
-      return td::Status::Error("Failed to unpack AccountStorage");
-    }
-    TRY_RESULT(balance, to_balance(storage.balance));
-    res.balance = balance;
-    res.extra_currencies = storage.balance->prefetch_ref();
-    auto state_tag = block::gen::t_AccountState.get_tag(*storage.state);
-    if (state_tag < 0) {
-      return td::Status::Error("Failed to parse AccountState tag");
+  void finish() {
+    if (pending_queries_ != 0) {
+      return;
     }
-    if (state_tag == block::gen::AccountState::account_frozen) {
-      block::gen::AccountState::Record_account_frozen state;
-      if (!tlb::csr_unpack(storage.state, state)) {
-        return td::Status::Error("Failed to parse AccountState");
+    std::vector<RawAccountState> res;
+    res.reserve(addresses_.size());
+    for (auto& address : addresses_) {
+      auto it = states_.find(std::make_pair(address.workchain, address.addr));
+      if (it == states_.end()) {
+        check(TonlibError::ValidateAccountState().move_as_error_suffix(PSLICE() << ": no state of " << address));
+        return;
       }
-      res.frozen_hash = state.state_hash.as_slice().str();
-      return res;
-    }
-    if (state_tag != block::gen::AccountState::account_active) {
-      return res;
+      res.push_back(it->second);
     }
-    block::gen::AccountState::Record_account_active state;
-    if (!tlb::csr_unpack(storage.state, state)) {
-      return td::Status::Error("Failed to parse AccountState");
-    }
-    block::gen::StateInit::Record state_init;
-    res.state = vm::CellBuilder().append_cellslice(state.x).finalize();
-    if (!tlb::csr_unpack(state.x, state_init)) {
-      return td::Status::Error("Failed to parse StateInit");
-    }
-    state_init.code->prefetch_maybe_ref(res.code);
-    state_init.data->prefetch_maybe_ref(res.data);
-    return res;
+    LOG(DEBUG) << "got " << addresses_.size() << " account states in "
+               << (addresses_.size() + max_batch_size - 1) / max_batch_size << " queries, time=" << timer_.elapsed();
+    promise_.set_value(std::move(res));
+    stop();
   }
 
   void with_last_block(td::Result<LastBlockState> r_last_block) {
@@ -1452,11 +1572,20 @@ class GetRawAccountState : public td::actor::Actor {
   }
 
   void with_block_id() {
-    client_.send_query(
-        ton::lite_api::liteServer_getAccountState(
-            ton::create_tl_lite_block_id(block_id_.value()),
-            ton::create_tl_object<ton::lite_api::liteServer_accountId>(address_.workchain, address_.addr)),
-        [self = this](auto r_state) { self->with_account_state(std::move(r_state)); });
+    std::vector<ton::tl_object_ptr<ton::lite_api::liteServer_accountId>> batch;
+    for (size_t i = 0; i < addresses_.size(); i++) {
+      batch.push_back(ton::create_tl_object<ton::lite_api::liteServer_accountId>(addresses_[i].workchain,
+                                                                                  addresses_[i].addr));
+      if (batch.size() == max_batch_size || i + 1 == addresses_.size()) {
+        pending_queries_++;
+        client_.send_query(
+            ton::lite_api::liteServer_getAccountStates(1, ton::create_tl_lite_block_id(block_id_.value()),
+                                                       std::move(batch)),
+            [self = this](auto r_states) { self->with_account_states(std::move(r_states)); });
+        batch.clear();
+      }
+    }
+    finish();
   }
 
   td::Status do_with_last_block(td::Result<LastBlockState> r_last_block) {
@@ -1476,7 +1605,7 @@ class GetRawAccountState : public td::actor::Actor {
   }
 
   void check(td::Status status) {
-    if (status.is_error()) {
+    if (status.is_error() && promise_) {
       promise_.set_error(std::move(status));
       stop();
     }
@@ -2271,6 +2400,7 @@ void TonlibClient::hangup() {
   raw_client_ = {};
   raw_last_block_ = {};
   raw_last_config_ = {};
+  account_watcher_ = {};
   try_stop();
 }
 
@@ -2382,6 +2512,57 @@ void TonlibClient::init_last_config() {
                                           get_client_ref(), td::make_unique<Callback>(td::actor::actor_shared(this)));
 }
 
+void TonlibClient::init_account_watcher() {
+  if (watched_accounts_.empty() || raw_client_.empty()) {
+    account_watcher_ = {};
+    return;
+  }
+  ref_cnt_++;
+  class Callback : public AccountWatcher::Callback {
+   public:
+    Callback(td::actor::ActorShared<TonlibClient> client, td::uint32 config_generation)
+        : client_(std::move(client)), config_generation_(config_generation) {
+    }
+    void on_account_changed(block::StdAddress address, ton::BlockIdExt mc_block_id) override {
+      send_closure(client_, &TonlibClient::on_account_changed, std::move(address), mc_block_id, config_generation_);
+    }
+
+   private:
+    td::actor::ActorShared<TonlibClient> client_;
+    td::uint32 config_generation_;
+  };
+  std::vector<block::StdAddress> addresses;
+  for (auto& it : watched_accounts_) {
+    addresses.push_back(it.second);
+  }
+  account_watcher_ = td::actor::create_actor<AccountWatcher>(
+      "AccountWatcher", get_client_ref(), std::move(addresses),
+      td::make_unique<Callback>(td::actor::actor_shared(this), config_generation_));
+}
+
+void TonlibClient::on_account_changed(block::StdAddress address, ton::BlockIdExt mc_block_id,
+                                      td::uint32 config_generation) {
+  if (config_generation != config_generation_ ||
+      !watched_accounts_.count(std::make_pair(address.workchain, address.addr))) {
+    return;
+  }
+  make_request(int_api::GetAccountState{address, mc_block_id, {}},
+               [self = this, address](td::Result<td::unique_ptr<AccountState>> r_state) {
+                 auto r_raw_state = [&]() -> td::Result<object_ptr<tonlib_api::raw_fullAccountState>> {
+                   TRY_RESULT(state, std::move(r_state));
+                   return state->to_raw_fullAccountState();
+                 }();
+                 if (r_raw_state.is_error()) {
+                   LOG(WARNING) << "Failed to get state of watched account " << address << ": "
+                                << r_raw_state.error();
+                   return;
+                 }
+                 self->on_update(tonlib_api::make_object<tonlib_api::updateAccountState>(
+                     tonlib_api::make_object<tonlib_api::accountAddress>(address.rserialize(true)),
+                     r_raw_state.move_as_ok()));
+               });
+}
+
 void TonlibClient::on_result(td::uint64 id, tonlib_api::object_ptr<tonlib_api::Object> response) {
   VLOG_IF(tonlib_query, id != 0) << "Tonlib answer query " << td::tag("id", id) << " " << to_string(response);
   VLOG_IF(tonlib_query, id == 0) << "Tonlib update " << to_string(response);
@@ -3086,6 +3267,7 @@ void TonlibClient::set_config(FullConfig full_config) {
   init_last_block(std::move(full_config.last_state));
   init_last_config();
   client_.set_client(get_client_ref());
+  init_account_watcher();
 }
 
 td::Status TonlibClient::do_request(const tonlib_api::close& request,
@@ -3508,6 +3690,72 @@ td::Status TonlibClient::do_request(tonlib_api::raw_getAccountState& request,
   return td::Status::OK();
 }
 
+td::Status TonlibClient::do_request(const tonlib_api::raw_getAccountStates& request,
+                                    td::Promise<object_ptr<tonlib_api::raw_fullAccountStates>>&& promise) {
+  std::vector<block::StdAddress> addresses;
+  for (auto& account_address : request.account_addresses_) {
+    if (!account_address) {
+      return TonlibError::EmptyField("account_addresses");
+    }
+    TRY_RESULT(address, get_account_address(account_address->account_address_));
+    addresses.push_back(std::move(address));
+  }
+  if (addresses.empty()) {
+    promise.set_value(tonlib_api::make_object<tonlib_api::raw_fullAccountStates>());
+    return td::Status::OK();
+  }
+  auto actor_id = actor_id_++;
+  actors_[actor_id] = td::actor::create_actor<GetRawAccountStates>(
+      "GetAccountStates", client_.get_client(), addresses, query_context_.block_id.copy(),
+      actor_shared(this, actor_id),
+      promise.wrap([addresses, wallet_id = wallet_id_](std::vector<RawAccountState>&& states)
+                       -> td::Result<object_ptr<tonlib_api::raw_fullAccountStates>> {
+        std::vector<object_ptr<tonlib_api::raw_fullAccountState>> res;
+        for (size_t i = 0; i < states.size(); i++) {
+          TRY_RESULT(state, AccountState(addresses[i], std::move(states[i]), wallet_id).to_raw_fullAccountState());
+          res.push_back(std::move(state));
+        }
+        return tonlib_api::make_object<tonlib_api::raw_fullAccountStates>(std::move(res));
+      }));
+  return td::Status::OK();
+}
+
+td::Status TonlibClient::do_request(const tonlib_api::raw_watchAccount& request,
+                                    td::Promise<object_ptr<tonlib_api::ok>>&& promise) {
+  if (!request.account_address_) {
+    return TonlibError::EmptyField("account_address");
+  }
+  TRY_RESULT(account_address, get_account_address(request.account_address_->account_address_));
+  auto key = std::make_pair(account_address.workchain, account_address.addr);
+  if (!watched_accounts_.count(key)) {
+    watched_accounts_[key] = account_address;
+    if (account_watcher_.empty()) {
+      init_account_watcher();
+    } else {
+      send_closure(account_watcher_, &AccountWatcher::watch, std::move(account_address));
+    }
+  }
+  promise.set_value(tonlib_api::make_object<tonlib_api::ok>());
+  return td::Status::OK();
+}
+
+td::Status TonlibClient::do_request(const tonlib_api::raw_unwatchAccount& request,
+                                    td::Promise<object_ptr<tonlib_api::ok>>&& promise) {
+  if (!request.account_address_) {
+    return TonlibError::EmptyField("account_address");
+  }
+  TRY_RESULT(account_address, get_account_address(request.account_address_->account_address_));
+  if (watched_accounts_.erase(std::make_pair(account_address.workchain, account_address.addr))) {
+    if (watched_accounts_.empty()) {
+      account_watcher_ = {};
+    } else if (!account_watcher_.empty()) {
+      send_closure(account_watcher_, &AccountWatcher::unwatch, std::move(account_address));
+    }
+  }
+  promise.set_value(tonlib_api::make_object<tonlib_api::ok>());
+  return td::Status::OK();
+}
+
 td::Status TonlibClient::do_request(tonlib_api::raw_getAccountStateByTransaction& request,
                                     td::Promise<object_ptr<tonlib_api::raw_fullAccountState>>&& promise) {
   if (!request.account_address_) {
@@ -5025,6 +5273,17 @@ void TonlibClient::perform_smc_execution(td::Ref<ton::SmartContract> smc, ton::S
 
   args.set_libraries(libraries);
 
+  auto r_cache_key = GetMethodCache::make_key(smc->get_state(), args);
+  if (r_cache_key.is_ok()) {
+    auto cached = get_method_cache_.get(r_cache_key.ok());
+    if (cached) {
+      TRY_RESULT_PROMISE(promise, cached_stack, to_tonlib_api(cached.value().stack));
+      promise.set_value(tonlib_api::make_object<tonlib_api::smc_runResult>(
+          cached.value().gas_used, std::move(cached_stack), cached.value().exit_code));
+      return;
+    }
+  }
+
   auto res = smc->run_get_method(args);
 
   // smc.runResult gas_used:int53 stack:vector<tvm.StackEntry> exit_code:int32 = smc.RunResult;
@@ -5078,6 +5337,9 @@ void TonlibClient::perform_smc_execution(td::Ref<ton::SmartContract> smc, ton::S
     });
   }
   else {
+    if (r_cache_key.is_ok()) {
+      get_method_cache_.set(r_cache_key.ok(), {res.gas_used, res.stack, res.code});
+    }
     promise.set_value(tonlib_api::make_object<tonlib_api::smc_runResult>(res.gas_used, std::move(res_stack), res.code));
   }
 }
@@ -5614,6 +5876,32 @@ td::Status TonlibClient::do_request(const tonlib_api::liteServer_getInfo& reques
   return td::Status::OK();
 }
 
+td::Status TonlibClient::do_request(const tonlib_api::getStats& request,
+                                    td::Promise<object_ptr<tonlib_api::stats>>&& promise) {
+  std::vector<object_ptr<tonlib_api::stats_entry>> entries;
+  auto add_entry = [&](std::string key, td::int64 value) {
+    entries.push_back(tonlib_api::make_object<tonlib_api::stats_entry>(std::move(key), value));
+  };
+  auto& cache_stats = get_method_cache_.get_stats();
+  add_entry("get_method_cache.size", static_cast<td::int64>(get_method_cache_.size()));
+  add_entry("get_method_cache.hits", static_cast<td::int64>(cache_stats.hits));
+  add_entry("get_method_cache.misses", static_cast<td::int64>(cache_stats.misses));
+  add_entry("get_method_cache.invalidations", static_cast<td::int64>(cache_stats.invalidations));
+  add_entry("get_method_cache.evictions", static_cast<td::int64>(cache_stats.evictions));
+  if (account_watcher_.empty()) {
+    promise.set_value(tonlib_api::make_object<tonlib_api::stats>(std::move(entries)));
+    return td::Status::OK();
+  }
+  send_closure(account_watcher_, &AccountWatcher::get_stats,
+               promise.wrap([entries = std::move(entries)](auto&& watcher_stats) mutable {
+                 for (auto& it : watcher_stats) {
+                   entries.push_back(tonlib_api::make_object<tonlib_api::stats_entry>(std::move(it.first), it.second));
+                 }
+                 return tonlib_api::make_object<tonlib_api::stats>(std::move(entries));
+               }));
+  return td::Status::OK();
+}
+
 auto to_bits256(td::Slice data, td::Slice name) -> td::Result<td::Bits256> {
   if (data.size() != 32) {
     return TonlibError::InvalidField(name, "wrong length (not 32 bytes)");
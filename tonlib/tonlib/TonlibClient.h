@@ -20,9 +20,11 @@
 
 #include "TonlibCallback.h"
 
+#include "tonlib/AccountWatcher.h"
 #include "tonlib/Config.h"
 #include "tonlib/ExtClient.h"
 #include "tonlib/ExtClientOutbound.h"
+#include "tonlib/GetMethodCache.h"
 #include "tonlib/KeyStorage.h"
 #include "tonlib/KeyValue.h"
 #include "tonlib/LastBlockStorage.h"
@@ -121,6 +123,10 @@ class TonlibClient : public td::actor::Actor {
   td::actor::ActorOwn<LastConfig> raw_last_config_;
   ExtClient client_;
 
+  // accounts watched with raw.watchAccount, survive config changes
+  std::map<std::pair<ton::WorkchainId, ton::StdSmcAddress>, block::StdAddress> watched_accounts_;
+  td::actor::ActorOwn<AccountWatcher> account_watcher_;
+
   td::CancellationTokenSource source_;
 
   std::map<td::int64, td::actor::ActorOwn<>> actors_;
@@ -130,6 +136,8 @@ class TonlibClient : public td::actor::Actor {
   void init_ext_client();
   void init_last_block(LastBlockState state);
   void init_last_config();
+  void init_account_watcher();
+  void on_account_changed(block::StdAddress address, ton::BlockIdExt mc_block_id, td::uint32 config_generation);
 
   bool is_closing_{false};
   td::uint32 ref_cnt_{1};
@@ -241,6 +249,11 @@ class TonlibClient : public td::actor::Actor {
                         td::Promise<object_ptr<tonlib_api::raw_fullAccountState>>&& promise);
   td::Status do_request(tonlib_api::raw_getAccountStateByTransaction& request,
                         td::Promise<object_ptr<tonlib_api::raw_fullAccountState>>&& promise);
+  td::Status do_request(const tonlib_api::raw_getAccountStates& request,
+                        td::Promise<object_ptr<tonlib_api::raw_fullAccountStates>>&& promise);
+  td::Status do_request(const tonlib_api::raw_watchAccount& request, td::Promise<object_ptr<tonlib_api::ok>>&& promise);
+  td::Status do_request(const tonlib_api::raw_unwatchAccount& request,
+                        td::Promise<object_ptr<tonlib_api::ok>>&& promise);
   td::Status do_request(tonlib_api::raw_getTransactions& request,
                         td::Promise<object_ptr<tonlib_api::raw_transactions>>&& promise);
   td::Status do_request(tonlib_api::raw_getTransactionsV2& request,
@@ -313,6 +326,7 @@ class TonlibClient : public td::actor::Actor {
 
   td::int64 next_smc_id_{0};
   std::map<td::int64, td::unique_ptr<AccountState>> smcs_;
+  GetMethodCache get_method_cache_;
 
   td::int64 register_smc(td::unique_ptr<AccountState> smc);
   td::Result<tonlib_api::object_ptr<tonlib_api::smc_info>> get_smc_info(td::int64 id);
@@ -375,6 +389,7 @@ class TonlibClient : public td::actor::Actor {
 
   td::Status do_request(const tonlib_api::liteServer_getInfo& request,
                         td::Promise<object_ptr<tonlib_api::liteServer_info>>&& promise);
+  td::Status do_request(const tonlib_api::getStats& request, td::Promise<object_ptr<tonlib_api::stats>>&& promise);
 
   td::Status do_request(tonlib_api::withBlock& request, td::Promise<object_ptr<tonlib_api::Object>>&& promise);
 
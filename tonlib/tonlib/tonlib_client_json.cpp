@@ -61,3 +61,30 @@ const char *tonlib_client_json_execute(void *client, const char *request) {
     return slice.c_str();
   }
 }
+
+void tonlib_client_json_send_binary(void *client, const char *request, size_t request_size) {
+  static_cast<tonlib::ClientJson *>(client)->send_binary(
+      request == nullptr ? td::Slice() : td::Slice(request, request_size));
+}
+
+const char *tonlib_client_json_receive_binary(void *client, double timeout, size_t *response_size) {
+  auto slice = static_cast<tonlib::ClientJson *>(client)->receive_binary(timeout);
+  *response_size = slice.size();
+  if (slice.empty()) {
+    return nullptr;
+  } else {
+    return slice.data();
+  }
+}
+
+const char *tonlib_client_json_execute_binary(void *client, const char *request, size_t request_size,
+                                              size_t *response_size) {
+  auto slice =
+      tonlib::ClientJson::execute_binary(request == nullptr ? td::Slice() : td::Slice(request, request_size));
+  *response_size = slice.size();
+  if (slice.empty()) {
+    return nullptr;
+  } else {
+    return slice.data();
+  }
+}
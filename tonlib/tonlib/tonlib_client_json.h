@@ -20,6 +20,8 @@
 
 #include "tonlib/tonlibjson_export.h"
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -34,6 +36,15 @@ TONLIBJSON_EXPORT const char *tonlib_client_json_receive(void *client, double ti
 
 TONLIBJSON_EXPORT const char *tonlib_client_json_execute(void *client, const char *request);
 
+// Binary counterparts of the functions above, see ClientJson for the format of requests and responses.
+// The returned buffer stays valid until the next call of a receive or execute function on the same thread.
+TONLIBJSON_EXPORT void tonlib_client_json_send_binary(void *client, const char *request, size_t request_size);
+
+TONLIBJSON_EXPORT const char *tonlib_client_json_receive_binary(void *client, double timeout, size_t *response_size);
+
+TONLIBJSON_EXPORT const char *tonlib_client_json_execute_binary(void *client, const char *request, size_t request_size,
+                                                                size_t *response_size);
+
 TONLIBJSON_EXPORT void tonlib_client_json_destroy(void *client);
 
 #ifdef __cplusplus
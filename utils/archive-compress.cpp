@@ -0,0 +1,53 @@
+/*
+    This file is part of TON Blockchain source code.
+
+    TON Blockchain is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    TON Blockchain is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with TON Blockchain.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <iostream>
+#include <string>
+#include "td/utils/OptionParser.h"
+#include "td/utils/logging.h"
+
+#include "validator/db/archive-compress.hpp"
+
+// Converts packages of an archive slice to the compressed package format (version 2).
+// The validator must not be running. Usage: archive-compress <db>/archive/packages/archXXXX/archive.XXXXX.index
+
+int main(int argc, char **argv) {
+  td::OptionParser p;
+  p.set_description(
+      "converts packages of an archive slice to the compressed format, the validator must not be running\n"
+      "usage: archive-compress <db>/archive/packages/archXXXX/archive.XXXXX.index");
+  p.add_option('h', "help", "prints this help", [&]() {
+    char b[10240];
+    td::StringBuilder sb(td::MutableSlice{b, 10000});
+    sb << p;
+    std::cout << sb.as_cslice().c_str();
+    std::exit(2);
+  });
+  auto S = p.run(argc, argv, 1);
+  if (S.is_error()) {
+    std::cerr << S.move_as_error().message().str() << "\n";
+    std::_Exit(2);
+  }
+  SET_VERBOSITY_LEVEL(verbosity_INFO);
+  auto R = ton::validator::compress_archive_slice(S.ok()[0]);
+  if (R.is_error()) {
+    std::cerr << "failed to compress archive slice: " << R.error().to_string() << "\n";
+    std::_Exit(2);
+  }
+  auto stats = R.move_as_ok();
+  std::cout << stats.files << " files, " << stats.old_size << " -> " << stats.new_size << " bytes\n";
+  return 0;
+}
@@ -16,6 +16,7 @@
 #include "mc-config.h"
 
 td::Ref<vm::Tuple> c7;
+bool lazy_cell_hashes = false;
 
 void prepare_c7() {
   auto now = (td::uint32)td::Clocks::system();
@@ -137,6 +138,7 @@ runInfo time_run_vm(td::Slice command, td::Ref<vm::Stack> stack) {
     vm::GasLimits gas_limit;
     vm::VmState vm{
         vm::load_cell_slice_ref(cell), ton::SUPPORTED_VERSION, std::move(stack), gas_limit, 0, {}, vm::VmLog{}, {}, c7};
+    vm.set_lazy_cell_hashes(lazy_cell_hashes);
     std::clock_t cStart = std::clock();
     int ret = ~vm.run();
     std::clock_t cEnd = std::clock();
@@ -191,6 +193,12 @@ runtimeStats timeInstruction(const std::string& setupCode, const std::string& to
 
 int main(int argc, char** argv) {
   SET_VERBOSITY_LEVEL(verbosity_ERROR);
+  if (argc > 1 && td::Slice(argv[1]) == "--lazy-cell-hashes") {
+    lazy_cell_hashes = true;
+    argv[1] = argv[0];
+    argc--;
+    argv++;
+  }
   if (argc != 2 && argc != 3) {
     std::cerr << "This utility compares the timing of VM execution against the gas used.\n"
                  "It can be used to discover opcodes or opcode sequences that consume an "
@@ -207,10 +215,11 @@ int main(int argc, char** argv) {
                  "\n"
                  "Usage: "
               << argv[0]
-              << " [TVM_SETUP_BYTECODE] TVM_BYTECODE\n"
+              << " [--lazy-cell-hashes] [TVM_SETUP_BYTECODE] TVM_BYTECODE\n"
                  "\tBYTECODE is either:\n"
                  "\t1. hex-encoded string (e.g. A90E for DIVMODC)\n"
-                 "\t2. boc:<serialized boc in base64> (e.g. boc:te6ccgEBAgEABwABAogBAAJ7)"
+                 "\t2. boc:<serialized boc in base64> (e.g. boc:te6ccgEBAgEABwABAogBAAJ7)\n"
+                 "\t--lazy-cell-hashes defers hashing of cells created by the measured code until they are used"
               << std::endl
               << std::endl;
     return 1;
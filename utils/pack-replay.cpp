@@ -0,0 +1,185 @@
+/*
+    This file is part of TON Blockchain source code.
+
+    TON Blockchain is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    TON Blockchain is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with TON Blockchain.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include "td/utils/OptionParser.h"
+#include "td/utils/filesystem.h"
+#include "td/utils/misc.h"
+#include "td/utils/Random.h"
+#include "td/utils/Timer.h"
+
+#include "validator/db/package.hpp"
+#include "validator/db/fileref.hpp"
+#include "validator/db/archive-slice.hpp"
+
+// Replays archive reads against a package: random get_file-like reads of blocks and proofs
+// and sequential get_slice-like streaming of the whole package
+struct ReplayOptions {
+  td::uint32 reads = 100000;
+  double hot_fraction = 0.1;
+  double hot_probability = 0.8;
+  size_t cache_size = 64 << 20;
+  td::uint32 slice_size = 1 << 21;
+  td::uint32 read_ahead_size = 8 << 20;
+};
+
+struct Entry {
+  td::uint64 offset;
+  ton::FileHash hash;
+};
+
+static void report(const char *name, td::uint32 reads, td::uint64 bytes, double elapsed) {
+  std::cout << std::setw(28) << std::left << name << std::right << std::setw(12) << std::fixed
+            << std::setprecision(0) << reads / elapsed << " reads/s " << std::setw(10) << std::setprecision(1)
+            << static_cast<double>(bytes) / elapsed / (1 << 20) << " MB/s\n";
+}
+
+static std::vector<size_t> make_workload(size_t entries, const ReplayOptions &opts) {
+  std::vector<size_t> res(opts.reads);
+  size_t hot = std::max<size_t>(1, static_cast<size_t>(static_cast<double>(entries) * opts.hot_fraction));
+  for (auto &x : res) {
+    if (td::Random::fast(0, 999) < static_cast<int>(opts.hot_probability * 1000)) {
+      x = td::Random::fast(0, static_cast<int>(hot - 1));
+    } else {
+      x = td::Random::fast(0, static_cast<int>(entries - 1));
+    }
+  }
+  return res;
+}
+
+static void replay_reads(const std::string &filename, const std::vector<Entry> &entries,
+                         const std::vector<size_t> &workload, const ReplayOptions &opts) {
+  // fresh package: offset index is filled only by the reads themselves
+  {
+    auto p = ton::Package::open(filename, true, false).move_as_ok();
+    td::uint64 bytes = 0;
+    td::Timer timer;
+    for (auto i : workload) {
+      bytes += p.read(entries[i].offset).move_as_ok().second.size();
+    }
+    report("read (cold index)", opts.reads, bytes, timer.elapsed());
+  }
+
+  // fully indexed package: one pread per read
+  auto p = ton::Package::open(filename, true, false).move_as_ok();
+  p.iterate([](std::string, td::BufferSlice, td::uint64) { return true; });
+  {
+    td::uint64 bytes = 0;
+    td::Timer timer;
+    for (auto i : workload) {
+      bytes += p.read(entries[i].offset).move_as_ok().second.size();
+    }
+    report("read (indexed)", opts.reads, bytes, timer.elapsed());
+  }
+
+  ton::validator::ArchiveFileCache cache(opts.cache_size);
+  td::uint64 bytes = 0;
+  td::uint32 hits = 0;
+  td::Timer timer;
+  for (auto i : workload) {
+    auto cached = cache.get(entries[i].hash);
+    if (cached) {
+      hits++;
+      bytes += cached.value().size();
+      continue;
+    }
+    auto data = p.read(entries[i].offset).move_as_ok().second;
+    bytes += data.size();
+    cache.put(entries[i].hash, std::move(data));
+  }
+  report("read (indexed + file cache)", opts.reads, bytes, timer.elapsed());
+  std::cout << "file cache hit rate: " << std::setprecision(3) << static_cast<double>(hits) / opts.reads << "\n";
+}
+
+static void replay_slices(const std::string &filename, const ReplayOptions &opts) {
+  auto size = td::FileFd::open(filename, td::FileFd::Read).move_as_ok().get_size().move_as_ok();
+  for (auto chunk : {static_cast<td::uint64>(opts.slice_size), static_cast<td::uint64>(opts.read_ahead_size)}) {
+    td::uint32 reads = 0;
+    td::Timer timer;
+    for (td::uint64 offset = 0; offset < size; offset += chunk) {
+      td::read_file(filename, chunk, offset).ensure();
+      reads++;
+    }
+    report(chunk == opts.slice_size ? "get_slice (no read-ahead)" : "get_slice (read-ahead)", reads, size,
+           timer.elapsed());
+  }
+}
+
+void run(std::string filename, const ReplayOptions &opts) {
+  auto R = ton::Package::open(filename, true, false);
+  if (R.is_error()) {
+    std::cerr << "failed to open archive '" << filename << "': " << R.move_as_error().to_string();
+    std::_Exit(2);
+  }
+  auto p = R.move_as_ok();
+
+  std::vector<Entry> entries;
+  p.iterate([&](std::string filename, td::BufferSlice data, td::uint64 offset) -> bool {
+    auto E = ton::validator::FileReference::create(filename);
+    if (E.is_ok()) {
+      entries.push_back(Entry{offset, E.ok().hash()});
+    }
+    return true;
+  });
+  if (entries.empty()) {
+    std::cerr << "archive '" << filename << "' is empty\n";
+    std::_Exit(2);
+  }
+  std::cout << filename << ": " << entries.size() << " files\n";
+
+  replay_reads(filename, entries, make_workload(entries.size(), opts), opts);
+  replay_slices(filename, opts);
+}
+
+int main(int argc, char **argv) {
+  ReplayOptions opts;
+  td::OptionParser p;
+  p.set_description("replays archive reads against a package and prints read throughput");
+  p.add_option('h', "help", "prints this help", [&]() {
+    char b[10240];
+    td::StringBuilder sb(td::MutableSlice{b, 10000});
+    sb << p;
+    std::cout << sb.as_cslice().c_str();
+    std::exit(2);
+  });
+  p.add_checked_option('n', "reads", "number of random reads (default: 100000)", [&](td::Slice arg) {
+    TRY_RESULT_ASSIGN(opts.reads, td::to_integer_safe<td::uint32>(arg));
+    return td::Status::OK();
+  });
+  p.add_option('f', "hot-fraction", "fraction of files that are read often (default: 0.1)",
+               [&](td::Slice arg) { opts.hot_fraction = td::to_double(arg); });
+  p.add_option('p', "hot-probability", "probability that a read hits a hot file (default: 0.8)",
+               [&](td::Slice arg) { opts.hot_probability = td::to_double(arg); });
+  p.add_checked_option('c', "cache-size", "file cache size in MB (default: 64)", [&](td::Slice arg) {
+    TRY_RESULT(size, td::to_integer_safe<td::uint32>(arg));
+    opts.cache_size = static_cast<size_t>(size) << 20;
+    return td::Status::OK();
+  });
+  p.add_checked_option('s', "slice-size", "get_slice limit in bytes (default: 2097152)", [&](td::Slice arg) {
+    TRY_RESULT_ASSIGN(opts.slice_size, td::to_integer_safe<td::uint32>(arg));
+    return td::Status::OK();
+  });
+  auto S = p.run(argc, argv, 1);
+  if (S.is_error()) {
+    std::cerr << S.move_as_error().message().str() << "\n";
+    std::_Exit(2);
+  }
+  run(S.ok()[0], opts);
+  return 0;
+}
@@ -1124,6 +1124,32 @@ td::Status GetActorStatsQuery::receive(td::BufferSlice data) {
   return td::Status::OK();
 }
 
+td::Status GetActorProfileQuery::run() {
+  if (!tokenizer_.endl()) {
+    TRY_RESULT_ASSIGN(file_name_, tokenizer_.get_token<std::string>());
+  }
+  TRY_STATUS(tokenizer_.check_endl());
+  return td::Status::OK();
+}
+
+td::Status GetActorProfileQuery::send() {
+  auto b = ton::create_serialize_tl_object<ton::ton_api::engine_validator_getActorProfileJson>();
+  td::actor::send_closure(console_, &ValidatorEngineConsole::envelope_send_query, std::move(b), create_promise());
+  return td::Status::OK();
+}
+
+td::Status GetActorProfileQuery::receive(td::BufferSlice data) {
+  TRY_RESULT_PREFIX(f, ton::fetch_tl_object<ton::ton_api::engine_validator_textStats>(data.as_slice(), true),
+                    "received incorrect answer: ");
+  if (file_name_.empty()) {
+    td::TerminalIO::out() << f->data_ << "\n";
+  } else {
+    TRY_STATUS(td::write_file(file_name_, f->data_));
+    td::TerminalIO::out() << "wrote actor profile to " << file_name_ << "\n";
+  }
+  return td::Status::OK();
+}
+
 td::Status GetPerfTimerStatsJsonQuery::run() {
   TRY_RESULT_ASSIGN(file_name_, tokenizer_.get_token<std::string>());
   TRY_STATUS(tokenizer_.check_endl());
@@ -1550,6 +1550,9 @@ td::Status ValidatorEngine::load_global_config() {
   if (celldb_in_memory_ && celldb_v2_) {
     return td::Status::Error(ton::ErrorCode::error, "at most one of --celldb-in-memory --celldb-v2 could be used");
   }
+  if (celldb_in_memory_compact_ && !celldb_in_memory_) {
+    return td::Status::Error(ton::ErrorCode::error, "--celldb-in-memory-compact requires --celldb-in-memory");
+  }
 
   ton::BlockIdExt init_block;
   if (!conf.validator_->init_block_) {
@@ -1597,17 +1600,25 @@ td::Status ValidatorEngine::load_global_config() {
   if (!session_logs_file_.empty()) {
     validator_options_.write().set_session_logs_file(session_logs_file_);
   }
+  if (!actor_profile_file_.empty()) {
+    validator_options_.write().set_actor_profile_file(actor_profile_file_);
+  }
   if (celldb_in_memory_) {
     celldb_compress_depth_ = 0;
   }
   validator_options_.write().set_celldb_compress_depth(celldb_compress_depth_);
   validator_options_.write().set_celldb_in_memory(celldb_in_memory_);
+  validator_options_.write().set_celldb_in_memory_compact(celldb_in_memory_compact_);
   validator_options_.write().set_celldb_v2(celldb_v2_);
   validator_options_.write().set_celldb_disable_bloom_filter(celldb_disable_bloom_filter_);
   validator_options_.write().set_max_open_archive_files(max_open_archive_files_);
   validator_options_.write().set_archive_preload_period(archive_preload_period_);
   validator_options_.write().set_disable_rocksdb_stats(disable_rocksdb_stats_);
+  validator_options_.write().set_compress_archive_packages(compress_archive_packages_);
   validator_options_.write().set_nonfinal_ls_queries_enabled(nonfinal_ls_queries_enabled_);
+  validator_options_.write().set_ls_max_running_cost(ls_max_running_cost_);
+  validator_options_.write().set_ls_max_client_running_cost(ls_max_client_running_cost_);
+  validator_options_.write().set_ls_client_rate(ls_client_rate_);
   if (celldb_cache_size_) {
     validator_options_.write().set_celldb_cache_size(celldb_cache_size_.value());
   }
@@ -4188,6 +4199,30 @@ void ValidatorEngine::run_control_query(ton::ton_api::engine_validator_getActorT
                           std::move(P));
 }
 
+void ValidatorEngine::run_control_query(ton::ton_api::engine_validator_getActorProfileJson &query, td::BufferSlice data,
+                                        ton::PublicKeyHash src, td::uint32 perm, td::Promise<td::BufferSlice> promise) {
+  if (!(perm & ValidatorEnginePermissions::vep_default)) {
+    promise.set_value(create_control_query_error(td::Status::Error(ton::ErrorCode::error, "not authorized")));
+    return;
+  }
+
+  if (validator_manager_.empty()) {
+    promise.set_value(
+        create_control_query_error(td::Status::Error(ton::ErrorCode::notready, "validator manager not started")));
+    return;
+  }
+
+  auto P = td::PromiseCreator::lambda([promise = std::move(promise)](td::Result<std::string> R) mutable {
+    if (R.is_error()) {
+      promise.set_value(create_control_query_error(R.move_as_error()));
+    } else {
+      promise.set_value(ton::create_serialize_tl_object<ton::ton_api::engine_validator_textStats>(R.move_as_ok()));
+    }
+  });
+  td::actor::send_closure(validator_manager_, &ton::validator::ValidatorManagerInterface::prepare_actor_profile,
+                          std::move(P));
+}
+
 void ValidatorEngine::run_control_query(ton::ton_api::engine_validator_getPerfTimerStats &query, td::BufferSlice data,
                                         ton::PublicKeyHash src, td::uint32 perm, td::Promise<td::BufferSlice> promise) {
   if (!(perm & ValidatorEnginePermissions::vep_default)) {
@@ -5412,6 +5447,20 @@ int main(int argc, char *argv[]) {
     acts.push_back([&x, at]() { td::actor::send_closure(x, &ValidatorEngine::schedule_shutdown, (double)at); });
     return td::Status::OK();
   });
+  td::uint32 actor_profiler_period = 64;
+  p.add_checked_option('\0', "actor-profiler-period",
+                       PSTRING() << "profile every N-th actor execution, 0 disables the profiler (default: "
+                                 << actor_profiler_period << ")",
+                       [&](td::Slice arg) {
+                         TRY_RESULT_ASSIGN(actor_profiler_period, td::to_integer_safe<td::uint32>(arg));
+                         return td::Status::OK();
+                       });
+  p.add_option('\0', "actor-profile", "periodically write actor execution profile (json) to this file",
+               [&](td::Slice fname) {
+                 acts.push_back([&x, fname = fname.str()]() {
+                   td::actor::send_closure(x, &ValidatorEngine::set_actor_profile_file, fname);
+                 });
+               });
   p.add_checked_option('\0', "celldb-compress-depth",
                        "optimize celldb by storing cells of depth X with whole subtrees (experimental, default: 0)",
                        [&](td::Slice arg) {
@@ -5445,9 +5494,47 @@ int main(int argc, char *argv[]) {
   p.add_option('\0', "disable-rocksdb-stats", "disable gathering rocksdb statistics (enabled by default)", [&]() {
     acts.push_back([&x]() { td::actor::send_closure(x, &ValidatorEngine::set_disable_rocksdb_stats, true); });
   });
+  p.add_option('\0', "compress-archive-packages",
+               "lz4-compress files in new archive packages (disabled by default), existing packages can be "
+               "converted with archive-compress",
+               [&]() {
+                 acts.push_back(
+                     [&x]() { td::actor::send_closure(x, &ValidatorEngine::set_compress_archive_packages, true); });
+               });
   p.add_option('\0', "nonfinal-ls", "enable special LS queries to non-finalized blocks", [&]() {
     acts.push_back([&x]() { td::actor::send_closure(x, &ValidatorEngine::set_nonfinal_ls_queries_enabled); });
   });
+  p.add_checked_option('\0', "ls-max-running-cost",
+                       "max total estimated cost of LS queries running at once, the rest are queued; 0 disables "
+                       "LS admission control (default: 512, getMasterchainInfo costs 1, runSmcMethod 8, getState 64)",
+                       [&](td::Slice s) -> td::Status {
+                         TRY_RESULT(v, td::to_integer_safe<td::uint32>(s));
+                         acts.push_back(
+                             [&x, v]() { td::actor::send_closure(x, &ValidatorEngine::set_ls_max_running_cost, v); });
+                         return td::Status::OK();
+                       });
+  p.add_checked_option('\0', "ls-max-client-running-cost",
+                       "max total estimated cost of LS queries running at once for one client (ADNL id, or IP "
+                       "address for anonymous clients), the rest are queued (default: 0 - unlimited)",
+                       [&](td::Slice s) -> td::Status {
+                         TRY_RESULT(v, td::to_integer_safe<td::uint32>(s));
+                         acts.push_back([&x, v]() {
+                           td::actor::send_closure(x, &ValidatorEngine::set_ls_max_client_running_cost, v);
+                         });
+                         return td::Status::OK();
+                       });
+  p.add_checked_option('\0', "ls-client-rate",
+                       "max estimated cost of LS queries per second from one client (ADNL id, or IP address for "
+                       "anonymous clients), excess queries are rejected (default: 0 - unlimited)",
+                       [&](td::Slice s) -> td::Status {
+                         auto v = td::to_double(s);
+                         if (v < 0) {
+                           return td::Status::Error("ls-client-rate should be non-negative");
+                         }
+                         acts.push_back(
+                             [&x, v]() { td::actor::send_closure(x, &ValidatorEngine::set_ls_client_rate, v); });
+                         return td::Status::OK();
+                       });
   p.add_checked_option(
       '\0', "celldb-cache-size", "block cache size for RocksDb in CellDb, in bytes (default: 1G)",
       [&](td::Slice s) -> td::Status {
@@ -5475,6 +5562,13 @@ int main(int argc, char *argv[]) {
       [&]() {
         acts.push_back([&x]() { td::actor::send_closure(x, &ValidatorEngine::set_celldb_in_memory, true); });
       });
+  p.add_option('\0', "celldb-in-memory-compact",
+               "with --celldb-in-memory, keep cells in a packed representation: several times less RAM, but slower "
+               "cell loads",
+               [&]() {
+                 acts.push_back(
+                     [&x]() { td::actor::send_closure(x, &ValidatorEngine::set_celldb_in_memory_compact, true); });
+               });
   p.add_option(
       '\0', "celldb-v2",
       "use new version off celldb",
@@ -5618,6 +5712,7 @@ int main(int argc, char *argv[]) {
   td::set_runtime_signal_handler(2, need_scheduler_status).ensure();
 
   td::actor::set_debug(true);
+  td::actor::ActorProfiler::set_sample_period(actor_profiler_period);
   td::actor::Scheduler scheduler({threads});
 
   scheduler.run_in_context([&] {
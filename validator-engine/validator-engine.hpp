@@ -234,11 +234,16 @@ class ValidatorEngine : public td::actor::Actor {
   size_t max_open_archive_files_ = 0;
   double archive_preload_period_ = 0.0;
   bool disable_rocksdb_stats_ = false;
+  bool compress_archive_packages_ = false;
   bool nonfinal_ls_queries_enabled_ = false;
+  td::uint32 ls_max_running_cost_ = 512;
+  td::uint32 ls_max_client_running_cost_ = 0;
+  double ls_client_rate_ = 0.0;
   td::optional<td::uint64> celldb_cache_size_ = 1LL << 30;
   bool celldb_direct_io_ = false;
   bool celldb_preload_all_ = false;
   bool celldb_in_memory_ = false;
+  bool celldb_in_memory_compact_ = false;
   bool celldb_v2_ = false;
   bool celldb_disable_bloom_filter_ = false;
   td::optional<double> catchain_max_block_delay_, catchain_max_block_delay_slow_;
@@ -247,6 +252,7 @@ class ValidatorEngine : public td::actor::Actor {
   bool started_ = false;
   ton::BlockSeqno truncate_seqno_{0};
   std::string session_logs_file_;
+  std::string actor_profile_file_;
   bool fast_state_serializer_enabled_ = false;
   std::string validator_telemetry_filename_;
   bool not_all_shards_ = false;
@@ -306,6 +312,9 @@ class ValidatorEngine : public td::actor::Actor {
   void set_session_logs_file(std::string f) {
     session_logs_file_ = std::move(f);
   }
+  void set_actor_profile_file(std::string f) {
+    actor_profile_file_ = std::move(f);
+  }
   void add_ip(td::IPAddress addr) {
     addrs_.push_back(addr);
   }
@@ -325,9 +334,21 @@ class ValidatorEngine : public td::actor::Actor {
   void set_disable_rocksdb_stats(bool value) {
     disable_rocksdb_stats_ = value;
   }
+  void set_compress_archive_packages(bool value) {
+    compress_archive_packages_ = value;
+  }
   void set_nonfinal_ls_queries_enabled() {
     nonfinal_ls_queries_enabled_ = true;
   }
+  void set_ls_max_running_cost(td::uint32 value) {
+    ls_max_running_cost_ = value;
+  }
+  void set_ls_max_client_running_cost(td::uint32 value) {
+    ls_max_client_running_cost_ = value;
+  }
+  void set_ls_client_rate(double value) {
+    ls_client_rate_ = value;
+  }
   void set_celldb_cache_size(td::uint64 value) {
     celldb_cache_size_ = value;
   }
@@ -340,6 +361,9 @@ class ValidatorEngine : public td::actor::Actor {
   void set_celldb_in_memory(bool value) {
     celldb_in_memory_ = value;
   }
+  void set_celldb_in_memory_compact(bool value) {
+    celldb_in_memory_compact_ = value;
+  }
   void set_celldb_v2(bool value) {
     celldb_v2_ = value;
   }
@@ -592,6 +616,8 @@ class ValidatorEngine : public td::actor::Actor {
                          ton::PublicKeyHash src, td::uint32 perm, td::Promise<td::BufferSlice> promise);
   void run_control_query(ton::ton_api::engine_validator_getActorTextStats &query, td::BufferSlice data,
                          ton::PublicKeyHash src, td::uint32 perm, td::Promise<td::BufferSlice> promise);
+  void run_control_query(ton::ton_api::engine_validator_getActorProfileJson &query, td::BufferSlice data,
+                         ton::PublicKeyHash src, td::uint32 perm, td::Promise<td::BufferSlice> promise);
   void run_control_query(ton::ton_api::engine_validator_addShard &query, td::BufferSlice data,
                          ton::PublicKeyHash src, td::uint32 perm, td::Promise<td::BufferSlice> promise);
   void run_control_query(ton::ton_api::engine_validator_delShard &query, td::BufferSlice data,
@@ -1478,9 +1478,10 @@ td::actor::ActorOwn<ValidatorSession> ValidatorSession::create(
     td::actor::ActorId<keyring::Keyring> keyring, td::actor::ActorId<adnl::Adnl> adnl,
     td::actor::ActorId<rldp2::Rldp> rldp, td::actor::ActorId<overlay::Overlays> overlays, std::string db_root,
     std::string db_suffix, bool allow_unsafe_self_blocks_resync) {
-  return td::actor::create_actor<ValidatorSessionImpl>("session", session_id, std::move(opts), local_id,
-                                                       std::move(nodes), std::move(callback), keyring, adnl, rldp,
-                                                       overlays, db_root, db_suffix, allow_unsafe_self_blocks_resync);
+  return td::actor::create_actor<ValidatorSessionImpl>(
+      td::actor::ActorOptions().with_name("session").with_priority(td::actor::ActorPriority::Consensus), session_id,
+      std::move(opts), local_id, std::move(nodes), std::move(callback), keyring, adnl, rldp, overlays, db_root,
+      db_suffix, allow_unsafe_self_blocks_resync);
 }
 
 td::Bits256 ValidatorSessionOptions::get_hash() const {
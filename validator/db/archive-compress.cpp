@@ -0,0 +1,191 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "archive-compress.hpp"
+
+#include "td/db/RocksDb.h"
+#include "td/utils/PathView.h"
+#include "td/utils/misc.h"
+#include "td/utils/port/path.h"
+#include "td/utils/port/Stat.h"
+#include "ton/ton-shard.h"
+
+#include "archive-slice.hpp"
+#include "fileref.hpp"
+#include "package.hpp"
+
+namespace ton::validator {
+
+namespace {
+
+constexpr td::uint32 compressed_package_version = 2;
+
+td::Result<PackageId> parse_package_id(td::Slice stem) {
+  bool key = false;
+  bool temp = false;
+  if (td::begins_with(stem, "key.")) {
+    key = true;
+    stem.remove_prefix(4);
+  } else if (td::begins_with(stem, "temp.")) {
+    temp = true;
+    stem.remove_prefix(5);
+  }
+  if (!td::begins_with(stem, "archive.")) {
+    return td::Status::Error(PSLICE() << "bad archive slice name '" << stem << "'");
+  }
+  stem.remove_prefix(8);
+  TRY_RESULT(id, td::to_integer_safe<td::uint32>(stem));
+  return PackageId(id, key, temp);
+}
+
+std::string package_file_name(td::Slice dir, const PackageId &package_id, ShardIdFull shard_prefix) {
+  td::StringBuilder sb;
+  sb << dir << package_id.name();
+  if (!shard_prefix.is_masterchain()) {
+    sb << "." << shard_prefix.workchain << ":" << shard_to_str(shard_prefix.shard);
+  }
+  sb << ".pack";
+  return sb.as_cslice().str();
+}
+
+td::Result<std::string> get_value(td::KeyValue &kv, td::Slice key) {
+  std::string value;
+  TRY_RESULT(status, kv.get(key, value));
+  if (status != td::KeyValue::GetStatus::Ok) {
+    return td::Status::Error(PSLICE() << "no key '" << key << "' in the slice index");
+  }
+  return value;
+}
+
+}  // namespace
+
+td::Result<ArchiveCompressStats> compress_archive_package(td::KeyValue &kv, td::uint32 idx, const std::string &path) {
+  auto tmp_path = path + ".compressed";
+  TRY_RESULT(version_str, get_value(kv, PSLICE() << "version." << idx));
+  TRY_RESULT(version, td::to_integer_safe<td::uint32>(version_str));
+  TRY_RESULT(size_str, get_value(kv, PSLICE() << "status." << idx));
+  TRY_RESULT(size, td::to_integer_safe<td::uint64>(size_str));
+  ArchiveCompressStats stats;
+  if (version >= compressed_package_version) {
+    if (td::stat(tmp_path).is_ok()) {
+      TRY_STATUS(td::rename(tmp_path, path));
+      LOG(INFO) << path << ": finished interrupted conversion";
+    }
+    stats.old_size = stats.new_size = size;
+    return stats;
+  }
+
+  TRY_RESULT(old_package, Package::open(path, true, false));
+  if (old_package.size() < size) {
+    return td::Status::Error(PSLICE() << path << " is shorter than recorded in the slice index");
+  }
+  // a copy left by a conversion that was interrupted before the commit
+  td::unlink(tmp_path).ignore();
+  TRY_RESULT(new_package, Package::open(tmp_path, false, true));
+  new_package.set_compression(true);
+
+  TRY_STATUS(kv.begin_transaction());
+  td::Status error;
+  old_package.iterate([&](std::string filename, td::BufferSlice data, td::uint64 offset) -> bool {
+    if (offset >= size) {
+      // not committed to the slice index, truncated on open
+      return false;
+    }
+    auto r_ref = FileReference::create(filename);
+    if (r_ref.is_error()) {
+      error = r_ref.move_as_error_prefix(PSLICE() << "bad filename '" << filename << "': ");
+      return false;
+    }
+    auto key = r_ref.ok().hash().to_hex();
+    std::string value;
+    auto r_get = kv.get(key, value);
+    if (r_get.is_error()) {
+      error = r_get.move_as_error();
+      return false;
+    }
+    auto new_offset = new_package.append(std::move(filename), data, false);
+    // the file may be stored in another package of the slice or be deleted
+    if (r_get.ok() == td::KeyValue::GetStatus::Ok && td::to_integer<td::uint64>(value) == offset) {
+      auto S = kv.set(key, td::to_string(new_offset));
+      if (S.is_error()) {
+        error = std::move(S);
+        return false;
+      }
+    }
+    stats.files++;
+    return true;
+  });
+  auto S = [&]() -> td::Status {
+    TRY_STATUS(std::move(error));
+    new_package.sync();
+    stats.old_size = size;
+    stats.new_size = new_package.size();
+    TRY_STATUS(kv.set(PSLICE() << "status." << idx, td::to_string(stats.new_size)));
+    TRY_STATUS(kv.set(PSLICE() << "version." << idx, td::to_string(compressed_package_version)));
+    return kv.commit_transaction();
+  }();
+  if (S.is_error()) {
+    kv.abort_transaction().ignore();
+    td::unlink(tmp_path).ignore();
+    return S.move_as_error_prefix(PSLICE() << path << ": ");
+  }
+  TRY_STATUS(td::rename(tmp_path, path));
+  LOG(INFO) << path << ": " << stats.files << " files, " << stats.old_size << " -> " << stats.new_size << " bytes";
+  return stats;
+}
+
+td::Result<ArchiveCompressStats> compress_archive_slice(const std::string &index_path) {
+  auto dir = td::PathView(index_path).parent_dir().str();
+  TRY_RESULT(package_id, parse_package_id(td::PathView(index_path).file_stem()));
+  if (package_id.key || package_id.temp) {
+    // ArchiveSlice never records a package version for these slices and would serve compressed entries to peers
+    return td::Status::Error("key block and temp archive slices cannot be compressed");
+  }
+  TRY_RESULT(kv, td::RocksDb::open(index_path));
+  TRY_RESULT(status, get_value(kv, "status"));
+  if (status != "sliced") {
+    return td::Status::Error("only sliced archive slices can be compressed");
+  }
+  TRY_RESULT(slices_str, get_value(kv, "slices"));
+  TRY_RESULT(slices, td::to_integer_safe<td::uint32>(slices_str));
+  TRY_RESULT(slice_size_str, get_value(kv, "slice_size"));
+  TRY_RESULT(slice_size, td::to_integer_safe<td::uint32>(slice_size_str));
+  std::string value;
+  TRY_RESULT(shard_split_depth_status, kv.get("shard_split_depth", value));
+  bool shard_separated = shard_split_depth_status == td::KeyValue::GetStatus::Ok;
+
+  ArchiveCompressStats total;
+  for (td::uint32 i = 0; i < slices; i++) {
+    BlockSeqno seqno = package_id.id + slice_size * i;
+    ShardIdFull shard_prefix{masterchainId};
+    if (shard_separated) {
+      TRY_RESULT(info, get_value(kv, PSLICE() << "info." << i));
+      unsigned long long shard;
+      if (sscanf(info.c_str(), "%u.%d:%016llx", &seqno, &shard_prefix.workchain, &shard) != 3) {
+        return td::Status::Error(PSLICE() << "bad package info '" << info << "'");
+      }
+      shard_prefix.shard = shard;
+    }
+    PackageId p_id{seqno, package_id.key, package_id.temp};
+    TRY_RESULT(stats, compress_archive_package(kv, i, package_file_name(dir, p_id, shard_prefix)));
+    total.files += stats.files;
+    total.old_size += stats.old_size;
+    total.new_size += stats.new_size;
+  }
+  return total;
+}
+
+}  // namespace ton::validator
@@ -0,0 +1,42 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "td/db/KeyValue.h"
+#include "td/utils/Status.h"
+
+#include <string>
+
+namespace ton::validator {
+
+struct ArchiveCompressStats {
+  td::uint64 files = 0;
+  td::uint64 old_size = 0;
+  td::uint64 new_size = 0;
+};
+
+// Converts package idx of a sliced archive slice to the compressed package format.
+// A compressed copy "<path>.compressed" is written first, then the new offsets, size and version are committed to
+// the slice index, and finally the copy replaces the package. ArchiveSlice finishes the rename on open if the
+// conversion was interrupted after the commit.
+td::Result<ArchiveCompressStats> compress_archive_package(td::KeyValue &kv, td::uint32 idx, const std::string &path);
+
+// Converts all packages of the archive slice with the given index ("<dir>/archive.XXXXX.index").
+// The validator must not be running
+td::Result<ArchiveCompressStats> compress_archive_slice(const std::string &index_path);
+
+}  // namespace ton::validator
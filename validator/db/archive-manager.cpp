@@ -662,7 +662,8 @@ void ArchiveManager::load_package(PackageId id) {
   }
 
   desc.file = td::actor::create_actor<ArchiveSlice>("slice", id.id, id.key, id.temp, false, 0, db_root_,
-                                                    archive_lru_.get(), statistics_);
+                                                    archive_lru_.get(), statistics_, file_cache_, read_ahead_cache_,
+                                                    opts_->get_compress_archive_packages());
 
   m.emplace(id, std::move(desc));
   update_permanent_slices();
@@ -699,7 +700,8 @@ const ArchiveManager::FileDescription *ArchiveManager::add_file_desc(ShardIdFull
   std::string prefix = PSTRING() << db_root_ << id.path() << id.name();
   new_desc.file = td::actor::create_actor<ArchiveSlice>("slice", id.id, id.key, id.temp, false,
                                                         id.key || id.temp ? 0 : cur_shard_split_depth_, db_root_,
-                                                        archive_lru_.get(), statistics_);
+                                                        archive_lru_.get(), statistics_, file_cache_, read_ahead_cache_,
+                                                        opts_->get_compress_archive_packages());
   const FileDescription &desc = f.emplace(id, std::move(new_desc));
   if (!id.temp) {
     update_desc(f, desc, shard, seqno, ts, lt);
@@ -892,6 +894,8 @@ void ArchiveManager::start_up() {
   if (opts_->get_max_open_archive_files() > 0) {
     archive_lru_ = td::actor::create_actor<ArchiveLru>("archive_lru", opts_->get_max_open_archive_files());
   }
+  file_cache_ = std::make_shared<ArchiveFileCache>(FILE_CACHE_SIZE);
+  read_ahead_cache_ = std::make_shared<ArchiveReadAheadCache>(READ_AHEAD_CACHE_SIZE);
   if (!opts_->get_disable_rocksdb_stats()) {
     statistics_.init();
   }
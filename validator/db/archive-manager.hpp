@@ -188,6 +188,8 @@ class ArchiveManager : public td::actor::Actor {
   td::uint32 cur_shard_split_depth_ = 0;
 
   DbStatistics statistics_;
+  std::shared_ptr<ArchiveFileCache> file_cache_;
+  std::shared_ptr<ArchiveReadAheadCache> read_ahead_cache_;
 
   FileMap &get_file_map(const PackageId &p) {
     return p.key ? key_files_ : p.temp ? temp_files_ : files_;
@@ -244,6 +246,8 @@ class ArchiveManager : public td::actor::Actor {
   void update_permanent_slices();
 
   static constexpr double TEMP_PACKAGES_TTL = 3600;
+  static constexpr size_t FILE_CACHE_SIZE = 64 << 20;
+  static constexpr size_t READ_AHEAD_CACHE_SIZE = 32 << 20;
 };
 
 }  // namespace validator
@@ -22,6 +22,7 @@
 #include "validator/fabric.h"
 #include "td/db/RocksDb.h"
 #include "td/utils/port/path.h"
+#include "td/utils/port/Stat.h"
 #include "common/delay.h"
 #include "files-async.hpp"
 #include "db-utils.h"
@@ -46,6 +47,14 @@ class PackageStatistics {
     read_time.insert(time);
   }
 
+  void record_file_cache(bool hit) {
+    (hit ? file_cache_hits : file_cache_misses).fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void record_read_ahead(bool hit) {
+    (hit ? read_ahead_hits : read_ahead_misses).fetch_add(1, std::memory_order_relaxed);
+  }
+
   void record_write(double time, uint64_t bytes) {
     write_bytes.fetch_add(bytes, std::memory_order_relaxed);
     std::lock_guard guard(write_mutex);
@@ -62,6 +71,10 @@ class PackageStatistics {
 
     ss << "ton.pack.read.bytes COUNT : " << read_bytes.exchange(0, std::memory_order_relaxed) << "\n";
     ss << "ton.pack.write.bytes COUNT : " << write_bytes.exchange(0, std::memory_order_relaxed) << "\n";
+    ss << "ton.pack.cache.hit COUNT : " << file_cache_hits.exchange(0, std::memory_order_relaxed) << "\n";
+    ss << "ton.pack.cache.miss COUNT : " << file_cache_misses.exchange(0, std::memory_order_relaxed) << "\n";
+    ss << "ton.pack.readahead.hit COUNT : " << read_ahead_hits.exchange(0, std::memory_order_relaxed) << "\n";
+    ss << "ton.pack.readahead.miss COUNT : " << read_ahead_misses.exchange(0, std::memory_order_relaxed) << "\n";
 
     PercentileStats temp_read_time;
     {
@@ -89,6 +102,10 @@ class PackageStatistics {
   std::atomic_uint64_t read_bytes{0};
   PercentileStats write_time;
   std::atomic_uint64_t write_bytes{0};
+  std::atomic_uint64_t file_cache_hits{0};
+  std::atomic_uint64_t file_cache_misses{0};
+  std::atomic_uint64_t read_ahead_hits{0};
+  std::atomic_uint64_t read_ahead_misses{0};
 
   mutable std::mutex read_mutex;
   mutable std::mutex write_mutex;
@@ -106,6 +123,97 @@ std::string DbStatistics::to_string_and_reset() {
   return ss.str();
 }
 
+td::optional<td::BufferSlice> ArchiveFileCache::get(const FileHash &hash) {
+  std::lock_guard guard(mutex_);
+  auto it = entries_.find(hash);
+  if (it == entries_.end()) {
+    return {};
+  }
+  auto entry = it->second.get();
+  entry->remove();
+  lru_.put(entry);
+  return entry->data.clone();
+}
+
+void ArchiveFileCache::put(const FileHash &hash, td::BufferSlice data) {
+  // a single huge file should not flush the whole cache
+  if (data.size() > max_size_ / 8) {
+    return;
+  }
+  std::lock_guard guard(mutex_);
+  auto &entry = entries_[hash];
+  if (entry) {
+    return;
+  }
+  total_size_ += data.size();
+  entry = std::make_unique<Entry>(hash, std::move(data));
+  lru_.put(entry.get());
+  while (total_size_ > max_size_) {
+    auto to_remove = static_cast<Entry *>(lru_.get());
+    CHECK(to_remove);
+    total_size_ -= to_remove->data.size();
+    to_remove->remove();
+    entries_.erase(to_remove->hash);
+  }
+}
+
+td::optional<td::BufferSlice> ArchiveReadAheadCache::get(const std::string &path, td::uint64 offset,
+                                                         td::uint32 limit) {
+  std::lock_guard guard(mutex_);
+  auto it = entries_.find(path);
+  if (it == entries_.end()) {
+    return {};
+  }
+  auto entry = it->second.get();
+  if (offset < entry->offset || offset + limit > entry->offset + entry->data.size()) {
+    return {};
+  }
+  auto data = entry->data.clone();
+  data.confirm_read(offset - entry->offset);
+  data.truncate(limit);
+  if (offset + limit == entry->offset + entry->data.size()) {
+    erase_entry(entry);
+  } else {
+    entry->remove();
+    lru_.put(entry);
+  }
+  return std::move(data);
+}
+
+void ArchiveReadAheadCache::put(const std::string &path, td::uint64 offset, td::BufferSlice data) {
+  if (data.size() > max_size_) {
+    return;
+  }
+  std::lock_guard guard(mutex_);
+  auto &entry = entries_[path];
+  if (entry) {
+    total_size_ -= entry->data.size();
+    entry->remove();
+  }
+  total_size_ += data.size();
+  entry = std::make_unique<Entry>(path, offset, std::move(data));
+  lru_.put(entry.get());
+  while (total_size_ > max_size_) {
+    auto to_remove = static_cast<Entry *>(lru_.get());
+    CHECK(to_remove);
+    erase_entry(to_remove);
+  }
+}
+
+void ArchiveReadAheadCache::erase(const std::string &path) {
+  std::lock_guard guard(mutex_);
+  auto it = entries_.find(path);
+  if (it != entries_.end()) {
+    erase_entry(it->second.get());
+  }
+}
+
+void ArchiveReadAheadCache::erase_entry(Entry *entry) {
+  total_size_ -= entry->data.size();
+  entry->remove();
+  entries_.erase(entry->path);
+}
+
 void PackageWriter::append(std::string filename, td::BufferSlice data,
                            td::Promise<std::pair<td::uint64, td::uint64>> promise) {
   td::uint64 offset, size;
@@ -152,6 +260,25 @@ class PackageReader : public td::actor::Actor {
   std::shared_ptr<PackageStatistics> statistics_;
 };
 
+class PackageSliceReader : public td::actor::Actor {
+ public:
+  PackageSliceReader(std::shared_ptr<Package> package, td::uint64 offset, td::uint32 limit,
+                     td::Promise<td::BufferSlice> promise)
+      : package_(std::move(package)), offset_(offset), limit_(limit), promise_(std::move(promise)) {
+  }
+  void start_up() override {
+    promise_.set_result(package_->read_plain_slice(offset_, limit_));
+    package_ = {};
+    stop();
+  }
+
+ private:
+  std::shared_ptr<Package> package_;
+  td::uint64 offset_;
+  td::uint32 limit_;
+  td::Promise<td::BufferSlice> promise_;
+};
+
 static std::string get_package_file_name(PackageId p_id, ShardIdFull shard_prefix) {
   td::StringBuilder sb;
   sb << p_id.name();
@@ -390,20 +517,34 @@ void ArchiveSlice::get_file(ConstBlockHandle handle, FileReference ref_id, td::P
     return;
   }
   auto offset = td::to_integer<td::uint64>(value);
+  if (file_cache_) {
+    auto cached = file_cache_->get(ref_id.hash());
+    if (statistics_.pack_statistics) {
+      statistics_.pack_statistics->record_file_cache(bool(cached));
+    }
+    if (cached) {
+      promise.set_value(cached.unwrap());
+      return;
+    }
+  }
   TRY_RESULT_PROMISE(
       promise, p,
       choose_package(
           handle ? handle->id().is_masterchain() ? handle->id().seqno() : handle->masterchain_ref_block() : 0,
           handle ? handle->id().shard_full() : ShardIdFull{masterchainId}, false));
   promise = begin_async_query(std::move(promise));
-  auto P = td::PromiseCreator::lambda(
-      [promise = std::move(promise)](td::Result<std::pair<std::string, td::BufferSlice>> R) mutable {
-        if (R.is_error()) {
-          promise.set_error(R.move_as_error());
-        } else {
-          promise.set_value(std::move(R.move_as_ok().second));
-        }
-      });
+  auto P = td::PromiseCreator::lambda([promise = std::move(promise), file_cache = file_cache_, hash = ref_id.hash()](
+                                          td::Result<std::pair<std::string, td::BufferSlice>> R) mutable {
+    if (R.is_error()) {
+      promise.set_error(R.move_as_error());
+    } else {
+      auto data = std::move(R.move_as_ok().second);
+      if (file_cache) {
+        file_cache->put(hash, data.clone());
+      }
+      promise.set_value(std::move(data));
+    }
+  });
   td::actor::create_actor<PackageReader>("reader", p->package, offset, std::move(P), statistics_.pack_statistics).release();
 }
 
@@ -564,8 +705,75 @@ void ArchiveSlice::get_slice(td::uint64 archive_id, td::uint64 offset, td::uint3
   } else {
     TRY_RESULT_PROMISE_ASSIGN(promise, p, choose_package(value, ShardIdFull{masterchainId}, false));
   }
+
+  // Peers download a package with consecutive get_slice queries, so a sequential query reads
+  // SLICE_READ_AHEAD_SIZE bytes at once and the following queries are answered from memory
+  if (!read_ahead_cache_) {
+    read_package_slice(p, offset, limit, begin_async_query(std::move(promise)));
+    return;
+  }
+  auto &next_offset = read_ahead_next_offset_[p->idx];
+  bool sequential = offset == next_offset;
+  next_offset = offset + limit;
+  auto cached = read_ahead_cache_->get(p->path, offset, limit);
+  if (statistics_.pack_statistics) {
+    statistics_.pack_statistics->record_read_ahead(bool(cached));
+  }
+  if (cached) {
+    promise.set_value(cached.unwrap());
+    return;
+  }
   promise = begin_async_query(std::move(promise));
-  td::actor::create_actor<db::ReadFile>("readfile", p->path, offset, limit, 0, std::move(promise)).release();
+  if (!sequential || limit >= SLICE_READ_AHEAD_SIZE) {
+    read_package_slice(p, offset, limit, std::move(promise));
+    return;
+  }
+  auto P = td::PromiseCreator::lambda([SelfId = actor_id(this), idx = p->idx, offset, limit,
+                                       promise = std::move(promise)](td::Result<td::BufferSlice> R) mutable {
+    if (R.is_error()) {
+      promise.set_error(R.move_as_error());
+      return;
+    }
+    auto data = R.move_as_ok();
+    if (data.size() > limit) {
+      td::actor::send_closure(SelfId, &ArchiveSlice::got_read_ahead, idx, offset, data.clone());
+      data.truncate(limit);
+    }
+    promise.set_value(std::move(data));
+  });
+  read_package_slice(p, offset, SLICE_READ_AHEAD_SIZE, std::move(P));
+}
+
+void ArchiveSlice::read_package_slice(PackageInfo *p, td::uint64 offset, td::uint32 limit,
+                                      td::Promise<td::BufferSlice> promise) {
+  if (p->version >= compressed_package_version() && p->package) {
+    // peers get the package with all entries uncompressed
+    td::actor::create_actor<PackageSliceReader>("slicereader", p->package, offset, limit, std::move(promise))
+        .release();
+  } else {
+    td::actor::create_actor<db::ReadFile>("readfile", p->path, offset, limit, 0, std::move(promise)).release();
+  }
+}
+
+void ArchiveSlice::got_read_ahead(td::uint32 idx, td::uint64 offset, td::BufferSlice data) {
+  if (status_ == st_closed || destroyed_) {
+    return;
+  }
+  auto it = read_ahead_next_offset_.find(idx);
+  if (it == read_ahead_next_offset_.end() || it->second <= offset || it->second >= offset + data.size() ||
+      idx >= packages_.size()) {
+    return;
+  }
+  read_ahead_cache_->put(packages_[idx].path, offset, std::move(data));
+}
+
+void ArchiveSlice::clear_read_ahead() {
+  if (read_ahead_cache_) {
+    for (auto &p : packages_) {
+      read_ahead_cache_->erase(p.path);
+    }
+  }
+  read_ahead_next_offset_.clear();
 }
 
 void ArchiveSlice::get_archive_id(BlockSeqno masterchain_seqno, ShardIdFull shard_prefix,
@@ -653,12 +861,12 @@ void ArchiveSlice::before_query() {
         kv_->set("slices", "1").ensure();
         kv_->set("slice_size", td::to_string(slice_size_)).ensure();
         kv_->set("status.0", "0").ensure();
-        kv_->set("version.0", td::to_string(default_package_version())).ensure();
+        kv_->set("version.0", td::to_string(new_package_version())).ensure();
         shard_separated_ = true;
         kv_->set("info.0", package_info_to_str(archive_id_, ShardIdFull{masterchainId})).ensure();
         kv_->set("shard_split_depth", td::to_string(shard_split_depth_)).ensure();
         kv_->commit_transaction().ensure();
-        add_package(archive_id_, ShardIdFull{masterchainId}, 0, default_package_version());
+        add_package(archive_id_, ShardIdFull{masterchainId}, 0, new_package_version());
       } else {
         kv_->begin_transaction().ensure();
         kv_->set("status", "0").ensure();
@@ -717,6 +925,7 @@ void ArchiveSlice::do_close() {
   if (statistics_.pack_statistics) {
     statistics_.pack_statistics->record_close(packages_.size());
   }
+  clear_read_ahead();
   packages_.clear();
   id_to_package_.clear();
 }
@@ -776,7 +985,9 @@ void ArchiveSlice::set_async_mode(bool mode, td::Promise<td::Unit> promise) {
 
 ArchiveSlice::ArchiveSlice(td::uint32 archive_id, bool key_blocks_only, bool temp, bool finalized,
                            td::uint32 shard_split_depth, std::string db_root,
-                           td::actor::ActorId<ArchiveLru> archive_lru, DbStatistics statistics)
+                           td::actor::ActorId<ArchiveLru> archive_lru, DbStatistics statistics,
+                           std::shared_ptr<ArchiveFileCache> file_cache,
+                           std::shared_ptr<ArchiveReadAheadCache> read_ahead_cache, bool compress_packages)
     : archive_id_(archive_id)
     , key_blocks_only_(key_blocks_only)
     , temp_(temp)
@@ -785,7 +996,10 @@ ArchiveSlice::ArchiveSlice(td::uint32 archive_id, bool key_blocks_only, bool tem
     , shard_split_depth_(temp || key_blocks_only ? 0 : shard_split_depth)
     , db_root_(std::move(db_root))
     , archive_lru_(std::move(archive_lru))
-    , statistics_(statistics) {
+    , statistics_(statistics)
+    , file_cache_(std::move(file_cache))
+    , read_ahead_cache_(std::move(read_ahead_cache))
+    , compress_packages_(compress_packages && !temp && !key_blocks_only) {
   db_path_ = PSTRING() << db_root_ << p_id_.path() << p_id_.name() << ".index";
 }
 
@@ -814,12 +1028,12 @@ td::Result<ArchiveSlice::PackageInfo *> ArchiveSlice::choose_package(BlockSeqno
     size_t v = packages_.size();
     kv_->set("slices", td::to_string(v + 1)).ensure();
     kv_->set(PSTRING() << "status." << v, "0").ensure();
-    kv_->set(PSTRING() << "version." << v, td::to_string(default_package_version())).ensure();
+    kv_->set(PSTRING() << "version." << v, td::to_string(new_package_version())).ensure();
     if (shard_separated_) {
       kv_->set(PSTRING() << "info." << v, package_info_to_str(masterchain_seqno, shard_prefix)).ensure();
     }
     commit_transaction();
-    add_package(masterchain_seqno, shard_prefix, 0, default_package_version());
+    add_package(masterchain_seqno, shard_prefix, 0, new_package_version());
     return &packages_[v];
   } else {
     return &packages_[it->second];
@@ -829,6 +1043,10 @@ td::Result<ArchiveSlice::PackageInfo *> ArchiveSlice::choose_package(BlockSeqno
 void ArchiveSlice::add_package(td::uint32 seqno, ShardIdFull shard_prefix, td::uint64 size, td::uint32 version) {
   PackageId p_id{seqno, key_blocks_only_, temp_};
   std::string path = PSTRING() << db_root_ << p_id.path() << get_package_file_name(p_id, shard_prefix);
+  if (version >= compressed_package_version() && td::stat(path + ".compressed").is_ok()) {
+    // archive-compress was interrupted after committing the new offsets to the index
+    td::rename(path + ".compressed", path).ensure();
+  }
   auto R = Package::open(path, false, true);
   if (R.is_error()) {
     LOG(FATAL) << "failed to open/create archive '" << path << "': " << R.move_as_error();
@@ -847,6 +1065,7 @@ void ArchiveSlice::add_package(td::uint32 seqno, ShardIdFull shard_prefix, td::u
   if (version >= 1) {
     pack->truncate(size).ensure();
   }
+  pack->set_compression(version >= compressed_package_version());
   auto writer = td::actor::create_actor<PackageWriter>("writer", pack, async_mode_, statistics_.pack_statistics);
   packages_.emplace_back(std::move(pack), std::move(writer), seqno, shard_prefix, path, idx, version);
 }
@@ -880,6 +1099,7 @@ void ArchiveSlice::destroy(td::Promise<td::Unit> promise) {
   if (statistics_.pack_statistics) {
     statistics_.pack_statistics->record_close(packages_.size());
   }
+  clear_read_ahead();
   packages_.clear();
   id_to_package_.clear();
   kv_ = nullptr;
@@ -1023,6 +1243,7 @@ void ArchiveSlice::truncate(BlockSeqno masterchain_seqno, ConstBlockHandle, td::
     return;
   }
   before_query();
+  clear_read_ahead();
   LOG(INFO) << "TRUNCATE: slice " << archive_id_ << " maxseqno= " << max_masterchain_seqno()
             << " truncate_upto=" << masterchain_seqno;
   if (max_masterchain_seqno() <= masterchain_seqno) {
@@ -1066,6 +1287,7 @@ void ArchiveSlice::truncate(BlockSeqno masterchain_seqno, ConstBlockHandle, td::
       new_package_r.ensure();
       auto new_package = std::make_shared<Package>(new_package_r.move_as_ok());
       new_package->truncate(0).ensure();
+      new_package->set_compression(package->version >= compressed_package_version());
       new_packages[package->shard_prefix] = std::move(new_package);
     }
     truncate_shard(masterchain_seqno, shard, package->seqno, new_packages[package->shard_prefix].get());
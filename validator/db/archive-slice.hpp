@@ -22,7 +22,10 @@
 #include "package.hpp"
 #include "fileref.hpp"
 #include "td/db/RocksDb.h"
+#include "td/utils/List.h"
+#include "td/utils/optional.h"
 #include <map>
+#include <mutex>
 
 namespace rocksdb {
 class Statistics;
@@ -68,6 +71,59 @@ struct DbStatistics {
   std::shared_ptr<rocksdb::Statistics> rocksdb_statistics;
 };
 
+// LRU of recently read archive files (blocks, proofs), shared by all slices of the archive manager
+class ArchiveFileCache {
+ public:
+  explicit ArchiveFileCache(size_t max_size) : max_size_(max_size) {
+  }
+  td::optional<td::BufferSlice> get(const FileHash &hash);
+  void put(const FileHash &hash, td::BufferSlice data);
+
+ private:
+  struct Entry : public td::ListNode {
+    Entry(FileHash hash, td::BufferSlice data) : hash(hash), data(std::move(data)) {
+    }
+    FileHash hash;
+    td::BufferSlice data;
+  };
+
+  std::mutex mutex_;
+  std::map<FileHash, std::unique_ptr<Entry>> entries_;
+  td::ListNode lru_;
+  size_t total_size_ = 0;
+  size_t max_size_;
+};
+
+// data read ahead of get_slice queries, keyed by package path; the total size is bounded by max_size,
+// least recently used buffers are dropped first
+class ArchiveReadAheadCache {
+ public:
+  explicit ArchiveReadAheadCache(size_t max_size) : max_size_(max_size) {
+  }
+  // returns [offset, offset + limit) if it is buffered; the buffer is freed once its last byte is returned
+  td::optional<td::BufferSlice> get(const std::string &path, td::uint64 offset, td::uint32 limit);
+  void put(const std::string &path, td::uint64 offset, td::BufferSlice data);
+  void erase(const std::string &path);
+
+ private:
+  struct Entry : public td::ListNode {
+    Entry(std::string path, td::uint64 offset, td::BufferSlice data)
+        : path(std::move(path)), offset(offset), data(std::move(data)) {
+    }
+    std::string path;
+    td::uint64 offset;
+    td::BufferSlice data;
+  };
+
+  void erase_entry(Entry *entry);
+
+  std::mutex mutex_;
+  std::map<std::string, std::unique_ptr<Entry>> entries_;
+  td::ListNode lru_;
+  size_t total_size_ = 0;
+  size_t max_size_;
+};
+
 class PackageWriter : public td::actor::Actor {
  public:
   PackageWriter(std::weak_ptr<Package> package, bool async_mode = false, std::shared_ptr<PackageStatistics> statistics = nullptr)
@@ -97,7 +153,9 @@ class ArchiveLru;
 class ArchiveSlice : public td::actor::Actor {
  public:
   ArchiveSlice(td::uint32 archive_id, bool key_blocks_only, bool temp, bool finalized, td::uint32 shard_split_depth,
-               std::string db_root, td::actor::ActorId<ArchiveLru> archive_lru, DbStatistics statistics = {});
+               std::string db_root, td::actor::ActorId<ArchiveLru> archive_lru, DbStatistics statistics = {},
+               std::shared_ptr<ArchiveFileCache> file_cache = nullptr,
+               std::shared_ptr<ArchiveReadAheadCache> read_ahead_cache = nullptr, bool compress_packages = false);
 
   void get_archive_id(BlockSeqno masterchain_seqno, ShardIdFull shard_prefix, td::Promise<td::uint64> promise);
 
@@ -141,6 +199,8 @@ class ArchiveSlice : public td::actor::Actor {
 
   void add_file_cont(size_t idx, FileReference ref_id, td::uint64 offset, td::uint64 size,
                      td::Promise<td::Unit> promise);
+  void got_read_ahead(td::uint32 idx, td::uint64 offset, td::BufferSlice data);
+  void clear_read_ahead();
 
   /* ltdb */
   td::BufferSlice get_db_key_lt_desc(ShardIdFull shard);
@@ -172,8 +232,14 @@ class ArchiveSlice : public td::actor::Actor {
   std::string db_root_;
   td::actor::ActorId<ArchiveLru> archive_lru_;
   DbStatistics statistics_;
+  std::shared_ptr<ArchiveFileCache> file_cache_;
+  std::shared_ptr<ArchiveReadAheadCache> read_ahead_cache_;
+  bool compress_packages_ = false;
   std::unique_ptr<td::KeyValue> kv_;
 
+  // package idx -> end of the last range requested by get_slice, a request starting here is considered sequential
+  std::map<td::uint32, td::uint64> read_ahead_next_offset_;
+
   struct PackageInfo {
     PackageInfo(std::shared_ptr<Package> package, td::actor::ActorOwn<PackageWriter> writer, BlockSeqno seqno, ShardIdFull shard_prefix,
                 std::string path, td::uint32 idx, td::uint32 version)
@@ -197,6 +263,7 @@ class ArchiveSlice : public td::actor::Actor {
   std::map<std::pair<BlockSeqno, ShardIdFull>, td::uint32> id_to_package_;
 
   td::Result<PackageInfo *> choose_package(BlockSeqno masterchain_seqno, ShardIdFull shard_prefix, bool force);
+  void read_package_slice(PackageInfo *p, td::uint64 offset, td::uint32 limit, td::Promise<td::BufferSlice> promise);
   void add_package(BlockSeqno masterchain_seqno, ShardIdFull shard_prefix, td::uint64 size, td::uint32 version);
   void truncate_shard(BlockSeqno masterchain_seqno, ShardIdFull shard, td::uint32 cutoff_seqno, Package *pack);
   bool truncate_block(BlockSeqno masterchain_seqno, BlockIdExt block_id, td::uint32 cutoff_seqno, Package *pack);
@@ -211,8 +278,16 @@ class ArchiveSlice : public td::actor::Actor {
   static constexpr td::uint32 default_package_version() {
     return 1;
   }
+  // entries of packages of this version may be lz4-compressed
+  static constexpr td::uint32 compressed_package_version() {
+    return 2;
+  }
+  td::uint32 new_package_version() const {
+    return compress_packages_ ? compressed_package_version() : default_package_version();
+  }
 
   static const size_t ESTIMATED_DB_OPEN_FILES = 5;
+  static constexpr td::uint64 SLICE_READ_AHEAD_SIZE = 8 << 20;
 };
 
 class ArchiveLru : public td::actor::Actor {
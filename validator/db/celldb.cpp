@@ -226,8 +226,9 @@ void CellDbIn::start_up() {
         .verbose = true,
         .use_arena = false,
         .use_less_memory_during_creation = true,
+        .compact = opts_->get_celldb_in_memory_compact(),
     };
-    LOG(WARNING) << "Using InMemory DynamicBagOfCells with options " << *boc_v2_options;
+    LOG(WARNING) << "Using InMemory DynamicBagOfCells with options " << *boc_in_memory_options;
   } else {
     boc_v1_options = vm::DynamicBagOfCellsDb::CreateV1Options{};
     LOG(WARNING) << "Using V1 DynamicBagOfCells with options " << *boc_v1_options;
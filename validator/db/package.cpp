@@ -18,6 +18,10 @@
 */
 #include "package.hpp"
 #include "common/errorcode.h"
+#include "td/utils/lz4.h"
+
+#include <algorithm>
+#include <cstring>
 
 namespace ton {
 
@@ -39,11 +43,41 @@ constexpr td::uint16 entry_header_magic() {
   return 0x1e8b;
 }
 
+// entry header is followed by the uncompressed data size, then filename and lz4-compressed data
+constexpr td::uint16 compressed_entry_header_magic() {
+  return 0x1e8c;
+}
+
+constexpr td::uint32 min_compress_size() {
+  return 128;
+}
+
 constexpr td::uint32 package_header_magic() {
   return 0xae8fdd01;
 }
+
+// proofs and most small files fit into one read of this size
+constexpr td::uint32 speculative_read_size() {
+  return 1u << 13;
+}
 }  // namespace
 
+td::uint32 Package::Index::get(td::uint64 offset) const {
+  std::lock_guard<std::mutex> guard(mutex);
+  auto it = entry_size.find(offset);
+  return it == entry_size.end() ? 0 : it->second;
+}
+
+void Package::Index::add(td::uint64 offset, td::uint64 size) {
+  std::lock_guard<std::mutex> guard(mutex);
+  entry_size[offset] = td::narrow_cast<td::uint32>(size);
+}
+
+void Package::Index::clear() {
+  std::lock_guard<std::mutex> guard(mutex);
+  entry_size.clear();
+}
+
 Package::Package(td::FileFd fd) : fd_(std::move(fd)) {
 }
 
@@ -53,6 +87,13 @@ td::Status Package::truncate(td::uint64 size) {
 
   // Only truncate if the size actually differs to avoid updating mtime unnecessarily
   if (current_size != target_size) {
+    index_->clear();
+    {
+      std::lock_guard<std::mutex> guard(plain_view_->mutex);
+      plain_view_->entries.clear();
+      plain_view_->plain_size = 0;
+      plain_view_->size = 0;
+    }
     TRY_STATUS(fd_.seek(target_size));
     return fd_.truncate_to_current_position(target_size);
   }
@@ -63,13 +104,31 @@ td::Status Package::truncate(td::uint64 size) {
 td::uint64 Package::append(std::string filename, td::Slice data, bool sync) {
   CHECK(data.size() <= max_data_size());
   CHECK(filename.size() <= max_filename_size());
+  td::BufferSlice compressed;
+  if (compress_ && data.size() >= min_compress_size()) {
+    compressed = td::lz4_compress(data);
+    // keep the entry uncompressed if compression saves less than 1/8 of it
+    if (compressed.size() + 4 > data.size() - data.size() / 8) {
+      compressed = {};
+    }
+  }
   auto size = fd_.get_size().move_as_ok();
   auto orig_size = size;
-  td::uint32 header[2];
-  header[0] = entry_header_magic() + (td::narrow_cast<td::uint32>(filename.size()) << 16);
-  header[1] = td::narrow_cast<td::uint32>(data.size());
-  CHECK(fd_.pwrite(td::Slice(reinterpret_cast<const td::uint8*>(header), 8), size).move_as_ok() == 8);
-  size += 8;
+  td::uint32 header[3];
+  size_t entry_header_size = 8;
+  if (compressed.empty()) {
+    header[0] = entry_header_magic() + (td::narrow_cast<td::uint32>(filename.size()) << 16);
+    header[1] = td::narrow_cast<td::uint32>(data.size());
+  } else {
+    header[0] = compressed_entry_header_magic() + (td::narrow_cast<td::uint32>(filename.size()) << 16);
+    header[1] = td::narrow_cast<td::uint32>(compressed.size() + 4);
+    header[2] = td::narrow_cast<td::uint32>(data.size());
+    entry_header_size = 12;
+    data = compressed.as_slice();
+  }
+  CHECK(fd_.pwrite(td::Slice(reinterpret_cast<const td::uint8*>(header), entry_header_size), size).move_as_ok() ==
+        entry_header_size);
+  size += entry_header_size;
   CHECK(fd_.pwrite(filename, size).move_as_ok() == filename.size());
   size += filename.size();
   while (data.size() != 0) {
@@ -83,6 +142,7 @@ td::uint64 Package::append(std::string filename, td::Slice data, bool sync) {
   if (sync) {
     fd_.sync().ensure();
   }
+  index_->add(orig_size - header_size(), size - orig_size);
   return orig_size - header_size();
 }
 
@@ -95,34 +155,64 @@ td::uint64 Package::size() const {
 }
 
 td::Result<std::pair<std::string, td::BufferSlice>> Package::read(td::uint64 offset) const {
-  offset += header_size();
-
-  td::uint32 header[2];
-  TRY_RESULT(s1, fd_.pread(td::MutableSlice(reinterpret_cast<td::uint8*>(header), 8), offset));
-  if (s1 != 8) {
+  td::uint32 entry_size = index_->get(offset);
+  td::BufferSlice buf{entry_size != 0 ? entry_size : speculative_read_size()};
+  TRY_RESULT(s1, fd_.pread(buf.as_slice(), offset + header_size()));
+  if (s1 < 8) {
     return td::Status::Error(ErrorCode::notready, "too short read");
   }
-  if ((header[0] & 0xffff) != entry_header_magic()) {
+  td::uint32 header[2];
+  std::memcpy(header, buf.data(), 8);
+  auto magic = header[0] & 0xffff;
+  if (magic != entry_header_magic() && magic != compressed_entry_header_magic()) {
     return td::Status::Error(ErrorCode::notready,
-                             PSTRING() << "bad entry magic " << (header[0] & 0xffff) << " offset=" << offset);
+                             PSTRING() << "bad entry magic " << magic << " offset=" << offset + header_size());
   }
-  offset += 8;
   auto fname_size = header[0] >> 16;
   auto data_size = header[1];
+  td::uint64 total_size = 8 + static_cast<td::uint64>(fname_size) + data_size;
 
-  std::string fname(fname_size, '\0');
-  TRY_RESULT(s2, fd_.pread(fname, offset));
-  if (s2 != fname_size) {
-    return td::Status::Error(ErrorCode::notready, "too short read (filename)");
+  if (total_size > s1) {
+    if (entry_size != 0 || s1 < buf.size()) {
+      return td::Status::Error(ErrorCode::notready, "too short read (data)");
+    }
+    td::BufferSlice full{static_cast<size_t>(total_size)};
+    full.as_slice().copy_from(buf.as_slice());
+    TRY_RESULT(s2, fd_.pread(full.as_slice().substr(s1), offset + header_size() + s1));
+    if (s2 != total_size - s1) {
+      return td::Status::Error(ErrorCode::notready, "too short read (data)");
+    }
+    buf = std::move(full);
+  }
+  if (entry_size == 0) {
+    index_->add(offset, total_size);
+  }
+
+  if (magic == compressed_entry_header_magic()) {
+    if (data_size < 4) {
+      return td::Status::Error(ErrorCode::notready, "bad compressed entry");
+    }
+    td::uint32 raw_size;
+    std::memcpy(&raw_size, buf.data() + 8, 4);
+    if (raw_size > max_data_size()) {
+      return td::Status::Error(ErrorCode::notready, "bad compressed entry size");
+    }
+    std::string fname = buf.as_slice().substr(12, fname_size).str();
+    TRY_RESULT(data, td::lz4_decompress(buf.as_slice().substr(12 + fname_size, data_size - 4),
+                                        static_cast<int>(raw_size)));
+    if (data.size() != raw_size) {
+      return td::Status::Error(ErrorCode::notready, "bad compressed entry size");
+    }
+    return std::pair<std::string, td::BufferSlice>{std::move(fname), std::move(data)};
   }
-  offset += fname_size;
 
-  td::BufferSlice data{data_size};
-  TRY_RESULT(s3, fd_.pread(data.as_slice(), offset));
-  if (s3 != data_size) {
-    return td::Status::Error(ErrorCode::notready, "too short read (data)");
+  std::string fname = buf.as_slice().substr(8, fname_size).str();
+  auto data = buf.as_slice().substr(8 + fname_size, data_size);
+  if (buf.size() == total_size) {
+    return std::pair<std::string, td::BufferSlice>{std::move(fname), buf.from_slice(data)};
   }
-  return std::pair<std::string, td::BufferSlice>{std::move(fname), std::move(data)};
+  // don't keep the rest of the speculative buffer alive
+  return std::pair<std::string, td::BufferSlice>{std::move(fname), td::BufferSlice{data}};
 }
 
 td::Result<td::uint64> Package::advance(td::uint64 offset) {
@@ -133,15 +223,17 @@ td::Result<td::uint64> Package::advance(td::uint64 offset) {
   if (s1 != 8) {
     return td::Status::Error(ErrorCode::notready, "too short read");
   }
-  if ((header[0] & 0xffff) != entry_header_magic()) {
+  auto magic = header[0] & 0xffff;
+  if (magic != entry_header_magic() && magic != compressed_entry_header_magic()) {
     return td::Status::Error(ErrorCode::notready, "bad entry magic");
   }
 
-  offset += 8 + (header[0] >> 16) + header[1];
-  if (offset > static_cast<td::uint64>(fd_.get_size().move_as_ok())) {
+  td::uint64 entry_size = 8 + (header[0] >> 16) + static_cast<td::uint64>(header[1]);
+  if (offset + entry_size > static_cast<td::uint64>(fd_.get_size().move_as_ok())) {
     return td::Status::Error(ErrorCode::notready, "truncated read");
   }
-  return offset - header_size();
+  index_->add(offset - header_size(), entry_size);
+  return offset + entry_size - header_size();
 }
 
 td::Result<Package> Package::open(std::string path, bool read_only, bool create) {
@@ -195,12 +287,103 @@ void Package::iterate(std::function<bool(std::string, td::BufferSlice, td::uint6
       return;
     }
     auto q = R.move_as_ok();
-    if (!func(q.first, q.second.clone(), p)) {
+    auto next = advance(p);
+    if (next.is_error()) {
+      LOG(ERROR) << "broken archive: " << next.move_as_error();
+      return;
+    }
+    if (!func(std::move(q.first), std::move(q.second), p)) {
       break;
     }
+    p = next.move_as_ok();
+  }
+}
 
-    p = advance(p).move_as_ok();
+td::Result<td::BufferSlice> Package::read_plain_slice(td::uint64 offset, td::uint32 limit) const {
+  std::lock_guard<std::mutex> guard(plain_view_->mutex);
+  auto &view = *plain_view_;
+  TRY_RESULT(file_size, fd_.get_size());
+  if (file_size < header_size()) {
+    return td::Status::Error(ErrorCode::notready, "too short archive");
+  }
+  td::uint64 size = file_size - header_size();
+  if (size < view.size) {
+    view.entries.clear();
+    view.plain_size = 0;
+    view.size = 0;
   }
+  while (view.size < size) {
+    td::uint32 header[3];
+    TRY_RESULT(s, fd_.pread(td::MutableSlice(reinterpret_cast<td::uint8 *>(header), 12), view.size + header_size()));
+    if (s < 8) {
+      break;
+    }
+    auto magic = header[0] & 0xffff;
+    auto fname_size = header[0] >> 16;
+    td::uint64 stored_size = 8 + static_cast<td::uint64>(fname_size) + header[1];
+    td::uint64 plain_size;
+    if (magic == entry_header_magic()) {
+      plain_size = stored_size;
+    } else if (magic == compressed_entry_header_magic() && s == 12 && header[1] >= 4) {
+      plain_size = 8 + static_cast<td::uint64>(fname_size) + header[2];
+    } else {
+      return td::Status::Error(ErrorCode::notready, PSTRING() << "bad entry magic " << magic);
+    }
+    if (view.size + stored_size > size) {
+      // the entry is being written
+      break;
+    }
+    view.entries.emplace_back(view.plain_size, view.size);
+    view.plain_size += plain_size;
+    view.size += stored_size;
+  }
+
+  td::uint64 total_size = header_size() + view.plain_size;
+  if (offset >= total_size) {
+    return td::BufferSlice();
+  }
+  td::BufferSlice res{static_cast<size_t>(std::min<td::uint64>(total_size - offset, limit))};
+  auto dest = res.as_slice();
+  if (offset < header_size()) {
+    td::uint32 magic = package_header_magic();
+    auto src = td::Slice(reinterpret_cast<const char *>(&magic), header_size()).substr(static_cast<size_t>(offset));
+    src.truncate(dest.size());
+    dest.copy_from(src);
+    dest.remove_prefix(src.size());
+    offset = header_size();
+  }
+  td::uint64 pos = offset - header_size();
+  auto it = std::upper_bound(view.entries.begin(), view.entries.end(), pos,
+                             [](td::uint64 x, const std::pair<td::uint64, td::uint64> &e) { return x < e.first; });
+  while (!dest.empty()) {
+    CHECK(it != view.entries.begin());
+    auto &entry_pos = *(it - 1);
+    TRY_RESULT(entry, read(entry_pos.second));
+    td::uint32 header[2];
+    header[0] = entry_header_magic() + (td::narrow_cast<td::uint32>(entry.first.size()) << 16);
+    header[1] = td::narrow_cast<td::uint32>(entry.second.size());
+    td::Slice parts[3] = {td::Slice(reinterpret_cast<const char *>(header), 8), entry.first, entry.second.as_slice()};
+    td::uint64 skip = pos - entry_pos.first;
+    for (auto part : parts) {
+      if (skip >= part.size()) {
+        skip -= part.size();
+        continue;
+      }
+      part.remove_prefix(static_cast<size_t>(skip));
+      skip = 0;
+      part.truncate(dest.size());
+      dest.copy_from(part);
+      dest.remove_prefix(part.size());
+      pos += part.size();
+    }
+    ++it;
+  }
+  return std::move(res);
+}
+
+size_t Package::indexed_entries() const {
+  std::lock_guard<std::mutex> guard(index_->mutex);
+  return index_->entry_size.size();
 }
 
 Package::~Package() {
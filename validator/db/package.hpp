@@ -22,6 +22,9 @@
 #include "td/utils/port/FileFd.h"
 #include "td/utils/buffer.h"
 
+#include <mutex>
+#include <unordered_map>
+
 namespace ton {
 
 class Package {
@@ -37,7 +40,18 @@ class Package {
   td::uint64 append(std::string filename, td::Slice data, bool sync = true);
   void sync();
   td::uint64 size() const;
+  // Reads the whole entry with one pread if its size is in the offset index, otherwise
+  // reads a speculative prefix and issues a second pread only for the rest of a large entry
   td::Result<std::pair<std::string, td::BufferSlice>> read(td::uint64 offset) const;
+  size_t indexed_entries() const;
+  // Returns bytes [offset, offset + limit) of the package as it would be stored with all entries uncompressed.
+  // This is the format served to peers, which do not know compressed entries
+  td::Result<td::BufferSlice> read_plain_slice(td::uint64 offset, td::uint32 limit) const;
+
+  // New entries are lz4-compressed if it makes them noticeably smaller
+  void set_compression(bool value) {
+    compress_ = value;
+  }
 
   td::Result<td::uint64> advance(td::uint64 offset);
   void iterate(std::function<bool(std::string, td::BufferSlice, td::uint64)> func);
@@ -47,7 +61,28 @@ class Package {
   }
 
  private:
+  // entry offset -> size of the entry including its header; filled by append, iterate and read
+  struct Index {
+    mutable std::mutex mutex;
+    std::unordered_map<td::uint64, td::uint32> entry_size;
+
+    td::uint32 get(td::uint64 offset) const;
+    void add(td::uint64 offset, td::uint64 size);
+    void clear();
+  };
+
+  // (plain offset, offset) of each entry, built lazily by read_plain_slice
+  struct PlainView {
+    std::mutex mutex;
+    std::vector<std::pair<td::uint64, td::uint64>> entries;
+    td::uint64 plain_size{0};
+    td::uint64 size{0};
+  };
+
   td::FileFd fd_;
+  bool compress_ = false;
+  std::unique_ptr<Index> index_ = std::make_unique<Index>();
+  std::unique_ptr<PlainView> plain_view_ = std::make_unique<PlainView>();
 };
 
 }  // namespace ton
@@ -163,17 +163,25 @@ void WaitBlockState::start() {
                             std::move(P));
   } else if (prev_state_.is_null()) {
     CHECK(handle_->inited_proof() || handle_->inited_proof_link());
-    auto P = td::PromiseCreator::lambda([SelfId = actor_id(this)](td::Result<td::Ref<ShardState>> R) {
-      if (R.is_error()) {
-        td::actor::send_closure(SelfId, &WaitBlockState::failed_to_get_prev_state,
-                                R.move_as_error_prefix("prev state wait error: "));
-      } else {
-        td::actor::send_closure(SelfId, &WaitBlockState::got_prev_state, R.move_as_ok());
-      }
-    });
+    if (!waiting_prev_state_) {
+      waiting_prev_state_ = true;
+      auto P = td::PromiseCreator::lambda([SelfId = actor_id(this)](td::Result<td::Ref<ShardState>> R) {
+        if (R.is_error()) {
+          td::actor::send_closure(SelfId, &WaitBlockState::failed_to_get_prev_state,
+                                  R.move_as_error_prefix("prev state wait error: "));
+        } else {
+          td::actor::send_closure(SelfId, &WaitBlockState::got_prev_state, R.move_as_ok());
+        }
+      });
 
-    td::actor::send_closure(manager_, &ValidatorManager::wait_prev_block_state, handle_, priority_, timeout_,
-                            std::move(P));
+      td::actor::send_closure(manager_, &ValidatorManager::wait_prev_block_state, handle_, priority_, timeout_,
+                              std::move(P));
+    }
+    // the previous state may take long (it can be a chain of blocks to apply), download the block meanwhile
+    bool proof_ready = !handle_->id().is_masterchain() || handle_->inited_proof();
+    if (proof_ready && (allow_download || handle_->received())) {
+      wait_block_data();
+    }
   } else if (handle_->id().is_masterchain() && !handle_->inited_proof()) {
     if (!allow_download) {
       abort_query(td::Status::Error(PSTRING() << "not monitoring shard " << handle_->id().shard_full()));
@@ -196,22 +204,31 @@ void WaitBlockState::start() {
       abort_query(td::Status::Error(PSTRING() << "not monitoring shard " << handle_->id().shard_full()));
       return;
     }
-    auto P = td::PromiseCreator::lambda([SelfId = actor_id(this)](td::Result<td::Ref<BlockData>> R) {
-      if (R.is_error()) {
-        td::actor::send_closure(SelfId, &WaitBlockState::failed_to_get_block_data,
-                                R.move_as_error_prefix("block wait error: "));
-      } else {
-        td::actor::send_closure(SelfId, &WaitBlockState::got_block_data, R.move_as_ok());
-      }
-    });
-
-    td::actor::send_closure(manager_, &ValidatorManager::wait_block_data, handle_, priority_, timeout_, std::move(P));
+    wait_block_data();
   } else {
     apply();
   }
 }
 
+void WaitBlockState::wait_block_data() {
+  if (waiting_block_data_ || block_.not_null()) {
+    return;
+  }
+  waiting_block_data_ = true;
+  auto P = td::PromiseCreator::lambda([SelfId = actor_id(this)](td::Result<td::Ref<BlockData>> R) {
+    if (R.is_error()) {
+      td::actor::send_closure(SelfId, &WaitBlockState::failed_to_get_block_data,
+                              R.move_as_error_prefix("block wait error: "));
+    } else {
+      td::actor::send_closure(SelfId, &WaitBlockState::got_block_data, R.move_as_ok());
+    }
+  });
+
+  td::actor::send_closure(manager_, &ValidatorManager::wait_block_data, handle_, priority_, timeout_, std::move(P));
+}
+
 void WaitBlockState::failed_to_get_prev_state(td::Status reason) {
+  waiting_prev_state_ = false;
   if (reason.code() == ErrorCode::notready) {
     start();
   } else {
@@ -220,6 +237,7 @@ void WaitBlockState::failed_to_get_prev_state(td::Status reason) {
 }
 
 void WaitBlockState::got_prev_state(td::Ref<ShardState> state) {
+  waiting_prev_state_ = false;
   prev_state_ = std::move(state);
 
   start();
@@ -266,6 +284,7 @@ void WaitBlockState::got_proof(td::BufferSlice data) {
 }
 
 void WaitBlockState::failed_to_get_block_data(td::Status reason) {
+  waiting_block_data_ = false;
   if (reason.code() == ErrorCode::notready) {
     start();
   } else {
@@ -274,7 +293,11 @@ void WaitBlockState::failed_to_get_block_data(td::Status reason) {
 }
 
 void WaitBlockState::got_block_data(td::Ref<BlockData> data) {
+  waiting_block_data_ = false;
   block_ = std::move(data);
+  if (prev_state_.is_null() && waiting_prev_state_) {
+    return;
+  }
 
   start();
 }
@@ -293,8 +316,12 @@ void WaitBlockState::apply() {
     return;
   }
   TD_PERF_COUNTER(apply_block_to_state);
-  td::PerfWarningTimer t{"applyblocktostate", 0.1};
+  td::PerfWarningTimer t{"applyblocktostate", 0.1, [manager = manager_](double duration) {
+                           td::actor::send_closure(manager, &ValidatorManager::add_perf_timer_stat,
+                                                   "applyblocktostate", duration);
+                         }};
   auto S = prev_state_.write().apply_block(handle_->id(), block_);
+  t.reset();
   if (S.is_error()) {
     abort_query(S.move_as_error_prefix("apply error: "));
     return;
@@ -57,6 +57,7 @@ class WaitBlockState : public td::actor::Actor {
   void got_state_from_static_file(td::Ref<ShardState> state, td::BufferSlice data);
   void got_prev_state(td::Ref<ShardState> state);
   void failed_to_get_prev_state(td::Status reason);
+  void wait_block_data();
   void got_block_data(td::Ref<BlockData> data);
   void failed_to_get_block_data(td::Status reason);
   void got_state_from_net(td::BufferSlice data);
@@ -108,6 +109,9 @@ class WaitBlockState : public td::actor::Actor {
   bool reading_from_db_ = false;
   bool waiting_proof_link_ = false;
   bool waiting_proof_ = false;
+  // block data is requested while the previous state is still being prepared
+  bool waiting_prev_state_ = false;
+  bool waiting_block_data_ = false;
   td::Timestamp next_static_file_attempt_;
 
   td::PerfWarningTimer perf_timer_{"waitstate", 1.0};
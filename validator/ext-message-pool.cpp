@@ -0,0 +1,204 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "ext-message-pool.hpp"
+#include "ton/ton-shard.h"
+#include "td/utils/Random.h"
+#include "td/utils/Span.h"
+#include "td/utils/format.h"
+#include "td/utils/misc.h"
+
+#include <cmath>
+
+namespace ton::validator {
+
+bool ExtMessagePool::Entry::is_active() {
+  if (!active && reactivate_at.is_in_past()) {
+    active = true;
+    generation++;
+  }
+  return active;
+}
+
+bool ExtMessagePool::add_message(td::Ref<ExtMessage> message, int priority) {
+  auto hash = message->hash();
+  auto address = std::make_pair(message->wc(), message->addr());
+  auto level_it = levels_.find(priority);
+  if (level_it != levels_.end()) {
+    auto it = level_it->second.address_count.find(address);
+    if (it != level_it->second.address_count.end() && it->second >= kPerAddressLimit) {
+      ++total_dropped_;
+      return false;
+    }
+  }
+  auto old = entries_.find(hash);
+  if (old != entries_.end()) {
+    if (old->second.priority >= priority) {
+      return false;
+    }
+    erase_entry(old);
+  }
+  // the level is created only for an accepted message: erase_entry drops levels once they become empty
+  auto &level = levels_[priority];
+  double now = td::Time::now();
+  td::uint64 seq = next_seq_++;
+  auto &entry = entries_[hash];
+  entry.message = message;
+  entry.priority = priority;
+  entry.seq = seq;
+  entry.added_at = now;
+  level.queues[AddressKey{message->shard(), message->addr()}].emplace(seq, &entry);
+  level.address_count[address]++;
+  level.size++;
+  auto slot = static_cast<td::int64>(std::ceil((now + kMessageTtl) / kWheelSlot));
+  expire_wheel_[slot].emplace_back(hash, seq);
+  ++total_added_;
+  return true;
+}
+
+void ExtMessagePool::erase_entry(std::map<ExtMessage::Hash, Entry>::iterator it) {
+  auto &entry = it->second;
+  auto level_it = levels_.find(entry.priority);
+  CHECK(level_it != levels_.end());
+  auto &level = level_it->second;
+  auto queue_it = level.queues.find(AddressKey{entry.message->shard(), entry.message->addr()});
+  CHECK(queue_it != level.queues.end());
+  queue_it->second.erase(entry.seq);
+  if (queue_it->second.empty()) {
+    level.queues.erase(queue_it);
+  }
+  auto count_it = level.address_count.find(std::make_pair(entry.message->wc(), entry.message->addr()));
+  CHECK(count_it != level.address_count.end());
+  if (--count_it->second == 0) {
+    level.address_count.erase(count_it);
+  }
+  if (--level.size == 0) {
+    levels_.erase(level_it);
+  }
+  entries_.erase(it);
+}
+
+std::vector<std::pair<td::Ref<ExtMessage>, int>> ExtMessagePool::get_messages(ShardIdFull shard, size_t &processed) {
+  std::vector<std::pair<td::Ref<ExtMessage>, int>> res;
+  AddressKey left{AccountIdPrefixFull{shard.workchain, shard.shard & (shard.shard - 1)}, StdSmcAddress::zero()};
+  td::Random::Fast rnd;
+  using Cursor = std::pair<std::map<td::uint64, Entry *>::iterator, std::map<td::uint64, Entry *>::iterator>;
+  std::vector<Cursor> cursors;
+  for (auto &[priority, level] : levels_) {
+    cursors.clear();
+    for (auto it = level.queues.lower_bound(left); it != level.queues.end() && shard_contains(shard, it->first.first);
+         ++it) {
+      cursors.emplace_back(it->second.begin(), it->second.end());
+    }
+    // one message per address in each round, addresses in random order
+    td::random_shuffle(td::as_mutable_span(cursors), rnd);
+    while (!cursors.empty()) {
+      size_t j = 0;
+      for (size_t i = 0; i < cursors.size(); ++i) {
+        auto &[cur, end] = cursors[i];
+        while (cur != end && !cur->second->is_active()) {
+          ++processed;
+          ++cur;
+        }
+        if (cur == end) {
+          continue;
+        }
+        ++processed;
+        res.emplace_back(cur->second->message, priority);
+        ++cur;
+        cursors[j++] = cursors[i];
+      }
+      cursors.resize(j);
+    }
+  }
+  return res;
+}
+
+void ExtMessagePool::erase_message(const ExtMessage::Hash &hash) {
+  auto it = entries_.find(hash);
+  if (it != entries_.end()) {
+    erase_entry(it);
+  }
+}
+
+void ExtMessagePool::delay_message(const ExtMessage::Hash &hash, size_t soft_limit) {
+  auto it = entries_.find(hash);
+  if (it == entries_.end()) {
+    return;
+  }
+  auto &entry = it->second;
+  if (size(entry.priority) < soft_limit && entry.generation <= 2) {
+    if (entry.active) {
+      entry.active = false;
+      entry.reactivate_at = td::Timestamp::in(entry.generation * 5.0);
+    }
+  } else {
+    ++total_dropped_;
+    erase_entry(it);
+  }
+}
+
+size_t ExtMessagePool::expire() {
+  auto last_slot = static_cast<td::int64>(std::floor(td::Time::now() / kWheelSlot));
+  size_t expired = 0;
+  while (!expire_wheel_.empty() && expire_wheel_.begin()->first <= last_slot) {
+    for (auto &[hash, seq] : expire_wheel_.begin()->second) {
+      auto it = entries_.find(hash);
+      // the message could have been removed or re-added with a higher priority since
+      if (it != entries_.end() && it->second.seq == seq) {
+        erase_entry(it);
+        ++expired;
+      }
+    }
+    expire_wheel_.erase(expire_wheel_.begin());
+  }
+  total_expired_ += expired;
+  return expired;
+}
+
+void ExtMessagePool::prepare_stats(std::vector<std::pair<std::string, std::string>> &vec) const {
+  td::StringBuilder sb;
+  sb << "total:" << entries_.size();
+  for (auto &[priority, level] : levels_) {
+    sb << " priority" << priority << ":" << level.size << "(addrs:" << level.address_count.size() << ")";
+  }
+  vec.emplace_back("ext_msg_pool.size", sb.as_cslice().str());
+
+  static constexpr double kAgeBuckets[] = {10.0, 60.0, 300.0};
+  size_t age_count[std::size(kAgeBuckets) + 1] = {};
+  size_t postponed = 0;
+  double now = td::Time::now(), max_age = 0.0;
+  for (auto &[_, entry] : entries_) {
+    double age = now - entry.added_at;
+    max_age = std::max(max_age, age);
+    size_t i = 0;
+    while (i < std::size(kAgeBuckets) && age >= kAgeBuckets[i]) {
+      ++i;
+    }
+    ++age_count[i];
+    if (!entry.active) {
+      ++postponed;
+    }
+  }
+  vec.emplace_back("ext_msg_pool.age", PSTRING() << "<10s:" << age_count[0] << " <60s:" << age_count[1]
+                                                  << " <300s:" << age_count[2] << " >=300s:" << age_count[3]
+                                                  << " max:" << td::format::as_time(max_age));
+  vec.emplace_back("ext_msg_pool.postponed", td::to_string(postponed));
+  vec.emplace_back("ext_msg_pool.total", PSTRING() << "added:" << total_added_ << " expired:" << total_expired_
+                                                    << " dropped:" << total_dropped_);
+}
+
+}  // namespace ton::validator
@@ -0,0 +1,96 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "interfaces/external-message.h"
+#include "td/utils/Time.h"
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace ton::validator {
+
+/**
+ * Mempool of external messages waiting for collation.
+ *
+ * Messages are grouped by priority, then by destination (ordered by account prefix, so the messages of a shard
+ * form a contiguous range found with a single lower_bound), and kept in arrival order for each address.
+ * Collation takes messages round-robin over the addresses of the shard, highest priority first.
+ * Expired messages are dropped through a wheel of TTL slots, so expiration never scans the whole pool.
+ */
+class ExtMessagePool {
+ public:
+  static constexpr double kMessageTtl = 600.0;
+  static constexpr size_t kPerAddressLimit = 256;
+
+  // returns false if the message was not added
+  bool add_message(td::Ref<ExtMessage> message, int priority);
+  std::vector<std::pair<td::Ref<ExtMessage>, int>> get_messages(ShardIdFull shard, size_t &processed);
+  void erase_message(const ExtMessage::Hash &hash);
+  // postpones the message, or drops it if it was already postponed too many times or the pool is too large
+  void delay_message(const ExtMessage::Hash &hash, size_t soft_limit);
+  // drops all expired messages, returns their number
+  size_t expire();
+
+  size_t size() const {
+    return entries_.size();
+  }
+  size_t size(int priority) const {
+    auto it = levels_.find(priority);
+    return it == levels_.end() ? 0 : it->second.size;
+  }
+
+  void prepare_stats(std::vector<std::pair<std::string, std::string>> &vec) const;
+
+ private:
+  static constexpr double kWheelSlot = 10.0;
+
+  using AddressKey = std::pair<AccountIdPrefixFull, StdSmcAddress>;
+
+  struct Entry {
+    td::Ref<ExtMessage> message;
+    int priority;
+    td::uint64 seq;
+    double added_at;
+    td::uint32 generation = 0;
+    bool active = true;
+    td::Timestamp reactivate_at;
+
+    bool is_active();
+  };
+
+  struct Level {
+    // destination -> messages in arrival order
+    std::map<AddressKey, std::map<td::uint64, Entry *>> queues;
+    // the per-address limit ignores anycast rewrites of the destination
+    std::map<std::pair<WorkchainId, StdSmcAddress>, size_t> address_count;
+    size_t size = 0;
+  };
+
+  void erase_entry(std::map<ExtMessage::Hash, Entry>::iterator it);
+
+  std::map<ExtMessage::Hash, Entry> entries_;
+  std::map<int, Level, std::greater<int>> levels_;
+  // slot -> (hash, seq) of the messages that expire before the end of the slot
+  std::map<td::int64, std::vector<std::pair<ExtMessage::Hash, td::uint64>>> expire_wheel_;
+  td::uint64 next_seq_ = 0;
+  td::uint64 total_added_ = 0, total_expired_ = 0, total_dropped_ = 0;
+};
+
+}  // namespace ton::validator
@@ -0,0 +1,83 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "full-node-broadcast-dedup.hpp"
+#include "td/utils/Time.h"
+#include "common/checksum.h"
+#include "tl-utils/tl-utils.hpp"
+
+namespace ton::validator::fullnode {
+
+BlockBroadcastDedup &BlockBroadcastDedup::instance() {
+  static BlockBroadcastDedup dedup;
+  return dedup;
+}
+
+bool BlockBroadcastDedup::try_start(const BlockIdExt &block_id, const td::Bits256 &payload_hash, size_t size) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  double now = td::Time::now();
+  cleanup(now);
+  auto [it, inserted] = blocks_.try_emplace(block_id);
+  if (inserted) {
+    added_at_.emplace_back(now, block_id);
+  }
+  if (it->second.accepted || !it->second.in_flight.insert(payload_hash).second) {
+    duplicates_.inc();
+    duplicate_bytes_.add(static_cast<td::int64>(size));
+    return false;
+  }
+  return true;
+}
+
+void BlockBroadcastDedup::finish(const BlockIdExt &block_id, const td::Bits256 &payload_hash, bool accepted) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  auto it = blocks_.find(block_id);
+  if (it == blocks_.end()) {
+    return;
+  }
+  it->second.in_flight.erase(payload_hash);
+  if (accepted) {
+    it->second.accepted = true;
+  }
+}
+
+void BlockBroadcastDedup::cleanup(double now) {
+  while (!added_at_.empty() && (added_at_.front().first < now - kKeepTime || added_at_.size() > kMaxSize)) {
+    blocks_.erase(added_at_.front().second);
+    added_at_.pop_front();
+  }
+}
+
+td::Result<BlockBroadcast> deserialize_new_block_broadcast(ton_api::tonNode_Broadcast &obj,
+                                                           int max_decompressed_data_size,
+                                                           td::Ref<vm::Cell> &data_root, td::Bits256 &payload_hash) {
+  BlockIdExt block_id;
+  size_t size = 0;
+  TRY_STATUS(get_block_broadcast_info(obj, block_id, size));
+  // signatures are part of the payload: a copy with forged signatures is a different payload
+  payload_hash = td::sha256_bits256(serialize_tl_object(&obj, true));
+  auto &dedup = BlockBroadcastDedup::instance();
+  if (!dedup.try_start(block_id, payload_hash, size)) {
+    return td::Status::Error(PSTRING() << "duplicate broadcast of block " << block_id.to_str());
+  }
+  auto B = deserialize_block_broadcast(obj, max_decompressed_data_size, &data_root);
+  if (B.is_error()) {
+    dedup.finish(block_id, payload_hash, false);
+  }
+  return B;
+}
+
+}  // namespace ton::validator::fullnode
@@ -0,0 +1,72 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "full-node-serializer.hpp"
+#include "td/utils/ThreadSafeCounter.h"
+
+#include <deque>
+#include <map>
+#include <mutex>
+#include <set>
+
+namespace ton::validator::fullnode {
+
+/**
+ * Process-wide filter of block broadcasts, shared by the public shard overlays, fast sync overlays and private and
+ * custom overlays. The same block arrives from many peers and overlays; only the first copy is decompressed and
+ * validated.
+ * The block id in the broadcast header is not authenticated, so copies in flight are told apart by the hash of the
+ * payload: a forged copy does not hold back a genuine one with the same block id. A block id is marked as seen only
+ * once a copy passes validation (and its signatures); after that all its broadcasts are dropped.
+ */
+class BlockBroadcastDedup {
+ public:
+  static BlockBroadcastDedup &instance();
+
+  // returns false if the block was accepted or this payload is already being processed
+  bool try_start(const BlockIdExt &block_id, const td::Bits256 &payload_hash, size_t size);
+  void finish(const BlockIdExt &block_id, const td::Bits256 &payload_hash, bool accepted);
+
+ private:
+  static constexpr double kKeepTime = 600.0;
+  static constexpr size_t kMaxSize = 1 << 14;
+
+  struct Block {
+    bool accepted = false;
+    std::set<td::Bits256> in_flight;  // payload hashes
+  };
+
+  void cleanup(double now);
+
+  std::mutex mutex_;
+  std::map<BlockIdExt, Block> blocks_;
+  std::deque<std::pair<double, BlockIdExt>> added_at_;
+
+  td::NamedThreadSafeCounter::CounterRef duplicates_ =
+      td::NamedThreadSafeCounter::get_default().get_counter("fullnode.block_broadcast.duplicates");
+  td::NamedThreadSafeCounter::CounterRef duplicate_bytes_ =
+      td::NamedThreadSafeCounter::get_default().get_counter("fullnode.block_broadcast.duplicate_bytes");
+};
+
+// Deserializes a block broadcast unless it is a duplicate; data_root is set as in deserialize_block_broadcast,
+// payload_hash is to be passed to BlockBroadcastDedup::finish
+td::Result<BlockBroadcast> deserialize_new_block_broadcast(ton_api::tonNode_Broadcast &obj,
+                                                           int max_decompressed_data_size,
+                                                           td::Ref<vm::Cell> &data_root, td::Bits256 &payload_hash);
+
+}  // namespace ton::validator::fullnode
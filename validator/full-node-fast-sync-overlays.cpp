@@ -24,6 +24,7 @@
 #include "tl/tl_json.h"
 #include "auto/tl/ton_api_json.h"
 #include "full-node-serializer.hpp"
+#include "full-node-broadcast-dedup.hpp"
 
 namespace ton::validator::fullnode {
 
@@ -40,14 +41,18 @@ void FullNodeFastSyncOverlay::process_broadcast(PublicKeyHash src, ton_api::tonN
 }
 
 void FullNodeFastSyncOverlay::process_block_broadcast(PublicKeyHash src, ton_api::tonNode_Broadcast &query) {
-  auto B = deserialize_block_broadcast(query, overlay::Overlays::max_fec_broadcast_size());
+  td::Ref<vm::Cell> data_root;
+  td::Bits256 payload_hash;
+  auto B = deserialize_new_block_broadcast(query, overlay::Overlays::max_fec_broadcast_size(), data_root,
+                                           payload_hash);
   if (B.is_error()) {
     LOG(DEBUG) << "dropped broadcast: " << B.move_as_error();
     return;
   }
   VLOG(FULL_NODE_DEBUG) << "Received block broadcast in fast sync overlay from " << src << ": "
                         << B.ok().block_id.to_str();
-  td::actor::send_closure(full_node_, &FullNode::process_block_broadcast, B.move_as_ok());
+  td::actor::send_closure(full_node_, &FullNode::process_block_broadcast, B.move_as_ok(),
+                          std::move(data_root), payload_hash);
 }
 
 void FullNodeFastSyncOverlay::process_broadcast(PublicKeyHash src, ton_api::tonNode_outMsgQueueProofBroadcast &query) {
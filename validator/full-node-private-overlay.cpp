@@ -19,6 +19,7 @@
 #include "common/delay.h"
 #include "common/checksum.h"
 #include "full-node-serializer.hpp"
+#include "full-node-broadcast-dedup.hpp"
 #include "auto/tl/ton_api_json.h"
 #include "td/utils/JsonBuilder.h"
 #include "tl/tl_json.h"
@@ -40,14 +41,18 @@ void FullNodePrivateBlockOverlay::process_broadcast(PublicKeyHash src,
 }
 
 void FullNodePrivateBlockOverlay::process_block_broadcast(PublicKeyHash src, ton_api::tonNode_Broadcast &query) {
-  auto B = deserialize_block_broadcast(query, overlay::Overlays::max_fec_broadcast_size());
+  td::Ref<vm::Cell> data_root;
+  td::Bits256 payload_hash;
+  auto B = deserialize_new_block_broadcast(query, overlay::Overlays::max_fec_broadcast_size(), data_root,
+                                           payload_hash);
   if (B.is_error()) {
     LOG(DEBUG) << "dropped broadcast: " << B.move_as_error();
     return;
   }
   VLOG(FULL_NODE_DEBUG) << "Received block broadcast in private overlay from " << src << ": "
                         << B.ok().block_id.to_str();
-  td::actor::send_closure(full_node_, &FullNode::process_block_broadcast, B.move_as_ok());
+  td::actor::send_closure(full_node_, &FullNode::process_block_broadcast, B.move_as_ok(),
+                          std::move(data_root), payload_hash);
 }
 
 void FullNodePrivateBlockOverlay::process_broadcast(PublicKeyHash src, ton_api::tonNode_newShardBlockBroadcast &query) {
@@ -322,14 +327,18 @@ void FullNodeCustomOverlay::process_block_broadcast(PublicKeyHash src, ton_api::
                           << src;
     return;
   }
-  auto B = deserialize_block_broadcast(query, overlay::Overlays::max_fec_broadcast_size());
+  td::Ref<vm::Cell> data_root;
+  td::Bits256 payload_hash;
+  auto B = deserialize_new_block_broadcast(query, overlay::Overlays::max_fec_broadcast_size(), data_root,
+                                           payload_hash);
   if (B.is_error()) {
     LOG(DEBUG) << "dropped broadcast: " << B.move_as_error();
     return;
   }
   VLOG(FULL_NODE_DEBUG) << "Received block broadcast in custom overlay \"" << name_ << "\" from " << src << ": "
                         << B.ok().block_id.to_str();
-  td::actor::send_closure(full_node_, &FullNode::process_block_broadcast, B.move_as_ok());
+  td::actor::send_closure(full_node_, &FullNode::process_block_broadcast, B.move_as_ok(),
+                          std::move(data_root), payload_hash);
 }
 
 void FullNodeCustomOverlay::process_broadcast(PublicKeyHash src, ton_api::tonNode_externalMessageBroadcast &query) {
@@ -66,7 +66,8 @@ static td::Result<BlockBroadcast> deserialize_block_broadcast(ton_api::tonNode_b
 }
 
 static td::Result<BlockBroadcast> deserialize_block_broadcast(ton_api::tonNode_blockBroadcastCompressed& f,
-                                                              int max_decompressed_size) {
+                                                              int max_decompressed_size,
+                                                              td::Ref<vm::Cell>* data_root) {
   TRY_RESULT(decompressed, td::lz4_decompress(f.compressed_, max_decompressed_size));
   TRY_RESULT(f2, fetch_tl_object<ton_api::tonNode_blockBroadcastCompressed_data>(decompressed, true));
   std::vector<BlockSignature> signatures;
@@ -81,6 +82,9 @@ static td::Result<BlockBroadcast> deserialize_block_broadcast(ton_api::tonNode_b
   TRY_RESULT(data, vm::std_boc_serialize(roots[1], 31));
   VLOG(FULL_NODE_DEBUG) << "Decompressing block broadcast: " << f.compressed_.size() << " -> "
                         << data.size() + proof.size() + signatures.size() * 96;
+  if (data_root) {
+    *data_root = std::move(roots[1]);
+  }
   return BlockBroadcast{create_block_id(f.id_),
                         std::move(signatures),
                         static_cast<UnixTime>(f.catchain_seqno_),
@@ -90,7 +94,8 @@ static td::Result<BlockBroadcast> deserialize_block_broadcast(ton_api::tonNode_b
 }
 
 static td::Result<BlockBroadcast> deserialize_block_broadcast(ton_api::tonNode_blockBroadcastCompressedV2& f,
-                                                              int max_decompressed_size) {
+                                                              int max_decompressed_size,
+                                                              td::Ref<vm::Cell>* data_root) {
   std::vector<BlockSignature> signatures;
   for (auto& sig : f.signatures_) {
     signatures.emplace_back(BlockSignature{sig->who_, std::move(sig->signature_)});
@@ -103,6 +108,9 @@ static td::Result<BlockBroadcast> deserialize_block_broadcast(ton_api::tonNode_b
   TRY_RESULT(data, vm::std_boc_serialize(roots[1], 31));
   VLOG(FULL_NODE_DEBUG) << "Decompressing block broadcast: " << f.compressed_.size() << " -> "
                         << data.size() + proof.size() + signatures.size() * 96;
+  if (data_root) {
+    *data_root = std::move(roots[1]);
+  }
   return BlockBroadcast{create_block_id(f.id_),
                         std::move(signatures),
                         static_cast<UnixTime>(f.catchain_seqno_),
@@ -111,21 +119,40 @@ static td::Result<BlockBroadcast> deserialize_block_broadcast(ton_api::tonNode_b
                         std::move(proof)};
 }
 
-td::Result<BlockBroadcast> deserialize_block_broadcast(ton_api::tonNode_Broadcast& obj,
-                                                       int max_decompressed_data_size) {
+td::Result<BlockBroadcast> deserialize_block_broadcast(ton_api::tonNode_Broadcast& obj, int max_decompressed_data_size,
+                                                       td::Ref<vm::Cell>* data_root) {
   td::Result<BlockBroadcast> B;
   ton_api::downcast_call(obj,
                          td::overloaded([&](ton_api::tonNode_blockBroadcast& f) { B = deserialize_block_broadcast(f); },
                                         [&](ton_api::tonNode_blockBroadcastCompressed& f) {
-                                          B = deserialize_block_broadcast(f, max_decompressed_data_size);
+                                          B = deserialize_block_broadcast(f, max_decompressed_data_size, data_root);
                                         },
                                         [&](ton_api::tonNode_blockBroadcastCompressedV2& f) {
-                                          B = deserialize_block_broadcast(f, max_decompressed_data_size);
+                                          B = deserialize_block_broadcast(f, max_decompressed_data_size, data_root);
                                         },
                                         [&](auto&) { B = td::Status::Error("unknown broadcast type"); }));
   return B;
 }
 
+td::Status get_block_broadcast_info(ton_api::tonNode_Broadcast& obj, BlockIdExt& block_id, size_t& size) {
+  td::Status S;
+  ton_api::downcast_call(obj, td::overloaded(
+                                  [&](ton_api::tonNode_blockBroadcast& f) {
+                                    block_id = create_block_id(f.id_);
+                                    size = f.data_.size() + f.proof_.size();
+                                  },
+                                  [&](ton_api::tonNode_blockBroadcastCompressed& f) {
+                                    block_id = create_block_id(f.id_);
+                                    size = f.compressed_.size();
+                                  },
+                                  [&](ton_api::tonNode_blockBroadcastCompressedV2& f) {
+                                    block_id = create_block_id(f.id_);
+                                    size = f.compressed_.size();
+                                  },
+                                  [&](auto&) { S = td::Status::Error("unknown broadcast type"); }));
+  return S;
+}
+
 td::Result<td::BufferSlice> serialize_block_full(const BlockIdExt& id, td::Slice proof, td::Slice data,
                                                  bool is_proof_link, bool compression_enabled) {
   if (!compression_enabled) {
@@ -17,11 +17,16 @@
 #pragma once
 #include "ton/ton-types.h"
 #include "auto/tl/ton_api.h"
+#include "vm/cells/Cell.h"
 
 namespace ton::validator::fullnode {
 
 td::Result<td::BufferSlice> serialize_block_broadcast(const BlockBroadcast& broadcast, bool compression_enabled);
-td::Result<BlockBroadcast> deserialize_block_broadcast(ton_api::tonNode_Broadcast& obj, int max_decompressed_data_size);
+// data_root, if not null, receives the root of the block data when it was decompressed from a cell tree
+td::Result<BlockBroadcast> deserialize_block_broadcast(ton_api::tonNode_Broadcast& obj, int max_decompressed_data_size,
+                                                       td::Ref<vm::Cell>* data_root = nullptr);
+// block id and the size of the payload, without decompressing it
+td::Status get_block_broadcast_info(ton_api::tonNode_Broadcast& obj, BlockIdExt& block_id, size_t& size);
 
 td::Result<td::BufferSlice> serialize_block_full(const BlockIdExt& id, td::Slice proof, td::Slice data,
                                                  bool is_proof_link, bool compression_enabled);
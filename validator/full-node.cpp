@@ -22,6 +22,7 @@
 #include "full-node.h"
 #include "common/delay.h"
 #include "impl/out-msg-queue-proof.hpp"
+#include "full-node-broadcast-dedup.hpp"
 #include "td/utils/Random.h"
 #include "ton/ton-tl.hpp"
 
@@ -625,10 +626,14 @@ void FullNodeImpl::new_key_block(BlockHandle handle) {
   }
 }
 
-void FullNodeImpl::process_block_broadcast(BlockBroadcast broadcast) {
+void FullNodeImpl::process_block_broadcast(BlockBroadcast broadcast, td::Ref<vm::Cell> data_root,
+                                           td::Bits256 payload_hash) {
   send_block_broadcast_to_custom_overlays(broadcast);
+  BlockIdExt block_id = broadcast.block_id;
   td::actor::send_closure(validator_manager_, &ValidatorManagerInterface::new_block_broadcast, std::move(broadcast),
-                          [](td::Result<td::Unit> R) {
+                          std::move(data_root), [block_id, payload_hash](td::Result<td::Unit> R) {
+                            // the block is marked as seen only after its signatures were checked
+                            BlockBroadcastDedup::instance().finish(block_id, payload_hash, R.is_ok());
                             if (R.is_error()) {
                               if (R.error().code() == ErrorCode::notready) {
                                 LOG(DEBUG) << "dropped broadcast: " << R.move_as_error();
@@ -75,5 +75,14 @@ td::Result<td::Ref<BlockQ>> BlockQ::create(BlockIdExt id, td::BufferSlice data)
   }
 }
 
+td::Result<td::Ref<BlockQ>> BlockQ::create(BlockIdExt id, td::BufferSlice data, td::Ref<vm::Cell> root) {
+  if (root.is_null()) {
+    return create(id, std::move(data));
+  }
+  td::Ref<BlockQ> res{true, id, std::move(data)};
+  res.unique_write().root_ = std::move(root);
+  return std::move(res);
+}
+
 }  // namespace validator
 }  // namespace ton
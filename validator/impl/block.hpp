@@ -55,6 +55,7 @@ class BlockQ : public BlockData {
     return new BlockQ(*this);
   }
   static td::Result<td::Ref<BlockQ>> create(BlockIdExt id, td::BufferSlice data);
+  static td::Result<td::Ref<BlockQ>> create(BlockIdExt id, td::BufferSlice data, td::Ref<vm::Cell> root);
 };
 
 }  // namespace validator
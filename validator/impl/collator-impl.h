@@ -139,7 +139,7 @@ class Collator final : public td::actor::Actor {
   Ref<vm::Cell> mc_state_root;
   Ref<vm::Cell> mc_block_root;
   td::BitArray<256> rand_seed_ = td::Bits256::zero();
-  std::unique_ptr<block::ConfigInfo> config_;
+  std::shared_ptr<const block::ConfigInfo> config_;
   std::unique_ptr<block::ShardConfig> shard_conf_;
   std::map<BlockSeqno, Ref<MasterchainStateQ>> aux_mc_states_;
   std::map<ShardIdFull, td::int32> neighbor_msg_queues_limits_;
@@ -255,7 +255,8 @@ class Collator final : public td::actor::Actor {
   bool store_out_msg_queue_size_ = false;
 
   std::function<td::Ref<vm::Cell>(const td::Bits256&)> storage_stat_cache_;
-  std::vector<std::pair<td::Ref<vm::Cell>, td::uint32>> storage_stat_cache_update_;
+  std::vector<StorageStatCacheUpdate> storage_stat_cache_update_;
+  std::shared_ptr<vm::CellDbReader> cell_db_reader_;
 
   td::PerfWarningTimer perf_timer_;
   td::PerfLog perf_log_;
@@ -281,6 +282,7 @@ class Collator final : public td::actor::Actor {
   void after_get_shard_blocks(td::Result<std::vector<Ref<ShardTopBlockDescription>>> res, td::PerfLogAction token);
   void after_get_storage_stat_cache(td::Result<std::function<td::Ref<vm::Cell>(const td::Bits256&)>> res,
                                     td::PerfLogAction token);
+  void after_get_cell_db_reader(td::Result<std::shared_ptr<vm::CellDbReader>> res, td::PerfLogAction token);
   void after_get_shard_state_optimistic(td::Result<Ref<ShardState>> res, td::PerfLogAction token);
   bool preprocess_prev_mc_state();
   bool register_mc_state(Ref<MasterchainStateQ> other_mc_state);
@@ -286,7 +286,18 @@ void Collator::start_up() {
                                                                 &Collator::after_get_storage_stat_cache, std::move(res),
                                                                 std::move(token));
                                 });
-  // 7. set timeout
+  // 7. get cell db reader for prefetching neighbors' output queues
+  ++pending;
+  LOG(DEBUG) << "sending get_cell_db_reader() query to Manager";
+  td::actor::send_closure_later(
+      manager, &ValidatorManager::get_cell_db_reader,
+      [self = get_self(), token = perf_log_.start_action("get_cell_db_reader")](
+          td::Result<std::shared_ptr<vm::CellDbReader>> res) mutable {
+        LOG(DEBUG) << "got answer to get_cell_db_reader() query";
+        td::actor::send_closure_later(std::move(self), &Collator::after_get_cell_db_reader, std::move(res),
+                                      std::move(token));
+      });
+  // 8. set timeout
   alarm_timestamp() = timeout;
   CHECK(pending);
 }
@@ -824,6 +835,23 @@ void Collator::after_get_storage_stat_cache(td::Result<std::function<td::Ref<vm:
   check_pending();
 }
 
+/**
+ * Callback function called after retrieving the cell db reader.
+ * The collator works without it, only neighbors' output queues are not prefetched then.
+ *
+ * @param res The retrieved cell db reader.
+ */
+void Collator::after_get_cell_db_reader(td::Result<std::shared_ptr<vm::CellDbReader>> res, td::PerfLogAction token) {
+  --pending;
+  token.finish(res);
+  if (res.is_error()) {
+    LOG(INFO) << "after_get_cell_db_reader : " << res.error();
+  } else {
+    cell_db_reader_ = res.move_as_ok();
+  }
+  check_pending();
+}
+
 /**
  * Callback function called after retrieving previous state for optimistic prev block
  *
@@ -855,7 +883,7 @@ void Collator::after_get_shard_state_optimistic(td::Result<Ref<ShardState>> res,
  * @returns True if the unpacking and initialization is successful, false otherwise.
  */
 bool Collator::unpack_last_mc_state() {
-  auto res = block::ConfigInfo::extract_config(
+  auto res = block::ConfigInfo::extract_config_cached(
       mc_state_root, mc_block_id_,
       block::ConfigInfo::needShardHashes | block::ConfigInfo::needLibraries | block::ConfigInfo::needValidatorSet |
           block::ConfigInfo::needWorkchainInfo | block::ConfigInfo::needCapabilities |
@@ -2261,6 +2289,7 @@ bool Collator::fetch_config_params() {
     return fatal_error(res.move_as_error());
   }
   compute_phase_cfg_.libraries = std::make_unique<vm::Dictionary>(config_->get_libraries_root(), 256);
+  compute_phase_cfg_.lazy_cell_hashes = true;
   defer_out_queue_size_limit_ = std::max<td::uint64>(collator_opts_->defer_out_queue_size_limit,
                                                      compute_phase_cfg_.size_limits.defer_out_queue_size_limit);
   // This one is checked in validate-query
@@ -2332,7 +2361,7 @@ bool Collator::create_output_queue_merger() {
     td::int32 msg_limit = it == neighbor_msg_queues_limits_.end() ? -1 : it->second;
     neighbor_queues.emplace_back(descr.top_block_id(), descr.outmsg_root, descr.disabled_, msg_limit);
   }
-  nb_out_msgs_ = std::make_unique<block::OutputQueueMerger>(shard_, neighbor_queues);
+  nb_out_msgs_ = std::make_unique<block::OutputQueueMerger>(shard_, neighbor_queues, cell_db_reader_);
   return true;
 }
 
@@ -2786,7 +2815,8 @@ bool Collator::init_account_storage_dict(block::Account& account) {
     CHECK(td::Bits256{cached_dict_root->get_hash().bits()} == storage_dict_hash);
     LOG(DEBUG) << "Inited storage stat from cache for account " << account.addr.to_hex() << " ("
                << account.storage_used.cells << " cells)";
-    storage_stat_cache_update_.emplace_back(cached_dict_root, account.storage_used.cells);
+    storage_stat_cache_update_.push_back(
+        {account.workchain, account.addr, cached_dict_root, account.storage_used.cells});
     stats_.storage_stat_cache.hit_cnt++;
     stats_.storage_stat_cache.hit_cells += account.storage_used.cells;
   } else if (account.storage_used.cells >= StorageStatCache::MIN_ACCOUNT_CELLS) {
@@ -2816,7 +2846,11 @@ bool Collator::init_account_storage_dict(block::Account& account) {
     } else {
       // don't mark cells in account state as loaded during compute_account_storage_dict
       state_usage_tree_->set_ignore_loads(true);
+      td::Timer recount_timer;
       auto res = account.compute_account_storage_dict();
+      if (account.storage_used.cells >= StorageStatCache::MIN_ACCOUNT_CELLS) {
+        stats_.storage_stat_cache.collator_recount_time += recount_timer.elapsed();
+      }
       state_usage_tree_->set_ignore_loads(false);
       if (res.is_error()) {
         return fatal_error(res.move_as_error_prefix(PSTRING() << "Failed to init account storage dict for "
@@ -2968,7 +3002,7 @@ bool Collator::process_account_storage_dict(block::Account& account) {
   if (!account.orig_storage_dict_hash) {
     if (store_dict_to_cache) {
       td::Ref<vm::Cell> dict_root = account.account_storage_stat.value().get_dict_root().move_as_ok();
-      storage_stat_cache_update_.emplace_back(dict_root, account.storage_used.cells);
+      storage_stat_cache_update_.push_back({account.workchain, account.addr, dict_root, account.storage_used.cells});
     }
     return true;
   }
@@ -2977,7 +3011,7 @@ bool Collator::process_account_storage_dict(block::Account& account) {
   if (it == account_storage_dicts_.end()) {
     if (store_dict_to_cache) {
       td::Ref<vm::Cell> dict_root = account.account_storage_stat.value().get_dict_root().move_as_ok();
-      storage_stat_cache_update_.emplace_back(dict_root, account.storage_used.cells);
+      storage_stat_cache_update_.push_back({account.workchain, account.addr, dict_root, account.storage_used.cells});
     }
     return true;
   }
@@ -2987,7 +3021,7 @@ bool Collator::process_account_storage_dict(block::Account& account) {
   if (store_dict_to_cache) {
     td::Ref<vm::Cell> dict_root = account.account_storage_stat.value().get_dict_root().move_as_ok();
     dict_root = clean_usage_cells(original_dict_root, dict_root, dict.mpb.get_usage_tree());
-    storage_stat_cache_update_.emplace_back(dict_root, account.storage_used.cells);
+    storage_stat_cache_update_.push_back({account.workchain, account.addr, dict_root, account.storage_used.cells});
   }
   if (dict.add_to_collated_data) {
     LOG(DEBUG) << "Storage dict proof of account " << account.addr.to_hex() << " : already included";
@@ -3076,6 +3110,10 @@ bool Collator::process_account_storage_dict(block::Account& account) {
  */
 bool Collator::combine_account_transactions() {
   vm::AugmentedDictionary dict{256, block::tlb::aug_ShardAccountBlocks};
+  // accounts are sorted by address, so both batches are sorted as well; each dictionary is then updated
+  // by a single multiset, which rebuilds every affected fork only once
+  std::vector<std::pair<td::ConstBitPtr, Ref<vm::CellSlice>>> account_blocks, account_descrs;
+  account_blocks.reserve(accounts.size());
   for (auto& z : accounts) {
     block::Account& acc = *(z.second);
     CHECK(acc.addr == z.first);
@@ -3112,10 +3150,7 @@ bool Collator::combine_account_transactions() {
         return fatal_error(std::string{"new AccountBlock for "} + z.first.to_hex() +
                            " failed to pass handwritten validation tests");
       }
-      if (!dict.set(z.first, csr, vm::Dictionary::SetMode::Add)) {
-        return fatal_error(std::string{"new AccountBlock for "} + z.first.to_hex() +
-                           " could not be added to ShardAccountBlocks");
-      }
+      account_blocks.emplace_back(z.first.cbits(), std::move(csr));
       // update account_dict
       if (acc.total_state->get_hash() != acc.orig_total_state->get_hash()) {
         // account changed
@@ -3123,13 +3158,13 @@ bool Collator::combine_account_transactions() {
           // account created
           CHECK(acc.status != block::Account::acc_nonexist);
           vm::CellBuilder cb;
-          if (!(cb.store_ref_bool(acc.total_state)             // account_descr$_ account:^Account
-                && cb.store_bits_bool(acc.last_trans_hash_)    // last_trans_hash:bits256
-                && cb.store_long_bool(acc.last_trans_lt_, 64)  // last_trans_lt:uint64
-                && account_dict->set_builder(acc.addr, cb, vm::Dictionary::SetMode::Add))) {
+          if (!(cb.store_ref_bool(acc.total_state)                 // account_descr$_ account:^Account
+                && cb.store_bits_bool(acc.last_trans_hash_)        // last_trans_hash:bits256
+                && cb.store_long_bool(acc.last_trans_lt_, 64))) {  // last_trans_lt:uint64
             return fatal_error(std::string{"cannot add newly-created account "} + acc.addr.to_hex() +
                                " into ShardAccounts");
           }
+          account_descrs.emplace_back(acc.addr.cbits(), vm::load_cell_slice_ref(cb.finalize()));
         } else if (acc.status == block::Account::acc_nonexist) {
           // account deleted
           if (verbosity > 2) {
@@ -3138,9 +3173,7 @@ bool Collator::combine_account_transactions() {
               block::gen::t_Account.print_ref(sb, acc.total_state);
             };
           }
-          if (account_dict->lookup_delete(acc.addr).is_null()) {
-            return fatal_error(std::string{"cannot delete account "} + acc.addr.to_hex() + " from ShardAccounts");
-          }
+          account_descrs.emplace_back(acc.addr.cbits(), Ref<vm::CellSlice>{});
         } else {
           // existing account modified
           if (verbosity > 4) {
@@ -3149,13 +3182,13 @@ bool Collator::combine_account_transactions() {
               block::gen::t_Account.print_ref(sb, acc.total_state);
             };
           }
-          if (!(cb.store_ref_bool(acc.total_state)             // account_descr$_ account:^Account
-                && cb.store_bits_bool(acc.last_trans_hash_)    // last_trans_hash:bits256
-                && cb.store_long_bool(acc.last_trans_lt_, 64)  // last_trans_lt:uint64
-                && account_dict->set_builder(acc.addr, cb, vm::Dictionary::SetMode::Replace))) {
+          if (!(cb.store_ref_bool(acc.total_state)                 // account_descr$_ account:^Account
+                && cb.store_bits_bool(acc.last_trans_hash_)        // last_trans_hash:bits256
+                && cb.store_long_bool(acc.last_trans_lt_, 64))) {  // last_trans_lt:uint64
             return fatal_error(std::string{"cannot modify existing account "} + acc.addr.to_hex() +
                                " in ShardAccounts");
           }
+          account_descrs.emplace_back(acc.addr.cbits(), vm::load_cell_slice_ref(cb.finalize()));
         }
       }
       if (!process_account_storage_dict(acc)) {
@@ -3168,6 +3201,13 @@ bool Collator::combine_account_transactions() {
       }
     }
   }
+  if (!dict.multiset(account_blocks)) {
+    return fatal_error("new AccountBlocks could not be added to ShardAccountBlocks");
+  }
+  // a null value deletes the account, the deleted accounts must be present in ShardAccounts
+  if (!account_dict->multiset(account_descrs)) {
+    return fatal_error("cannot add, modify or delete accounts in ShardAccounts");
+  }
   vm::CellBuilder cb;
   if (!(cb.append_cellslice_bool(std::move(dict).extract_root()) && cb.finalize_to(shard_account_blocks_))) {
     return fatal_error("cannot serialize ShardAccountBlocks");
@@ -5830,7 +5870,9 @@ bool Collator::create_shard_state() {
     CHECK(block::tlb::t_ShardState.validate_ref(1000000, state_root));
   }
   LOG(INFO) << "creating Merkle update for the ShardState";
-  state_update = vm::MerkleUpdate::generate(prev_state_root_, state_root, state_usage_tree_.get());
+  // the pure root has the same cells as prev_state_root_, but can be traversed from several threads
+  state_update = vm::MerkleUpdate::generate(prev_state_root_pure_, state_root, state_usage_tree_.get(),
+                                            state_update_extra_threads());
   if (state_update.is_null()) {
     return fatal_error("cannot create Merkle update for ShardState");
   }
@@ -6446,7 +6488,7 @@ bool Collator::create_block_candidate() {
   if (need_out_msg_queue_broadcasts) {
     // we can't generate two proofs at the same time for the same root (it is not currently supported by cells)
     // so we have can't reuse new state and have to regenerate it with merkle update
-    auto new_state = vm::MerkleUpdate::apply(prev_state_root_pure_, state_update);
+    auto new_state = vm::MerkleUpdate::apply(prev_state_root_pure_, state_update, state_update_extra_threads());
     CHECK(new_state.not_null());
     CHECK(new_state->get_hash() == state_root->get_hash());
     CHECK(shard_conf_);
@@ -6698,6 +6740,23 @@ void Collator::finalize_stats() {
   stats_.total_time = perf_timer_.elapsed();
   stats_.work_time.total = work_time;
   stats_.time_stats = (PSTRING() << perf_log_);
+  if (nb_out_msgs_) {
+    const auto& merger_stats = nb_out_msgs_->get_neighbor_stats();
+    for (size_t i = 0; i < merger_stats.size(); ++i) {
+      const auto& s = merger_stats[i];
+      if (s.nodes_split == 0 && s.prefetch_batches == 0) {
+        continue;
+      }
+      stats_.time_stats += PSTRING() << "\nout_msg_queue of neighbor #" << i << ": splits=" << s.nodes_split
+                                     << " loaded=" << s.cells_loaded << " prefetched=" << s.cells_prefetched
+                                     << " batches=" << s.prefetch_batches << " prefetch_time=" << s.prefetch_time;
+    }
+  }
+  if (stats_.storage_stat_cache.hit_cnt + stats_.storage_stat_cache.miss_cnt > 0) {
+    stats_.time_stats += PSTRING() << "\nstorage_stat_cache: recount_time="
+                                   << stats_.storage_stat_cache.collator_recount_time << " estimated_saved_time="
+                                   << stats_.storage_stat_cache.collator_estimated_saved_time();
+  }
   if (is_masterchain() && shard_conf_) {
     shard_conf_->process_shard_hashes([&](const block::McShardHash& shard) {
       stats_.shard_configuration.push_back(shard.top_block_id());
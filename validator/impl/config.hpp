@@ -24,15 +24,15 @@ namespace validator {
 using td::Ref;
 
 class ConfigHolderQ : public ConfigHolder {
-  std::shared_ptr<block::Config> config_;
+  std::shared_ptr<const block::Config> config_;
   std::shared_ptr<vm::StaticBagOfCellsDb> boc_;
 
  public:
   ConfigHolderQ() = default;
-  ConfigHolderQ(std::shared_ptr<block::Config> config, std::shared_ptr<vm::StaticBagOfCellsDb> boc)
+  ConfigHolderQ(std::shared_ptr<const block::Config> config, std::shared_ptr<vm::StaticBagOfCellsDb> boc)
       : config_(std::move(config)), boc_(std::move(boc)) {
   }
-  ConfigHolderQ(std::shared_ptr<block::Config> config) : config_(std::move(config)) {
+  ConfigHolderQ(std::shared_ptr<const block::Config> config) : config_(std::move(config)) {
   }
   const block::Config *get_config() const {
     return config_.get();
@@ -0,0 +1,292 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "ext-message-checker.hpp"
+#include "external-message.hpp"
+#include "block/block-auto.h"
+#include "block/block-parse.h"
+#include "td/utils/ScopeGuard.h"
+#include "td/utils/Timer.h"
+#include "td/utils/port/thread.h"
+
+namespace ton::validator {
+
+void ExtMessageCheckerImpl::start_up() {
+  size_t workers = std::max<size_t>(2, td::thread::hardware_concurrency() / 4);
+  for (size_t i = 0; i < workers; ++i) {
+    workers_.push_back(td::actor::create_actor<Worker>(PSTRING() << "extmsgcheck" << i));
+  }
+  alarm_timestamp() = td::Timestamp::in(stats_period);
+}
+
+void ExtMessageCheckerImpl::alarm() {
+  last_period_rate_ = (double)period_checked_ / stats_period;
+  period_checked_ = 0;
+  alarm_timestamp() = td::Timestamp::in(stats_period);
+}
+
+void ExtMessageCheckerImpl::check_message(td::Ref<ExtMessage> message, td::Ref<MasterchainState> mc_state,
+                                          td::Promise<td::Ref<ExtMessage>> promise) {
+  ++total_received_;
+  if (mc_state_.is_null() || mc_state_->get_block_id() != mc_state->get_block_id()) {
+    reset_snapshot(std::move(mc_state));
+  }
+  if (pending_ >= max_pending_total) {
+    reject(std::move(promise), Overloaded, td::Status::Error("too many external messages are being checked"));
+    return;
+  }
+  AccountKey key{message->wc(), message->addr()};
+  auto &queue = accounts_[key];
+  if (queue.messages.size() >= max_pending_per_addr) {
+    reject(std::move(promise), QueueFull,
+           td::Status::Error(PSTRING() << "too many external messages to address " << key.first << ":"
+                                       << key.second.to_hex() << " are being checked"));
+    return;
+  }
+  queue.messages.emplace_back(std::move(message), std::move(promise));
+  ++pending_;
+  if (!queue.in_flight && queue.messages.size() == 1) {
+    ready_.push_back(key);
+  }
+  dispatch();
+}
+
+void ExtMessageCheckerImpl::reset_snapshot(td::Ref<MasterchainState> mc_state) {
+  ++total_snapshots_;
+  mc_state_ = std::move(mc_state);
+  auto R = block::ConfigInfo::extract_config_cached(mc_state_->root_cell(), mc_state_->get_block_id(), 0xFFFF);
+  if (R.is_error()) {
+    config_ = nullptr;
+    config_error_ = R.move_as_error_prefix("cannot extract config: ");
+  } else {
+    config_ = R.move_as_ok();
+  }
+  // addresses waiting for shard states of the previous snapshot are rescheduled
+  for (auto &[_, shard] : shards_) {
+    for (auto &key : shard.waiting) {
+      accounts_[key].in_flight = false;
+      ready_.push_back(key);
+    }
+  }
+  shards_.clear();
+  shards_[mc_state_->get_block_id()] = ShardSnapshot{.ready = true, .state = mc_state_};
+  for (auto it = accounts_.begin(); it != accounts_.end();) {
+    auto &queue = it->second;
+    queue.shard_account_known = false;
+    queue.shard_account = {};
+    if (!queue.in_flight && queue.messages.empty()) {
+      it = accounts_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+void ExtMessageCheckerImpl::dispatch() {
+  while (running_ < workers_.size() && !ready_.empty()) {
+    auto key = ready_.front();
+    ready_.pop_front();
+    auto it = accounts_.find(key);
+    CHECK(it != accounts_.end());
+    CHECK(!it->second.in_flight && !it->second.messages.empty());
+    it->second.in_flight = true;
+    run_check(key, it->second);
+  }
+}
+
+void ExtMessageCheckerImpl::run_check(const AccountKey &key, AccountQueue &queue) {
+  auto &message = queue.messages.front().first;
+  auto fail = [&](td::Status error) {
+    auto promise = std::move(queue.messages.front().second);
+    queue.messages.pop_front();
+    --pending_;
+    reject(std::move(promise), NoState, std::move(error));
+    finish_message(key);
+  };
+  if (!config_) {
+    fail(config_error_.clone());
+    return;
+  }
+  BlockIdExt block_id = mc_state_->get_block_id();
+  if (key.first != masterchainId) {
+    auto shard = mc_state_->get_shard_from_config(message->shard().as_leaf_shard(), false);
+    if (shard.is_null()) {
+      fail(td::Status::Error(PSTRING() << "no shard for address " << key.first << ":" << key.second.to_hex()));
+      return;
+    }
+    block_id = shard->top_block_id();
+  }
+  auto &snapshot = shards_[block_id];
+  if (!snapshot.ready) {
+    snapshot.waiting.push_back(key);
+    if (snapshot.waiting.size() == 1) {
+      td::actor::send_closure(manager_, &ValidatorManager::get_block_state_for_litequery, block_id,
+                              [SelfId = actor_id(this), block_id](td::Result<td::Ref<ShardState>> R) {
+                                td::actor::send_closure(SelfId, &ExtMessageCheckerImpl::got_shard_state, block_id,
+                                                        std::move(R));
+                              });
+    }
+    return;
+  }
+
+  ++(queue.shard_account_known ? total_cache_hits_ : total_cache_misses_);
+  ++running_;
+  auto &worker = workers_[next_worker_++ % workers_.size()];
+  td::actor::send_closure(
+      worker, &Worker::run, message, snapshot.state->root_cell(), queue.shard_account, queue.shard_account_known,
+      snapshot.state->get_unix_time(), snapshot.state->get_logical_time(), config_,
+      [SelfId = actor_id(this), mc_block_id = mc_state_->get_block_id(), key](td::Result<CheckResult> R) {
+        CheckResult result;
+        if (R.is_error()) {
+          result.status = R.move_as_error();
+        } else {
+          result = R.move_as_ok();
+        }
+        td::actor::send_closure(SelfId, &ExtMessageCheckerImpl::checked, mc_block_id, key, std::move(result));
+      });
+}
+
+void ExtMessageCheckerImpl::got_shard_state(BlockIdExt block_id, td::Result<td::Ref<ShardState>> R) {
+  auto it = shards_.find(block_id);
+  if (it == shards_.end()) {
+    // snapshot was reset
+    return;
+  }
+  auto waiting = std::move(it->second.waiting);
+  if (R.is_error()) {
+    shards_.erase(it);
+    auto error = R.move_as_error_prefix(PSTRING() << "cannot load state " << block_id.to_str() << ": ");
+    for (auto &key : waiting) {
+      auto &queue = accounts_[key];
+      auto promise = std::move(queue.messages.front().second);
+      queue.messages.pop_front();
+      --pending_;
+      reject(std::move(promise), NoState, error.clone());
+      finish_message(key);
+    }
+  } else {
+    it->second.ready = true;
+    it->second.state = R.move_as_ok();
+    for (auto &key : waiting) {
+      accounts_[key].in_flight = false;
+      ready_.push_front(key);
+    }
+  }
+  dispatch();
+}
+
+void ExtMessageCheckerImpl::checked(BlockIdExt mc_block_id, AccountKey key, CheckResult result) {
+  CHECK(running_ > 0);
+  --running_;
+  total_check_time_ += result.time;
+  ++period_checked_;
+  auto it = accounts_.find(key);
+  CHECK(it != accounts_.end() && it->second.in_flight);
+  auto &queue = it->second;
+  if (mc_block_id == mc_state_->get_block_id() && result.reason != NoState) {
+    queue.shard_account_known = true;
+    queue.shard_account = std::move(result.shard_account);
+  }
+  auto [message, promise] = std::move(queue.messages.front());
+  queue.messages.pop_front();
+  --pending_;
+  if (result.status.is_ok()) {
+    ++total_accepted_;
+    promise.set_value(std::move(message));
+  } else {
+    reject(std::move(promise), result.reason, std::move(result.status));
+  }
+  finish_message(key);
+  dispatch();
+}
+
+void ExtMessageCheckerImpl::finish_message(AccountKey key) {
+  auto it = accounts_.find(key);
+  CHECK(it != accounts_.end());
+  auto &queue = it->second;
+  queue.in_flight = false;
+  if (!queue.messages.empty()) {
+    ready_.push_back(key);
+  } else if (!queue.shard_account_known) {
+    accounts_.erase(it);
+  }
+}
+
+void ExtMessageCheckerImpl::reject(td::Promise<td::Ref<ExtMessage>> promise, RejectReason reason,
+                                   td::Status error) {
+  ++total_rejected_[reason];
+  promise.set_error(std::move(error));
+}
+
+void ExtMessageCheckerImpl::prepare_stats(td::Promise<std::vector<std::pair<std::string, std::string>>> promise) {
+  std::vector<std::pair<std::string, std::string>> vec;
+  td::uint64 checked = total_accepted_ + total_rejected_[BadAccount] + total_rejected_[NotAccepted];
+  vec.emplace_back("received", td::to_string(total_received_));
+  vec.emplace_back("accepted", td::to_string(total_accepted_));
+  vec.emplace_back("rejected", PSTRING() << "queue_full:" << total_rejected_[QueueFull]
+                                         << " overloaded:" << total_rejected_[Overloaded]
+                                         << " no_state:" << total_rejected_[NoState]
+                                         << " bad_account:" << total_rejected_[BadAccount]
+                                         << " not_accepted:" << total_rejected_[NotAccepted]);
+  vec.emplace_back("account_cache", PSTRING() << "hits:" << total_cache_hits_ << " misses:" << total_cache_misses_);
+  vec.emplace_back("pending", PSTRING() << pending_ << " running:" << running_ << " workers:" << workers_.size());
+  vec.emplace_back("checks_per_sec", PSTRING() << last_period_rate_);
+  vec.emplace_back("avg_check_time", PSTRING() << (checked ? total_check_time_ / (double)checked : 0.0));
+  vec.emplace_back("snapshots", td::to_string(total_snapshots_));
+  promise.set_value(std::move(vec));
+}
+
+void ExtMessageCheckerImpl::Worker::run(td::Ref<ExtMessage> message, td::Ref<vm::Cell> state_root,
+                                        td::Ref<vm::CellSlice> shard_account, bool shard_account_known,
+                                        UnixTime utime, LogicalTime lt, std::shared_ptr<const block::ConfigInfo> config,
+                                        td::Promise<CheckResult> promise) {
+  td::Timer timer;
+  CheckResult result;
+  SCOPE_EXIT {
+    result.time = timer.elapsed();
+    promise.set_value(std::move(result));
+  };
+  WorkchainId wc = message->wc();
+  StdSmcAddress addr = message->addr();
+  if (!shard_account_known) {
+    block::gen::ShardStateUnsplit::Record sstate;
+    if (!tlb::unpack_cell(state_root, sstate)) {
+      result.status = td::Status::Error("cannot unpack shard state header");
+      result.reason = NoState;
+      return;
+    }
+    vm::AugmentedDictionary accounts_dict{vm::load_cell_slice_ref(sstate.accounts), 256,
+                                          block::tlb::aug_ShardAccounts};
+    shard_account = accounts_dict.lookup(addr);
+  }
+  result.shard_account = shard_account;
+
+  block::Account acc;
+  bool special = wc == masterchainId && config->is_special_smartcontract(addr);
+  if (!acc.unpack(std::move(shard_account), utime, special)) {
+    result.status = td::Status::Error("Failed to unpack account state");
+    result.reason = BadAccount;
+    return;
+  }
+  acc.block_lt = lt;
+  auto status = ExtMessageQ::run_message_on_account(wc, &acc, utime, lt + 1, message->root_cell(), std::move(config));
+  if (status.is_error()) {
+    result.status = td::Status::Error(PSLICE() << "External message was not accepted\n" << status.message());
+    result.reason = NotAccepted;
+  }
+}
+
+}  // namespace ton::validator
@@ -0,0 +1,122 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "interfaces/ext-message-checker.h"
+#include "interfaces/validator-manager.h"
+#include "block/mc-config.h"
+
+#include <deque>
+#include <map>
+
+namespace ton::validator {
+
+/**
+ * Pre-checks of inbound external messages (see ExtMessageQ::run_message_on_account).
+ *
+ * All checks share one snapshot: the masterchain state given by the manager, its config and the shard states
+ * referenced by it, each loaded once. ShardAccount of a destination address is looked up once per snapshot and
+ * reused by subsequent messages to the same address. Addresses are served round-robin with at most one message
+ * of an address being checked at a time, so a burst of messages to a single wallet does not delay others.
+ * The VM is run in a pool of worker actors.
+ */
+class ExtMessageCheckerImpl : public ExtMessageChecker {
+ public:
+  explicit ExtMessageCheckerImpl(td::actor::ActorId<ValidatorManager> manager) : manager_(std::move(manager)) {
+  }
+
+  void start_up() override;
+  void alarm() override;
+
+  void check_message(td::Ref<ExtMessage> message, td::Ref<MasterchainState> mc_state,
+                     td::Promise<td::Ref<ExtMessage>> promise) override;
+  void prepare_stats(td::Promise<std::vector<std::pair<std::string, std::string>>> promise) override;
+
+  enum RejectReason : int {
+    QueueFull,     // too many messages to the address are waiting
+    Overloaded,    // too many messages are waiting in total
+    NoState,       // shard state is not available
+    BadAccount,    // account state cannot be unpacked
+    NotAccepted,   // the contract did not accept the message
+    RejectReasonCount
+  };
+
+  struct CheckResult {
+    td::Status status;
+    RejectReason reason{NotAccepted};
+    // ShardAccount from the state, or null if the account does not exist
+    td::Ref<vm::CellSlice> shard_account;
+    double time{0.0};
+  };
+
+  class Worker : public td::actor::Actor {
+   public:
+    void run(td::Ref<ExtMessage> message, td::Ref<vm::Cell> state_root, td::Ref<vm::CellSlice> shard_account,
+             bool shard_account_known, UnixTime utime, LogicalTime lt, std::shared_ptr<const block::ConfigInfo> config,
+             td::Promise<CheckResult> promise);
+  };
+
+  static constexpr size_t max_pending_per_addr = 16;
+  static constexpr size_t max_pending_total = 8192;
+  static constexpr double stats_period = 60.0;
+
+ private:
+  using AccountKey = std::pair<WorkchainId, StdSmcAddress>;
+
+  struct ShardSnapshot {
+    bool ready{false};
+    td::Ref<ShardState> state;
+    std::vector<AccountKey> waiting;
+  };
+
+  struct AccountQueue {
+    std::deque<std::pair<td::Ref<ExtMessage>, td::Promise<td::Ref<ExtMessage>>>> messages;
+    bool in_flight{false};
+    bool shard_account_known{false};
+    td::Ref<vm::CellSlice> shard_account;
+  };
+
+  void reset_snapshot(td::Ref<MasterchainState> mc_state);
+  void dispatch();
+  void run_check(const AccountKey &key, AccountQueue &queue);
+  void got_shard_state(BlockIdExt block_id, td::Result<td::Ref<ShardState>> R);
+  void checked(BlockIdExt mc_block_id, AccountKey key, CheckResult result);
+  void finish_message(AccountKey key);
+  void reject(td::Promise<td::Ref<ExtMessage>> promise, RejectReason reason, td::Status error);
+
+  td::actor::ActorId<ValidatorManager> manager_;
+  std::vector<td::actor::ActorOwn<Worker>> workers_;
+  size_t next_worker_{0};
+  size_t running_{0};
+
+  td::Ref<MasterchainState> mc_state_;
+  std::shared_ptr<const block::ConfigInfo> config_;
+  td::Status config_error_;
+  std::map<BlockIdExt, ShardSnapshot> shards_;
+  std::map<AccountKey, AccountQueue> accounts_;
+  std::deque<AccountKey> ready_;
+  size_t pending_{0};
+
+  td::uint64 total_received_{0}, total_accepted_{0}, total_cache_hits_{0}, total_cache_misses_{0};
+  std::array<td::uint64, RejectReasonCount> total_rejected_{};
+  double total_check_time_{0.0};
+  td::uint64 period_checked_{0};
+  double last_period_rate_{0.0};
+  size_t total_snapshots_{0};
+};
+
+}  // namespace ton::validator
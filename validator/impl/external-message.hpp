@@ -61,13 +61,11 @@ class ExtMessageQ : public ExtMessage {
               ton::StdSmcAddress addr);
   static td::Result<td::Ref<ExtMessageQ>> create_ext_message(td::BufferSlice data,
                                                              block::SizeLimitsConfig::ExtMsgLimits limits);
-  static void run_message(td::Ref<ExtMessage> message, td::actor::ActorId<ton::validator::ValidatorManager> manager,
-                          td::Promise<td::Ref<ExtMessage>> promise);
   static td::Status run_message_on_account(ton::WorkchainId wc,
                                            block::Account* acc,
                                            UnixTime utime, LogicalTime lt,
                                            td::Ref<vm::Cell> msg_root,
-                                           std::unique_ptr<block::ConfigInfo> config);
+                                           std::shared_ptr<const block::ConfigInfo> config);
 };
 
 }  // namespace validator
@@ -26,6 +26,7 @@
 #include "block.hpp"
 #include "proof.hpp"
 #include "signature-set.hpp"
+#include "ext-message-checker.hpp"
 #include "external-message.hpp"
 #include "ihr-message.hpp"
 #include "validate-query.hpp"
@@ -50,6 +51,10 @@ td::actor::ActorOwn<LiteServerCache> create_liteserver_cache_actor(td::actor::Ac
   return td::actor::create_actor<LiteServerCacheImpl>("cache");
 }
 
+td::actor::ActorOwn<ExtMessageChecker> create_ext_message_checker_actor(td::actor::ActorId<ValidatorManager> manager) {
+  return td::actor::create_actor<ExtMessageCheckerImpl>("extmsgchecker", std::move(manager));
+}
+
 td::Result<td::Ref<BlockData>> create_block(BlockIdExt block_id, td::BufferSlice data) {
   auto res = BlockQ::create(block_id, std::move(data));
   if (res.is_error()) {
@@ -59,6 +64,15 @@ td::Result<td::Ref<BlockData>> create_block(BlockIdExt block_id, td::BufferSlice
   }
 }
 
+td::Result<td::Ref<BlockData>> create_block(BlockIdExt block_id, td::BufferSlice data, td::Ref<vm::Cell> root) {
+  auto res = BlockQ::create(block_id, std::move(data), std::move(root));
+  if (res.is_error()) {
+    return res.move_as_error();
+  } else {
+    return td::Ref<BlockData>{res.move_as_ok()};
+  }
+}
+
 td::Result<td::Ref<BlockData>> create_block(ReceivedBlock data) {
   return create_block(data.id, std::move(data.data));
 }
@@ -119,11 +133,6 @@ td::Result<td::Ref<ExtMessage>> create_ext_message(td::BufferSlice data,
   return std::move(res);
 }
 
-void run_check_external_message(Ref<ExtMessage> message, td::actor::ActorId<ValidatorManager> manager,
-                                td::Promise<td::Ref<ExtMessage>> promise) {
-  ExtMessageQ::run_message(std::move(message), std::move(manager), std::move(promise));
-}
-
 td::Result<td::Ref<IhrMessage>> create_ihr_message(td::BufferSlice data) {
   TRY_RESULT(res, IhrMessageQ::create_ihr_message(std::move(data)));
   return std::move(res);
@@ -218,10 +227,11 @@ void run_collate_query(CollateParams params, td::actor::ActorId<ValidatorManager
       seqno = p.seqno();
     }
   }
-  td::actor::create_actor<Collator>(PSTRING() << "collate" << params.shard.to_str() << ":" << (seqno + 1)
-                                              << (params.attempt_idx ? "_" + td::to_string(params.attempt_idx) : ""),
-                                    std::move(params), std::move(manager), timeout, std::move(cancellation_token),
-                                    std::move(promise))
+  auto name = PSTRING() << "collate" << params.shard.to_str() << ":" << (seqno + 1)
+                        << (params.attempt_idx ? "_" + td::to_string(params.attempt_idx) : "");
+  td::actor::create_actor<Collator>(
+      td::actor::ActorOptions().with_name(name).with_priority(td::actor::ActorPriority::Collation), std::move(params),
+      std::move(manager), timeout, std::move(cancellation_token), std::move(promise))
       .release();
 }
 
@@ -230,11 +240,6 @@ void run_liteserver_query(td::BufferSlice data, td::actor::ActorId<ValidatorMana
   LiteQuery::run_query(std::move(data), std::move(manager), std::move(cache), std::move(promise));
 }
 
-void run_fetch_account_state(WorkchainId wc, StdSmcAddress  addr, td::actor::ActorId<ValidatorManager> manager,
-                             td::Promise<std::tuple<td::Ref<vm::CellSlice>,UnixTime,LogicalTime,std::unique_ptr<block::ConfigInfo>>> promise) {
-  LiteQuery::fetch_account_state(wc, addr, std::move(manager), std::move(promise));
-}
-
 void run_validate_shard_block_description(td::BufferSlice data, BlockHandle masterchain_block,
                                           td::Ref<MasterchainState> masterchain_state,
                                           td::actor::ActorId<ValidatorManager> manager, td::Timestamp timeout,
@@ -17,6 +17,8 @@
 #pragma once
 
 #include "interfaces/liteserver.h"
+#include "liteserver-proof-cache.hpp"
+#include "liteserver.hpp"
 #include <map>
 
 namespace ton::validator {
@@ -29,11 +31,16 @@ class LiteServerCacheImpl : public LiteServerCache {
 
   void alarm() override {
     alarm_timestamp() = td::Timestamp::in(60.0);
-    if (queries_cnt_ > 0 || !send_message_cache_.empty()) {
+    auto proof_stats = LiteProofCache::instance().get_stats_and_reset();
+    auto batch_stats = LiteQuery::get_account_states_stats_and_reset();
+    if (queries_cnt_ > 0 || !send_message_cache_.empty() || proof_stats.lookups > 0 || batch_stats.batches > 0) {
       LOG(WARNING) << "LS Cache stats: " << queries_cnt_ << " queries, " << queries_hit_cnt_ << " hits; "
                    << cache_.size() << " entries, size=" << total_size_ << "/" << MAX_CACHE_SIZE << ";   "
                    << send_message_cache_.size() << " different sendMessage queries, " << send_message_error_cnt_
-                   << " duplicates";
+                   << " duplicates;   proof cache: " << proof_stats.lookups << " lookups, " << proof_stats.hits
+                   << " hits;   getAccountStates: " << batch_stats.batches << " batches, " << batch_stats.accounts
+                   << " accounts, " << batch_stats.shard_blocks << " shard blocks, load time "
+                   << batch_stats.load_time << "s, proof time " << batch_stats.proof_time << "s";
       queries_cnt_ = 0;
       queries_hit_cnt_ = 0;
       send_message_cache_.clear();
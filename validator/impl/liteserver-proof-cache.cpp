@@ -0,0 +1,70 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "liteserver-proof-cache.hpp"
+
+namespace ton::validator {
+
+LiteProofCache &LiteProofCache::instance() {
+  static LiteProofCache cache;
+  return cache;
+}
+
+Ref<vm::Cell> LiteProofCache::get_state_root_proof(const RootHash &block_root_hash, const RootHash &state_hash) {
+  std::pair<RootHash, Ref<vm::Cell>> value;
+  if (!lookup([&] { return state_root_proofs_.get(block_root_hash, value) && value.first == state_hash; })) {
+    return {};
+  }
+  return value.second;
+}
+
+void LiteProofCache::set_state_root_proof(const RootHash &block_root_hash, const RootHash &state_hash,
+                                          Ref<vm::Cell> proof) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  state_root_proofs_.set(block_root_hash, std::make_pair(state_hash, std::move(proof)));
+}
+
+bool LiteProofCache::get_shard_info_proof(const RootHash &mc_state_hash, ShardIdFull shard, bool exact,
+                                          ShardInfoProof &res) {
+  return lookup([&] { return shard_info_proofs_.get(std::make_tuple(mc_state_hash, shard, exact), res); });
+}
+
+void LiteProofCache::set_shard_info_proof(const RootHash &mc_state_hash, ShardIdFull shard, bool exact,
+                                          ShardInfoProof value) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  shard_info_proofs_.set(std::make_tuple(mc_state_hash, shard, exact), std::move(value));
+}
+
+Ref<vm::Cell> LiteProofCache::get_config_param_proof(const RootHash &mc_state_hash, int mode, int param) {
+  Ref<vm::Cell> res;
+  lookup([&] { return config_param_proofs_.get(std::make_tuple(mc_state_hash, mode, param), res); });
+  return res;
+}
+
+void LiteProofCache::set_config_param_proof(const RootHash &mc_state_hash, int mode, int param,
+                                            Ref<vm::Cell> proof) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  config_param_proofs_.set(std::make_tuple(mc_state_hash, mode, param), std::move(proof));
+}
+
+LiteProofCache::Stats LiteProofCache::get_stats_and_reset() {
+  Stats res;
+  res.lookups = lookups_.exchange(0, std::memory_order_relaxed);
+  res.hits = hits_.exchange(0, std::memory_order_relaxed);
+  return res;
+}
+
+}  // namespace ton::validator
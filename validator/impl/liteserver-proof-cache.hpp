@@ -0,0 +1,136 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "block/mc-config.h"
+#include "td/utils/List.h"
+#include "ton/ton-types.h"
+#include "vm/cells.h"
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+
+namespace ton::validator {
+
+using td::Ref;
+
+/**
+ * Process-wide cache of Merkle proofs that liteserver queries build over the same blocks and states:
+ * block header proofs of state roots, proofs of ShardHashes entries and proofs of single configuration
+ * parameters. Proofs of several configuration parameters are combined from the cached single-parameter
+ * proofs with MerkleProof::combine_fast. Used by all LiteQuery actors concurrently.
+ */
+class LiteProofCache {
+ public:
+  struct ShardInfoProof {
+    Ref<vm::Cell> proof;
+    // info and leaf hold plain cells, not tied to the usage tree of the proof builder
+    Ref<block::McShardHash> info;
+    ShardIdFull true_shard;
+    Ref<vm::Cell> leaf;
+    bool found{false};
+  };
+
+  struct Stats {
+    td::uint64 lookups{0};
+    td::uint64 hits{0};
+  };
+
+  static LiteProofCache &instance();
+
+  // block header proof linking block_root_hash to the state
+  Ref<vm::Cell> get_state_root_proof(const RootHash &block_root_hash, const RootHash &state_hash);
+  void set_state_root_proof(const RootHash &block_root_hash, const RootHash &state_hash, Ref<vm::Cell> proof);
+
+  bool get_shard_info_proof(const RootHash &mc_state_hash, ShardIdFull shard, bool exact, ShardInfoProof &res);
+  void set_shard_info_proof(const RootHash &mc_state_hash, ShardIdFull shard, bool exact, ShardInfoProof value);
+
+  // param = -1 stands for the proof of the whole configuration
+  Ref<vm::Cell> get_config_param_proof(const RootHash &mc_state_hash, int mode, int param);
+  void set_config_param_proof(const RootHash &mc_state_hash, int mode, int param, Ref<vm::Cell> proof);
+
+  // returns the counters since the previous call
+  Stats get_stats_and_reset();
+
+ private:
+  template <class KeyT, class ValueT>
+  class LruMap {
+   public:
+    explicit LruMap(size_t max_size) : max_size_(max_size) {
+    }
+    bool get(const KeyT &key, ValueT &value) {
+      auto it = map_.find(key);
+      if (it == map_.end()) {
+        return false;
+      }
+      auto entry = it->second.get();
+      entry->remove();
+      lru_.put(entry);
+      value = entry->value;
+      return true;
+    }
+    void set(const KeyT &key, ValueT value) {
+      auto &entry = map_[key];
+      if (entry == nullptr) {
+        entry = std::make_unique<Entry>(key, std::move(value));
+      } else {
+        entry->value = std::move(value);
+        entry->remove();
+      }
+      lru_.put(entry.get());
+      if (map_.size() > max_size_) {
+        auto to_remove = static_cast<Entry *>(lru_.get());
+        CHECK(to_remove);
+        to_remove->remove();
+        map_.erase(to_remove->key);
+      }
+    }
+
+   private:
+    struct Entry : td::ListNode {
+      Entry(KeyT key, ValueT value) : key(std::move(key)), value(std::move(value)) {
+      }
+      KeyT key;
+      ValueT value;
+    };
+    std::map<KeyT, std::unique_ptr<Entry>> map_;
+    td::ListNode lru_;
+    size_t max_size_;
+  };
+
+  template <class F>
+  bool lookup(F &&f) {
+    lookups_.fetch_add(1, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> guard(mutex_);
+    bool hit = f();
+    if (hit) {
+      hits_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return hit;
+  }
+
+  std::mutex mutex_;
+  LruMap<RootHash, std::pair<RootHash, Ref<vm::Cell>>> state_root_proofs_{1024};
+  LruMap<std::tuple<RootHash, ShardIdFull, bool>, ShardInfoProof> shard_info_proofs_{4096};
+  LruMap<std::tuple<RootHash, int, int>, Ref<vm::Cell>> config_param_proofs_{16384};
+  std::atomic<td::uint64> lookups_{0}, hits_{0};
+};
+
+}  // namespace ton::validator
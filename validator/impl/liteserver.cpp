@@ -44,6 +44,9 @@
 #include <ctime>
 #include "td/actor/MultiPromise.h"
 #include "collator-impl.h"
+#include "liteserver-proof-cache.hpp"
+
+#include <mutex>
 
 namespace ton {
 
@@ -55,36 +58,38 @@ td::int32 get_tl_tag(td::Slice slice) {
   return slice.size() >= 4 ? td::as<td::int32>(slice.data()) : -1;
 }
 
+namespace {
+
+std::mutex account_states_stats_mutex;
+LiteQuery::AccountStatesStats account_states_stats;
+
+}  // namespace
+
+LiteQuery::AccountStatesStats LiteQuery::get_account_states_stats_and_reset() {
+  std::lock_guard<std::mutex> guard(account_states_stats_mutex);
+  auto res = account_states_stats;
+  account_states_stats = {};
+  return res;
+}
+
 void LiteQuery::run_query(td::BufferSlice data, td::actor::ActorId<ValidatorManager> manager,
                           td::actor::ActorId<LiteServerCache> cache,
                           td::Promise<td::BufferSlice> promise) {
-  td::actor::create_actor<LiteQuery>("litequery", std::move(data), std::move(manager), std::move(cache),
-                                     std::move(promise))
+  td::actor::create_actor<LiteQuery>(
+      td::actor::ActorOptions().with_name("litequery").with_priority(td::actor::ActorPriority::Serving),
+      std::move(data), std::move(manager), std::move(cache), std::move(promise))
       .release();
 }
 
-void LiteQuery::fetch_account_state(WorkchainId wc, StdSmcAddress  acc_addr, td::actor::ActorId<ton::validator::ValidatorManager> manager,
-                                 td::Promise<std::tuple<td::Ref<vm::CellSlice>,UnixTime,LogicalTime,std::unique_ptr<block::ConfigInfo>>> promise) {
-  td::actor::create_actor<LiteQuery>("litequery", wc, acc_addr, std::move(manager), std::move(promise)).release();
-}
-
 LiteQuery::LiteQuery(td::BufferSlice data, td::actor::ActorId<ValidatorManager> manager,
                      td::actor::ActorId<LiteServerCache> cache, td::Promise<td::BufferSlice> promise)
     : query_(std::move(data)), manager_(std::move(manager)), cache_(std::move(cache)), promise_(std::move(promise)) {
   timeout_ = td::Timestamp::in(default_timeout_msec * 0.001);
 }
 
-LiteQuery::LiteQuery(WorkchainId wc, StdSmcAddress  acc_addr, td::actor::ActorId<ValidatorManager> manager,
-                     td::Promise<std::tuple<td::Ref<vm::CellSlice>,UnixTime,LogicalTime,std::unique_ptr<block::ConfigInfo>>> promise)
-    : manager_(std::move(manager)), acc_state_promise_(std::move(promise)), acc_workchain_(wc), acc_addr_(acc_addr) {
-  timeout_ = td::Timestamp::in(default_timeout_msec * 0.001);
-}
-
 void LiteQuery::abort_query(td::Status reason) {
   LOG(INFO) << "aborted liteserver query: " << reason.to_string();
-  if (acc_state_promise_) {
-    acc_state_promise_.set_error(std::move(reason));
-  } else if (promise_) {
+  if (promise_) {
     td::actor::send_closure(manager_, &ValidatorManager::add_lite_query_stats, query_obj_ ? query_obj_->get_id() : 0,
                             false);
     promise_.set_error(std::move(reason));
@@ -128,11 +133,6 @@ bool LiteQuery::finish_query(td::BufferSlice result, bool skip_cache_update) {
 void LiteQuery::start_up() {
   alarm_timestamp() = timeout_;
 
-  if (acc_state_promise_) {
-    td::actor::send_closure_later(actor_id(this), &LiteQuery::perform_fetchAccountState);
-    return;
-  }
-
   auto F = fetch_tl_object<ton::lite_api::Function>(query_, true);
   if (F.is_error()) {
     abort_query(F.move_as_error());
@@ -209,6 +209,13 @@ void LiteQuery::perform() {
             this->perform_getAccountState(ton::create_block_id(q.id_), static_cast<WorkchainId>(q.account_->workchain_),
                                           q.account_->id_, 0x40000000);
           },
+          [&](lite_api::liteServer_getAccountStates& q) {
+            std::vector<std::pair<WorkchainId, StdSmcAddress>> accounts;
+            for (auto& account : q.accounts_) {
+              accounts.emplace_back(static_cast<WorkchainId>(account->workchain_), account->id_);
+            }
+            this->perform_getAccountStates(ton::create_block_id(q.id_), q.mode_, std::move(accounts));
+          },
           [&](lite_api::liteServer_getOneTransaction& q) {
             this->perform_getOneTransaction(ton::create_block_id(q.id_),
                                             static_cast<WorkchainId>(q.account_->workchain_), q.account_->id_,
@@ -316,23 +323,17 @@ void LiteQuery::perform_getMasterchainInfo(int mode) {
   }
   td::actor::send_closure_later(
       manager_, &ton::validator::ValidatorManager::get_last_liteserver_state_block,
-      [Self = actor_id(this), return_state = bool(acc_state_promise_), mode](td::Result<std::pair<Ref<ton::validator::MasterchainState>, BlockIdExt>> res) {
+      [Self = actor_id(this), mode](td::Result<std::pair<Ref<ton::validator::MasterchainState>, BlockIdExt>> res) {
         if (res.is_error()) {
           td::actor::send_closure(Self, &LiteQuery::abort_query, res.move_as_error());
         } else {
           auto pair = res.move_as_ok();
-          auto func = return_state ? &LiteQuery::gotMasterchainInfoForAccountState : &LiteQuery::continue_getMasterchainInfo;
-          td::actor::send_closure_later(Self, func, std::move(pair.first),
+          td::actor::send_closure_later(Self, &LiteQuery::continue_getMasterchainInfo, std::move(pair.first),
                                         pair.second, mode);
         }
       });
 }
 
-void LiteQuery::gotMasterchainInfoForAccountState(Ref<ton::validator::MasterchainState> mc_state, BlockIdExt blkid,
-                                            int mode) {
-  perform_getAccountState(blkid, acc_workchain_, acc_addr_, 0x80000000);
-}
-
 void LiteQuery::continue_getMasterchainInfo(Ref<ton::validator::MasterchainState> mc_state, BlockIdExt blkid,
                                             int mode) {
   LOG(INFO) << "obtained data for getMasterchainInfo() : last block = " << blkid.to_str();
@@ -844,8 +845,233 @@ void LiteQuery::continue_getAccountState_0(Ref<ton::validator::MasterchainState>
   request_mc_block_data(blkid);
 }
 
-void LiteQuery::perform_fetchAccountState() {
-  perform_getMasterchainInfo(-1);
+void LiteQuery::perform_getAccountStates(BlockIdExt blkid, int mode,
+                                         std::vector<std::pair<WorkchainId, StdSmcAddress>> accounts) {
+  LOG(INFO) << "started a getAccountStates(" << blkid.to_str() << ", " << mode << ", <list of " << accounts.size()
+            << " accounts>) liteserver query";
+  if (mode & ~1) {
+    fatal_error("unsupported mode in getAccountStates");
+    return;
+  }
+  if (!blkid.is_masterchain() || !blkid.is_valid_full()) {
+    fatal_error("reference block for a getAccountStates() must be a valid masterchain block");
+    return;
+  }
+  if (accounts.empty()) {
+    fatal_error("no accounts requested in getAccountStates");
+    return;
+  }
+  if (accounts.size() > max_batch_accounts) {
+    fatal_error(PSTRING() << "cannot request more than " << max_batch_accounts << " accounts in getAccountStates");
+    return;
+  }
+  std::sort(accounts.begin(), accounts.end());
+  accounts.erase(std::unique(accounts.begin(), accounts.end()), accounts.end());
+  mode_ = mode;
+  batch_accounts_ = std::move(accounts);
+  batch_timer_ = td::Timer();
+  set_continuation([&]() -> void { continue_getAccountStates(); });
+  request_mc_block_data_state(blkid);
+}
+
+void LiteQuery::continue_getAccountStates() {
+  LOG(INFO) << "continue getAccountStates() query";
+  // all shards are looked up in one pass, so that their proofs share the upper part of ShardHashes
+  vm::MerkleProofBuilder pb{mc_state_->root_cell()};
+  block::gen::ShardStateUnsplit::Record sstate;
+  if (!tlb::unpack_cell(pb.root(), sstate)) {
+    fatal_error("cannot unpack masterchain state header");
+    return;
+  }
+  auto shards_dict = block::ShardConfig::extract_shard_hashes_dict(pb.root());
+  if (!shards_dict) {
+    fatal_error("cannot extract ShardHashes from last mc state");
+    return;
+  }
+  bool have_shard_accounts = false;
+  for (auto& account : batch_accounts_) {
+    if (account.first == masterchainId) {
+      batch_shards_[base_blk_id_].accounts.push_back(account.second);
+      continue;
+    }
+    have_shard_accounts = true;
+    vm::CellSlice cs;
+    ShardIdFull true_shard;
+    if (!block::ShardConfig::get_shard_hash_raw_from(
+            *shards_dict, cs, extract_addr_prefix(account.first, account.second).as_leaf_shard(), true_shard, false)) {
+      // unknown workchain: the shard proof shows that there is no such shard
+      batch_unknown_accounts_.push_back(account);
+      continue;
+    }
+    auto info = block::McShardHash::unpack(cs, true_shard);
+    if (info.is_null()) {
+      fatal_error("cannot unpack a leaf entry from ShardHashes");
+      return;
+    }
+    batch_shards_[info->top_block_id()].accounts.push_back(account.second);
+  }
+  if ((mode_ & 1) && have_shard_accounts) {
+    Ref<vm::Cell> proof1, proof2;
+    if (!make_mc_state_root_proof(proof1)) {
+      return;
+    }
+    if (!pb.extract_proof_to(proof2)) {
+      fatal_error("unknown error creating Merkle proof");
+      return;
+    }
+    auto proof = vm::std_boc_serialize_multi({std::move(proof1), std::move(proof2)});
+    if (proof.is_error()) {
+      fatal_error(proof.move_as_error());
+      return;
+    }
+    shard_proof_ = proof.move_as_ok();
+  }
+  set_continuation([&]() -> void { finish_getAccountStates(); });
+  for (auto& it : batch_shards_) {
+    auto blkid = it.first;
+    if (blkid == base_blk_id_) {
+      continue;
+    }
+    LOG(INFO) << "requesting state for block (" << blkid.to_str() << ")";
+    ++pending_;
+    td::actor::send_closure(manager_, &ValidatorManager::get_block_state_for_litequery, blkid,
+                            [Self = actor_id(this), blkid](td::Result<Ref<ShardState>> res) {
+                              if (res.is_error()) {
+                                td::actor::send_closure(
+                                    Self, &LiteQuery::abort_query,
+                                    res.move_as_error_prefix("cannot load state for "s + blkid.to_str() + " : "));
+                              } else {
+                                td::actor::send_closure_later(Self, &LiteQuery::got_batch_block_state, blkid,
+                                                              res.move_as_ok());
+                              }
+                            });
+    if (!(mode_ & 1)) {
+      // the block itself is needed only for the state root proof
+      continue;
+    }
+    ++pending_;
+    td::actor::send_closure(manager_, &ValidatorManager::get_block_data_for_litequery, blkid,
+                            [Self = actor_id(this), blkid](td::Result<Ref<BlockData>> res) {
+                              if (res.is_error()) {
+                                td::actor::send_closure(
+                                    Self, &LiteQuery::abort_query,
+                                    res.move_as_error_prefix("cannot load block "s + blkid.to_str() + " : "));
+                              } else {
+                                td::actor::send_closure_later(Self, &LiteQuery::got_batch_block_data, blkid,
+                                                              res.move_as_ok());
+                              }
+                            });
+  }
+  if (!pending_) {
+    check_pending();
+  }
+}
+
+void LiteQuery::got_batch_block_data(BlockIdExt blkid, Ref<BlockData> data) {
+  LOG(INFO) << "obtained data for getBlock(" << blkid.to_str() << ") needed by a liteserver query";
+  CHECK(data.not_null());
+  auto& shard = batch_shards_[blkid];
+  shard.block = Ref<BlockQ>(std::move(data));
+  CHECK(shard.block.not_null());
+  dec_pending();
+}
+
+void LiteQuery::got_batch_block_state(BlockIdExt blkid, Ref<ShardState> state) {
+  LOG(INFO) << "obtained data for getState(" << blkid.to_str() << ") needed by a liteserver query";
+  CHECK(state.not_null());
+  auto& shard = batch_shards_[blkid];
+  shard.state = Ref<ShardStateQ>(std::move(state));
+  CHECK(shard.state.not_null());
+  dec_pending();
+}
+
+void LiteQuery::finish_getAccountStates() {
+  LOG(INFO) << "completing getAccountStates() query";
+  double load_time = batch_timer_.elapsed();
+  td::Timer proof_timer;
+  bool want_proof = mode_ & 1;
+  std::vector<tl_object_ptr<lite_api::liteServer_shardAccountStates>> shards;
+  for (auto& it : batch_shards_) {
+    auto& blkid = it.first;
+    auto& shard = it.second;
+    if (blkid == base_blk_id_) {
+      shard.block = mc_block_;
+      shard.state = mc_state_;
+    }
+    // one Merkle proof for all requested accounts of the shard
+    vm::MerkleProofBuilder pb{shard.state->root_cell()};
+    block::gen::ShardStateUnsplit::Record sstate;
+    if (!tlb::unpack_cell(want_proof ? pb.root() : shard.state->root_cell(), sstate)) {
+      fatal_error("cannot unpack state header of "s + blkid.to_str());
+      return;
+    }
+    vm::AugmentedDictionary accounts_dict{vm::load_cell_slice_ref(sstate.accounts), 256,
+                                          block::tlb::aug_ShardAccounts};
+    std::vector<Ref<vm::Cell>> acc_roots;
+    for (auto& addr : shard.accounts) {
+      auto acc_csr = accounts_dict.lookup(addr);
+      acc_roots.push_back(acc_csr.not_null() ? acc_csr->prefetch_ref() : Ref<vm::Cell>{});
+    }
+    td::BufferSlice proof;
+    if (want_proof) {
+      Ref<vm::Cell> proof1, proof2;
+      if (!make_state_root_proof(proof1, shard.state, shard.block, blkid)) {
+        return;
+      }
+      // extracted before serializing the accounts, which would add their whole trees to the proof
+      if (!pb.extract_proof_to(proof2)) {
+        fatal_error("unknown error creating Merkle proof");
+        return;
+      }
+      auto r_proof = vm::std_boc_serialize_multi({std::move(proof1), std::move(proof2)});
+      if (r_proof.is_error()) {
+        fatal_error(r_proof.move_as_error());
+        return;
+      }
+      proof = r_proof.move_as_ok();
+    }
+    std::vector<tl_object_ptr<lite_api::liteServer_accountStateEntry>> entries;
+    for (size_t i = 0; i < shard.accounts.size(); i++) {
+      td::BufferSlice data;
+      if (acc_roots[i].not_null()) {
+        auto res = vm::std_boc_serialize(std::move(acc_roots[i]));
+        if (res.is_error()) {
+          fatal_error(res.move_as_error());
+          return;
+        }
+        data = res.move_as_ok();
+      }
+      entries.push_back(create_tl_object<lite_api::liteServer_accountStateEntry>(
+          create_tl_object<lite_api::liteServer_accountId>(blkid.id.workchain, shard.accounts[i]), std::move(data)));
+    }
+    pb.clear();
+    shards.push_back(create_tl_object<lite_api::liteServer_shardAccountStates>(
+        mode_ & 1, ton::create_tl_lite_block_id(blkid), std::move(proof), std::move(entries)));
+  }
+  if (!batch_unknown_accounts_.empty()) {
+    // an invalid shard block id marks accounts of unknown workchains, as in getAccountState()
+    std::vector<tl_object_ptr<lite_api::liteServer_accountStateEntry>> entries;
+    for (auto& account : batch_unknown_accounts_) {
+      entries.push_back(create_tl_object<lite_api::liteServer_accountStateEntry>(
+          create_tl_object<lite_api::liteServer_accountId>(account.first, account.second), td::BufferSlice{}));
+    }
+    shards.push_back(create_tl_object<lite_api::liteServer_shardAccountStates>(
+        mode_ & 1, ton::create_tl_lite_block_id(BlockIdExt{}), td::BufferSlice{}, std::move(entries)));
+  }
+  double proof_time = proof_timer.elapsed();
+  LOG(INFO) << "getAccountStates() query completed: " << batch_accounts_.size() << " accounts in " << shards.size()
+            << " shard blocks, load time " << load_time << "s, proof time " << proof_time << "s";
+  {
+    std::lock_guard<std::mutex> guard(account_states_stats_mutex);
+    account_states_stats.batches++;
+    account_states_stats.accounts += batch_accounts_.size();
+    account_states_stats.shard_blocks += shards.size();
+    account_states_stats.load_time += load_time;
+    account_states_stats.proof_time += proof_time;
+  }
+  auto b = ton::create_serialize_tl_object<ton::lite_api::liteServer_accountStates>(
+      mode_ & 1, ton::create_tl_lite_block_id(base_blk_id_), std::move(shard_proof_), std::move(shards));
+  finish_query(std::move(b));
 }
 
 void LiteQuery::perform_runSmcMethod(BlockIdExt blkid, WorkchainId workchain, StdSmcAddress addr, int mode,
@@ -917,8 +1143,8 @@ void LiteQuery::continue_getLibraries(Ref<ton::validator::MasterchainState> mc_s
   mc_state_ = Ref<MasterchainStateQ>(std::move(mc_state));
   CHECK(mc_state_.not_null());
 
-  auto rconfig = block::ConfigInfo::extract_config(mc_state_->root_cell(), mc_state_->get_block_id(),
-                                                   block::ConfigInfo::needLibraries);
+  auto rconfig = block::ConfigInfo::extract_config_cached(mc_state_->root_cell(), mc_state_->get_block_id(),
+                                                          block::ConfigInfo::needLibraries);
   if (rconfig.is_error()) {
     fatal_error("cannot extract library list block configuration from masterchain state");
     return;
@@ -1177,6 +1403,12 @@ bool LiteQuery::make_state_root_proof(Ref<vm::Cell>& proof, Ref<vm::Cell> state_
   CHECK(block_root.not_null() && state_root.not_null());
   RootHash rhash{block_root->get_hash().bits()};
   CHECK(rhash == blkid.root_hash);
+  RootHash state_hash{state_root->get_hash().bits()};
+  auto& proof_cache = LiteProofCache::instance();
+  proof = proof_cache.get_state_root_proof(rhash, state_hash);
+  if (proof.not_null()) {
+    return true;
+  }
   vm::MerkleProofBuilder pb{std::move(block_root)};
   block::gen::Block::Record blk;
   block::gen::BlockInfo::Record info;
@@ -1190,18 +1422,29 @@ bool LiteQuery::make_state_root_proof(Ref<vm::Cell>& proof, Ref<vm::Cell> state_
     return fatal_error("invalid Merkle update in block");
   }
   auto upd_hash = upd_cs.prefetch_ref(1)->get_hash(0);
-  auto state_hash = state_root->get_hash();
-  if (upd_hash != state_hash) {
+  if (upd_hash != state_root->get_hash()) {
     return fatal_error("cannot construct Merkle proof for given masterchain state because of hash mismatch");
   }
   if (!pb.extract_proof_to(proof)) {
     return fatal_error("unknown error creating Merkle proof");
   }
+  proof_cache.set_state_root_proof(rhash, state_hash, proof);
   return true;
 }
 
 bool LiteQuery::make_shard_info_proof(Ref<vm::Cell>& proof, Ref<block::McShardHash>& info, ShardIdFull shard,
                                       ShardIdFull& true_shard, Ref<vm::Cell>& leaf, bool& found, bool exact) {
+  RootHash mc_state_hash{mc_state_->root_cell()->get_hash().bits()};
+  auto& proof_cache = LiteProofCache::instance();
+  LiteProofCache::ShardInfoProof cached;
+  if (proof_cache.get_shard_info_proof(mc_state_hash, shard, exact, cached)) {
+    proof = std::move(cached.proof);
+    info = std::move(cached.info);
+    true_shard = cached.true_shard;
+    leaf = std::move(cached.leaf);
+    found = cached.found;
+    return true;
+  }
   vm::MerkleProofBuilder pb{mc_state_->root_cell()};
   block::gen::ShardStateUnsplit::Record sstate;
   if (!(tlb::unpack_cell(pb.root(), sstate))) {
@@ -1224,6 +1467,18 @@ bool LiteQuery::make_shard_info_proof(Ref<vm::Cell>& proof, Ref<block::McShardHa
   if (!pb.extract_proof_to(proof)) {
     return fatal_error("unknown error creating Merkle proof");
   }
+  if (found) {
+    // leaf and info refer to cells of pb, which must not be kept in the cache: take the plain leaf cell
+    // and unpack info again from it
+    leaf = leaf->load_cell().move_as_ok().data_cell;
+    vm::CellSlice leaf_cs{vm::NoVmOrd(), leaf};
+    leaf_cs.advance(1);
+    info = block::McShardHash::unpack(leaf_cs, true_shard);
+    if (info.is_null()) {
+      return fatal_error("cannot unpack a leaf entry from ShardHashes");
+    }
+  }
+  proof_cache.set_shard_info_proof(mc_state_hash, shard, exact, {proof, info, true_shard, leaf, found});
   return true;
 }
 
@@ -1320,19 +1575,6 @@ void LiteQuery::finish_getAccountState(td::BufferSlice shard_proof) {
   }
   vm::AugmentedDictionary accounts_dict{vm::load_cell_slice_ref(sstate.accounts), 256, block::tlb::aug_ShardAccounts};
   auto acc_csr = accounts_dict.lookup(acc_addr_);
-  if (mode_ & 0x80000000) {
-    auto config = block::ConfigInfo::extract_config(mc_state_->root_cell(), mc_state_->get_block_id(), 0xFFFF);
-    if (config.is_error()) {
-      fatal_error(config.move_as_error());
-      return;
-    }
-    auto rconfig = config.move_as_ok();
-    acc_state_promise_.set_value(std::make_tuple(
-                                  std::move(acc_csr), sstate.gen_utime, sstate.gen_lt, std::move(rconfig)
-                                 ));
-    return;
-  }
-
   Ref<vm::Cell> acc_root;
   if (acc_csr.not_null()) {
     acc_root = acc_csr->prefetch_ref();
@@ -1502,7 +1744,7 @@ void LiteQuery::finish_runSmcMethod(td::BufferSlice shard_proof, td::BufferSlice
   }
   LOG(DEBUG) << "creating VM with gas limit " << gas_limit;
   // **** INIT VM ****
-  auto r_config = block::ConfigInfo::extract_config(
+  auto r_config = block::ConfigInfo::extract_config_cached(
       mc_state_->root_cell(), mc_state_->get_block_id(),
       block::ConfigInfo::needLibraries | block::ConfigInfo::needCapabilities | block::ConfigInfo::needPrevBlocks);
   if (r_config.is_error()) {
@@ -1877,42 +2119,23 @@ void LiteQuery::continue_getConfigParams(int mode, std::vector<int> param_list)
   LOG(INFO) << "completing getConfigParams(" << base_blk_id_.to_str() << ", " << mode << ", <list of "
             << param_list.size() << " parameters>) liteserver query";
   bool keyblk = (mode & 0x8000);
-  Ref<vm::Cell> proof1, block;
-  if (keyblk) {
-    block = mc_block_->root_cell();
-  } else if (!make_mc_state_root_proof(proof1)) {
+  if (!keyblk) {
+    continue_getConfigParams_from_state(mode, std::move(param_list));
     return;
   }
 
-  vm::MerkleProofBuilder mpb{keyblk ? block : mc_state_->root_cell()};
-  if (keyblk) {
-    auto res = block::check_block_header_proof(mpb.root(), base_blk_id_);
-    if (res.is_error()) {
-      fatal_error(res.move_as_error_prefix("invalid key block header:"));
-      return;
-    }
+  vm::MerkleProofBuilder mpb{mc_block_->root_cell()};
+  auto res = block::check_block_header_proof(mpb.root(), base_blk_id_);
+  if (res.is_error()) {
+    fatal_error(res.move_as_error_prefix("invalid key block header:"));
+    return;
   }
-
-  std::unique_ptr<block::Config> cfg;
-  if (keyblk || !(mode & block::ConfigInfo::needPrevBlocks)) {
-    auto res = keyblk ? block::Config::extract_from_key_block(mpb.root(), mode)
-                      : block::Config::extract_from_state(mpb.root(), mode);
-    if (res.is_error()) {
-      fatal_error(res.move_as_error());
-      return;
-    }
-    cfg = res.move_as_ok();
-  } else {
-    if (mode & block::ConfigInfo::needPrevBlocks) {
-      mode |= block::ConfigInfo::needCapabilities;
-    }
-    auto res = block::ConfigInfo::extract_config(mpb.root(), keyblk ? base_blk_id_ : mc_state_->get_block_id(), mode);
-    if (res.is_error()) {
-      fatal_error(res.move_as_error());
-      return;
-    }
-    cfg = res.move_as_ok();
+  auto cfg_res = block::Config::extract_from_key_block(mpb.root(), mode);
+  if (cfg_res.is_error()) {
+    fatal_error(cfg_res.move_as_error());
+    return;
   }
+  auto cfg = cfg_res.move_as_ok();
   if (!cfg) {
     fatal_error("cannot extract configuration from last mc state");
     return;
@@ -1925,19 +2148,57 @@ void LiteQuery::continue_getConfigParams(int mode, std::vector<int> param_list)
         visit(cfg->get_config_param(i));
       }
     }
-    if (!keyblk && mode & block::ConfigInfo::needPrevBlocks) {
-      ((block::ConfigInfo*)cfg.get())->get_prev_blocks_info();
-    }
   } catch (vm::VmError& err) {
     fatal_error("error while traversing required configuration parameters: "s + err.get_msg());
     return;
   }
-  auto res1 = !keyblk ? vm::std_boc_serialize(std::move(proof1)) : td::BufferSlice();
+  auto res2 = mpb.extract_proof_boc();
+  if (res2.is_error()) {
+    fatal_error("cannot serialize Merkle proof : "s + res2.move_as_error().to_string());
+    return;
+  }
+  LOG(INFO) << "getConfigParams() query completed";
+  auto b = ton::create_serialize_tl_object<ton::lite_api::liteServer_configInfo>(
+      mode & 0xffff, ton::create_tl_lite_block_id(base_blk_id_), td::BufferSlice(), res2.move_as_ok());
+  finish_query(std::move(b));
+}
+
+void LiteQuery::continue_getConfigParams_from_state(int mode, std::vector<int> param_list) {
+  Ref<vm::Cell> proof1;
+  if (!make_mc_state_root_proof(proof1)) {
+    return;
+  }
+  if (mode & block::ConfigInfo::needPrevBlocks) {
+    mode |= block::ConfigInfo::needCapabilities;
+  }
+  // the state proof is combined from the proofs of single parameters, which are shared between queries
+  std::vector<int> params;
+  if (mode & 0x20000) {
+    params.push_back(-1);
+  } else if (mode & 0x10000) {
+    params = std::move(param_list);
+  }
+  if (params.empty()) {
+    params.push_back(-2);
+  }
+  Ref<vm::Cell> proof2;
+  for (int i : params) {
+    Ref<vm::Cell> param_proof;
+    if (!make_config_param_proof(param_proof, mode, i)) {
+      return;
+    }
+    proof2 = proof2.is_null() ? std::move(param_proof) : vm::MerkleProof::combine_fast(proof2, std::move(param_proof));
+    if (proof2.is_null()) {
+      fatal_error("cannot combine Merkle proofs of configuration parameters");
+      return;
+    }
+  }
+  auto res1 = vm::std_boc_serialize(std::move(proof1));
   if (res1.is_error()) {
     fatal_error("cannot serialize Merkle proof : "s + res1.move_as_error().to_string());
     return;
   }
-  auto res2 = mpb.extract_proof_boc();
+  auto res2 = vm::std_boc_serialize(std::move(proof2));
   if (res2.is_error()) {
     fatal_error("cannot serialize Merkle proof : "s + res2.move_as_error().to_string());
     return;
@@ -1948,6 +2209,51 @@ void LiteQuery::continue_getConfigParams(int mode, std::vector<int> param_list)
   finish_query(std::move(b));
 }
 
+// param = -1: the whole configuration, param = -2: only the parts of the state required by mode
+bool LiteQuery::make_config_param_proof(Ref<vm::Cell>& proof, int mode, int param) {
+  RootHash mc_state_hash{mc_state_->root_cell()->get_hash().bits()};
+  auto& proof_cache = LiteProofCache::instance();
+  proof = proof_cache.get_config_param_proof(mc_state_hash, mode & 0xffff, param);
+  if (proof.not_null()) {
+    return true;
+  }
+  vm::MerkleProofBuilder mpb{mc_state_->root_cell()};
+  std::unique_ptr<block::Config> cfg;
+  if (!(mode & block::ConfigInfo::needPrevBlocks)) {
+    auto res = block::Config::extract_from_state(mpb.root(), mode);
+    if (res.is_error()) {
+      return fatal_error(res.move_as_error());
+    }
+    cfg = res.move_as_ok();
+  } else {
+    auto res = block::ConfigInfo::extract_config(mpb.root(), mc_state_->get_block_id(), mode);
+    if (res.is_error()) {
+      return fatal_error(res.move_as_error());
+    }
+    cfg = res.move_as_ok();
+  }
+  if (!cfg) {
+    return fatal_error("cannot extract configuration from last mc state");
+  }
+  try {
+    if (param == -1) {
+      visit(cfg->get_root_cell());
+    } else if (param >= 0) {
+      visit(cfg->get_config_param(param));
+    }
+    if (mode & block::ConfigInfo::needPrevBlocks) {
+      ((block::ConfigInfo*)cfg.get())->get_prev_blocks_info();
+    }
+  } catch (vm::VmError& err) {
+    return fatal_error("error while traversing required configuration parameters: "s + err.get_msg());
+  }
+  if (!mpb.extract_proof_to(proof)) {
+    return fatal_error("unknown error creating Merkle proof");
+  }
+  proof_cache.set_config_param_proof(mc_state_hash, mode & 0xffff, param, proof);
+  return true;
+}
+
 void LiteQuery::perform_getAllShardsInfo(BlockIdExt blkid) {
   LOG(INFO) << "started a getAllShardsInfo(" << blkid.to_str() << ") liteserver query";
   set_continuation([&]() -> void { continue_getAllShardsInfo(); });
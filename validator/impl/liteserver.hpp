@@ -20,6 +20,7 @@
 #include "ton/ton-types.h"
 #include "td/actor/actor.h"
 #include "td/utils/Time.h"
+#include "td/utils/Timer.h"
 #include "interfaces/block-handle.h"
 #include "interfaces/validator-manager.h"
 #include "interfaces/shard.h"
@@ -41,8 +42,6 @@ class LiteQuery : public td::actor::Actor {
   td::Timestamp timeout_;
   td::Promise<td::BufferSlice> promise_;
 
-  td::Promise<std::tuple<td::Ref<vm::CellSlice>,UnixTime,LogicalTime,std::unique_ptr<block::ConfigInfo>>> acc_state_promise_;
-
   tl_object_ptr<ton::lite_api::Function> query_obj_;
   bool use_cache_{false};
   td::Bits256 cache_key_;
@@ -72,25 +71,42 @@ class LiteQuery : public td::actor::Actor {
   td::BufferSlice lookup_header_proof_;
   td::BufferSlice lookup_prev_header_proof_;
 
+  struct BatchShard {
+    Ref<BlockQ> block;
+    Ref<ShardStateQ> state;
+    std::vector<StdSmcAddress> accounts;
+  };
+  std::vector<std::pair<WorkchainId, StdSmcAddress>> batch_accounts_;
+  std::map<BlockIdExt, BatchShard> batch_shards_;
+  std::vector<std::pair<WorkchainId, StdSmcAddress>> batch_unknown_accounts_;
+  td::Timer batch_timer_;
+
  public:
   enum {
     default_timeout_msec = 4500,      // 4.5 seconds
     max_transaction_count = 16,       // fetch at most 16 transactions in one query
-    client_method_gas_limit = 300000  // gas limit for liteServer.runSmcMethod
+    client_method_gas_limit = 300000,  // gas limit for liteServer.runSmcMethod
+    max_batch_accounts = 1024          // accounts in one liteServer.getAccountStates query
   };
+  // version 1.1; +1 = build block proof chains, +2 = masterchainInfoExt, +4 = runSmcMethod, +8 = getAccountStates
   enum {
     ls_version = 0x101,
-    ls_capabilities = 7
-  };  // version 1.1; +1 = build block proof chains, +2 = masterchainInfoExt, +4 = runSmcMethod
+    ls_capabilities = 15
+  };
   LiteQuery(td::BufferSlice data, td::actor::ActorId<ton::validator::ValidatorManager> manager,
             td::actor::ActorId<LiteServerCache> cache, td::Promise<td::BufferSlice> promise);
-  LiteQuery(WorkchainId wc, StdSmcAddress  acc_addr, td::actor::ActorId<ton::validator::ValidatorManager> manager,
-            td::Promise<std::tuple<td::Ref<vm::CellSlice>,UnixTime,LogicalTime,std::unique_ptr<block::ConfigInfo>>> promise);
   static void run_query(td::BufferSlice data, td::actor::ActorId<ton::validator::ValidatorManager> manager,
                         td::actor::ActorId<LiteServerCache> cache, td::Promise<td::BufferSlice> promise);
 
-  static void fetch_account_state(WorkchainId wc, StdSmcAddress  acc_addr, td::actor::ActorId<ton::validator::ValidatorManager> manager,
-                                  td::Promise<std::tuple<td::Ref<vm::CellSlice>,UnixTime,LogicalTime,std::unique_ptr<block::ConfigInfo>>> promise);
+  struct AccountStatesStats {
+    td::uint64 batches{0};
+    td::uint64 accounts{0};
+    td::uint64 shard_blocks{0};
+    double load_time{0};
+    double proof_time{0};
+  };
+  // totals of liteServer.getAccountStates queries completed since the previous call
+  static AccountStatesStats get_account_states_stats_and_reset();
 
  private:
   bool fatal_error(td::Status error);
@@ -106,7 +122,6 @@ class LiteQuery : public td::actor::Actor {
   void perform_getVersion();
   void perform_getMasterchainInfo(int mode);
   void continue_getMasterchainInfo(Ref<MasterchainState> mc_state, BlockIdExt blkid, int mode);
-  void gotMasterchainInfoForAccountState(Ref<MasterchainState> mc_state, BlockIdExt blkid, int mode);
   void perform_getBlock(BlockIdExt blkid);
   void continue_getBlock(BlockIdExt blkid, Ref<BlockData> block);
   void perform_getBlockHeader(BlockIdExt blkid, int mode);
@@ -119,7 +134,12 @@ class LiteQuery : public td::actor::Actor {
   void continue_getAccountState_0(Ref<MasterchainState> mc_state, BlockIdExt blkid);
   void continue_getAccountState();
   void finish_getAccountState(td::BufferSlice shard_proof);
-  void perform_fetchAccountState();
+  void perform_getAccountStates(BlockIdExt blkid, int mode,
+                                std::vector<std::pair<WorkchainId, StdSmcAddress>> accounts);
+  void continue_getAccountStates();
+  void got_batch_block_data(BlockIdExt blkid, Ref<BlockData> data);
+  void got_batch_block_state(BlockIdExt blkid, Ref<ShardState> state);
+  void finish_getAccountStates();
   void perform_runSmcMethod(BlockIdExt blkid, WorkchainId workchain, StdSmcAddress addr, int mode, td::int64 method_id,
                             td::BufferSlice params);
   void finish_runSmcMethod(td::BufferSlice shard_proof, td::BufferSlice state_proof, Ref<vm::Cell> acc_root,
@@ -141,6 +161,7 @@ class LiteQuery : public td::actor::Actor {
   void continue_getAllShardsInfo();
   void perform_getConfigParams(BlockIdExt blkid, int mode, std::vector<int> param_list = {});
   void continue_getConfigParams(int mode, std::vector<int> param_list);
+  void continue_getConfigParams_from_state(int mode, std::vector<int> param_list);
   void perform_lookupBlock(BlockId blkid, int mode, LogicalTime lt, UnixTime utime);
   void perform_lookupBlockWithProof(BlockId blkid, BlockIdExt client_mc_blkid, int mode, LogicalTime lt, UnixTime utime);
   void continue_lookupBlockWithProof_getHeaderProof(Ref<ton::validator::BlockData> block, AccountIdPrefixFull req_prefix, BlockSeqno masterchain_ref_seqno);
@@ -221,6 +242,7 @@ class LiteQuery : public td::actor::Actor {
   bool make_shard_info_proof(Ref<vm::Cell>& proof, Ref<block::McShardHash>& info, ShardIdFull shard, bool exact = true);
   bool make_shard_info_proof(Ref<vm::Cell>& proof, Ref<block::McShardHash>& info, AccountIdPrefixFull prefix);
   bool make_shard_info_proof(Ref<vm::Cell>& proof, BlockIdExt& blkid, AccountIdPrefixFull prefix);
+  bool make_config_param_proof(Ref<vm::Cell>& proof, int mode, int param);
   bool make_ancestor_block_proof(Ref<vm::Cell>& proof, Ref<MasterchainState> mc_state, const BlockIdExt& old_blkid);
 };
 
@@ -27,6 +27,9 @@
 #include "block/block-parse.h"
 #include "block/block-auto.h"
 #include "td/utils/filesystem.h"
+#include "td/utils/port/thread.h"
+
+#include <algorithm>
 
 #define LAZY_STATE_DESERIALIZE 1
 
@@ -36,6 +39,10 @@ namespace validator {
 using td::Ref;
 using namespace std::literals::string_literals;
 
+size_t state_update_extra_threads() {
+  return std::clamp(td::thread::hardware_concurrency() / 2, 1u, 8u);
+}
+
 ShardStateQ::ShardStateQ(const ShardStateQ& other)
     : blkid(other.blkid)
     , rhash(other.rhash)
@@ -202,7 +209,7 @@ td::Status ShardStateQ::apply_block(BlockIdExt newid, td::Ref<BlockData> block)
     return td::Status::Error(-666, "invalid shardchain block header for block "s + block->block_id().id.to_str());
   }
   Ref<vm::Cell> update = cs.prefetch_ref(2);  // Merkle update
-  auto next_state_root = vm::MerkleUpdate::apply(root, update);
+  auto next_state_root = vm::MerkleUpdate::apply(root, update, state_update_extra_threads());
   if (next_state_root.is_null()) {
     return td::Status::Error("cannot apply Merkle update from block "s + block->block_id().id.to_str() +
                              " to previous state");
@@ -375,7 +382,7 @@ td::Status MasterchainStateQ::mc_init() {
 }
 
 td::Status MasterchainStateQ::mc_reinit() {
-  auto res = block::ConfigInfo::extract_config(
+  auto res = block::ConfigInfo::extract_config_cached(
       root_cell(), blkid,
       block::ConfigInfo::needStateRoot | block::ConfigInfo::needValidatorSet | block::ConfigInfo::needShardHashes |
           block::ConfigInfo::needPrevBlocks | block::ConfigInfo::needWorkchainInfo);
@@ -158,7 +158,7 @@ class MasterchainStateQ : public MasterchainState, public ShardStateQ {
   bool get_old_mc_block_id(ton::BlockSeqno seqno, ton::BlockIdExt& blkid,
                            ton::LogicalTime* end_lt = nullptr) const override;
   bool check_old_mc_block_id(const ton::BlockIdExt& blkid, bool strict = false) const override;
-  std::shared_ptr<block::ConfigInfo> get_config() const {
+  std::shared_ptr<const block::ConfigInfo> get_config() const {
     return config_;
   }
   td::Result<td::Ref<ConfigHolder>> get_config_holder() const override {
@@ -174,7 +174,7 @@ class MasterchainStateQ : public MasterchainState, public ShardStateQ {
 
  private:
   ZeroStateIdExt zerostate_id_;
-  std::shared_ptr<block::ConfigInfo> config_;
+  std::shared_ptr<const block::ConfigInfo> config_;
   std::shared_ptr<block::ValidatorSet> cur_validators_, next_validators_;
   MasterchainStateQ(const MasterchainStateQ& other) = default;
   td::Status mc_init();
@@ -186,5 +186,8 @@ class MasterchainStateQ : public MasterchainState, public ShardStateQ {
 #pragma warning(pop)
 #endif
 
+// number of extra threads for Merkle updates of shard states and for comparing their dictionaries
+size_t state_update_extra_threads();
+
 }  // namespace validator
 }  // namespace ton
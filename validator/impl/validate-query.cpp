@@ -1008,7 +1008,7 @@ bool ValidateQuery::try_unpack_mc_state() {
     if (mc_state_root_.is_null()) {
       return fatal_error(-666, "latest masterchain state does not have a root cell");
     }
-    auto res = block::ConfigInfo::extract_config(
+    auto res = block::ConfigInfo::extract_config_cached(
         mc_state_root_, mc_blkid_,
         block::ConfigInfo::needShardHashes | block::ConfigInfo::needLibraries | block::ConfigInfo::needValidatorSet |
             block::ConfigInfo::needWorkchainInfo | block::ConfigInfo::needStateExtraRoot |
@@ -1134,6 +1134,7 @@ bool ValidateQuery::fetch_config_params() {
     compute_phase_cfg_.block_rand_seed = rand_seed_;
     compute_phase_cfg_.libraries = std::make_unique<vm::Dictionary>(config_->get_libraries_root(), 256);
     compute_phase_cfg_.max_vm_data_depth = size_limits.max_vm_data_depth;
+    compute_phase_cfg_.lazy_cell_hashes = true;
     compute_phase_cfg_.global_config = config_->get_root_cell();
     compute_phase_cfg_.global_version = config_->get_global_version();
     if (compute_phase_cfg_.global_version >= 4) {
@@ -1466,7 +1467,7 @@ bool ValidateQuery::compute_next_state() {
   if (res.is_error()) {
     return reject_query("state update cannot be applied: "s + res.move_as_error().to_string());
   }
-  state_root_ = vm::MerkleUpdate::apply(prev_state_root_, state_update_);
+  state_root_ = vm::MerkleUpdate::apply(prev_state_root_, state_update_, state_update_extra_threads());
   if (state_root_.is_null()) {
     return reject_query("cannot apply Merkle update from block to compute new state");
   }
@@ -3122,14 +3123,18 @@ bool ValidateQuery::precheck_account_updates() {
   LOG(INFO) << "pre-checking all Account updates between the old and the new state";
   try {
     CHECK(ps_.account_dict_ && ns_.account_dict_);
-    if (!ps_.account_dict_->scan_diff(
+    if (!ps_.account_dict_->scan_diff_batched(
             *ns_.account_dict_,
-            [this](td::ConstBitPtr key, int key_len, Ref<vm::CellSlice> old_val_extra,
-                   Ref<vm::CellSlice> new_val_extra) {
-              CHECK(key_len == 256);
-              return precheck_one_account_update(key, std::move(old_val_extra), std::move(new_val_extra));
+            [this](const vm::ScanDiffBatch& batch) {
+              CHECK(batch.key_len == 256);
+              for (size_t i = 0; i < batch.size(); i++) {
+                if (!precheck_one_account_update(batch.key(i), batch.values[i].first, batch.values[i].second)) {
+                  return false;
+                }
+              }
+              return true;
             },
-            2 /* check augmentation of changed nodes in the new dict */)) {
+            2 /* check augmentation of changed nodes in the new dict */, state_update_extra_threads())) {
       return reject_query("invalid ShardAccounts dictionary in the new state");
     }
   } catch (vm::VmError& err) {
@@ -3569,14 +3574,18 @@ bool ValidateQuery::precheck_message_queue_update() {
     CHECK(ps_.out_msg_queue_ && ns_.out_msg_queue_);
     CHECK(out_msg_dict_);
     new_out_msg_queue_size_ = old_out_msg_queue_size_;
-    if (!ps_.out_msg_queue_->scan_diff(
+    if (!ps_.out_msg_queue_->scan_diff_batched(
             *ns_.out_msg_queue_,
-            [this](td::ConstBitPtr key, int key_len, Ref<vm::CellSlice> old_val_extra,
-                   Ref<vm::CellSlice> new_val_extra) {
-              CHECK(key_len == 352);
-              return precheck_one_message_queue_update(key, std::move(old_val_extra), std::move(new_val_extra));
+            [this](const vm::ScanDiffBatch& batch) {
+              CHECK(batch.key_len == 352);
+              for (size_t i = 0; i < batch.size(); i++) {
+                if (!precheck_one_message_queue_update(batch.key(i), batch.values[i].first, batch.values[i].second)) {
+                  return false;
+                }
+              }
+              return true;
             },
-            2 /* check augmentation of changed nodes in the new dict */)) {
+            2 /* check augmentation of changed nodes in the new dict */, state_update_extra_threads())) {
       return reject_query("invalid OutMsgQueue dictionary in the new state");
     }
   } catch (vm::VmError& err) {
@@ -5499,7 +5508,8 @@ std::unique_ptr<block::Account> ValidateQuery::unpack_account(td::ConstBitPtr ad
         }
         LOG(DEBUG) << "Inited storage stat from cache for account " << addr.to_hex(256) << " ("
                    << new_acc->storage_used.cells << " cells)";
-        storage_stat_cache_update_.emplace_back(dict_root, new_acc->storage_used.cells);
+        storage_stat_cache_update_.push_back(
+            {new_acc->workchain, new_acc->addr, dict_root, new_acc->storage_used.cells});
         stats_.storage_stat_cache.hit_cnt++;
         stats_.storage_stat_cache.hit_cells += new_acc->storage_used.cells;
       } else if (new_acc->storage_used.cells >= StorageStatCache::MIN_ACCOUNT_CELLS) {
@@ -6124,8 +6134,9 @@ bool ValidateQuery::check_account_transactions(const StdSmcAddress& acc_addr, Re
   if ((!full_collated_data_ || is_masterchain()) && account.storage_dict_hash && account.account_storage_stat &&
       account.account_storage_stat.value().is_dict_ready() &&
       account.storage_used.cells >= StorageStatCache::MIN_ACCOUNT_CELLS) {
-    storage_stat_cache_update_.emplace_back(account.account_storage_stat.value().get_dict_root().move_as_ok(),
-                                            account.storage_used.cells);
+    storage_stat_cache_update_.push_back({account.workchain, account.addr,
+                                          account.account_storage_stat.value().get_dict_root().move_as_ok(),
+                                          account.storage_used.cells});
   }
   if (is_masterchain() && account.libraries_changed()) {
     return scan_account_libraries(account.orig_library, account.library, acc_addr);
@@ -179,7 +179,8 @@ class ValidateQuery : public td::actor::Actor {
   Ref<BlockSignatureSet> prev_signatures_;       // from McBlockExtra (UNCHECKED)
   Ref<vm::Cell> recover_create_msg_, mint_msg_;  // from McBlockExtra (UNCHECKED)
 
-  std::unique_ptr<block::ConfigInfo> config_, new_config_;
+  std::shared_ptr<const block::ConfigInfo> config_;
+  std::unique_ptr<block::ConfigInfo> new_config_;
   std::unique_ptr<block::ShardConfig> old_shard_conf_;  // from reference mc state
   std::unique_ptr<block::ShardConfig> new_shard_conf_;  // from shard_hashes_ in mc blocks
   Ref<block::WorkchainInfo> wc_info_;
@@ -248,7 +249,7 @@ class ValidateQuery : public td::actor::Actor {
   bool have_out_msg_queue_size_in_state_ = false;
 
   std::function<td::Ref<vm::Cell>(const td::Bits256&)> storage_stat_cache_;
-  std::vector<std::pair<td::Ref<vm::Cell>, td::uint32>> storage_stat_cache_update_;
+  std::vector<StorageStatCacheUpdate> storage_stat_cache_update_;
 
   bool msg_metadata_enabled_ = false;
   bool deferring_messages_enabled_ = false;
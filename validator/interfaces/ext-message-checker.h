@@ -0,0 +1,35 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "td/actor/actor.h"
+#include "validator/interfaces/external-message.h"
+#include "validator/interfaces/shard.h"
+
+namespace ton::validator {
+
+class ExtMessageChecker : public td::actor::Actor {
+ public:
+  ~ExtMessageChecker() override = default;
+
+  // runs the message on the destination account in the state referenced by mc_state (accept_message check)
+  virtual void check_message(td::Ref<ExtMessage> message, td::Ref<MasterchainState> mc_state,
+                             td::Promise<td::Ref<ExtMessage>> promise) = 0;
+  virtual void prepare_stats(td::Promise<std::vector<std::pair<std::string, std::string>>> promise) = 0;
+};
+
+}  // namespace ton::validator
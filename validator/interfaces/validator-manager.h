@@ -59,6 +59,15 @@ struct StorageStatCacheStats {
   td::uint64 small_cnt = 0, small_cells = 0;
   td::uint64 hit_cnt = 0, hit_cells = 0;
   td::uint64 miss_cnt = 0, miss_cells = 0;
+  // time the collator spent computing storage dicts from scratch on cache misses; the validator computes them
+  // lazily inside transactions, so this is not measured there and stays zero in validation stats
+  double collator_recount_time = 0.0;
+
+  // collator recount time that the cache hits are estimated to have saved, assuming the same time per cell
+  // as on misses
+  double collator_estimated_saved_time() const {
+    return miss_cells == 0 ? 0.0 : collator_recount_time * (double)hit_cells / (double)miss_cells;
+  }
 
   tl_object_ptr<ton_api::validatorStats_storageStatCacheStats> tl() const {
     return create_tl_object<ton_api::validatorStats_storageStatCacheStats>(small_cnt, small_cells, hit_cnt, hit_cells,
@@ -66,6 +75,14 @@ struct StorageStatCacheStats {
   }
 };
 
+// new storage dict of a large account, sent to the storage stat cache after a block is collated or validated
+struct StorageStatCacheUpdate {
+  WorkchainId workchain;
+  td::Bits256 addr;
+  td::Ref<vm::Cell> dict_root;
+  td::uint32 cells;
+};
+
 struct CollationStats {
   BlockIdExt block_id{workchainInvalid, 0, 0, RootHash::zero(), FileHash::zero()};
   td::Status status = td::Status::OK();
@@ -384,7 +401,7 @@ class ValidatorManager : public ValidatorManagerInterface {
   virtual void get_storage_stat_cache(td::Promise<std::function<td::Ref<vm::Cell>(const td::Bits256&)>> promise) {
     promise.set_error(td::Status::Error("not implemented"));
   }
-  virtual void update_storage_stat_cache(std::vector<std::pair<td::Ref<vm::Cell>, td::uint32>> data) {
+  virtual void update_storage_stat_cache(std::vector<StorageStatCacheUpdate> data) {
     // not implemented
   }
 
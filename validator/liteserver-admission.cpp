@@ -0,0 +1,311 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "liteserver-admission.hpp"
+
+#include "auto/tl/lite_api.h"
+#include "common/errorcode.h"
+#include "td/utils/tl_parsers.h"
+#include "td/utils/Time.h"
+#include "tl-utils/common-utils.hpp"
+
+namespace ton::validator {
+
+void LiteServerAdmission::TokenBucket::refill(double now) {
+  tokens_ = std::min(burst_, tokens_ + std::max(now - refilled_at_, 0.0) * rate_);
+  refilled_at_ = now;
+}
+
+bool LiteServerAdmission::TokenBucket::take(double cost, double now) {
+  refill(now);
+  if (tokens_ < cost) {
+    return false;
+  }
+  tokens_ -= cost;
+  return true;
+}
+
+bool LiteServerAdmission::TokenBucket::is_full(double now) const {
+  return tokens_ + std::max(now - refilled_at_, 0.0) * rate_ >= burst_;
+}
+
+td::Slice LiteServerAdmission::query_header(td::Slice data) {
+  // the inner query is unaligned, so it is cut to avoid copying all of it in TlParser
+  const size_t header_size = 16;
+  td::TlParser parser(data);
+  if (parser.fetch_int() == lite_api::liteServer_query::ID) {
+    auto query = parser.fetch_string<td::Slice>();
+    return parser.get_error() ? td::Slice() : query.substr(0, header_size);
+  }
+  return data.substr(std::min<size_t>(4, data.size()), header_size);
+}
+
+td::uint32 LiteServerAdmission::query_cost(td::Slice data) {
+  td::TlParser parser(query_header(data));
+  auto id = parser.fetch_int();
+  if (id == lite_api::liteServer_waitMasterchainSeqno::ID) {
+    parser.fetch_int();
+    parser.fetch_int();
+    id = parser.fetch_int();
+  }
+  if (parser.get_error()) {
+    return 1;
+  }
+  switch (id) {
+    case lite_api::liteServer_getMasterchainInfo::ID:
+    case lite_api::liteServer_getMasterchainInfoExt::ID:
+    case lite_api::liteServer_getTime::ID:
+    case lite_api::liteServer_getVersion::ID:
+      return 1;
+    case lite_api::liteServer_getBlock::ID:
+    case lite_api::liteServer_getOneTransaction::ID:
+    case lite_api::liteServer_getTransactions::ID:
+    case lite_api::liteServer_lookupBlockWithProof::ID:
+    case lite_api::liteServer_listBlockTransactions::ID:
+    case lite_api::liteServer_listBlockTransactionsExt::ID:
+    case lite_api::liteServer_getBlockProof::ID:
+    case lite_api::liteServer_getConfigAll::ID:
+    case lite_api::liteServer_getValidatorStats::ID:
+    case lite_api::liteServer_getLibrariesWithProof::ID:
+    case lite_api::liteServer_getShardBlockProof::ID:
+    case lite_api::liteServer_getBlockOutMsgQueueSize::ID:
+    case lite_api::liteServer_getDispatchQueueInfo::ID:
+    case lite_api::liteServer_getDispatchQueueMessages::ID:
+      return 4;
+    case lite_api::liteServer_runSmcMethod::ID:
+      return 8;
+    case lite_api::liteServer_getAccountStates::ID:
+      return 16;
+    case lite_api::liteServer_getState::ID:
+      return MAX_QUERY_COST;
+    default:
+      return 2;
+  }
+}
+
+bool LiteServerAdmission::get_wait_seqno(td::Slice data, BlockSeqno &seqno, double &timeout) {
+  td::TlParser parser(query_header(data));
+  if (parser.fetch_int() != lite_api::liteServer_waitMasterchainSeqno::ID) {
+    return false;
+  }
+  seqno = parser.fetch_int();
+  auto timeout_ms = parser.fetch_int();
+  if (parser.get_error()) {
+    return false;
+  }
+  timeout = std::min(timeout_ms * 0.001, MAX_WAIT_SEQNO_TIMEOUT);
+  return true;
+}
+
+void LiteServerAdmission::start_up() {
+  next_report_ = td::Timestamp::in(REPORT_PERIOD);
+  alarm_timestamp() = td::Timestamp::in(1.0);
+}
+
+void LiteServerAdmission::alarm() {
+  while (!queue_.empty() && queue_.front().timeout.is_in_past()) {
+    auto &q = queue_.front();
+    clients_[q.src].queued--;
+    stats_.timed_out++;
+    reject(std::move(q.promise), td::Status::Error(ErrorCode::timeout, "timeout in liteserver queue"));
+    queue_.pop_front();
+  }
+  if (next_report_.is_in_past()) {
+    next_report_ = td::Timestamp::in(REPORT_PERIOD);
+    if (stats_.served + stats_.waited + stats_.rejected_rate + stats_.rejected_queue + stats_.timed_out > 0) {
+      LOG(WARNING) << "LS admission stats: " << stats_.served << " served (cost " << stats_.served_cost << "), "
+                   << stats_.queued << " queued (avg wait "
+                   << (stats_.queued ? stats_.total_wait / (double)stats_.queued : 0.0) << "s, max wait "
+                   << stats_.max_wait << "s), " << stats_.waited << " waited for seqno, rejected: "
+                   << stats_.rejected_rate << " by rate limit, " << stats_.rejected_queue << " by queue size, " << stats_.timed_out << " by timeout; "
+                   << clients_.size() << " clients, running cost " << running_cost_ << "/" << max_cost_
+                   << ", queue size " << queue_.size();
+    }
+    total_stats_.served += stats_.served;
+    total_stats_.queued += stats_.queued;
+    total_stats_.waited += stats_.waited;
+    total_stats_.rejected_rate += stats_.rejected_rate;
+    total_stats_.rejected_queue += stats_.rejected_queue;
+    total_stats_.timed_out += stats_.timed_out;
+    total_stats_.served_cost += stats_.served_cost;
+    total_stats_.total_wait += stats_.total_wait;
+    total_stats_.max_wait = std::max(total_stats_.max_wait, stats_.max_wait);
+    stats_ = Stats{};
+
+    // forget idle clients whose bucket is full again
+    double now = td::Time::now();
+    for (auto it = clients_.begin(); it != clients_.end();) {
+      auto &client = it->second;
+      if (client.running_cost == 0 && client.queued == 0 && client.waiting == 0 &&
+          (client_rate_ <= 0.0 || client.bucket.is_full(now))) {
+        it = clients_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+  alarm_timestamp() = td::Timestamp::in(1.0);
+}
+
+void LiteServerAdmission::run_query(adnl::AdnlNodeIdShort src, td::BufferSlice data,
+                                    td::Promise<td::BufferSlice> promise) {
+  td::uint32 cost = query_cost(data.as_slice());
+  auto it = clients_.find(src);
+  if (it == clients_.end()) {
+    it = clients_.emplace(src, Client{TokenBucket{client_rate_, client_burst(), td::Time::now()}}).first;
+  }
+  auto &client = it->second;
+  if (client_rate_ > 0.0 && !client.bucket.take(cost, td::Time::now())) {
+    stats_.rejected_rate++;
+    reject(std::move(promise), td::Status::Error(ErrorCode::error, "rate limit exceeded"));
+    return;
+  }
+  BlockSeqno seqno;
+  double timeout;
+  if (!get_wait_seqno(data.as_slice(), seqno, timeout)) {
+    admit_query(src, client, cost, std::move(data), std::move(promise));
+    return;
+  }
+  // the query does not hold the running cost while it waits for the masterchain block
+  if (client.waiting >= MAX_CLIENT_QUEUE_SIZE) {
+    stats_.rejected_queue++;
+    reject(std::move(promise), td::Status::Error(ErrorCode::notready, "liteserver is overloaded"));
+    return;
+  }
+  client.waiting++;
+  stats_.waited++;
+  callback_->wait_masterchain_seqno(
+      seqno, td::Timestamp::in(timeout),
+      [SelfId = actor_id(this), src, cost, data = std::move(data),
+       promise = std::move(promise)](td::Result<td::Unit> R) mutable {
+        td::actor::send_closure(SelfId, &LiteServerAdmission::seqno_ready, src, cost, std::move(data),
+                                std::move(promise), std::move(R));
+      });
+}
+
+void LiteServerAdmission::seqno_ready(adnl::AdnlNodeIdShort src, td::uint32 cost, td::BufferSlice data,
+                                      td::Promise<td::BufferSlice> promise, td::Result<td::Unit> R) {
+  auto &client = clients_[src];
+  CHECK(client.waiting > 0);
+  client.waiting--;
+  if (R.is_error()) {
+    reject(std::move(promise), R.move_as_error());
+    return;
+  }
+  admit_query(src, client, cost, std::move(data), std::move(promise));
+}
+
+void LiteServerAdmission::admit_query(adnl::AdnlNodeIdShort src, Client &client, td::uint32 cost,
+                                      td::BufferSlice data, td::Promise<td::BufferSlice> promise) {
+  if (queue_.empty() && can_run(client, cost)) {
+    start_query(src, client, cost, std::move(data), std::move(promise));
+    return;
+  }
+  if (queue_.size() >= MAX_QUEUE_SIZE || client.queued >= MAX_CLIENT_QUEUE_SIZE) {
+    stats_.rejected_queue++;
+    reject(std::move(promise), td::Status::Error(ErrorCode::notready, "liteserver is overloaded"));
+    return;
+  }
+  client.queued++;
+  stats_.queued++;
+  queue_.push_back(
+      PendingQuery{src, cost, std::move(data), std::move(promise), td::Timestamp::in(QUEUE_TIMEOUT), td::Time::now()});
+  if (queue_.size() > 1) {
+    // the queue may be held only by clients that are at their own limit
+    process_queue();
+  }
+}
+
+bool LiteServerAdmission::can_run(const Client &client, td::uint32 cost) const {
+  // a query always runs if nothing else is running, so that cost > max_cost does not block it forever
+  if (running_cost_ > 0 && running_cost_ + cost > max_cost_) {
+    return false;
+  }
+  return max_client_cost_ == 0 || client.running_cost == 0 || client.running_cost + cost <= max_client_cost_;
+}
+
+void LiteServerAdmission::start_query(adnl::AdnlNodeIdShort src, Client &client, td::uint32 cost,
+                                      td::BufferSlice data, td::Promise<td::BufferSlice> promise) {
+  running_cost_ += cost;
+  client.running_cost += cost;
+  auto P = td::PromiseCreator::lambda([SelfId = actor_id(this), src, cost,
+                                       promise = std::move(promise)](td::Result<td::BufferSlice> R) mutable {
+    td::actor::send_closure(SelfId, &LiteServerAdmission::query_finished, src, cost);
+    promise.set_result(std::move(R));
+  });
+  callback_->run_query(std::move(data), std::move(P));
+}
+
+void LiteServerAdmission::query_finished(adnl::AdnlNodeIdShort src, td::uint32 cost) {
+  CHECK(running_cost_ >= cost);
+  running_cost_ -= cost;
+  auto it = clients_.find(src);
+  CHECK(it != clients_.end() && it->second.running_cost >= cost);
+  it->second.running_cost -= cost;
+  stats_.served++;
+  stats_.served_cost += cost;
+  process_queue();
+}
+
+void LiteServerAdmission::process_queue() {
+  // queries of clients that are at their own limit are skipped, others keep the FIFO order
+  for (auto it = queue_.begin(); it != queue_.end() && running_cost_ < max_cost_;) {
+    auto &client = clients_[it->src];
+    if (!can_run(client, it->cost)) {
+      if (running_cost_ + it->cost > max_cost_) {
+        break;
+      }
+      ++it;
+      continue;
+    }
+    double wait = td::Time::now() - it->queued_at;
+    stats_.total_wait += wait;
+    stats_.max_wait = std::max(stats_.max_wait, wait);
+    client.queued--;
+    start_query(it->src, client, it->cost, std::move(it->data), std::move(it->promise));
+    it = queue_.erase(it);
+  }
+}
+
+void LiteServerAdmission::reject(td::Promise<td::BufferSlice> promise, td::Status error) {
+  promise.set_value(create_serialize_tl_object<lite_api::liteServer_error>(error.code(), error.message().c_str()));
+}
+
+void LiteServerAdmission::prepare_stats(td::Promise<std::vector<std::pair<std::string, std::string>>> promise) {
+  auto total = total_stats_;
+  total.served += stats_.served;
+  total.queued += stats_.queued;
+  total.waited += stats_.waited;
+  total.rejected_rate += stats_.rejected_rate;
+  total.rejected_queue += stats_.rejected_queue;
+  total.timed_out += stats_.timed_out;
+  total.served_cost += stats_.served_cost;
+  total.total_wait += stats_.total_wait;
+  total.max_wait = std::max(total.max_wait, stats_.max_wait);
+  std::vector<std::pair<std::string, std::string>> vec;
+  vec.emplace_back("served", PSTRING() << "count:" << total.served << " cost:" << total.served_cost);
+  vec.emplace_back("queued", PSTRING() << "count:" << total.queued << " avg_wait:"
+                                       << (total.queued ? total.total_wait / (double)total.queued : 0.0)
+                                       << " max_wait:" << total.max_wait);
+  vec.emplace_back("waited_seqno", PSTRING() << total.waited);
+  vec.emplace_back("rejected", PSTRING() << "rate:" << total.rejected_rate << " queue:" << total.rejected_queue
+                                         << " timeout:" << total.timed_out);
+  vec.emplace_back("current", PSTRING() << "clients:" << clients_.size() << " running_cost:" << running_cost_ << "/"
+                                        << max_cost_ << " queue:" << queue_.size());
+  promise.set_value(std::move(vec));
+}
+
+}  // namespace ton::validator
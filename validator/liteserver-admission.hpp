@@ -0,0 +1,152 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "adnl/adnl-node-id.hpp"
+#include "td/actor/actor.h"
+#include "ton/ton-types.h"
+
+#include <algorithm>
+#include <list>
+#include <map>
+
+namespace ton::validator {
+
+/**
+ * Admission control for liteserver queries received from ADNL clients.
+ *
+ * Every query gets a cost estimate by its type (runSmcMethod and getState are much more expensive than
+ * getMasterchainInfo). Clients are identified by src: the ADNL id of an authenticated ext client, or an id derived
+ * from the remote IP address for anonymous ones (see AdnlInboundConnection). Each client has a token bucket refilled
+ * at client_rate cost units per second; queries that do not fit into it are rejected at once. Accepted queries run
+ * while the total cost of running queries is below max_cost (and below max_client_cost for a single client, if set),
+ * the rest wait in a bounded FIFO queue and are rejected when the queue is full or after a timeout.
+ *
+ * Queries wrapped in liteServer.waitMasterchainSeqno first wait for the seqno outside of the admission control, so
+ * that parked queries do not hold the running cost.
+ */
+class LiteServerAdmission : public td::actor::Actor {
+ public:
+  class Callback {
+   public:
+    virtual ~Callback() = default;
+    virtual void run_query(td::BufferSlice data, td::Promise<td::BufferSlice> promise) = 0;
+    virtual void wait_masterchain_seqno(BlockSeqno seqno, td::Timestamp timeout, td::Promise<td::Unit> promise) = 0;
+  };
+
+  // Refilled at rate cost units per second, holds at most burst units
+  class TokenBucket {
+   public:
+    TokenBucket() = default;
+    TokenBucket(double rate, double burst, double now) : rate_(rate), burst_(burst), tokens_(burst), refilled_at_(now) {
+    }
+    bool take(double cost, double now);
+    bool is_full(double now) const;
+
+   private:
+    double rate_{0.0};
+    double burst_{0.0};
+    double tokens_{0.0};
+    double refilled_at_{0.0};
+
+    void refill(double now);
+  };
+
+  // max_client_cost = 0 disables per-client limits on the running cost, client_rate = 0 disables per-client rate limits
+  LiteServerAdmission(std::unique_ptr<Callback> callback, td::uint32 max_cost, td::uint32 max_client_cost,
+                      double client_rate)
+      : callback_(std::move(callback))
+      , max_cost_(max_cost)
+      , max_client_cost_(max_client_cost)
+      , client_rate_(client_rate) {
+  }
+
+  void start_up() override;
+  void alarm() override;
+
+  void run_query(adnl::AdnlNodeIdShort src, td::BufferSlice data, td::Promise<td::BufferSlice> promise);
+  void prepare_stats(td::Promise<std::vector<std::pair<std::string, std::string>>> promise);
+
+  static td::uint32 query_cost(td::Slice data);
+  // returns true if the query is wrapped in liteServer.waitMasterchainSeqno
+  static bool get_wait_seqno(td::Slice data, BlockSeqno &seqno, double &timeout);
+
+ private:
+  struct Client {
+    TokenBucket bucket;
+    td::uint32 running_cost{0};
+    td::uint32 queued{0};
+    td::uint32 waiting{0};
+  };
+  struct PendingQuery {
+    adnl::AdnlNodeIdShort src;
+    td::uint32 cost;
+    td::BufferSlice data;
+    td::Promise<td::BufferSlice> promise;
+    td::Timestamp timeout;
+    double queued_at;
+  };
+  struct Stats {
+    td::uint64 served{0};
+    td::uint64 queued{0};
+    td::uint64 waited{0};
+    td::uint64 rejected_rate{0};
+    td::uint64 rejected_queue{0};
+    td::uint64 timed_out{0};
+    td::uint64 served_cost{0};
+    double total_wait{0.0};
+    double max_wait{0.0};
+  };
+
+  // waitMasterchainSeqno prefix (if any) and the constructor id of the query
+  static td::Slice query_header(td::Slice data);
+  double client_burst() const {
+    return std::max(client_rate_ * CLIENT_BURST, (double)MAX_QUERY_COST);
+  }
+  void seqno_ready(adnl::AdnlNodeIdShort src, td::uint32 cost, td::BufferSlice data,
+                   td::Promise<td::BufferSlice> promise, td::Result<td::Unit> R);
+  void admit_query(adnl::AdnlNodeIdShort src, Client &client, td::uint32 cost, td::BufferSlice data,
+                   td::Promise<td::BufferSlice> promise);
+  bool can_run(const Client &client, td::uint32 cost) const;
+  void start_query(adnl::AdnlNodeIdShort src, Client &client, td::uint32 cost, td::BufferSlice data,
+                   td::Promise<td::BufferSlice> promise);
+  void query_finished(adnl::AdnlNodeIdShort src, td::uint32 cost);
+  void process_queue();
+  static void reject(td::Promise<td::BufferSlice> promise, td::Status error);
+
+  std::unique_ptr<Callback> callback_;
+  td::uint32 max_cost_;
+  td::uint32 max_client_cost_;
+  double client_rate_;
+  td::uint32 running_cost_{0};
+
+  std::map<adnl::AdnlNodeIdShort, Client> clients_;
+  std::list<PendingQuery> queue_;
+  Stats stats_, total_stats_;
+  td::Timestamp next_report_;
+
+  static constexpr td::uint32 MAX_QUERY_COST = 64;
+  static constexpr size_t MAX_QUEUE_SIZE = 4096;
+  static constexpr td::uint32 MAX_CLIENT_QUEUE_SIZE = 256;
+  static constexpr double QUEUE_TIMEOUT = 5.0;
+  static constexpr double MAX_WAIT_SEQNO_TIMEOUT = 10.0;
+  // burst allowed for a client, in seconds of its rate (but not less than MAX_QUERY_COST)
+  static constexpr double CLIENT_BURST = 5.0;
+  static constexpr double REPORT_PERIOD = 60.0;
+};
+
+}  // namespace ton::validator
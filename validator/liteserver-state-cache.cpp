@@ -0,0 +1,66 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "liteserver-state-cache.hpp"
+
+#include <algorithm>
+
+namespace ton::validator {
+
+td::Ref<ShardState> LiteServerStateCache::get(const BlockIdExt &block_id) {
+  auto state = cache_.get_if_exists(block_id);
+  if (state == nullptr) {
+    ++misses_;
+    return {};
+  }
+  ++hits_;
+  return *state;
+}
+
+bool LiteServerStateCache::wait(const BlockIdExt &block_id, td::Promise<td::Ref<ShardState>> promise) {
+  auto &waiting = loading_[block_id];
+  waiting.push_back(std::move(promise));
+  if (waiting.size() > 1) {
+    ++shared_loads_;
+    return false;
+  }
+  return true;
+}
+
+void LiteServerStateCache::loaded(const BlockIdExt &block_id, td::Result<td::Ref<ShardState>> R) {
+  auto it = loading_.find(block_id);
+  CHECK(it != loading_.end());
+  auto waiting = std::move(it->second);
+  loading_.erase(it);
+  if (R.is_ok() && cache_.put(block_id, R.ok())) {
+    // the cache never grows above max_size_, evicting the least recently used state instead
+    size_ = std::min(size_ + 1, max_size_);
+  }
+  for (auto &promise : waiting) {
+    if (R.is_ok()) {
+      promise.set_value(R.ok());
+    } else {
+      promise.set_error(R.error().clone());
+    }
+  }
+}
+
+void LiteServerStateCache::prepare_stats(std::vector<std::pair<std::string, std::string>> &vec) const {
+  vec.emplace_back("liteserver_state_cache", PSTRING() << "size:" << size_ << " hits:" << hits_ << " misses:"
+                                                        << misses_ << " shared_loads:" << shared_loads_);
+}
+
+}  // namespace ton::validator
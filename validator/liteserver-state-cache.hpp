@@ -0,0 +1,57 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "interfaces/shard.h"
+#include "td/actor/PromiseFuture.h"
+#include "td/utils/LRUCache.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace ton::validator {
+
+/**
+ * States read from db for liteserver queries (get_block_state_for_litequery).
+ *
+ * Kept apart from the block state cache of the manager, which serves collation and validation: queries for old
+ * states evict each other here and never push out the states of the current blocks.
+ * Concurrent queries for the same state share a single db read.
+ */
+class LiteServerStateCache {
+ public:
+  explicit LiteServerStateCache(size_t max_size) : max_size_(max_size), cache_(max_size) {
+  }
+
+  // returns the cached state, or null
+  td::Ref<ShardState> get(const BlockIdExt &block_id);
+  // queues promise until the state is loaded; returns true if the caller has to load it and call loaded()
+  bool wait(const BlockIdExt &block_id, td::Promise<td::Ref<ShardState>> promise);
+  void loaded(const BlockIdExt &block_id, td::Result<td::Ref<ShardState>> R);
+
+  void prepare_stats(std::vector<std::pair<std::string, std::string>> &vec) const;
+
+ private:
+  size_t max_size_;
+  td::LRUCache<BlockIdExt, td::Ref<ShardState>> cache_;
+  std::map<BlockIdExt, std::vector<td::Promise<td::Ref<ShardState>>>> loading_;
+  size_t size_ = 0;
+  td::uint64 hits_ = 0, misses_ = 0, shared_loads_ = 0;
+};
+
+}  // namespace ton::validator
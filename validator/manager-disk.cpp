@@ -64,7 +64,8 @@ void ValidatorManagerImpl::validate_block(ReceivedBlock block, td::Promise<Block
   UNREACHABLE();
 }
 
-void ValidatorManagerImpl::new_block_broadcast(BlockBroadcast broadcast, td::Promise<td::Unit> promise) {
+void ValidatorManagerImpl::new_block_broadcast(BlockBroadcast broadcast, td::Ref<vm::Cell> data_root,
+                                               td::Promise<td::Unit> promise) {
   UNREACHABLE();
 }
 
@@ -107,7 +107,8 @@ class ValidatorManagerImpl : public ValidatorManager {
   void validate_block(ReceivedBlock block, td::Promise<BlockHandle> promise) override {
     UNREACHABLE();
   }
-  void new_block_broadcast(BlockBroadcast broadcast, td::Promise<td::Unit> promise) override {
+  void new_block_broadcast(BlockBroadcast broadcast, td::Ref<vm::Cell> data_root,
+                           td::Promise<td::Unit> promise) override {
     UNREACHABLE();
   }
 
@@ -443,6 +444,10 @@ class ValidatorManagerImpl : public ValidatorManager {
     UNREACHABLE();
  }
 
+  void prepare_actor_profile(td::Promise<std::string> promise) override {
+    UNREACHABLE();
+  }
+
   void prepare_perf_timer_stats(td::Promise<std::vector<PerfTimerStats>> promise) override {
     UNREACHABLE();
   }
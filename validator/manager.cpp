@@ -213,7 +213,8 @@ void ValidatorManagerImpl::validate_block(ReceivedBlock block, td::Promise<Block
   run_apply_block_query(block.id, pp.move_as_ok(), block.id, actor_id(this), td::Timestamp::in(10.0), std::move(P));
 }
 
-void ValidatorManagerImpl::new_block_broadcast(BlockBroadcast broadcast, td::Promise<td::Unit> promise) {
+void ValidatorManagerImpl::new_block_broadcast(BlockBroadcast broadcast, td::Ref<vm::Cell> data_root,
+                                               td::Promise<td::Unit> promise) {
   if (!started_) {
     promise.set_error(td::Status::Error(ErrorCode::notready, "node not started"));
     return;
@@ -231,7 +232,8 @@ void ValidatorManagerImpl::new_block_broadcast(BlockBroadcast broadcast, td::Pro
   };
   BlockIdExt block_id = broadcast.block_id;
   td::actor::create_actor<ValidateBroadcast>(PSTRING() << "broadcast" << block_id.id.to_str(), std::move(broadcast),
-                                             last_masterchain_block_handle_, last_masterchain_state_,
+                                             std::move(data_root), last_masterchain_block_handle_,
+                                             last_masterchain_state_,
                                              last_known_key_block_handle_, actor_id(this), td::Timestamp::in(20.0),
                                              std::move(promise))
       .release();
@@ -408,7 +410,7 @@ void ValidatorManagerImpl::new_external_message(td::BufferSlice data, int priori
     VLOG(VALIDATOR_NOTICE) << "dropping ext message: validator is not ready";
     return;
   }
-  if (ext_msgs_[priority].ext_messages_.size() > (size_t)max_mempool_num()) {
+  if (ext_msg_pool_.size(priority) > (size_t)max_mempool_num()) {
     return;
   }
   auto R = create_ext_message(std::move(data), last_masterchain_state_->get_ext_msg_limits());
@@ -420,26 +422,7 @@ void ValidatorManagerImpl::new_external_message(td::BufferSlice data, int priori
 }
 
 void ValidatorManagerImpl::add_external_message(td::Ref<ExtMessage> msg, int priority) {
-  auto &msgs = ext_msgs_[priority];
-  auto message = std::make_unique<MessageExt<ExtMessage>>(msg);
-  auto id = message->ext_id();
-  auto address = message->address();
-  unsigned long per_address_limit = 256;
-  auto it = msgs.ext_addr_messages_.find(address);
-  if (it != msgs.ext_addr_messages_.end() && it->second.size() >= per_address_limit) {
-    return;
-  }
-  auto it2 = ext_messages_hashes_.find(id.hash);
-  if (it2 != ext_messages_hashes_.end()) {
-    int old_priority = it2->second.first;
-    if (old_priority >= priority) {
-      return;
-    }
-    ext_msgs_[old_priority].erase(id);
-  }
-  msgs.ext_messages_.emplace(id, std::move(message));
-  msgs.ext_addr_messages_[address].emplace(id.hash, id);
-  ext_messages_hashes_[id.hash] = {priority, id};
+  ext_msg_pool_.add_message(std::move(msg), priority);
 }
 void ValidatorManagerImpl::check_external_message(td::BufferSlice data, td::Promise<td::Ref<ExtMessage>> promise) {
   if (!started_) {
@@ -479,7 +462,8 @@ void ValidatorManagerImpl::check_external_message(td::BufferSlice data, td::Prom
     });
   };
   ++ls_stats_check_ext_messages_;
-  run_check_external_message(std::move(message), actor_id(this), std::move(promise));
+  td::actor::send_closure(ext_message_checker_, &ExtMessageChecker::check_message, std::move(message),
+                          std::move(state), std::move(promise));
 }
 
 void ValidatorManagerImpl::new_ihr_message(td::BufferSlice data) {
@@ -702,22 +686,28 @@ void ValidatorManagerImpl::add_ext_server_id(adnl::AdnlNodeIdShort id) {
   class Cb : public adnl::Adnl::Callback {
    private:
     td::actor::ActorId<ValidatorManagerImpl> id_;
+    td::actor::ActorId<LiteServerAdmission> admission_;
 
     void receive_message(adnl::AdnlNodeIdShort src, adnl::AdnlNodeIdShort dst, td::BufferSlice data) override {
     }
     void receive_query(adnl::AdnlNodeIdShort src, adnl::AdnlNodeIdShort dst, td::BufferSlice data,
                        td::Promise<td::BufferSlice> promise) override {
-      td::actor::send_closure(id_, &ValidatorManagerImpl::run_ext_query, std::move(data), std::move(promise));
+      if (admission_.empty()) {
+        td::actor::send_closure(id_, &ValidatorManagerImpl::run_ext_query, std::move(data), std::move(promise));
+      } else {
+        td::actor::send_closure(admission_, &LiteServerAdmission::run_query, src, std::move(data), std::move(promise));
+      }
     }
 
    public:
-    Cb(td::actor::ActorId<ValidatorManagerImpl> id) : id_(id) {
+    Cb(td::actor::ActorId<ValidatorManagerImpl> id, td::actor::ActorId<LiteServerAdmission> admission)
+        : id_(id), admission_(admission) {
     }
   };
 
   td::actor::send_closure(adnl_, &adnl::Adnl::subscribe, id,
                           adnl::Adnl::int_to_bytestring(lite_api::liteServer_query::ID),
-                          std::make_unique<Cb>(actor_id(this)));
+                          std::make_unique<Cb>(actor_id(this), ls_admission_.get()));
 
   if (lite_server_.empty()) {
     pending_ext_ids_.push_back(id);
@@ -800,10 +790,12 @@ void ValidatorManagerImpl::wait_block_state(BlockHandle handle, td::uint32 prior
                                             bool wait_store, td::Promise<td::Ref<ShardState>> promise) {
   auto it0 = block_state_cache_.find(handle->id());
   if (it0 != block_state_cache_.end()) {
+    ++block_state_cache_hits_;
     it0->second.ttl_ = td::Timestamp::in(30.0);
     promise.set_result(it0->second.state_);
     return;
   }
+  ++block_state_cache_misses_;
   auto it = wait_state_.find(handle->id());
   if (it == wait_state_.end()) {
     auto P1 = td::PromiseCreator::lambda([SelfId = actor_id(this), handle](td::Result<td::Ref<ShardState>> R) {
@@ -1080,41 +1072,12 @@ void ValidatorManagerImpl::wait_block_message_queue_short(BlockIdExt block_id, t
 void ValidatorManagerImpl::get_external_messages(
     ShardIdFull shard, td::Promise<std::vector<std::pair<td::Ref<ExtMessage>, int>>> promise) {
   td::Timer t;
-  size_t processed = 0, deleted = 0;
-  std::vector<std::pair<td::Ref<ExtMessage>, int>> res;
-  MessageId<ExtMessage> left{AccountIdPrefixFull{shard.workchain, shard.shard & (shard.shard - 1)}, Bits256::zero()};
-  size_t total_msgs = 0;
-  td::Random::Fast rnd;
-  for (auto iter = ext_msgs_.rbegin(); iter != ext_msgs_.rend(); ++iter) {
-    std::vector<std::pair<td::Ref<ExtMessage>, int>> cur_res;
-    int priority = iter->first;
-    auto &msgs = iter->second;
-    auto it = msgs.ext_messages_.lower_bound(left);
-    while (it != msgs.ext_messages_.end()) {
-      auto s = it->first;
-      if (!shard_contains(shard, s.dst)) {
-        break;
-      }
-      ++processed;
-      if (it->second->expired()) {
-        msgs.ext_addr_messages_[it->second->address()].erase(it->first.hash);
-        ext_messages_hashes_.erase(it->first.hash);
-        it = msgs.ext_messages_.erase(it);
-        ++deleted;
-        continue;
-      }
-      if (it->second->is_active()) {
-        cur_res.emplace_back(it->second->message(), priority);
-      }
-      it++;
-    }
-    td::random_shuffle(td::as_mutable_span(cur_res), rnd);
-    res.insert(res.end(), cur_res.begin(), cur_res.end());
-    total_msgs += msgs.ext_messages_.size();
-  }
+  size_t processed = 0;
+  size_t deleted = ext_msg_pool_.expire();
+  auto res = ext_msg_pool_.get_messages(shard, processed);
   LOG(WARNING) << "get_external_messages to shard " << shard.to_str() << " : time=" << t.elapsed()
                << " result_size=" << res.size() << " processed=" << processed << " expired=" << deleted
-               << " total_size=" << total_msgs;
+               << " total_size=" << ext_msg_pool_.size();
   promise.set_value(std::move(res));
 }
 
@@ -1155,29 +1118,11 @@ void ValidatorManagerImpl::get_shard_blocks_for_collator(
 void ValidatorManagerImpl::complete_external_messages(std::vector<ExtMessage::Hash> to_delay,
                                                       std::vector<ExtMessage::Hash> to_delete) {
   for (auto &hash : to_delete) {
-    auto it = ext_messages_hashes_.find(hash);
-    if (it != ext_messages_hashes_.end()) {
-      int priority = it->second.first;
-      auto msg_id = it->second.second;
-      ext_msgs_[priority].erase(msg_id);
-      ext_messages_hashes_.erase(it);
-    }
+    ext_msg_pool_.erase_message(hash);
   }
-  unsigned long soft_mempool_limit = 1024;
+  size_t soft_mempool_limit = 1024;
   for (auto &hash : to_delay) {
-    auto it = ext_messages_hashes_.find(hash);
-    if (it != ext_messages_hashes_.end()) {
-      int priority = it->second.first;
-      auto msg_id = it->second.second;
-      auto &msgs = ext_msgs_[priority];
-      auto it2 = msgs.ext_messages_.find(msg_id);
-      if ((msgs.ext_messages_.size() < soft_mempool_limit) && it2->second->can_postpone()) {
-        it2->second->postpone();
-      } else {
-        msgs.erase(msg_id);
-        ext_messages_hashes_.erase(it);
-      }
-    }
+    ext_msg_pool_.delay_message(hash, soft_mempool_limit);
   }
 }
 
@@ -1335,7 +1280,7 @@ void ValidatorManagerImpl::finished_wait_state(BlockHandle handle, td::Result<td
     it->second.preliminary_result_ = r;
     it->second.waiting_preliminary_.clear();
     if (!preliminary) {
-      block_state_cache_[handle->id()] = {r, td::Timestamp::in(30.0)};
+      cache_block_state(handle->id(), r);
       for (auto &X : it->second.waiting_) {
         X.promise.set_result(r);
       }
@@ -1369,6 +1314,46 @@ void ValidatorManagerImpl::finished_wait_state(BlockHandle handle, td::Result<td
   }
 }
 
+void ValidatorManagerImpl::cache_block_state(BlockIdExt block_id, td::Ref<ShardState> state) {
+  block_state_cache_[block_id] = {std::move(state), td::Timestamp::in(30.0)};
+  if (block_state_cache_.size() <= max_block_state_cache_size()) {
+    return;
+  }
+  // evict the entry that would expire first
+  auto to_evict = block_state_cache_.begin();
+  for (auto it = block_state_cache_.begin(); it != block_state_cache_.end(); ++it) {
+    if (it->second.ttl_.at() < to_evict->second.ttl_.at()) {
+      to_evict = it;
+    }
+  }
+  block_state_cache_.erase(to_evict);
+}
+
+void ValidatorManagerImpl::get_shard_state_cached(ConstBlockHandle handle, td::Promise<td::Ref<ShardState>> promise) {
+  // states of recent blocks are taken from the block state cache, but liteserver queries do not add to it
+  auto it = block_state_cache_.find(handle->id());
+  if (it != block_state_cache_.end()) {
+    promise.set_result(it->second.state_);
+    return;
+  }
+  auto state = liteserver_state_cache_.get(handle->id());
+  if (state.not_null()) {
+    promise.set_result(std::move(state));
+    return;
+  }
+  if (!liteserver_state_cache_.wait(handle->id(), std::move(promise))) {
+    return;
+  }
+  auto P = [SelfId = actor_id(this), block_id = handle->id()](td::Result<td::Ref<ShardState>> R) {
+    td::actor::send_closure(SelfId, &ValidatorManagerImpl::loaded_shard_state, block_id, std::move(R));
+  };
+  get_shard_state_from_db(std::move(handle), std::move(P));
+}
+
+void ValidatorManagerImpl::loaded_shard_state(BlockIdExt block_id, td::Result<td::Ref<ShardState>> R) {
+  liteserver_state_cache_.loaded(block_id, std::move(R));
+}
+
 void ValidatorManagerImpl::finished_wait_data(BlockHandle handle, td::Result<td::Ref<BlockData>> R) {
   auto it = wait_block_data_.find(handle->id());
   if (it != wait_block_data_.end()) {
@@ -1952,9 +1937,35 @@ void ValidatorManagerImpl::get_block_proof_link_from_import(BlockIdExt block_id,
 void ValidatorManagerImpl::start_up() {
   db_ = create_db_actor(actor_id(this), db_root_, opts_);
   actor_stats_ = td::actor::create_actor<td::actor::ActorStats>("actor_stats");
+  if (!opts_->get_actor_profile_file().empty()) {
+    td::actor::send_closure(actor_stats_, &td::actor::ActorStats::set_profile_dump, opts_->get_actor_profile_file(),
+                            ACTOR_PROFILE_DUMP_PERIOD);
+  }
   lite_server_cache_ = create_liteserver_cache_actor(actor_id(this), db_root_);
+  if (opts_->get_ls_max_running_cost() > 0) {
+    class Cb : public LiteServerAdmission::Callback {
+     public:
+      explicit Cb(td::actor::ActorId<ValidatorManagerImpl> id) : id_(id) {
+      }
+      void run_query(td::BufferSlice data, td::Promise<td::BufferSlice> promise) override {
+        td::actor::send_closure(id_, &ValidatorManagerImpl::run_ext_query, std::move(data), std::move(promise));
+      }
+      void wait_masterchain_seqno(BlockSeqno seqno, td::Timestamp timeout, td::Promise<td::Unit> promise) override {
+        td::actor::send_closure(id_, &ValidatorManagerImpl::wait_shard_client_state, seqno, timeout,
+                                std::move(promise));
+      }
+
+     private:
+      td::actor::ActorId<ValidatorManagerImpl> id_;
+    };
+    ls_admission_ = td::actor::create_actor<LiteServerAdmission>(
+        "lsadmission", std::make_unique<Cb>(actor_id(this)), opts_->get_ls_max_running_cost(),
+        opts_->get_ls_max_client_running_cost(), opts_->get_ls_client_rate());
+  }
+  ext_message_checker_ = create_ext_message_checker_actor(actor_id(this));
   token_manager_ = td::actor::create_actor<TokenManager>("tokenmanager");
-  storage_stat_cache_ = td::actor::create_actor<StorageStatCache>("storagestatcache");
+  storage_stat_cache_ =
+      td::actor::create_actor<StorageStatCache>("storagestatcache", db_root_ + "/storage-stat-cache");
   td::mkdir(db_root_ + "/tmp/").ensure();
   td::mkdir(db_root_ + "/catchains/").ensure();
 
@@ -2089,7 +2100,9 @@ void ValidatorManagerImpl::read_gc_list(std::vector<ValidatorSessionId> list) {
   new_masterchain_block();
 
   serializer_ =
-      td::actor::create_actor<AsyncStateSerializer>("serializer", last_key_block_handle_->id(), opts_, actor_id(this));
+      td::actor::create_actor<AsyncStateSerializer>(
+          td::actor::ActorOptions().with_name("serializer").with_priority(td::actor::ActorPriority::Background),
+          last_key_block_handle_->id(), opts_, actor_id(this));
   td::actor::send_closure(serializer_, &AsyncStateSerializer::update_last_known_key_block_ts,
                           last_key_block_handle_->unix_time());
 
@@ -2955,13 +2968,8 @@ void ValidatorManagerImpl::alarm() {
   }
   alarm_timestamp().relax(log_ls_stats_at_);
   if (cleanup_mempool_at_.is_in_past()) {
-    if (is_validator() || !collator_nodes_.empty()) {
-      get_external_messages(ShardIdFull{masterchainId, shardIdAll},
-                            [](td::Result<std::vector<std::pair<td::Ref<ExtMessage>, int>>>) {});
-      get_external_messages(ShardIdFull{basechainId, shardIdAll},
-                            [](td::Result<std::vector<std::pair<td::Ref<ExtMessage>, int>>>) {});
-    }
-    cleanup_mempool_at_ = td::Timestamp::in(250.0);
+    ext_msg_pool_.expire();
+    cleanup_mempool_at_ = td::Timestamp::in(10.0);
   }
   alarm_timestamp().relax(cleanup_mempool_at_);
 }
@@ -3090,6 +3098,10 @@ void ValidatorManagerImpl::prepare_actor_stats(td::Promise<std::string> promise)
   send_closure(actor_stats_, &td::actor::ActorStats::prepare_stats, std::move(promise));
 }
 
+void ValidatorManagerImpl::prepare_actor_profile(td::Promise<std::string> promise) {
+  send_closure(actor_stats_, &td::actor::ActorStats::prepare_profile_json, std::move(promise));
+}
+
 void ValidatorManagerImpl::prepare_stats(td::Promise<std::vector<std::pair<std::string, std::string>>> promise) {
   auto merger = StatsMerger::create(std::move(promise));
 
@@ -3119,6 +3131,10 @@ void ValidatorManagerImpl::prepare_stats(td::Promise<std::vector<std::pair<std::
       promise.set_value(std::move(vec));
     });
     td::actor::send_closure(shard_client_, &ShardClient::get_processed_masterchain_block, std::move(P));
+    td::actor::send_closure(shard_client_, &ShardClient::prepare_stats, merger.make_promise("shardclient."));
+  }
+  if (!ls_admission_.empty()) {
+    td::actor::send_closure(ls_admission_, &LiteServerAdmission::prepare_stats, merger.make_promise("lsadmission."));
   }
 
   vec.emplace_back("start_time", td::to_string(started_at_));
@@ -3152,6 +3168,11 @@ void ValidatorManagerImpl::prepare_stats(td::Promise<std::vector<std::pair<std::
     serializer_enabled = false;
   }
   vec.emplace_back("stateserializerenabled", serializer_enabled ? "true" : "false");
+  vec.emplace_back("state_cache", PSTRING() << "size:" << block_state_cache_.size()
+                                             << " hits:" << block_state_cache_hits_
+                                             << " misses:" << block_state_cache_misses_);
+  liteserver_state_cache_.prepare_stats(vec);
+  ext_msg_pool_.prepare_stats(vec);
 
   merger.make_promise("").set_value(std::move(vec));
 
@@ -3160,6 +3181,8 @@ void ValidatorManagerImpl::prepare_stats(td::Promise<std::vector<std::pair<std::
   }
 
   td::actor::send_closure(db_, &Db::prepare_stats, merger.make_promise("db."));
+  td::actor::send_closure(ext_message_checker_, &ExtMessageChecker::prepare_stats,
+                          merger.make_promise("ext_msg_check."));
   for (auto &[_, p] : stats_providers_) {
     p.second(merger.make_promise(p.first));
   }
@@ -3263,7 +3286,7 @@ void ValidatorManagerImpl::get_block_state_for_litequery(BlockIdExt block_id,
     get_block_handle_for_litequery(
         block_id, [manager = actor_id(this), promise = std::move(promise)](td::Result<ConstBlockHandle> R) mutable {
           TRY_RESULT_PROMISE(promise, handle, std::move(R));
-          td::actor::send_closure_later(manager, &ValidatorManager::get_shard_state_from_db, std::move(handle),
+          td::actor::send_closure_later(manager, &ValidatorManagerImpl::get_shard_state_cached, std::move(handle),
                                         std::move(promise));
         });
   } else {
@@ -3277,7 +3300,7 @@ void ValidatorManagerImpl::get_block_state_for_litequery(BlockIdExt block_id,
           td::actor::send_closure(manager, &ValidatorManagerImpl::get_block_handle_for_litequery, block_id,
                                   [manager, promise = std::move(promise)](td::Result<ConstBlockHandle> R) mutable {
                                     TRY_RESULT_PROMISE(promise, handle, std::move(R));
-                                    td::actor::send_closure_later(manager, &ValidatorManager::get_shard_state_from_db,
+                                    td::actor::send_closure_later(manager, &ValidatorManagerImpl::get_shard_state_cached,
                                                                   std::move(handle), std::move(promise));
                                   });
         });
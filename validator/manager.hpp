@@ -21,6 +21,7 @@
 #include "common/refcnt.hpp"
 #include "interfaces/validator-manager.h"
 #include "interfaces/db.h"
+#include "interfaces/ext-message-checker.h"
 #include "td/actor/ActorStats.h"
 #include "td/actor/PromiseFuture.h"
 #include "td/utils/SharedSlice.h"
@@ -34,8 +35,11 @@
 #include "rldp/rldp.h"
 #include "rldp2/rldp.h"
 #include "token-manager.h"
+#include "liteserver-admission.hpp"
+#include "liteserver-state-cache.hpp"
 #include "queue-size-counter.hpp"
 #include "storage-stat-cache.hpp"
+#include "ext-message-pool.hpp"
 #include "impl/candidates-buffer.hpp"
 #include "collator-node/collator-node.hpp"
 #include "shard-block-verifier.hpp"
@@ -226,6 +230,11 @@ class ValidatorManagerImpl : public ValidatorManager {
     td::Timestamp ttl_;
   };
   std::map<BlockIdExt, CachedBlockState> block_state_cache_;
+  static constexpr size_t max_block_state_cache_size() {
+    return 256;
+  }
+  td::uint64 block_state_cache_hits_ = 0, block_state_cache_misses_ = 0;
+  LiteServerStateCache liteserver_state_cache_{/* max_size = */ 64};
 
   struct WaitBlockHandle {
     std::vector<td::Promise<BlockHandle>> waiting_;
@@ -271,19 +280,7 @@ class ValidatorManagerImpl : public ValidatorManager {
   td::LRUCache<BlockIdExt, td::BufferSlice> cached_block_data_{/* max_size = */ 128};
   td::LRUCache<BlockIdExt, td::Unit> cached_checked_shard_block_descriptions_{/* max_size = */ 1024};
 
-  struct ExtMessages {
-    std::map<MessageId<ExtMessage>, std::unique_ptr<MessageExt<ExtMessage>>> ext_messages_;
-    std::map<std::pair<ton::WorkchainId, ton::StdSmcAddress>, std::map<ExtMessage::Hash, MessageId<ExtMessage>>>
-        ext_addr_messages_;
-    void erase(const MessageId<ExtMessage>& id) {
-      auto it = ext_messages_.find(id);
-      CHECK(it != ext_messages_.end());
-      ext_addr_messages_[it->second->address()].erase(id.hash);
-      ext_messages_.erase(it);
-    }
-  };
-  std::map<int, ExtMessages> ext_msgs_;  // priority -> messages
-  std::map<ExtMessage::Hash, std::pair<int, MessageId<ExtMessage>>> ext_messages_hashes_;  // hash -> priority
+  ExtMessagePool ext_msg_pool_;
   td::Timestamp cleanup_mempool_at_;
   // IHR ?
   std::map<MessageId<IhrMessage>, std::unique_ptr<MessageExt<IhrMessage>>> ihr_messages_;
@@ -401,7 +398,8 @@ class ValidatorManagerImpl : public ValidatorManager {
   void validate_block_proof_rel(BlockIdExt block_id, BlockIdExt rel_block_id, td::BufferSlice proof,
                                 td::Promise<td::Unit> promise) override;
   void validate_block(ReceivedBlock block, td::Promise<BlockHandle> promise) override;
-  void new_block_broadcast(BlockBroadcast broadcast, td::Promise<td::Unit> promise) override;
+  void new_block_broadcast(BlockBroadcast broadcast, td::Ref<vm::Cell> data_root,
+                           td::Promise<td::Unit> promise) override;
   void validated_block_broadcast(BlockIdExt block_id, CatchainSeqno cc_seqno);
 
   //void create_validate_block(BlockId block, td::BufferSlice data, td::Promise<Block> promise) = 0;
@@ -600,6 +598,9 @@ class ValidatorManagerImpl : public ValidatorManager {
   void register_block_handle(BlockHandle handle);
 
   void finished_wait_state(BlockHandle handle, td::Result<td::Ref<ShardState>> R, bool preliminary);
+  void cache_block_state(BlockIdExt block_id, td::Ref<ShardState> state);
+  void get_shard_state_cached(ConstBlockHandle handle, td::Promise<td::Ref<ShardState>> promise);
+  void loaded_shard_state(BlockIdExt block_id, td::Result<td::Ref<ShardState>> R);
   void finished_wait_data(BlockHandle handle, td::Result<td::Ref<BlockData>> R);
 
   void start_up() override;
@@ -638,6 +639,7 @@ class ValidatorManagerImpl : public ValidatorManager {
   void prepare_stats(td::Promise<std::vector<std::pair<std::string, std::string>>> promise) override;
 
   void prepare_actor_stats(td::Promise<std::string> promise) override;
+  void prepare_actor_profile(td::Promise<std::string> promise) override;
 
   void prepare_perf_timer_stats(td::Promise<std::vector<PerfTimerStats>> promise) override;
   void add_perf_timer_stat(std::string name, double duration) override;
@@ -705,7 +707,7 @@ class ValidatorManagerImpl : public ValidatorManager {
   void get_storage_stat_cache(td::Promise<std::function<td::Ref<vm::Cell>(const td::Bits256&)>> promise) override {
     td::actor::send_closure(storage_stat_cache_, &StorageStatCache::get_cache, std::move(promise));
   }
-  void update_storage_stat_cache(std::vector<std::pair<td::Ref<vm::Cell>, td::uint32>> data) override {
+  void update_storage_stat_cache(std::vector<StorageStatCacheUpdate> data) override {
     td::actor::send_closure(storage_stat_cache_, &StorageStatCache::update, std::move(data));
   }
 
@@ -730,6 +732,8 @@ class ValidatorManagerImpl : public ValidatorManager {
  private:
   td::actor::ActorOwn<adnl::AdnlExtServer> lite_server_;
   td::actor::ActorOwn<LiteServerCache> lite_server_cache_;
+  td::actor::ActorOwn<LiteServerAdmission> ls_admission_;
+  td::actor::ActorOwn<ExtMessageChecker> ext_message_checker_;
   std::vector<td::uint16> pending_ext_ports_;
   std::vector<adnl::AdnlNodeIdShort> pending_ext_ids_;
 
@@ -759,6 +763,7 @@ class ValidatorManagerImpl : public ValidatorManager {
   std::unique_ptr<Callback> callback_;
   td::actor::ActorOwn<Db> db_;
   td::actor::ActorOwn<td::actor::ActorStats> actor_stats_;
+  static constexpr double ACTOR_PROFILE_DUMP_PERIOD = 60.0;
 
   bool started_ = false;
   bool allow_validate_ = false;
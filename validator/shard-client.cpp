@@ -107,6 +107,7 @@ void ShardClient::download_shard_states(BlockIdExt masterchain_block_id, std::ve
 
 void ShardClient::applied_all_shards() {
   LOG(DEBUG) << "shardclient: " << masterchain_block_handle_->id() << " finished";
+  finish_stage(stage_shard_states);
   auto P = td::PromiseCreator::lambda([SelfId = actor_id(this)](td::Result<td::Unit> R) {
     R.ensure();
     td::actor::send_closure(SelfId, &ShardClient::saved_to_db);
@@ -117,6 +118,12 @@ void ShardClient::applied_all_shards() {
 
 void ShardClient::saved_to_db() {
   CHECK(masterchain_block_handle_);
+  finish_stage(stage_save);
+  if (block_started_at_ > 0.0) {
+    stage_stats_[stage_total].add(td::Time::now() - block_started_at_);
+    block_started_at_ = 0.0;
+  }
+  stage_started_at_ = 0.0;
   td::actor::send_closure(manager_, &ValidatorManager::update_shard_client_block_handle, masterchain_block_handle_,
                           std::move(masterchain_state_), [](td::Unit) {});
   masterchain_state_.clear();
@@ -138,6 +145,7 @@ void ShardClient::saved_to_db() {
 }
 
 void ShardClient::new_masterchain_block_id(BlockIdExt block_id) {
+  block_started_at_ = stage_started_at_ = td::Time::now();
   auto P = td::PromiseCreator::lambda([SelfId = actor_id(this)](td::Result<BlockHandle> R) {
     R.ensure();
     td::actor::send_closure(SelfId, &ShardClient::got_masterchain_block_handle, R.move_as_ok());
@@ -147,10 +155,29 @@ void ShardClient::new_masterchain_block_id(BlockIdExt block_id) {
 
 void ShardClient::got_masterchain_block_handle(BlockHandle handle) {
   masterchain_block_handle_ = std::move(handle);
+  auto seqno = masterchain_block_handle_->id().seqno();
+  prefetched_states_.erase(prefetched_states_.begin(), prefetched_states_.lower_bound(seqno));
+  for (auto it = prefetched_shard_blocks_.begin(); it != prefetched_shard_blocks_.end();) {
+    if (it->second < seqno) {
+      it = prefetched_shard_blocks_.erase(it);
+    } else {
+      ++it;
+    }
+  }
   download_masterchain_state();
+  prefetch_next_blocks();
 }
 
 void ShardClient::download_masterchain_state() {
+  auto it = prefetched_states_.find(masterchain_block_handle_->id().seqno());
+  if (it != prefetched_states_.end()) {
+    ++prefetch_hits_;
+    auto state = std::move(it->second);
+    prefetched_states_.erase(it);
+    got_masterchain_block_state(std::move(state));
+    return;
+  }
+  ++prefetch_misses_;
   auto P = td::PromiseCreator::lambda([SelfId = actor_id(this)](td::Result<td::Ref<ShardState>> R) {
     if (R.is_error()) {
       LOG(WARNING) << "failed to download masterchain state: " << R.move_as_error();
@@ -166,6 +193,7 @@ void ShardClient::download_masterchain_state() {
 
 void ShardClient::got_masterchain_block_state(td::Ref<MasterchainState> state) {
   masterchain_state_ = std::move(state);
+  finish_stage(stage_mc_state);
   if (started_) {
     apply_all_shards();
   }
@@ -226,6 +254,101 @@ void ShardClient::downloaded_shard_state(td::Ref<ShardState> state, td::Promise<
                         td::Timestamp::in(600), std::move(promise));
 }
 
+void ShardClient::prefetch_next_blocks() {
+  if (!started_ || prefetch_in_progress_ || !masterchain_block_handle_) {
+    return;
+  }
+  auto seqno = masterchain_block_handle_->id().seqno();
+  if (!prefetch_handle_ || prefetch_handle_->id().seqno() < seqno) {
+    prefetch_handle_ = masterchain_block_handle_;
+  }
+  if (prefetch_handle_->id().seqno() >= seqno + max_prefetch_blocks() || !prefetch_handle_->inited_next_left()) {
+    return;
+  }
+  prefetch_in_progress_ = true;
+  auto P = td::PromiseCreator::lambda([SelfId = actor_id(this)](td::Result<BlockHandle> R) {
+    R.ensure();
+    td::actor::send_closure(SelfId, &ShardClient::got_prefetch_block_handle, R.move_as_ok());
+  });
+  td::actor::send_closure(manager_, &ValidatorManager::get_block_handle, prefetch_handle_->one_next(true), true,
+                          std::move(P));
+}
+
+void ShardClient::got_prefetch_block_handle(BlockHandle handle) {
+  prefetch_handle_ = handle;
+  auto it = prefetched_states_.find(handle->id().seqno());
+  if (it != prefetched_states_.end()) {
+    got_prefetch_block_state(std::move(handle), it->second);
+    return;
+  }
+  auto P = td::PromiseCreator::lambda([SelfId = actor_id(this), handle](td::Result<td::Ref<ShardState>> R) mutable {
+    td::Result<td::Ref<MasterchainState>> res;
+    if (R.is_error()) {
+      res = R.move_as_error();
+    } else {
+      res = td::Ref<MasterchainState>{R.move_as_ok()};
+    }
+    td::actor::send_closure(SelfId, &ShardClient::got_prefetch_block_state, std::move(handle), std::move(res));
+  });
+  td::actor::send_closure(manager_, &ValidatorManager::wait_block_state, handle, shard_client_priority(),
+                          td::Timestamp::in(600), true, std::move(P));
+}
+
+void ShardClient::got_prefetch_block_state(BlockHandle handle, td::Result<td::Ref<MasterchainState>> R) {
+  prefetch_in_progress_ = false;
+  if (R.is_error()) {
+    LOG(INFO) << "failed to prefetch masterchain state " << handle->id() << ": " << R.move_as_error();
+    // start over from the current block when it changes
+    prefetch_handle_ = {};
+    return;
+  }
+  auto seqno = handle->id().seqno();
+  if (seqno <= masterchain_block_handle_->id().seqno()) {
+    prefetch_next_blocks();
+    return;
+  }
+  auto state = R.move_as_ok();
+  prefetched_states_[seqno] = state;
+  for (auto &shard : state->get_shards()) {
+    if (shard_prefetches_in_flight_ >= max_shard_prefetches_in_flight()) {
+      break;
+    }
+    auto block_id = shard->top_block_id();
+    if (!opts_->need_monitor(shard->shard(), state) || prefetched_shard_blocks_.count(block_id)) {
+      continue;
+    }
+    prefetched_shard_blocks_[block_id] = seqno;
+    ++shard_prefetches_in_flight_;
+    auto P = td::PromiseCreator::lambda([SelfId = actor_id(this), block_id](td::Result<td::Ref<ShardState>> R) {
+      td::actor::send_closure(SelfId, &ShardClient::prefetched_shard_state, block_id, std::move(R));
+    });
+    td::actor::send_closure(manager_, &ValidatorManager::wait_block_state_short, block_id, shard_client_priority(),
+                            td::Timestamp::in(1500), true, std::move(P));
+  }
+  prefetch_next_blocks();
+}
+
+void ShardClient::prefetched_shard_state(BlockIdExt block_id, td::Result<td::Ref<ShardState>> R) {
+  CHECK(shard_prefetches_in_flight_ > 0);
+  --shard_prefetches_in_flight_;
+  if (R.is_error()) {
+    LOG(INFO) << "failed to prefetch shard state " << block_id.to_str() << ": " << R.move_as_error();
+    ++shard_prefetches_failed_;
+    prefetched_shard_blocks_.erase(block_id);
+  } else {
+    ++shard_prefetches_ok_;
+  }
+}
+
+void ShardClient::finish_stage(Stage stage) {
+  if (stage_started_at_ <= 0.0) {
+    return;
+  }
+  double now = td::Time::now();
+  stage_stats_[stage].add(now - stage_started_at_);
+  stage_started_at_ = now;
+}
+
 void ShardClient::new_masterchain_block_notification(BlockHandle handle, td::Ref<MasterchainState> state) {
   if (!waiting_) {
     return;
@@ -240,6 +363,7 @@ void ShardClient::new_masterchain_block_notification(BlockHandle handle, td::Ref
   masterchain_state_ = std::move(state);
   waiting_ = false;
 
+  block_started_at_ = stage_started_at_ = td::Time::now();
   apply_all_shards();
 }
 
@@ -259,6 +383,23 @@ void ShardClient::get_processed_masterchain_block_id(td::Promise<BlockIdExt> pro
   }
 }
 
+void ShardClient::prepare_stats(td::Promise<std::vector<std::pair<std::string, std::string>>> promise) {
+  static const char *stage_names[stage_count] = {"mc_state", "shard_states", "save", "total"};
+  std::vector<std::pair<std::string, std::string>> vec;
+  for (int i = 0; i < stage_count; ++i) {
+    auto &stats = stage_stats_[i];
+    vec.emplace_back(PSTRING() << "stage." << stage_names[i],
+                     PSTRING() << "count:" << stats.count << " avg:" << (stats.count ? stats.total / stats.count : 0.0)
+                               << " max:" << stats.max);
+  }
+  vec.emplace_back("prefetch.mc_states", PSTRING() << "hits:" << prefetch_hits_ << " misses:" << prefetch_misses_
+                                                   << " ready:" << prefetched_states_.size());
+  vec.emplace_back("prefetch.shard_states", PSTRING() << "ok:" << shard_prefetches_ok_
+                                                      << " failed:" << shard_prefetches_failed_
+                                                      << " in_flight:" << shard_prefetches_in_flight_);
+  promise.set_value(std::move(vec));
+}
+
 void ShardClient::force_update_shard_client(BlockHandle handle, td::Promise<td::Unit> promise) {
   CHECK(!init_mode_);
   CHECK(!started_);
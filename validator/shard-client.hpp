@@ -19,6 +19,8 @@
 #pragma once
 
 #include "interfaces/validator-manager.h"
+#include <algorithm>
+#include <map>
 #include <set>
 
 namespace ton {
@@ -47,6 +49,31 @@ class ShardClient : public td::actor::Actor {
 
   td::Promise<td::Unit> promise_;
 
+  // Catch-up pipeline: while the current masterchain block is applied, states of the next masterchain blocks
+  // are loaded and states of their shard blocks are computed in advance. Shard blocks are still applied in order.
+  BlockHandle prefetch_handle_;
+  bool prefetch_in_progress_ = false;
+  std::map<BlockSeqno, td::Ref<MasterchainState>> prefetched_states_;
+  std::map<BlockIdExt, BlockSeqno> prefetched_shard_blocks_;  // block -> masterchain seqno
+  size_t shard_prefetches_in_flight_ = 0;
+
+  struct StageStats {
+    td::uint64 count = 0;
+    double total = 0.0, max = 0.0;
+    void add(double duration) {
+      ++count;
+      total += duration;
+      max = std::max(max, duration);
+    }
+  };
+  enum Stage { stage_mc_state, stage_shard_states, stage_save, stage_total, stage_count };
+  StageStats stage_stats_[stage_count];
+  double stage_started_at_ = 0.0, block_started_at_ = 0.0;
+  td::uint64 prefetch_hits_ = 0, prefetch_misses_ = 0;
+  td::uint64 shard_prefetches_ok_ = 0, shard_prefetches_failed_ = 0;
+
+  void finish_stage(Stage stage);
+
  public:
   ShardClient(td::Ref<ValidatorManagerOptions> opts, BlockHandle masterchain_block_handle,
               td::Ref<MasterchainState> masterchain_state, td::actor::ActorId<ValidatorManager> manager,
@@ -66,6 +93,12 @@ class ShardClient : public td::actor::Actor {
   static constexpr td::uint32 shard_client_priority() {
     return 2;
   }
+  static constexpr BlockSeqno max_prefetch_blocks() {
+    return 8;
+  }
+  static constexpr size_t max_shard_prefetches_in_flight() {
+    return 32;
+  }
 
   void start_up() override;
   void start_up_init_mode();
@@ -84,10 +117,16 @@ class ShardClient : public td::actor::Actor {
   void applied_all_shards();
   void saved_to_db();
 
+  void prefetch_next_blocks();
+  void got_prefetch_block_handle(BlockHandle handle);
+  void got_prefetch_block_state(BlockHandle handle, td::Result<td::Ref<MasterchainState>> R);
+  void prefetched_shard_state(BlockIdExt block_id, td::Result<td::Ref<ShardState>> R);
+
   void new_masterchain_block_notification(BlockHandle handle, td::Ref<MasterchainState> state);
 
   void get_processed_masterchain_block(td::Promise<BlockSeqno> promise);
   void get_processed_masterchain_block_id(td::Promise<BlockIdExt> promise);
+  void prepare_stats(td::Promise<std::vector<std::pair<std::string, std::string>>> promise);
 
   void force_update_shard_client(BlockHandle handle, td::Promise<td::Unit> promise);
   void force_update_shard_client_ex(BlockHandle handle, td::Ref<MasterchainState> state, td::Promise<td::Unit> promise);
@@ -15,24 +15,207 @@
     along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
 */
 #include "storage-stat-cache.hpp"
+#include "td/db/RocksDb.h"
+#include "td/utils/Timer.h"
+#include "td/utils/as.h"
+#include "td/utils/bits.h"
+#include "vm/boc.h"
 
 namespace ton::validator {
 
+namespace {
+
+// Reads all entries of the db on a background actor, the cache works without them until they arrive
+class StorageStatCacheLoader : public td::actor::Actor {
+ public:
+  StorageStatCacheLoader(std::shared_ptr<td::KeyValue> db, td::actor::ActorId<StorageStatCache> parent)
+      : db_(std::move(db)), parent_(std::move(parent)) {
+  }
+
+  // db key: workchain (4 bytes, big endian) + account address; value: account total cells (4 bytes) + BoC of the
+  // storage dict
+  void start_up() override {
+    td::Timer timer;
+    std::vector<StorageStatCache::DbEntry> entries;
+    std::vector<std::string> bad_keys;
+    size_t loaded_cells = 0;
+    auto S = db_->for_each([&](td::Slice key, td::Slice value) -> td::Status {
+      if (key.size() != 36 || value.size() < 4) {
+        bad_keys.push_back(key.str());
+        return td::Status::OK();
+      }
+      auto r_cell = vm::std_boc_deserialize(value.substr(4));
+      if (r_cell.is_error()) {
+        bad_keys.push_back(key.str());
+        return td::Status::OK();
+      }
+      StorageStatCache::DbEntry entry;
+      entry.account.first = static_cast<WorkchainId>(td::bswap32(td::as<td::uint32>(key.data())));
+      entry.account.second.as_slice().copy_from(key.substr(4));
+      entry.dict_root = r_cell.move_as_ok();
+      entry.cells = td::as<td::uint32>(value.data());
+      loaded_cells += entry.cells;
+      entries.push_back(std::move(entry));
+      return td::Status::OK();
+    });
+    if (S.is_error()) {
+      LOG(WARNING) << "StorageStatCache: error loading from db: " << S;
+    }
+    LOG(INFO) << "StorageStatCache: loaded " << entries.size() << " dicts of accounts with " << loaded_cells
+              << " cells in total from db in " << timer.elapsed() << "s, " << bad_keys.size() << " invalid entries";
+    td::actor::send_closure(parent_, &StorageStatCache::loaded_from_db, std::move(entries), std::move(bad_keys));
+    stop();
+  }
+
+ private:
+  std::shared_ptr<td::KeyValue> db_;
+  td::actor::ActorId<StorageStatCache> parent_;
+};
+
+}  // namespace
+
+void StorageStatCache::start_up() {
+  if (db_path_.empty()) {
+    return;
+  }
+  auto r_db = td::RocksDb::open(db_path_);
+  if (r_db.is_error()) {
+    LOG(WARNING) << "StorageStatCache: cannot open db " << db_path_ << ", the cache will not be persisted: "
+                 << r_db.error();
+    return;
+  }
+  db_ = std::make_shared<td::RocksDb>(r_db.move_as_ok());
+  loading_ = true;
+  td::actor::create_actor<StorageStatCacheLoader>(
+      td::actor::ActorOptions().with_name("storagestatcacheloader").with_priority(td::actor::ActorPriority::Background),
+      db_, actor_id(this))
+      .release();
+  alarm_timestamp() = td::Timestamp::in(FLUSH_PERIOD);
+}
+
+void StorageStatCache::tear_down() {
+  flush();
+}
+
+void StorageStatCache::alarm() {
+  flush();
+  alarm_timestamp() = td::Timestamp::in(FLUSH_PERIOD);
+}
+
+std::string StorageStatCache::db_key(const AccountKey& account) {
+  std::string key(36, '\0');
+  td::as<td::uint32>(key.data()) = td::bswap32(static_cast<td::uint32>(account.first));
+  td::MutableSlice(key).substr(4).copy_from(account.second.as_slice());
+  return key;
+}
+
+void StorageStatCache::loaded_from_db(std::vector<DbEntry> entries, std::vector<std::string> bad_keys) {
+  loading_ = false;
+  for (auto& entry : entries) {
+    // accounts updated while loading already have a newer dict
+    if (accounts_.count(entry.account)) {
+      continue;
+    }
+    td::Bits256 hash = entry.dict_root->get_hash().bits();
+    accounts_.emplace(entry.account, hash);
+    add_entry(hash, std::move(entry.dict_root), entry.cells);
+  }
+  // entries evicted while loading and broken entries are removed from db on the next flush
+  bad_keys_ = std::move(bad_keys);
+}
+
+void StorageStatCache::flush() {
+  if (!db_ || loading_) {
+    return;
+  }
+  // accounts whose dict was evicted from the cache are removed from db, unless the dict was added back
+  if (!evicted_.empty()) {
+    std::set<td::Bits256> evicted(evicted_.begin(), evicted_.end());
+    for (auto& [account, hash] : accounts_) {
+      if (evicted.count(hash)) {
+        changed_accounts_.insert(account);
+      }
+    }
+    evicted_.clear();
+  }
+  if (changed_accounts_.empty() && bad_keys_.empty()) {
+    return;
+  }
+  td::Timer timer;
+  size_t stored = 0, erased = 0;
+  db_->begin_write_batch().ensure();
+  for (const std::string& key : bad_keys_) {
+    db_->erase(key).ensure();
+    ++erased;
+  }
+  for (const AccountKey& account : changed_accounts_) {
+    auto it = accounts_.find(account);
+    td::Ref<vm::Cell> cell;
+    Deleter* entry = nullptr;
+    if (it != accounts_.end()) {
+      cell = cache_.lookup_ref(it->second);
+      entry = lru_.get_if_exists(it->second, false);
+    }
+    td::Result<td::BufferSlice> r_boc = td::Status::Error("evicted");
+    if (cell.not_null() && entry) {
+      r_boc = vm::std_boc_serialize(std::move(cell));
+      if (r_boc.is_error()) {
+        LOG(WARNING) << "StorageStatCache: cannot serialize dict " << it->second.to_hex() << ": " << r_boc.error();
+      }
+    }
+    if (r_boc.is_error()) {
+      db_->erase(db_key(account)).ensure();
+      if (it != accounts_.end()) {
+        accounts_.erase(it);
+      }
+      ++erased;
+      continue;
+    }
+    auto boc = r_boc.move_as_ok();
+    std::string value(4 + boc.size(), '\0');
+    td::as<td::uint32>(value.data()) = entry->size;
+    td::MutableSlice(value).substr(4).copy_from(boc.as_slice());
+    db_->set(db_key(account), value).ensure();
+    ++stored;
+  }
+  db_->commit_write_batch().ensure();
+  changed_accounts_.clear();
+  bad_keys_.clear();
+  LOG(DEBUG) << "StorageStatCache: flushed to db, " << stored << " stored, " << erased << " erased in "
+             << timer.elapsed() << "s";
+}
+
+void StorageStatCache::add_entry(const td::Bits256& hash, td::Ref<vm::Cell> cell, td::uint32 size) {
+  cache_.set_ref(hash, std::move(cell));
+  lru_.put(hash, Deleter{hash, &cache_, db_ ? &evicted_ : nullptr, size}, true, size);
+}
+
 void StorageStatCache::get_cache(td::Promise<std::function<td::Ref<vm::Cell>(const td::Bits256&)>> promise) {
   LOG(DEBUG) << "StorageStatCache::get_cache";
   promise.set_value(
       [cache = cache_](const td::Bits256& hash) mutable -> td::Ref<vm::Cell> { return cache.lookup_ref(hash); });
 }
 
-void StorageStatCache::update(std::vector<std::pair<td::Ref<vm::Cell>, td::uint32>> data) {
-  for (auto &[cell, size] : data) {
-    if (size < MIN_ACCOUNT_CELLS) {
+void StorageStatCache::update(std::vector<StorageStatCacheUpdate> data) {
+  for (auto &upd : data) {
+    if (upd.cells < MIN_ACCOUNT_CELLS) {
       continue;
     }
-    td::Bits256 hash = cell->get_hash().bits();
-    LOG(DEBUG) << "StorageStatCache::update " << hash.to_hex() << " " << size;
-    cache_.set_ref(hash, cell);
-    lru_.put(hash, Deleter{hash, &cache_}, true, size);
+    td::Bits256 hash = upd.dict_root->get_hash().bits();
+    LOG(DEBUG) << "StorageStatCache::update " << hash.to_hex() << " " << upd.cells;
+    add_entry(hash, std::move(upd.dict_root), upd.cells);
+    if (!db_) {
+      continue;
+    }
+    AccountKey account{upd.workchain, upd.addr};
+    auto it = accounts_.find(account);
+    if (it == accounts_.end()) {
+      accounts_.emplace(account, hash);
+      changed_accounts_.insert(account);
+    } else if (it->second != hash) {
+      it->second = hash;
+      changed_accounts_.insert(account);
+    }
   }
 }
 
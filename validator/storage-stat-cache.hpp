@@ -18,32 +18,59 @@
 #include "interfaces/validator-manager.h"
 #include "td/utils/ConcurrentHashTable.h"
 #include "td/utils/LRUCache.h"
+#include "td/db/KeyValue.h"
 
 #include <functional>
+#include <map>
+#include <set>
 
 namespace ton::validator {
 
+/**
+ * Cache of account storage dicts of large accounts, keyed by the dict hash (which is stored in the account).
+ * If db_path is not empty, the latest dict of each account is persisted in a separate RocksDB, keyed by the
+ * account address, and loaded back in the background on startup, so that storage stat of large accounts is not
+ * recomputed from scratch after a restart. Only accounts whose dict changed are written on flush.
+ */
 class StorageStatCache : public td::actor::Actor {
  public:
+  explicit StorageStatCache(std::string db_path = "") : db_path_(std::move(db_path)) {
+  }
+  void start_up() override;
+  void tear_down() override;
+  void alarm() override;
+
   void get_cache(td::Promise<std::function<td::Ref<vm::Cell>(const td::Bits256&)>> promise);
 
-  // (storage dict root, account total cells)
-  void update(std::vector<std::pair<td::Ref<vm::Cell>, td::uint32>> data);
+  void update(std::vector<StorageStatCacheUpdate> data);
+
+  using AccountKey = std::pair<WorkchainId, td::Bits256>;
+  struct DbEntry {
+    AccountKey account;
+    td::Ref<vm::Cell> dict_root;
+    td::uint32 cells;
+  };
+  // called by the loader started in start_up
+  void loaded_from_db(std::vector<DbEntry> entries, std::vector<std::string> bad_keys);
 
  private:
   vm::Dictionary cache_{256};
 
   struct Deleter {
-    Deleter(const td::Bits256& hash, vm::Dictionary* cache) : hash(hash), cache(cache) {
+    Deleter(const td::Bits256& hash, vm::Dictionary* cache, std::vector<td::Bits256>* evicted, td::uint32 size)
+        : hash(hash), cache(cache), evicted(evicted), size(size) {
     }
     Deleter(const Deleter&) = delete;
-    Deleter(Deleter&& other) noexcept : hash(other.hash), cache(other.cache) {
+    Deleter(Deleter&& other) noexcept
+        : hash(other.hash), cache(other.cache), evicted(other.evicted), size(other.size) {
       other.cache = nullptr;
     }
     Deleter& operator=(const Deleter&) = delete;
     Deleter& operator=(Deleter&& other) noexcept {
       hash = other.hash;
       cache = other.cache;
+      evicted = other.evicted;
+      size = other.size;
       other.cache = nullptr;
       return *this;
     }
@@ -51,15 +78,37 @@ class StorageStatCache : public td::actor::Actor {
       if (cache) {
         CHECK(cache->lookup_delete_ref(hash).not_null());
         LOG(DEBUG) << "StorageStatCache remove " << hash.to_hex();
+        if (evicted) {
+          evicted->push_back(hash);
+        }
       }
     }
 
     td::Bits256 hash = td::Bits256::zero();
     vm::Dictionary* cache;
+    std::vector<td::Bits256>* evicted;
+    td::uint32 size;
   };
+
+  std::string db_path_;
+  std::shared_ptr<td::KeyValue> db_;
+  // db_ is read by the loader until loaded_from_db, nothing is written meanwhile
+  bool loading_ = false;
+  // storage dict hash of each account written or to be written to db_
+  std::map<AccountKey, td::Bits256> accounts_;
+  // changes not yet written to db_
+  std::set<AccountKey> changed_accounts_;
+  std::vector<td::Bits256> evicted_;
+  std::vector<std::string> bad_keys_;
+
   td::LRUCache<td::Bits256, Deleter> lru_{MAX_CACHE_TOTAL_CELLS};
 
+  void add_entry(const td::Bits256& hash, td::Ref<vm::Cell> cell, td::uint32 size);
+  void flush();
+  static std::string db_key(const AccountKey& account);
+
   static constexpr td::uint64 MAX_CACHE_TOTAL_CELLS = 1 << 24;
+  static constexpr double FLUSH_PERIOD = 60.0;
 
  public:
   static constexpr td::uint64 MIN_ACCOUNT_CELLS = 4000;
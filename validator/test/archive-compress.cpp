@@ -0,0 +1,140 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "td/utils/tests.h"
+#include "td/utils/port/path.h"
+#include "td/utils/port/Stat.h"
+#include "td/db/RocksDb.h"
+
+#include "validator/db/archive-compress.hpp"
+#include "validator/db/fileref.hpp"
+#include "validator/db/package.hpp"
+
+#include <map>
+
+namespace {
+
+using ton::validator::FileReference;
+
+std::string make_data(int i) {
+  std::string data;
+  if (i % 3 == 0) {
+    // incompressible entry, stays plain
+    data = td::rand_string(0, 255, 200 + i * 10);
+  } else {
+    while (data.size() < static_cast<size_t>(1000 + i * 100)) {
+      data += PSTRING() << "entry " << i << " line " << data.size() << "\n";
+    }
+  }
+  return data;
+}
+
+std::string make_filename(int i) {
+  ton::BlockIdExt block_id{ton::masterchainId, ton::shardIdAll, static_cast<ton::BlockSeqno>(i), td::Bits256::zero(),
+                           td::Bits256::zero()};
+  return FileReference(ton::validator::fileref::Block{block_id}).filename();
+}
+
+}  // namespace
+
+TEST(ArchiveCompress, round_trip) {
+  auto dir = td::mkdtemp("", "archive-compress").move_as_ok();
+  SCOPE_EXIT {
+    td::rmrf(dir).ignore();
+  };
+  auto index_path = dir + "/archive.00000.index";
+  auto package_path = dir + "/archive.00000.pack";
+
+  // filename -> data of the entry referenced by the index
+  std::map<std::string, std::string> expected;
+  td::uint64 committed_size;
+  {
+    auto kv = td::RocksDb::open(index_path).move_as_ok();
+    auto package = ton::Package::open(package_path, false, true).move_as_ok();
+    kv.begin_transaction().ensure();
+    for (int i = 0; i < 20; i++) {
+      auto filename = make_filename(i);
+      auto data = make_data(i);
+      auto offset = package.append(filename, data, false);
+      kv.set(FileReference::create(filename).move_as_ok().hash().to_hex(), td::to_string(offset)).ensure();
+      expected[filename] = data;
+    }
+    // a stale copy of an entry: the index references the later one
+    auto filename = make_filename(5);
+    package.append(filename, "stale", false);
+    auto offset = package.append(filename, expected[filename], false);
+    kv.set(FileReference::create(filename).move_as_ok().hash().to_hex(), td::to_string(offset)).ensure();
+    package.sync();
+    committed_size = package.size();
+    // written after the last commit, dropped on open
+    package.append(make_filename(100), make_data(100), true);
+
+    kv.set("status", "sliced").ensure();
+    kv.set("slices", "1").ensure();
+    kv.set("slice_size", "100").ensure();
+    kv.set("status.0", td::to_string(committed_size)).ensure();
+    kv.set("version.0", "1").ensure();
+    kv.commit_transaction().ensure();
+  }
+
+  auto stats = ton::validator::compress_archive_slice(index_path).move_as_ok();
+  ASSERT_EQ(22u, stats.files);
+  ASSERT_EQ(committed_size, stats.old_size);
+  ASSERT_TRUE(stats.new_size < stats.old_size);
+  ASSERT_TRUE(td::stat(package_path + ".compressed").is_error());
+
+  // converting again is a no-op
+  auto stats2 = ton::validator::compress_archive_slice(index_path).move_as_ok();
+  ASSERT_EQ(0u, stats2.files);
+  ASSERT_EQ(stats.new_size, stats2.new_size);
+
+  auto kv = td::RocksDb::open(index_path).move_as_ok();
+  std::string value;
+  kv.get("version.0", value).ensure();
+  ASSERT_EQ("2", value);
+  kv.get("status.0", value).ensure();
+  ASSERT_EQ(td::to_string(stats.new_size), value);
+
+  auto package = ton::Package::open(package_path, true, false).move_as_ok();
+  ASSERT_EQ(stats.new_size, package.size());
+  for (auto &[filename, data] : expected) {
+    ASSERT_EQ(td::KeyValue::GetStatus::Ok,
+              kv.get(FileReference::create(filename).move_as_ok().hash().to_hex(), value).move_as_ok());
+    auto entry = package.read(td::to_integer<td::uint64>(value)).move_as_ok();
+    ASSERT_EQ(filename, entry.first);
+    ASSERT_EQ(data, entry.second.as_slice().str());
+  }
+  size_t entries = 0;
+  package.iterate([&](std::string filename, td::BufferSlice data, td::uint64 offset) {
+    ASSERT_TRUE(expected.count(filename) == 1);
+    entries++;
+    return true;
+  });
+  ASSERT_EQ(22u, entries);
+}
+
+TEST(ArchiveCompress, key_slice) {
+  auto dir = td::mkdtemp("", "archive-compress").move_as_ok();
+  SCOPE_EXIT {
+    td::rmrf(dir).ignore();
+  };
+  auto index_path = dir + "/key.archive.000000.index";
+  {
+    auto kv = td::RocksDb::open(index_path).move_as_ok();
+    kv.set("status", "0").ensure();
+  }
+  ASSERT_TRUE(ton::validator::compress_archive_slice(index_path).is_error());
+}
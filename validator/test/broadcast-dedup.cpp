@@ -0,0 +1,103 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "td/utils/tests.h"
+
+#include "ton/ton-tl.hpp"
+#include "validator/full-node-broadcast-dedup.hpp"
+
+namespace {
+
+using ton::validator::fullnode::BlockBroadcastDedup;
+
+ton::BlockIdExt block_id(int seqno) {
+  return ton::BlockIdExt{ton::masterchainId, ton::shardIdAll, static_cast<ton::BlockSeqno>(seqno),
+                         td::Bits256::zero(), td::Bits256::zero()};
+}
+
+td::Bits256 payload_hash(int i) {
+  td::Bits256 hash = td::Bits256::zero();
+  hash.as_slice()[0] = static_cast<unsigned char>(i);
+  return hash;
+}
+
+ton::tl_object_ptr<ton::ton_api::tonNode_Broadcast> make_broadcast(const ton::BlockIdExt &id, td::Slice data,
+                                                                  td::Slice signature) {
+  std::vector<ton::tl_object_ptr<ton::ton_api::tonNode_blockSignature>> signatures;
+  signatures.push_back(
+      ton::create_tl_object<ton::ton_api::tonNode_blockSignature>(td::Bits256::zero(), td::BufferSlice{signature}));
+  return ton::create_tl_object<ton::ton_api::tonNode_blockBroadcast>(
+      ton::create_tl_block_id(id), 1, 2, std::move(signatures), td::BufferSlice{"proof"}, td::BufferSlice{data});
+}
+
+}  // namespace
+
+TEST(BlockBroadcastDedup, forged_first) {
+  BlockBroadcastDedup dedup;
+  auto id = block_id(1);
+  auto forged = payload_hash(1), genuine = payload_hash(2);
+  // a forged copy with the same block id does not hold back the genuine one
+  ASSERT_TRUE(dedup.try_start(id, forged, 100));
+  ASSERT_TRUE(dedup.try_start(id, genuine, 100));
+  // copies of a payload that is being processed are dropped
+  ASSERT_TRUE(!dedup.try_start(id, forged, 100));
+  ASSERT_TRUE(!dedup.try_start(id, genuine, 100));
+
+  // a failed copy is not remembered
+  dedup.finish(id, forged, false);
+  ASSERT_TRUE(dedup.try_start(id, forged, 100));
+  dedup.finish(id, forged, false);
+
+  // once a copy is accepted, every broadcast of the block is dropped
+  dedup.finish(id, genuine, true);
+  ASSERT_TRUE(!dedup.try_start(id, genuine, 100));
+  ASSERT_TRUE(!dedup.try_start(id, forged, 100));
+  ASSERT_TRUE(!dedup.try_start(id, payload_hash(3), 100));
+  ASSERT_TRUE(dedup.try_start(block_id(2), genuine, 100));
+}
+
+TEST(BlockBroadcastDedup, forged_broadcast) {
+  // the process-wide instance is used here, so the block id is not used by other tests
+  auto id = block_id(1000);
+  auto forged = make_broadcast(id, "forged data", "forged signature");
+  auto genuine = make_broadcast(id, "block data", "signature");
+  auto genuine_copy = make_broadcast(id, "block data", "signature");
+  // the genuine data with forged signatures
+  auto forged_signatures = make_broadcast(id, "block data", "forged signature");
+
+  td::Ref<vm::Cell> data_root;
+  td::Bits256 forged_hash, genuine_hash, hash;
+  auto B = ton::validator::fullnode::deserialize_new_block_broadcast(*forged, 1 << 20, data_root, forged_hash);
+  ASSERT_TRUE(B.is_ok());
+  ASSERT_EQ("forged data", B.ok().data.as_slice().str());
+  B = ton::validator::fullnode::deserialize_new_block_broadcast(*genuine, 1 << 20, data_root, genuine_hash);
+  ASSERT_TRUE(B.is_ok());
+  ASSERT_EQ("block data", B.ok().data.as_slice().str());
+  ASSERT_TRUE(forged_hash != genuine_hash);
+  ASSERT_TRUE(
+      ton::validator::fullnode::deserialize_new_block_broadcast(*genuine_copy, 1 << 20, data_root, hash).is_error());
+  ASSERT_TRUE(hash == genuine_hash);
+  ASSERT_TRUE(
+      ton::validator::fullnode::deserialize_new_block_broadcast(*forged_signatures, 1 << 20, data_root, hash).is_ok());
+
+  // the forged copies fail signature checks, the genuine one passes
+  BlockBroadcastDedup::instance().finish(id, forged_hash, false);
+  BlockBroadcastDedup::instance().finish(id, hash, false);
+  BlockBroadcastDedup::instance().finish(id, genuine_hash, true);
+  auto late_forged = make_broadcast(id, "forged data", "forged signature");
+  ASSERT_TRUE(
+      ton::validator::fullnode::deserialize_new_block_broadcast(*late_forged, 1 << 20, data_root, hash).is_error());
+}
@@ -0,0 +1,225 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "td/utils/tests.h"
+#include "td/utils/Time.h"
+
+#include "validator/ext-message-pool.hpp"
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+
+using ton::validator::ExtMessage;
+using ton::validator::ExtMessagePool;
+
+class TestMessage : public ExtMessage {
+ public:
+  TestMessage(int id, int addr) : addr_(ton::StdSmcAddress::zero()), hash_(ExtMessage::Hash::zero()) {
+    // the first byte selects the shard of the destination
+    addr_.as_slice()[0] = static_cast<unsigned char>(addr);
+    hash_.as_slice().substr(0, 4).copy_from(td::Slice(reinterpret_cast<const char *>(&id), 4));
+  }
+  ton::AccountIdPrefixFull shard() const override {
+    return ton::AccountIdPrefixFull{ton::basechainId, addr_.cbits().get_uint(64)};
+  }
+  td::BufferSlice serialize() const override {
+    return td::BufferSlice{};
+  }
+  td::Ref<vm::Cell> root_cell() const override {
+    return {};
+  }
+  Hash hash() const override {
+    return hash_;
+  }
+  ton::WorkchainId wc() const override {
+    return ton::basechainId;
+  }
+  ton::StdSmcAddress addr() const override {
+    return addr_;
+  }
+
+  static int id(const td::Ref<ExtMessage> &message) {
+    int id;
+    td::MutableSlice(reinterpret_cast<char *>(&id), 4).copy_from(message->hash().as_slice().substr(0, 4));
+    return id;
+  }
+  static int addr(const td::Ref<ExtMessage> &message) {
+    return message->addr().as_slice()[0];
+  }
+
+ private:
+  ton::StdSmcAddress addr_;
+  Hash hash_;
+};
+
+td::Ref<ExtMessage> message(int id, int addr) {
+  return td::make_ref<TestMessage>(id, addr);
+}
+
+ton::ShardIdFull shard_all() {
+  return ton::ShardIdFull{ton::basechainId, ton::shardIdAll};
+}
+
+std::vector<std::pair<td::Ref<ExtMessage>, int>> get_all(ExtMessagePool &pool) {
+  size_t processed = 0;
+  return pool.get_messages(shard_all(), processed);
+}
+
+std::vector<int> get_ids(ExtMessagePool &pool, ton::ShardIdFull shard = shard_all()) {
+  size_t processed = 0;
+  std::vector<int> res;
+  for (auto &[message, priority] : pool.get_messages(shard, processed)) {
+    res.push_back(TestMessage::id(message));
+  }
+  return res;
+}
+
+std::string size_stat(const ExtMessagePool &pool) {
+  std::vector<std::pair<std::string, std::string>> stats;
+  pool.prepare_stats(stats);
+  for (auto &[name, value] : stats) {
+    if (name == "ext_msg_pool.size") {
+      return value;
+    }
+  }
+  return "";
+}
+
+}  // namespace
+
+TEST(ExtMessagePool, ordering) {
+  ExtMessagePool pool;
+  // three addresses with three messages each at priority 0, one address at priority 1
+  for (int i = 0; i < 9; i++) {
+    ASSERT_TRUE(pool.add_message(message(i, i % 3), 0));
+  }
+  ASSERT_TRUE(pool.add_message(message(100, 5), 1));
+  ASSERT_TRUE(pool.add_message(message(101, 5), 1));
+
+  auto res = get_all(pool);
+  ASSERT_EQ(11u, res.size());
+  // higher priority first, in arrival order
+  ASSERT_EQ(100, TestMessage::id(res[0].first));
+  ASSERT_EQ(1, res[0].second);
+  ASSERT_EQ(101, TestMessage::id(res[1].first));
+  // then one message of each address per round, each address in arrival order
+  std::map<int, int> last_id;
+  for (size_t i = 2; i < res.size(); i++) {
+    ASSERT_EQ(0, res[i].second);
+    size_t round = (i - 2) / 3;
+    int id = TestMessage::id(res[i].first);
+    ASSERT_EQ(round, static_cast<size_t>(id / 3));
+    auto addr = TestMessage::addr(res[i].first);
+    ASSERT_EQ(id % 3, addr);
+    auto it = last_id.find(addr);
+    ASSERT_TRUE(it == last_id.end() || it->second < id);
+    last_id[addr] = id;
+  }
+
+  // only the messages of the requested shard are returned
+  ton::ShardIdFull left_shard{ton::basechainId, ton::shardIdAll >> 1};
+  ASSERT_EQ(11u, get_ids(pool, left_shard).size());
+  ton::ShardIdFull right_shard{ton::basechainId, ton::shardIdAll | (ton::shardIdAll >> 1)};
+  ASSERT_EQ(0u, get_ids(pool, right_shard).size());
+  ASSERT_TRUE(pool.add_message(message(200, 0x80), 0));
+  ASSERT_EQ(std::vector<int>{200}, get_ids(pool, right_shard));
+}
+
+TEST(ExtMessagePool, priority) {
+  ExtMessagePool pool;
+  ASSERT_TRUE(pool.add_message(message(1, 1), 0));
+  // a known message is only re-added with a higher priority
+  ASSERT_TRUE(!pool.add_message(message(1, 1), 0));
+  ASSERT_TRUE(pool.add_message(message(1, 1), 1));
+  ASSERT_EQ(1u, pool.size());
+  ASSERT_EQ(0u, pool.size(0));
+  ASSERT_EQ(1u, pool.size(1));
+  ASSERT_TRUE(!pool.add_message(message(1, 1), 0));
+  // rejected messages do not leave empty levels behind
+  ASSERT_EQ("total:1 priority1:1(addrs:1)", size_stat(pool));
+  pool.erase_message(message(1, 1)->hash());
+  ASSERT_EQ(0u, pool.size());
+  ASSERT_EQ("total:0", size_stat(pool));
+}
+
+TEST(ExtMessagePool, postpone) {
+  ExtMessagePool pool;
+  auto msg = message(1, 1);
+  ASSERT_TRUE(pool.add_message(msg, 0));
+  ASSERT_TRUE(pool.add_message(message(2, 2), 0));
+
+  // the first postponing is immediately over, the next ones last 5s and 10s
+  pool.delay_message(msg->hash(), 100);
+  ASSERT_EQ(2u, get_all(pool).size());
+  pool.delay_message(msg->hash(), 100);
+  ASSERT_EQ(std::vector<int>{2}, get_ids(pool));
+  td::Time::jump_in_future(td::Time::now() + 6.0);
+  ASSERT_EQ(2u, get_all(pool).size());
+  pool.delay_message(msg->hash(), 100);
+  ASSERT_EQ(std::vector<int>{2}, get_ids(pool));
+  td::Time::jump_in_future(td::Time::now() + 11.0);
+  ASSERT_EQ(2u, get_all(pool).size());
+  // then the message is dropped
+  pool.delay_message(msg->hash(), 100);
+  ASSERT_EQ(std::vector<int>{2}, get_ids(pool));
+  ASSERT_EQ(1u, pool.size());
+
+  // a message is dropped right away when its level has reached the soft limit
+  ASSERT_TRUE(pool.add_message(msg, 0));
+  pool.delay_message(msg->hash(), 2);
+  ASSERT_EQ(std::vector<int>{2}, get_ids(pool));
+  ASSERT_EQ(1u, pool.size());
+}
+
+TEST(ExtMessagePool, address_limit) {
+  ExtMessagePool pool;
+  int limit = static_cast<int>(ExtMessagePool::kPerAddressLimit);
+  for (int i = 0; i < limit; i++) {
+    ASSERT_TRUE(pool.add_message(message(i, 1), 0));
+  }
+  ASSERT_TRUE(!pool.add_message(message(limit, 1), 0));
+  // the limit is per address and per priority
+  ASSERT_TRUE(pool.add_message(message(limit, 2), 0));
+  ASSERT_TRUE(pool.add_message(message(limit + 1, 1), 1));
+  pool.erase_message(message(0, 1)->hash());
+  ASSERT_TRUE(pool.add_message(message(limit + 2, 1), 0));
+  ASSERT_EQ(static_cast<size_t>(limit + 2), pool.size());
+}
+
+TEST(ExtMessagePool, expire) {
+  ExtMessagePool pool;
+  ASSERT_TRUE(pool.add_message(message(1, 1), 0));
+  ASSERT_TRUE(pool.add_message(message(2, 2), 0));
+  ASSERT_EQ(0u, pool.expire());
+  td::Time::jump_in_future(td::Time::now() + ExtMessagePool::kMessageTtl / 2);
+  ASSERT_TRUE(pool.add_message(message(3, 3), 0));
+  // re-adding with a higher priority restarts the TTL
+  ASSERT_TRUE(pool.add_message(message(2, 2), 1));
+  ASSERT_EQ(0u, pool.expire());
+
+  td::Time::jump_in_future(td::Time::now() + ExtMessagePool::kMessageTtl / 2 + 20.0);
+  ASSERT_EQ(1u, pool.expire());
+  ASSERT_EQ(2u, pool.size());
+  ASSERT_EQ(0u, pool.expire());
+
+  td::Time::jump_in_future(td::Time::now() + ExtMessagePool::kMessageTtl);
+  ASSERT_EQ(2u, pool.expire());
+  ASSERT_EQ(0u, pool.size());
+  ASSERT_EQ("total:0", size_stat(pool));
+}
@@ -0,0 +1,324 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "td/utils/tests.h"
+#include "td/actor/actor.h"
+
+#include "auto/tl/lite_api.h"
+#include "common/errorcode.h"
+#include "ton/lite-tl.hpp"
+#include "tl-utils/common-utils.hpp"
+#include "validator/liteserver-admission.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+namespace {
+
+using ton::validator::LiteServerAdmission;
+namespace lite_api = ton::lite_api;
+
+ton::BlockIdExt block_id(int seqno) {
+  return ton::BlockIdExt{ton::masterchainId, ton::shardIdAll, static_cast<ton::BlockSeqno>(seqno),
+                         td::Bits256::zero(), td::Bits256::zero()};
+}
+
+td::BufferSlice wrap(td::BufferSlice query) {
+  return ton::create_serialize_tl_object<lite_api::liteServer_query>(std::move(query));
+}
+
+td::BufferSlice wait_seqno(int seqno, int timeout_ms, td::BufferSlice query) {
+  auto prefix = ton::create_tl_object<lite_api::liteServer_waitMasterchainSeqno>(seqno, timeout_ms);
+  return wrap(ton::serialize_tl_object(prefix, true, std::move(query)));
+}
+
+// cost 1
+td::BufferSlice get_time() {
+  return ton::create_serialize_tl_object<lite_api::liteServer_getTime>();
+}
+
+// cost 4, different modes give different queries
+td::BufferSlice get_config(int mode) {
+  return ton::create_serialize_tl_object<lite_api::liteServer_getConfigAll>(mode,
+                                                                           ton::create_tl_lite_block_id(block_id(1)));
+}
+
+// cost 8
+td::BufferSlice run_method(td::int64 method_id) {
+  return ton::create_serialize_tl_object<lite_api::liteServer_runSmcMethod>(
+      4, ton::create_tl_lite_block_id(block_id(1)),
+      ton::create_tl_object<lite_api::liteServer_accountId>(0, td::Bits256::zero()), method_id, td::BufferSlice());
+}
+
+// cost 64
+td::BufferSlice get_state(int seqno) {
+  return ton::create_serialize_tl_object<lite_api::liteServer_getState>(ton::create_tl_lite_block_id(block_id(seqno)));
+}
+
+ton::adnl::AdnlNodeIdShort client(int i) {
+  td::Bits256 id = td::Bits256::zero();
+  id.as_array()[0] = static_cast<td::uint8>(i);
+  return ton::adnl::AdnlNodeIdShort{id};
+}
+
+// Runs LiteServerAdmission in a single-threaded scheduler, the queries it starts are kept until finish() is called
+class AdmissionTester {
+ public:
+  AdmissionTester(td::uint32 max_cost, td::uint32 max_client_cost, double client_rate) {
+    scheduler_.run_in_context([&] {
+      admission_ = td::actor::create_actor<LiteServerAdmission>(
+          "lsadmission", std::make_unique<Callback>(state_), max_cost, max_client_cost, client_rate);
+    });
+    flush();
+  }
+  ~AdmissionTester() {
+    scheduler_.run_in_context([&] {
+      state_->running.clear();
+      state_->waits.clear();
+      admission_.reset();
+    });
+  }
+
+  // returns the index of the query in results()
+  size_t send(ton::adnl::AdnlNodeIdShort src, td::BufferSlice query) {
+    size_t idx = state_->results.size();
+    state_->results.emplace_back();
+    scheduler_.run_in_context([&] {
+      td::actor::send_closure(admission_, &LiteServerAdmission::run_query, src, std::move(query),
+                              [state = state_, idx](td::Result<td::BufferSlice> R) {
+                                if (R.is_error()) {
+                                  state->results[idx] = R.error().message().str();
+                                  return;
+                                }
+                                auto E = ton::fetch_tl_object<lite_api::liteServer_error>(R.ok().as_slice(), true);
+                                state->results[idx] = E.is_ok() ? E.ok()->message_ : "ok";
+                              });
+    });
+    flush();
+    return idx;
+  }
+
+  // queries passed to the manager and not finished yet, in the order they were started
+  std::vector<std::string> running() const {
+    std::vector<std::string> res;
+    for (auto &q : state_->running) {
+      res.push_back(q.first);
+    }
+    return res;
+  }
+  void finish(const td::BufferSlice &query) {
+    auto &running = state_->running;
+    auto it = std::find_if(running.begin(), running.end(), [&](const auto &q) { return q.first == query.as_slice(); });
+    CHECK(it != running.end());
+    auto promise = std::move(it->second);
+    running.erase(it);
+    scheduler_.run_in_context([&] { promise.set_value(td::BufferSlice("answer")); });
+    flush();
+  }
+  size_t waiting() const {
+    return state_->waits.size();
+  }
+  void seqno_ready(td::Result<td::Unit> R = td::Unit()) {
+    CHECK(!state_->waits.empty());
+    auto promise = std::move(state_->waits.front());
+    state_->waits.erase(state_->waits.begin());
+    scheduler_.run_in_context([&] { promise.set_result(std::move(R)); });
+    flush();
+  }
+  const std::vector<std::string> &results() const {
+    return state_->results;
+  }
+
+ private:
+  struct State {
+    std::vector<std::pair<std::string, td::Promise<td::BufferSlice>>> running;
+    std::vector<td::Promise<td::Unit>> waits;
+    std::vector<std::string> results;
+  };
+  class Callback : public LiteServerAdmission::Callback {
+   public:
+    explicit Callback(std::shared_ptr<State> state) : state_(std::move(state)) {
+    }
+    void run_query(td::BufferSlice data, td::Promise<td::BufferSlice> promise) override {
+      state_->running.emplace_back(data.as_slice().str(), std::move(promise));
+    }
+    void wait_masterchain_seqno(ton::BlockSeqno seqno, td::Timestamp timeout,
+                                td::Promise<td::Unit> promise) override {
+      state_->waits.push_back(std::move(promise));
+    }
+
+   private:
+    std::shared_ptr<State> state_;
+  };
+
+  void flush() {
+    for (int i = 0; i < 16; i++) {
+      scheduler_.run(0);
+    }
+  }
+
+  td::actor::Scheduler scheduler_{{0}};
+  std::shared_ptr<State> state_ = std::make_shared<State>();
+  td::actor::ActorOwn<LiteServerAdmission> admission_;
+};
+
+std::string q(const td::BufferSlice &query) {
+  return query.as_slice().str();
+}
+
+}  // namespace
+
+TEST(LiteServerAdmission, query_cost) {
+  ASSERT_EQ(1u, LiteServerAdmission::query_cost(wrap(get_time())));
+  ASSERT_EQ(4u, LiteServerAdmission::query_cost(wrap(get_config(0))));
+  ASSERT_EQ(8u, LiteServerAdmission::query_cost(wrap(run_method(1))));
+  ASSERT_EQ(64u, LiteServerAdmission::query_cost(wrap(get_state(1))));
+  ASSERT_EQ(8u, LiteServerAdmission::query_cost(wait_seqno(10, 1000, run_method(1))));
+  ASSERT_EQ(64u, LiteServerAdmission::query_cost(wait_seqno(10, 1000, get_state(1))));
+  // unknown query, truncated data
+  ASSERT_EQ(2u, LiteServerAdmission::query_cost(wrap(td::BufferSlice("\x01\x02\x03\x04"))));
+  ASSERT_EQ(1u, LiteServerAdmission::query_cost(td::BufferSlice("\x01\x02")));
+  auto data = wrap(get_state(1));
+  ASSERT_EQ(1u, LiteServerAdmission::query_cost(data.as_slice().substr(0, 6)));
+
+  ton::BlockSeqno seqno = 0;
+  double timeout = 0.0;
+  ASSERT_TRUE(!LiteServerAdmission::get_wait_seqno(wrap(run_method(1)), seqno, timeout));
+  ASSERT_TRUE(LiteServerAdmission::get_wait_seqno(wait_seqno(10, 1500, run_method(1)), seqno, timeout));
+  ASSERT_EQ(10u, seqno);
+  ASSERT_EQ(1.5, timeout);
+  ASSERT_TRUE(LiteServerAdmission::get_wait_seqno(wait_seqno(11, 100000, run_method(1)), seqno, timeout));
+  ASSERT_EQ(11u, seqno);
+  ASSERT_EQ(10.0, timeout);
+}
+
+TEST(LiteServerAdmission, token_bucket) {
+  LiteServerAdmission::TokenBucket bucket{2.0, 10.0, 100.0};
+  ASSERT_TRUE(bucket.is_full(100.0));
+  ASSERT_TRUE(bucket.take(8.0, 100.0));
+  ASSERT_TRUE(!bucket.is_full(100.0));
+  ASSERT_TRUE(!bucket.take(4.0, 100.0));
+  // 2 tokens left, 1 second gives 2 more
+  ASSERT_TRUE(bucket.take(4.0, 101.0));
+  ASSERT_TRUE(!bucket.take(1.0, 101.0));
+  // refills up to burst only
+  ASSERT_TRUE(bucket.is_full(200.0));
+  ASSERT_TRUE(bucket.take(10.0, 200.0));
+  ASSERT_TRUE(!bucket.take(1.0, 200.0));
+  // time going backwards does not add tokens
+  ASSERT_TRUE(!bucket.take(1.0, 150.0));
+}
+
+TEST(LiteServerAdmission, running_cost) {
+  AdmissionTester t{16, 0, 0.0};
+  t.send(client(1), wrap(run_method(1)));
+  t.send(client(1), wrap(get_config(1)));
+  t.send(client(2), wrap(get_config(2)));
+  // 8 + 4 + 4 fit into max_cost
+  ASSERT_EQ(3u, t.running().size());
+  auto idx = t.send(client(2), wrap(get_time()));
+  ASSERT_EQ(3u, t.running().size());
+  ASSERT_EQ("", t.results()[idx]);
+  t.finish(wrap(get_config(2)));
+  ASSERT_EQ(3u, t.running().size());
+  ASSERT_EQ(q(wrap(get_time())), t.running().back());
+  t.finish(wrap(get_time()));
+  ASSERT_EQ("ok", t.results()[idx]);
+
+  // a query costing more than max_cost runs alone
+  t.finish(wrap(run_method(1)));
+  t.finish(wrap(get_config(1)));
+  t.send(client(1), wrap(get_state(1)));
+  t.send(client(2), wrap(get_time()));
+  ASSERT_EQ(1u, t.running().size());
+  t.finish(wrap(get_state(1)));
+  ASSERT_EQ(1u, t.running().size());
+  ASSERT_EQ(q(wrap(get_time())), t.running().back());
+}
+
+TEST(LiteServerAdmission, fifo) {
+  AdmissionTester t{8, 0, 0.0};
+  t.send(client(1), wrap(run_method(1)));
+  t.send(client(2), wrap(run_method(2)));
+  // getTime would fit, but must not overtake the queued runSmcMethod
+  t.send(client(3), wrap(get_time()));
+  ASSERT_EQ(1u, t.running().size());
+  t.finish(wrap(run_method(1)));
+  ASSERT_EQ(1u, t.running().size());
+  ASSERT_EQ(q(wrap(run_method(2))), t.running().back());
+  t.finish(wrap(run_method(2)));
+  ASSERT_EQ(q(wrap(get_time())), t.running().back());
+}
+
+TEST(LiteServerAdmission, client_running_cost) {
+  AdmissionTester t{32, 8, 0.0};
+  t.send(client(1), wrap(run_method(1)));
+  t.send(client(1), wrap(run_method(2)));
+  t.send(client(1), wrap(get_config(1)));
+  // client 1 is at its own limit, the queries of client 2 skip its queue
+  t.send(client(2), wrap(get_config(2)));
+  t.send(client(2), wrap(get_config(3)));
+  ASSERT_EQ(std::vector<std::string>({q(wrap(run_method(1))), q(wrap(get_config(2))), q(wrap(get_config(3)))}),
+            t.running());
+  t.finish(wrap(run_method(1)));
+  ASSERT_EQ(q(wrap(run_method(2))), t.running().back());
+  t.finish(wrap(run_method(2)));
+  ASSERT_EQ(q(wrap(get_config(1))), t.running().back());
+
+  // without the per-client limit one client may take the whole budget
+  AdmissionTester t2{32, 0, 0.0};
+  t2.send(client(1), wrap(run_method(1)));
+  t2.send(client(1), wrap(run_method(2)));
+  t2.send(client(1), wrap(get_config(1)));
+  ASSERT_EQ(3u, t2.running().size());
+}
+
+TEST(LiteServerAdmission, client_rate) {
+  // burst is max(rate * 5, 64)
+  AdmissionTester t{1000, 0, 1.0};
+  auto idx = t.send(client(1), wrap(get_state(1)));
+  auto idx2 = t.send(client(1), wrap(get_time()));
+  auto idx3 = t.send(client(2), wrap(get_time()));
+  t.finish(wrap(get_state(1)));
+  ASSERT_EQ("ok", t.results()[idx]);
+  ASSERT_EQ("rate limit exceeded", t.results()[idx2]);
+  ASSERT_EQ(1u, t.running().size());
+  t.finish(wrap(get_time()));
+  ASSERT_EQ("ok", t.results()[idx3]);
+}
+
+TEST(LiteServerAdmission, wait_seqno) {
+  AdmissionTester t{8, 0, 0.0};
+  auto query = wait_seqno(10, 1000, run_method(1));
+  auto idx = t.send(client(1), query.clone());
+  auto idx2 = t.send(client(1), wait_seqno(11, 1000, run_method(2)));
+  // queries waiting for the masterchain block do not hold the running cost
+  ASSERT_EQ(2u, t.waiting());
+  ASSERT_EQ(0u, t.running().size());
+  t.send(client(2), wrap(run_method(3)));
+  ASSERT_EQ(1u, t.running().size());
+
+  t.seqno_ready();
+  ASSERT_EQ(1u, t.running().size());
+  t.finish(wrap(run_method(3)));
+  ASSERT_EQ(std::vector<std::string>({q(query)}), t.running());
+  t.seqno_ready(td::Status::Error(ton::ErrorCode::timeout, "timeout"));
+  ASSERT_EQ("timeout", t.results()[idx2]);
+  ASSERT_EQ(1u, t.running().size());
+  t.finish(query);
+  ASSERT_EQ("ok", t.results()[idx]);
+}
@@ -0,0 +1,179 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "td/utils/tests.h"
+
+#include "validator/liteserver-state-cache.hpp"
+
+#include <vector>
+
+namespace {
+
+using ton::validator::LiteServerStateCache;
+using ton::validator::ShardState;
+
+class TestState : public ShardState {
+ public:
+  explicit TestState(ton::BlockIdExt block_id) : block_id_(block_id) {
+  }
+  bool disable_boc() const override {
+    return true;
+  }
+  ton::UnixTime get_unix_time() const override {
+    return 0;
+  }
+  ton::LogicalTime get_logical_time() const override {
+    return 0;
+  }
+  td::int32 get_global_id() const override {
+    return 0;
+  }
+  ton::ShardIdFull get_shard() const override {
+    return block_id_.shard_full();
+  }
+  ton::BlockSeqno get_seqno() const override {
+    return block_id_.seqno();
+  }
+  ton::BlockIdExt get_block_id() const override {
+    return block_id_;
+  }
+  ton::RootHash root_hash() const override {
+    return block_id_.root_hash;
+  }
+  td::Ref<vm::Cell> root_cell() const override {
+    return {};
+  }
+  td::optional<ton::BlockIdExt> get_master_ref() const override {
+    return {};
+  }
+  td::Status validate_deep() const override {
+    return td::Status::OK();
+  }
+  bool before_split() const override {
+    return false;
+  }
+  td::Result<td::Ref<ton::validator::MessageQueue>> message_queue() const override {
+    return td::Status::Error("not implemented");
+  }
+  td::Status apply_block(ton::BlockIdExt id, td::Ref<ton::validator::BlockData> block) override {
+    return td::Status::Error("not implemented");
+  }
+  td::Result<td::Ref<ShardState>> merge_with(const ShardState &with) const override {
+    return td::Status::Error("not implemented");
+  }
+  td::Result<std::pair<td::Ref<ShardState>, td::Ref<ShardState>>> split() const override {
+    return td::Status::Error("not implemented");
+  }
+  td::Result<td::BufferSlice> serialize() const override {
+    return td::Status::Error("not implemented");
+  }
+  td::Status serialize_to_file(td::FileFd &fd) const override {
+    return td::Status::Error("not implemented");
+  }
+
+ private:
+  ton::BlockIdExt block_id_;
+};
+
+ton::BlockIdExt block_id(int seqno) {
+  return ton::BlockIdExt{ton::masterchainId, ton::shardIdAll, static_cast<ton::BlockSeqno>(seqno),
+                         td::Bits256::zero(), td::Bits256::zero()};
+}
+
+td::Ref<ShardState> make_state(int seqno) {
+  return td::make_ref<TestState>(block_id(seqno));
+}
+
+struct Waiter {
+  bool done = false;
+  td::Result<td::Ref<ShardState>> result;
+
+  td::Promise<td::Ref<ShardState>> promise() {
+    return [this](td::Result<td::Ref<ShardState>> R) {
+      done = true;
+      result = std::move(R);
+    };
+  }
+};
+
+std::string stats(const LiteServerStateCache &cache) {
+  std::vector<std::pair<std::string, std::string>> vec;
+  cache.prepare_stats(vec);
+  CHECK(vec.size() == 1);
+  return vec[0].second;
+}
+
+// loads the state of block seqno through the cache
+void load(LiteServerStateCache &cache, int seqno) {
+  Waiter waiter;
+  CHECK(cache.wait(block_id(seqno), waiter.promise()));
+  cache.loaded(block_id(seqno), make_state(seqno));
+  CHECK(waiter.done && waiter.result.is_ok());
+}
+
+}  // namespace
+
+TEST(LiteServerStateCache, hit_miss) {
+  LiteServerStateCache cache{4};
+  ASSERT_TRUE(cache.get(block_id(1)).is_null());
+  load(cache, 1);
+  auto state = cache.get(block_id(1));
+  ASSERT_TRUE(state.not_null());
+  ASSERT_EQ(1u, state->get_seqno());
+  ASSERT_TRUE(cache.get(block_id(2)).is_null());
+  ASSERT_EQ("size:1 hits:1 misses:2 shared_loads:0", stats(cache));
+}
+
+TEST(LiteServerStateCache, shared_load) {
+  LiteServerStateCache cache{4};
+  Waiter first, second, third;
+  // only the first query reads the state from db
+  ASSERT_TRUE(cache.wait(block_id(1), first.promise()));
+  ASSERT_TRUE(!cache.wait(block_id(1), second.promise()));
+  ASSERT_TRUE(cache.wait(block_id(2), third.promise()));
+  ASSERT_TRUE(!first.done && !second.done);
+
+  cache.loaded(block_id(1), make_state(1));
+  ASSERT_TRUE(first.done && second.done && !third.done);
+  ASSERT_EQ(1u, first.result.ok()->get_seqno());
+  ASSERT_EQ(first.result.ok().get(), second.result.ok().get());
+
+  // errors are passed to all waiters and are not cached
+  Waiter fourth;
+  ASSERT_TRUE(!cache.wait(block_id(2), fourth.promise()));
+  cache.loaded(block_id(2), td::Status::Error("no state"));
+  ASSERT_TRUE(third.done && third.result.is_error());
+  ASSERT_TRUE(fourth.done && fourth.result.is_error());
+  ASSERT_TRUE(cache.get(block_id(2)).is_null());
+  Waiter fifth;
+  ASSERT_TRUE(cache.wait(block_id(2), fifth.promise()));
+  ASSERT_EQ("size:1 hits:0 misses:1 shared_loads:2", stats(cache));
+}
+
+TEST(LiteServerStateCache, eviction) {
+  LiteServerStateCache cache{2};
+  load(cache, 1);
+  load(cache, 2);
+  // the least recently used state is evicted
+  ASSERT_TRUE(cache.get(block_id(1)).not_null());
+  load(cache, 3);
+  ASSERT_TRUE(cache.get(block_id(2)).is_null());
+  ASSERT_TRUE(cache.get(block_id(1)).not_null());
+  ASSERT_TRUE(cache.get(block_id(3)).not_null());
+  load(cache, 4);
+  ASSERT_TRUE(cache.get(block_id(1)).is_null());
+  ASSERT_EQ("size:2 hits:3 misses:2 shared_loads:0", stats(cache));
+}
@@ -241,7 +241,7 @@ void ValidateBroadcast::got_block_handle(BlockHandle handle) {
   VLOG(VALIDATOR_DEBUG) << "got_block_handle " << handle->id().id.to_str();
   handle_ = std::move(handle);
 
-  auto dataR = create_block(broadcast_.block_id, broadcast_.data.clone());
+  auto dataR = create_block(broadcast_.block_id, broadcast_.data.clone(), std::move(data_root_));
   if (dataR.is_error()) {
     abort_query(dataR.move_as_error_prefix("bad block data: "));
     return;
@@ -28,6 +28,7 @@ namespace validator {
 class ValidateBroadcast : public td::actor::Actor {
  private:
   BlockBroadcast broadcast_;
+  td::Ref<vm::Cell> data_root_;
   BlockHandle last_masterchain_block_handle_;
   td::Ref<MasterchainState> last_masterchain_state_;
   BlockHandle last_known_masterchain_block_handle_;
@@ -51,10 +52,11 @@ class ValidateBroadcast : public td::actor::Actor {
   td::Ref<MasterchainState> zero_state_;
 
  public:
-  ValidateBroadcast(BlockBroadcast broadcast, BlockHandle last_masterchain_block_handle,
+  ValidateBroadcast(BlockBroadcast broadcast, td::Ref<vm::Cell> data_root, BlockHandle last_masterchain_block_handle,
                     td::Ref<MasterchainState> last_masterchain_state, BlockHandle last_known_masterchain_block_handle,
                     td::actor::ActorId<ValidatorManager> manager, td::Timestamp timeout, td::Promise<td::Unit> promise)
       : broadcast_(std::move(broadcast))
+      , data_root_(std::move(data_root))
       , last_masterchain_block_handle_(std::move(last_masterchain_block_handle))
       , last_masterchain_state_(std::move(last_masterchain_state))
       , last_known_masterchain_block_handle_(std::move(last_known_masterchain_block_handle))
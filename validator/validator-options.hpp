@@ -113,6 +113,9 @@ struct ValidatorManagerOptionsImpl : public ValidatorManagerOptions {
   std::string get_session_logs_file() const override {
     return session_logs_file_;
   }
+  std::string get_actor_profile_file() const override {
+    return actor_profile_file_;
+  }
   td::uint32 get_celldb_compress_depth() const override {
     return celldb_compress_depth_;
   }
@@ -125,9 +128,21 @@ struct ValidatorManagerOptionsImpl : public ValidatorManagerOptions {
   bool get_disable_rocksdb_stats() const override {
     return disable_rocksdb_stats_;
   }
+  bool get_compress_archive_packages() const override {
+    return compress_archive_packages_;
+  }
   bool nonfinal_ls_queries_enabled() const override {
     return nonfinal_ls_queries_enabled_;
   }
+  td::uint32 get_ls_max_running_cost() const override {
+    return ls_max_running_cost_;
+  }
+  td::uint32 get_ls_max_client_running_cost() const override {
+    return ls_max_client_running_cost_;
+  }
+  double get_ls_client_rate() const override {
+    return ls_client_rate_;
+  }
   td::optional<td::uint64> get_celldb_cache_size() const override {
     return celldb_cache_size_;
   }
@@ -140,6 +155,9 @@ struct ValidatorManagerOptionsImpl : public ValidatorManagerOptions {
   bool get_celldb_in_memory() const override {
     return celldb_in_memory_;
   }
+  bool get_celldb_in_memory_compact() const override {
+    return celldb_in_memory_compact_;
+  }
   bool get_celldb_v2() const override {
     return celldb_v2_;
   }
@@ -229,6 +247,9 @@ struct ValidatorManagerOptionsImpl : public ValidatorManagerOptions {
   void set_session_logs_file(std::string f) override {
     session_logs_file_ = std::move(f);
   }
+  void set_actor_profile_file(std::string f) override {
+    actor_profile_file_ = std::move(f);
+  }
   void set_celldb_compress_depth(td::uint32 value) override {
     celldb_compress_depth_ = value;
   }
@@ -241,9 +262,21 @@ struct ValidatorManagerOptionsImpl : public ValidatorManagerOptions {
   void set_disable_rocksdb_stats(bool value) override {
     disable_rocksdb_stats_ = value;
   }
+  void set_compress_archive_packages(bool value) override {
+    compress_archive_packages_ = value;
+  }
   void set_nonfinal_ls_queries_enabled(bool value) override {
     nonfinal_ls_queries_enabled_ = value;
   }
+  void set_ls_max_running_cost(td::uint32 value) override {
+    ls_max_running_cost_ = value;
+  }
+  void set_ls_max_client_running_cost(td::uint32 value) override {
+    ls_max_client_running_cost_ = value;
+  }
+  void set_ls_client_rate(double value) override {
+    ls_client_rate_ = value;
+  }
   void set_celldb_cache_size(td::uint64 value) override {
     celldb_cache_size_ = value;
   }
@@ -256,6 +289,9 @@ struct ValidatorManagerOptionsImpl : public ValidatorManagerOptions {
   void set_celldb_in_memory(bool value) override {
     celldb_in_memory_ = value;
   }
+  void set_celldb_in_memory_compact(bool value) override {
+    celldb_in_memory_compact_ = value;
+  }
   void set_celldb_v2(bool value) override {
     celldb_v2_ = value;
   }
@@ -337,15 +373,21 @@ struct ValidatorManagerOptionsImpl : public ValidatorManagerOptions {
   BlockSeqno truncate_{0};
   BlockSeqno sync_upto_{0};
   std::string session_logs_file_;
+  std::string actor_profile_file_;
   td::uint32 celldb_compress_depth_{0};
   size_t max_open_archive_files_ = 0;
   double archive_preload_period_ = 0.0;
   bool disable_rocksdb_stats_;
+  bool compress_archive_packages_ = false;
   bool nonfinal_ls_queries_enabled_ = false;
+  td::uint32 ls_max_running_cost_ = 512;
+  td::uint32 ls_max_client_running_cost_ = 0;
+  double ls_client_rate_ = 0.0;
   td::optional<td::uint64> celldb_cache_size_;
   bool celldb_direct_io_ = false;
   bool celldb_preload_all_ = false;
   bool celldb_in_memory_ = false;
+  bool celldb_in_memory_compact_ = false;
   bool celldb_v2_ = false;
   bool celldb_disable_bloom_filter_ = false;
   td::optional<double> catchain_max_block_delay_, catchain_max_block_delay_slow_;
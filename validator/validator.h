@@ -134,13 +134,19 @@ struct ValidatorManagerOptions : public td::CntObject {
   virtual BlockSeqno get_truncate_seqno() const = 0;
   virtual BlockSeqno sync_upto() const = 0;
   virtual std::string get_session_logs_file() const = 0;
+  virtual std::string get_actor_profile_file() const = 0;
   virtual td::uint32 get_celldb_compress_depth() const = 0;
   virtual bool get_celldb_in_memory() const = 0;
+  virtual bool get_celldb_in_memory_compact() const = 0;
   virtual bool get_celldb_v2() const = 0;
   virtual size_t get_max_open_archive_files() const = 0;
   virtual double get_archive_preload_period() const = 0;
   virtual bool get_disable_rocksdb_stats() const = 0;
+  virtual bool get_compress_archive_packages() const = 0;
   virtual bool nonfinal_ls_queries_enabled() const = 0;
+  virtual td::uint32 get_ls_max_running_cost() const = 0;
+  virtual td::uint32 get_ls_max_client_running_cost() const = 0;
+  virtual double get_ls_client_rate() const = 0;
   virtual td::optional<td::uint64> get_celldb_cache_size() const = 0;
   virtual bool get_celldb_direct_io() const = 0;
   virtual bool get_celldb_preload_all() const = 0;
@@ -173,15 +179,21 @@ struct ValidatorManagerOptions : public td::CntObject {
   virtual void truncate_db(BlockSeqno seqno) = 0;
   virtual void set_sync_upto(BlockSeqno seqno) = 0;
   virtual void set_session_logs_file(std::string f) = 0;
+  virtual void set_actor_profile_file(std::string f) = 0;
   virtual void set_celldb_compress_depth(td::uint32 value) = 0;
   virtual void set_max_open_archive_files(size_t value) = 0;
   virtual void set_archive_preload_period(double value) = 0;
   virtual void set_disable_rocksdb_stats(bool value) = 0;
+  virtual void set_compress_archive_packages(bool value) = 0;
   virtual void set_nonfinal_ls_queries_enabled(bool value) = 0;
+  virtual void set_ls_max_running_cost(td::uint32 value) = 0;
+  virtual void set_ls_max_client_running_cost(td::uint32 value) = 0;
+  virtual void set_ls_client_rate(double value) = 0;
   virtual void set_celldb_cache_size(td::uint64 value) = 0;
   virtual void set_celldb_direct_io(bool value) = 0;
   virtual void set_celldb_preload_all(bool value) = 0;
   virtual void set_celldb_in_memory(bool value) = 0;
+  virtual void set_celldb_in_memory_compact(bool value) = 0;
   virtual void set_celldb_v2(bool value) = 0;
   virtual void set_celldb_disable_bloom_filter(bool value) = 0;
   virtual void set_catchain_max_block_delay(double value) = 0;
@@ -258,7 +270,8 @@ class ValidatorManagerInterface : public td::actor::Actor {
   virtual void validate_block_proof_rel(BlockIdExt block_id, BlockIdExt rel_block_id, td::BufferSlice proof,
                                         td::Promise<td::Unit> promise) = 0;
   virtual void validate_block(ReceivedBlock block, td::Promise<BlockHandle> promise) = 0;
-  virtual void new_block_broadcast(BlockBroadcast broadcast, td::Promise<td::Unit> promise) = 0;
+  virtual void new_block_broadcast(BlockBroadcast broadcast, td::Ref<vm::Cell> data_root,
+                                   td::Promise<td::Unit> promise) = 0;
 
   //virtual void create_validate_block(BlockId block, td::BufferSlice data, td::Promise<Block> promise) = 0;
   virtual void sync_complete(td::Promise<td::Unit> promise) = 0;
@@ -341,6 +354,7 @@ class ValidatorManagerInterface : public td::actor::Actor {
   virtual void run_ext_query(td::BufferSlice data, td::Promise<td::BufferSlice> promise) = 0;
   virtual void prepare_stats(td::Promise<std::vector<std::pair<std::string, std::string>>> promise) = 0;
   virtual void prepare_actor_stats(td::Promise<std::string> promise) = 0;
+  virtual void prepare_actor_profile(td::Promise<std::string> promise) = 0;
 
   virtual void prepare_perf_timer_stats(td::Promise<std::vector<PerfTimerStats>> promise) = 0;
   virtual void add_perf_timer_stat(std::string name, double duration) = 0;